@@ -123,6 +123,28 @@ class PlayVerb(VerbExtension):
                  'and this attribute will be used to determine which one stops playback '
                  'execution.')
 
+        parser.add_argument(
+            '--max-decompression-buffer-size', type=check_not_negative_int,
+            default=1024 * 1024 * 1024,
+            help='Maximum size in bytes of a file of a bag compressed by file that is decompressed '
+                 'in memory. Larger files are decompressed to disk next to the compressed file. '
+                 'Default is 1 GiB. 0 always decompresses to disk.')
+        parser.add_argument(
+            '--decompression-threads', type=check_not_negative_int, default=0,
+            help='Number of threads decompressing the messages of a bag compressed by message '
+                 'ahead of playback. Default is 0, which decompresses each message when it is '
+                 'read.')
+        parser.add_argument(
+            '--decompression-read-ahead-size', type=check_not_negative_int,
+            default=16 * 1024 * 1024,
+            help='Size in bytes of the messages decompressed ahead of playback by the '
+                 'decompression threads. Default is 16 MiB.')
+        parser.add_argument(
+            '--decompression-read-ahead-files', type=check_not_negative_int, default=0,
+            help='Number of files of a bag compressed by file that are decompressed in the '
+                 'background ahead of the file being played, so that playback does not pause '
+                 'at every split. Files decompressed to disk are removed once played. Default '
+                 'is 0, which decompresses each file when playback reaches it.')
         parser.add_argument(
             '--disable-keyboard-controls', action='store_true',
             help='disables keyboard controls for playback')
@@ -181,6 +203,10 @@ class PlayVerb(VerbExtension):
             uri=args.bag_path,
             storage_id=args.storage,
             storage_config_uri=storage_config_file,
+            max_decompression_buffer_size=args.max_decompression_buffer_size,
+            decompression_threads=args.decompression_threads,
+            decompression_read_ahead_size=args.decompression_read_ahead_size,
+            decompression_read_ahead_files=args.decompression_read_ahead_files,
         )
         play_options = PlayOptions()
         play_options.read_ahead_queue_size = args.read_ahead_queue_size
@@ -113,10 +113,24 @@ class RecordVerb(VerbExtension):
                  'about one second of total recorded data volume.'
                  'If the value specified is 0, then every message is directly written to disk.'
         )
+        parser.add_argument(
+            '--max-cache-spill-size', type=int, default=0,
+            help='maximum size (in bytes) of a file absorbing messages which do not fit into the '
+                 'cache, e.g. during short storage stalls. Spilled messages are written to the '
+                 'bag in order once storage catches up. Default is 0, which disables spilling '
+                 'and drops messages when the cache is full.'
+        )
+        parser.add_argument(
+            '--metadata-checkpoint-interval', type=int, default=0,
+            help='interval in seconds at which the bag metadata is rewritten while recording, '
+                 'and on every split, so that the bag can be read after an unclean shutdown '
+                 'without reindexing. Default is 0, which writes the metadata on exit only.'
+        )
         parser.add_argument(
             '--compression-mode', type=str, default='none',
-            choices=['none', 'file', 'message'],
-            help="Determine whether to compress by file or message. Default is 'none'."
+            choices=['none', 'file', 'message', 'chunk'],
+            help="Determine whether to compress by file, message or chunk of consecutive "
+                 "messages. Default is 'none'."
         )
         parser.add_argument(
             '--compression-format', type=str, default='', choices=compression_format_choices,
@@ -132,11 +146,83 @@ class RecordVerb(VerbExtension):
             help='Number of files or messages that may be compressed in parallel. '
                  'Default is 0, which will be interpreted as the number of CPU cores.'
         )
+        parser.add_argument(
+            '--compression-chunk-size', type=int, default=1024 * 1024,
+            help='Uncompressed size in bytes of the chunks compressed together in chunk '
+                 'compression mode. Default is 1 MiB. 0 compresses each cache flush as one chunk.'
+        )
+        parser.add_argument(
+            '--compression-dictionary-samples', type=int, default=0,
+            help='Number of messages per topic to train a compression dictionary on in message '
+                 'compression mode. Helps with small, repetitive messages. Default is 0, which '
+                 'disables dictionaries.'
+        )
+        parser.add_argument(
+            '--compression-level', type=int, default=0,
+            help='Compression level, with the meaning given by the compression format. '
+                 'Default is 0, which uses the default level of the format.'
+        )
+        parser.add_argument(
+            '--adaptive-compression-level', action='store_true',
+            help='In message compression mode, lower the compression level down to '
+                 '--min-compression-level while the compression threads fall behind, and raise it '
+                 'back up to --compression-level while they keep up.'
+        )
+        parser.add_argument(
+            '--min-compression-level', type=int, default=1,
+            help='Lowest level used by --adaptive-compression-level, which also requires '
+                 'an explicit --compression-level. Default is 1.'
+        )
+        parser.add_argument(
+            '--compression-file-workers', type=int, default=0,
+            help='In file compression mode, number of worker threads shared by the files being '
+                 'compressed, so that a single large file is compressed in parallel. Only zstd '
+                 'uses workers. Default is 0, which compresses every file on one thread.'
+        )
+        parser.add_argument(
+            '--compression-seekable-frame-size', type=int, default=0,
+            help='In file compression mode, compress files as independent frames of this many '
+                 'uncompressed bytes followed by a seek table, so that readers decompress only '
+                 'the parts of a file they read. Only zstd writes seekable files. Default is 0, '
+                 'which compresses every file as a whole.'
+        )
+        parser.add_argument(
+            '--compression-policy', default='always', choices=['always', 'never', 'auto'],
+            help='In message compression mode, whether the messages of a topic are compressed. '
+                 '"auto" compresses the first --compression-policy-samples messages of every '
+                 'topic and stores the following ones uncompressed if they compressed by less '
+                 'than --compression-policy-min-ratio. Default is "always".'
+        )
+        parser.add_argument(
+            '--compression-topic-policy', type=str, metavar='TOPIC=POLICY', nargs='*',
+            help='Compression policy of single topics, overriding --compression-policy. '
+                 'e.g. --compression-topic-policy /camera/image/compressed=never'
+        )
+        parser.add_argument(
+            '--compression-policy-samples', type=int, default=16,
+            help='Number of messages per topic the "auto" compression policy decides on. '
+                 'Default is 16.'
+        )
+        parser.add_argument(
+            '--compression-policy-min-ratio', type=float, default=1.1,
+            help='Compression ratio below which the "auto" compression policy stores a topic '
+                 'uncompressed. Default is 1.1.'
+        )
         parser.add_argument(
             '--snapshot-mode', action='store_true',
             help='Enable snapshot mode. Messages will not be written to the bagfile until '
                  'the "/rosbag2_recorder/snapshot" service is called.'
         )
+        parser.add_argument(
+            '--snapshot-duration', type=int, default=0,
+            help='Number of seconds of history retained per topic in snapshot mode. '
+                 'The total size is still bounded by --max-cache-size. '
+                 'Default is 0, which keeps a single circular buffer shared by all topics.'
+        )
+        parser.add_argument(
+            '--snapshot-file-per-trigger', action='store_true',
+            help='Write every snapshot to a new bagfile instead of appending to the current one.'
+        )
         parser.add_argument(
             '--ignore-leaf-topics', action='store_true',
             help='Ignore topics without a publisher.'
@@ -175,6 +261,29 @@ class RecordVerb(VerbExtension):
             '--use-sim-time', action='store_true', default=False,
             help='Use simulation time.'
         )
+        parser.add_argument(
+            '--statistics-publish-period', type=int, default=0,
+            help='Period in milliseconds to publish write statistics, e.g. per-topic write '
+                 'latencies and throughput, on the ~/write_statistics topic of the recorder. '
+                 'Default is 0, which disables publishing.'
+        )
+        parser.add_argument(
+            '--storage-shards', type=int, default=1,
+            help='Number of storage instances to spread the recorded topics over. Each topic is '
+                 'written to one of them, so messages of different topics can be written in '
+                 'parallel. The bag is still read back as a single bag. Default is 1.'
+        )
+        parser.add_argument(
+            '--max-rate', type=str, metavar='TOPIC=HZ', nargs='*',
+            help='Maximum rate in Hz at which messages of a topic are recorded, e.g. '
+                 '/joint_states=100. Faster messages are dropped before being written. '
+                 'Can be given for several topics.'
+        )
+        parser.add_argument(
+            '--keep-every-n', type=str, metavar='TOPIC=N', nargs='*',
+            help='Only record every n-th message received on a topic, e.g. /tf=10. '
+                 'Can be given for several topics.'
+        )
         self._subparser = parser
 
     def main(self, *, args):  # noqa: D102
@@ -204,6 +313,90 @@ class RecordVerb(VerbExtension):
         if args.compression_queue_size < 0:
             return print_error('Compression queue size must be at least 0.')
 
+        if args.compression_chunk_size < 0:
+            return print_error('Compression chunk size must be at least 0.')
+
+        if args.compression_dictionary_samples < 0:
+            return print_error('Compression dictionary samples must be at least 0.')
+
+        if args.compression_file_workers < 0:
+            return print_error('Compression file workers must be at least 0.')
+
+        if args.compression_seekable_frame_size < 0:
+            return print_error('Compression seekable frame size must be at least 0.')
+
+        compression_topic_policies = {}
+        try:
+            for pair in args.compression_topic_policy or []:
+                topic, policy = pair.rsplit('=', 1)
+                compression_topic_policies[topic] = policy
+        except ValueError:
+            return print_error('--compression-topic-policy expects TOPIC=POLICY pairs.')
+        if any(policy not in ('always', 'never', 'auto')
+               for policy in compression_topic_policies.values()):
+            return print_error('Compression policies must be one of always, never or auto.')
+        uses_policies = args.compression_policy != 'always' or any(
+            policy != 'always' for policy in compression_topic_policies.values())
+        if uses_policies and args.compression_mode != 'message':
+            return print_error('Compression policies require message compression mode.')
+        if args.compression_policy_samples < 1:
+            return print_error('Compression policy samples must be at least 1.')
+
+        if args.adaptive_compression_level:
+            if args.compression_mode != 'message':
+                return print_error('--adaptive-compression-level requires message compression '
+                                   'mode.')
+            if args.compression_level == 0:
+                return print_error('--adaptive-compression-level requires a --compression-level '
+                                   'other than 0.')
+            if args.compression_level <= args.min_compression_level:
+                return print_error('--adaptive-compression-level requires a --compression-level '
+                                   'greater than --min-compression-level.')
+
+        if args.max_cache_spill_size < 0:
+            return print_error('Cache spill size must be at least 0.')
+
+        if args.max_cache_spill_size and args.snapshot_mode:
+            return print_error('--max-cache-spill-size cannot be used with --snapshot-mode')
+
+        if args.metadata_checkpoint_interval < 0:
+            return print_error('Metadata checkpoint interval must be at least 0.')
+
+        if args.snapshot_duration < 0:
+            return print_error('Snapshot duration must be at least 0.')
+
+        if args.snapshot_duration and not args.snapshot_mode:
+            return print_error('--snapshot-duration requires --snapshot-mode')
+
+        if args.snapshot_file_per_trigger and not args.snapshot_mode:
+            return print_error('--snapshot-file-per-trigger requires --snapshot-mode')
+
+        if args.statistics_publish_period < 0:
+            return print_error('Statistics publish period must be at least 0.')
+
+        topic_max_rates = {}
+        topic_keep_every_n = {}
+        try:
+            for pair in args.max_rate or []:
+                topic, rate = pair.rsplit('=', 1)
+                topic_max_rates[topic] = float(rate)
+            for pair in args.keep_every_n or []:
+                topic, n = pair.rsplit('=', 1)
+                topic_keep_every_n[topic] = int(n)
+        except ValueError:
+            return print_error('--max-rate and --keep-every-n expect TOPIC=VALUE pairs '
+                               'with numeric values.')
+        if any(rate <= 0 for rate in topic_max_rates.values()):
+            return print_error('Maximum rates must be greater than 0.')
+        if any(n < 1 for n in topic_keep_every_n.values()):
+            return print_error('--keep-every-n values must be at least 1.')
+
+        if args.storage_shards < 1:
+            return print_error('Number of storage shards must be at least 1.')
+
+        if args.storage_shards > 1 and args.compression_format:
+            return print_error('--storage-shards cannot be used with compression')
+
         args.compression_mode = args.compression_mode.upper()
 
         qos_profile_overrides = {}  # Specify a valid default
@@ -234,6 +427,10 @@ class RecordVerb(VerbExtension):
             storage_preset_profile=args.storage_preset_profile,
             storage_config_uri=storage_config_file,
             snapshot_mode=args.snapshot_mode,
+            snapshot_duration=args.snapshot_duration,
+            snapshot_file_per_trigger=args.snapshot_file_per_trigger,
+            max_cache_spill_size=args.max_cache_spill_size,
+            metadata_checkpoint_interval=args.metadata_checkpoint_interval,
             custom_data=custom_data
         )
         record_options = RecordOptions()
@@ -250,12 +447,28 @@ class RecordVerb(VerbExtension):
         record_options.compression_format = args.compression_format
         record_options.compression_queue_size = args.compression_queue_size
         record_options.compression_threads = args.compression_threads
+        record_options.compression_chunk_size = args.compression_chunk_size
+        record_options.compression_dictionary_samples = args.compression_dictionary_samples
+        record_options.compression_level = args.compression_level
+        record_options.adaptive_compression_level = args.adaptive_compression_level
+        record_options.min_compression_level = args.min_compression_level
+        record_options.compression_file_workers = args.compression_file_workers
+        record_options.compression_seekable_frame_size = args.compression_seekable_frame_size
+        record_options.compression_policy = args.compression_policy
+        record_options.compression_topic_policies = compression_topic_policies
+        record_options.compression_policy_samples = args.compression_policy_samples
+        record_options.compression_policy_min_ratio = args.compression_policy_min_ratio
         record_options.topic_qos_profile_overrides = qos_profile_overrides
         record_options.include_hidden_topics = args.include_hidden_topics
         record_options.include_unpublished_topics = args.include_unpublished_topics
         record_options.start_paused = args.start_paused
         record_options.ignore_leaf_topics = args.ignore_leaf_topics
         record_options.use_sim_time = args.use_sim_time
+        record_options.statistics_publish_period = datetime.timedelta(
+            milliseconds=args.statistics_publish_period)
+        record_options.storage_shards = args.storage_shards
+        record_options.topic_max_rates = topic_max_rates
+        record_options.topic_keep_every_n = topic_keep_every_n
 
         recorder = Recorder()
 
@@ -0,0 +1,90 @@
+// Copyright 2022, Open Source Robotics Corporation.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ROSBAG2_COMPRESSION__ADAPTIVE_COMPRESSION_LEVEL_HPP_
+#define ROSBAG2_COMPRESSION__ADAPTIVE_COMPRESSION_LEVEL_HPP_
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+
+#include "visibility_control.hpp"
+
+#ifdef _WIN32
+# pragma warning(push)
+# pragma warning(disable:4251)
+#endif
+
+namespace rosbag2_compression
+{
+
+/**
+ * Compression level of the MESSAGE compression mode, adapted to the load of the compression
+ * threads.
+ *
+ * The level is lowered quickly while the compression pipeline is filling up and raised one step at
+ * a time while it has headroom, so that messages are compressed as much as the CPU allows without
+ * the pipeline running full. It also counts the messages compressed with every level.
+ * All functions are safe to call from several threads at once.
+ */
+class ROSBAG2_COMPRESSION_PUBLIC AdaptiveCompressionLevel
+{
+public:
+  /// Number of updates between two level changes.
+  static constexpr uint64_t kUpdateInterval = 32;
+  /// Above this load, the level is lowered half way to min_level.
+  static constexpr double kHighLoad = 0.5;
+  /// Below this load, the level is raised by one.
+  static constexpr double kLowLoad = 0.125;
+
+  /**
+   * \param min_level Lowest level to use.
+   * \param max_level Highest level to use, and the initial one. If equal to min_level the level
+   *   is fixed and only the message counts are kept.
+   */
+  AdaptiveCompressionLevel(int32_t min_level, int32_t max_level);
+
+  /**
+   * Adjusts the level to the current load of the compression pipeline.
+   *
+   * \param load Fraction of the compression pipeline in use, between 0 and 1.
+   */
+  void update(double load);
+
+  /// The level to compress the next message with.
+  int32_t get_level() const;
+
+  /// Counts a message compressed with level.
+  void count_message(int32_t level);
+
+  /// Number of messages compressed with each level that was used at least once.
+  std::map<int32_t, uint64_t> get_message_counts() const;
+
+private:
+  const int32_t min_level_;
+  const int32_t max_level_;
+  std::atomic<int32_t> level_;
+  std::atomic<uint64_t> update_count_{0};
+  // Indexed by level - min_level_.
+  std::unique_ptr<std::atomic<uint64_t>[]> message_counts_;
+};
+
+}  // namespace rosbag2_compression
+
+#ifdef _WIN32
+# pragma warning(pop)
+#endif
+
+#endif  // ROSBAG2_COMPRESSION__ADAPTIVE_COMPRESSION_LEVEL_HPP_
@@ -15,7 +15,10 @@
 #ifndef ROSBAG2_COMPRESSION__BASE_COMPRESSOR_INTERFACE_HPP_
 #define ROSBAG2_COMPRESSION__BASE_COMPRESSOR_INTERFACE_HPP_
 
+#include <cstdint>
+#include <memory>
 #include <string>
+#include <vector>
 
 #include "rosbag2_storage/serialized_bag_message.hpp"
 
@@ -66,6 +69,70 @@ public:
     const rosbag2_storage::SerializedBagMessage * bag_message,
     rosbag2_storage::SerializedBagMessage * compressed_message) = 0;
 
+  /**
+   * Train a dictionary for compressing further messages of the topic of samples.
+   * Compressors that do not support dictionaries keep this default implementation.
+   *
+   * \param samples Uncompressed messages of one topic.
+   * \return The dictionary, or an empty vector if no dictionary could be trained.
+   */
+  virtual std::vector<uint8_t> train_dictionary(
+    const std::vector<std::shared_ptr<const rosbag2_storage::SerializedBagMessage>> & samples)
+  {
+    (void)samples;
+    return {};
+  }
+
+  /**
+   * Compress all further messages of a topic with a dictionary returned by train_dictionary.
+   *
+   * \param topic_name Topic the dictionary was trained for.
+   * \param dictionary The dictionary.
+   */
+  virtual void set_dictionary(
+    const std::string & topic_name, const std::vector<uint8_t> & dictionary)
+  {
+    (void)topic_name;
+    (void)dictionary;
+  }
+
+  /**
+   * Set the compression level of all further compression, with the meaning the algorithm gives it.
+   * Compressors without levels keep this default implementation.
+   *
+   * \param level The compression level.
+   * \throws std::invalid_argument if the level is out of the range of the algorithm.
+   */
+  virtual void set_compression_level(int32_t level)
+  {
+    (void)level;
+  }
+
+  /**
+   * Set the number of worker threads compress_uri compresses further files with, in addition to
+   * the calling thread. Messages are always compressed on the calling thread.
+   * Compressors without multithreading keep this default implementation.
+   *
+   * \param workers The number of worker threads, 0 to compress on the calling thread alone.
+   */
+  virtual void set_compression_workers(uint64_t workers)
+  {
+    (void)workers;
+  }
+
+  /**
+   * Make compress_uri write further files as independently compressed frames of the given
+   * uncompressed size, followed by a seek table, so that a decompressor can decompress parts of
+   * the file. Compressors without such a format keep this default implementation.
+   *
+   * \param frame_size Uncompressed bytes per frame, 0 to compress files as a whole.
+   * \throws std::invalid_argument if the frame size is too large for the format.
+   */
+  virtual void set_seekable_frame_size(uint64_t frame_size)
+  {
+    (void)frame_size;
+  }
+
   /**
    * Get the identifier of the compression algorithm.
    * This is appended to the extension of the compressed file.
@@ -15,9 +15,12 @@
 #ifndef ROSBAG2_COMPRESSION__BASE_DECOMPRESSOR_INTERFACE_HPP_
 #define ROSBAG2_COMPRESSION__BASE_DECOMPRESSOR_INTERFACE_HPP_
 
+#include <cstdint>
 #include <memory>
 #include <string>
+#include <vector>
 
+#include "rosbag2_storage/range_reader_interface.hpp"
 #include "rosbag2_storage/serialized_bag_message.hpp"
 
 #include "visibility_control.hpp"
@@ -58,14 +61,80 @@ public:
    */
   virtual std::string decompress_uri(const std::string & uri) = 0;
 
+  /**
+   * Decompress a file on disk into memory, so that it can be read without a temporary file.
+   * The default implementation does not support this.
+   *
+   * \param uri Input file to decompress with file extension.
+   * \param max_size Largest decompressed size to accept, in bytes.
+   * \param[out] buffer The decompressed file, if successful.
+   * \return false if the decompressed file would be larger than max_size or the decompressor can
+   *   only decompress to disk, in which case decompress_uri must be used instead.
+   */
+  virtual bool decompress_uri_to_buffer(
+    const std::string & uri, uint64_t max_size, std::vector<uint8_t> & buffer)
+  {
+    (void)uri;
+    (void)max_size;
+    (void)buffer;
+    return false;
+  }
+
+  /**
+   * Open a file on disk for reading ranges of its decompressed content, so that only the parts
+   * of the file which are read get decompressed. The default implementation does not support this.
+   *
+   * \param uri Input file to decompress with file extension.
+   * \return A range reader which is independent of this decompressor, or nullptr if the file can
+   *   only be decompressed as a whole.
+   */
+  virtual std::shared_ptr<rosbag2_storage::RangeReaderInterface> open_uri_for_range_reads(
+    const std::string & uri)
+  {
+    (void)uri;
+    return nullptr;
+  }
+
   /**
    * Decompress the serialized_data of a serialized bag message in place.
+   * The decompressed data may be held by another array than the compressed data, replacing it in
+   * the message, so that decompressors can reuse their output arrays.
    *
    * \param[in,out] bag_message A serialized bag message.
    */
   virtual void decompress_serialized_bag_message(
     rosbag2_storage::SerializedBagMessage * bag_message) = 0;
 
+  /**
+   * Check whether the serialized_data of a message is compressed data of this format. Writers
+   * store messages uncompressed only if this returns false for them, and readers decompress the
+   * messages of such topics only if it returns true. Must not depend on the state of the
+   * decompressor. The default implementation regards all messages as compressed.
+   *
+   * \param bag_message A serialized bag message.
+   * \return true if the message is to be decompressed.
+   */
+  virtual bool is_compressed_message(const rosbag2_storage::SerializedBagMessage & bag_message)
+  const
+  {
+    (void)bag_message;
+    return true;
+  }
+
+  /**
+   * Make a dictionary, trained by the matching compressor, available for decompressing messages.
+   * Must be called for all dictionaries of a bag before its messages are decompressed.
+   *
+   * \param topic_name Topic the dictionary was trained for.
+   * \param dictionary The dictionary.
+   */
+  virtual void add_dictionary(
+    const std::string & topic_name, const std::vector<uint8_t> & dictionary)
+  {
+    (void)topic_name;
+    (void)dictionary;
+  }
+
   /**
    * Get the identifier of the compression algorithm. This is appended to the extension of the
    * compressed file.
@@ -0,0 +1,218 @@
+// Copyright 2022, Open Source Robotics Corporation.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ROSBAG2_COMPRESSION__CHUNK_COMPRESSION_STORAGE_HPP_
+#define ROSBAG2_COMPRESSION__CHUNK_COMPRESSION_STORAGE_HPP_
+
+#include <deque>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "rosbag2_storage/bag_metadata.hpp"
+#include "rosbag2_storage/serialized_bag_message.hpp"
+#include "rosbag2_storage/storage_factory_interface.hpp"
+#include "rosbag2_storage/storage_filter.hpp"
+#include "rosbag2_storage/storage_interfaces/read_only_interface.hpp"
+#include "rosbag2_storage/storage_interfaces/read_write_interface.hpp"
+#include "rosbag2_storage/topic_metadata.hpp"
+
+#include "base_compressor_interface.hpp"
+#include "base_decompressor_interface.hpp"
+#include "compression_statistics_collector.hpp"
+#include "visibility_control.hpp"
+
+#ifdef _WIN32
+# pragma warning(push)
+# pragma warning(disable:4251)
+#endif
+
+namespace rosbag2_compression
+{
+
+/// Topic under which the storage keeps the compressed chunks of a CHUNK compressed bag.
+ROSBAG2_COMPRESSION_PUBLIC extern const char kCompressedChunkTopic[];
+
+/**
+ * Storage decorator used by the CHUNK compression mode.
+ *
+ * Consecutive messages are serialized into one chunk and compressed as a single frame, which is
+ * then written to the wrapped storage as one message on kCompressedChunkTopic. The chunk's
+ * timestamp is the latest timestamp of its messages, so that seeking in the wrapped storage
+ * lands on the chunk holding the first message at or after the requested time.
+ */
+class ROSBAG2_COMPRESSION_PUBLIC ChunkCompressingStorage
+  : public rosbag2_storage::storage_interfaces::ReadWriteInterface
+{
+public:
+  /**
+   * \param storage The storage receiving the compressed chunks.
+   * \param compressor Compression context used for all chunks of this storage.
+   * \param chunk_size Uncompressed size in bytes at which a chunk is compressed and written.
+   *   If 0, every call to write() produces one chunk, i.e. one chunk per cache flush.
+   * \param statistics Receives the compression of every chunk under the empty topic name,
+   *   may be null.
+   */
+  ChunkCompressingStorage(
+    std::shared_ptr<rosbag2_storage::storage_interfaces::ReadWriteInterface> storage,
+    std::shared_ptr<BaseCompressorInterface> compressor,
+    uint64_t chunk_size,
+    std::shared_ptr<CompressionStatisticsCollector> statistics = nullptr);
+
+  /// Writes the last, partially filled, chunk.
+  ~ChunkCompressingStorage() override;
+
+  void open(
+    const rosbag2_storage::StorageOptions & storage_options,
+    rosbag2_storage::storage_interfaces::IOFlag io_flag) override;
+
+  void write(std::shared_ptr<const rosbag2_storage::SerializedBagMessage> message) override;
+
+  void write(
+    const std::vector<std::shared_ptr<const rosbag2_storage::SerializedBagMessage>> & messages)
+  override;
+
+  void create_topic(const rosbag2_storage::TopicMetadata & topic) override;
+
+  void remove_topic(const rosbag2_storage::TopicMetadata & topic) override;
+
+  bool has_next() override;
+
+  std::shared_ptr<rosbag2_storage::SerializedBagMessage> read_next() override;
+
+  std::vector<rosbag2_storage::TopicMetadata> get_all_topics_and_types() override;
+
+  rosbag2_storage::BagMetadata get_metadata() override;
+
+  std::string get_relative_file_path() const override;
+
+  uint64_t get_bagfile_size() const override;
+
+  uint64_t get_bagfile_size_estimate() const override;
+
+  std::string get_storage_identifier() const override;
+
+  uint64_t get_minimum_split_file_size() const override;
+
+  void set_filter(const rosbag2_storage::StorageFilter & storage_filter) override;
+
+  void reset_filter() override;
+
+  void seek(const rcutils_time_point_value_t & timestamp) override;
+
+  /// Compresses and writes the messages collected so far, if any.
+  void flush_chunk();
+
+private:
+  void append_to_chunk(const rosbag2_storage::SerializedBagMessage & message);
+
+  std::shared_ptr<rosbag2_storage::storage_interfaces::ReadWriteInterface> storage_;
+  std::shared_ptr<BaseCompressorInterface> compressor_;
+  const uint64_t chunk_size_;
+  std::shared_ptr<CompressionStatisticsCollector> statistics_;
+  std::vector<uint8_t> chunk_;
+  rcutils_time_point_value_t chunk_time_stamp_{0};
+  bool chunk_topic_created_{false};
+};
+
+/**
+ * Storage decorator reading bags written by ChunkCompressingStorage.
+ *
+ * Chunks are decompressed in memory one at a time and their messages are handed out in the order
+ * in which they were written. Topic filters and seek times are applied to the unpacked messages.
+ */
+class ROSBAG2_COMPRESSION_PUBLIC ChunkDecompressingStorage
+  : public rosbag2_storage::storage_interfaces::ReadOnlyInterface
+{
+public:
+  ChunkDecompressingStorage(
+    std::shared_ptr<rosbag2_storage::storage_interfaces::ReadOnlyInterface> storage,
+    std::shared_ptr<BaseDecompressorInterface> decompressor);
+
+  void open(
+    const rosbag2_storage::StorageOptions & storage_options,
+    rosbag2_storage::storage_interfaces::IOFlag io_flag) override;
+
+  bool has_next() override;
+
+  std::shared_ptr<rosbag2_storage::SerializedBagMessage> read_next() override;
+
+  std::vector<rosbag2_storage::TopicMetadata> get_all_topics_and_types() override;
+
+  rosbag2_storage::BagMetadata get_metadata() override;
+
+  std::string get_relative_file_path() const override;
+
+  uint64_t get_bagfile_size() const override;
+
+  std::string get_storage_identifier() const override;
+
+  void set_filter(const rosbag2_storage::StorageFilter & storage_filter) override;
+
+  void reset_filter() override;
+
+  void seek(const rcutils_time_point_value_t & timestamp) override;
+
+private:
+  // Unpacks chunks until a message passing the filter and seek time is available.
+  void fill_pending_messages();
+  bool is_wanted(const rosbag2_storage::SerializedBagMessage & message) const;
+
+  std::shared_ptr<rosbag2_storage::storage_interfaces::ReadOnlyInterface> storage_;
+  std::shared_ptr<BaseDecompressorInterface> decompressor_;
+  std::deque<std::shared_ptr<rosbag2_storage::SerializedBagMessage>> pending_messages_;
+  rosbag2_storage::StorageFilter storage_filter_;
+  rcutils_time_point_value_t seek_time_;
+};
+
+/// Storage factory wrapping every opened storage in the matching chunk decorator.
+class ROSBAG2_COMPRESSION_PUBLIC ChunkCompressionStorageFactory
+  : public rosbag2_storage::StorageFactoryInterface
+{
+public:
+  /**
+   * \param storage_factory Factory opening the wrapped storages.
+   * \param compressor Used by storages opened for writing; may be null when only reading.
+   * \param decompressor Used by storages opened for reading; may be null when only writing.
+   * \param chunk_size See ChunkCompressingStorage.
+   * \param statistics See ChunkCompressingStorage.
+   */
+  ChunkCompressionStorageFactory(
+    std::unique_ptr<rosbag2_storage::StorageFactoryInterface> storage_factory,
+    std::shared_ptr<BaseCompressorInterface> compressor,
+    std::shared_ptr<BaseDecompressorInterface> decompressor,
+    uint64_t chunk_size,
+    std::shared_ptr<CompressionStatisticsCollector> statistics = nullptr);
+
+  std::shared_ptr<rosbag2_storage::storage_interfaces::ReadOnlyInterface>
+  open_read_only(const rosbag2_storage::StorageOptions & storage_options) override;
+
+  std::shared_ptr<rosbag2_storage::storage_interfaces::ReadWriteInterface>
+  open_read_write(const rosbag2_storage::StorageOptions & storage_options) override;
+
+private:
+  std::unique_ptr<rosbag2_storage::StorageFactoryInterface> storage_factory_;
+  std::shared_ptr<BaseCompressorInterface> compressor_;
+  std::shared_ptr<BaseDecompressorInterface> decompressor_;
+  const uint64_t chunk_size_;
+  std::shared_ptr<CompressionStatisticsCollector> statistics_;
+};
+
+}  // namespace rosbag2_compression
+
+#ifdef _WIN32
+# pragma warning(pop)
+#endif
+
+#endif  // ROSBAG2_COMPRESSION__CHUNK_COMPRESSION_STORAGE_HPP_
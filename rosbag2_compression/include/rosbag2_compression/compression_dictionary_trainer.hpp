@@ -0,0 +1,101 @@
+// Copyright 2022, Open Source Robotics Corporation.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ROSBAG2_COMPRESSION__COMPRESSION_DICTIONARY_TRAINER_HPP_
+#define ROSBAG2_COMPRESSION__COMPRESSION_DICTIONARY_TRAINER_HPP_
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "rosbag2_storage/serialized_bag_message.hpp"
+
+#include "base_compressor_interface.hpp"
+#include "visibility_control.hpp"
+
+#ifdef _WIN32
+# pragma warning(push)
+# pragma warning(disable:4251)
+#endif
+
+namespace rosbag2_compression
+{
+
+/**
+ * Trains one compression dictionary per topic from the first messages of the topic, for the
+ * MESSAGE compression mode.
+ *
+ * A trainer is shared by all compression threads of a writer. The thread adding the last sample
+ * of a topic trains the dictionary with its own compressor. Every compressor picks the new
+ * dictionaries up through apply_new_dictionaries() before compressing its next message, so
+ * messages compressed before that stay readable without a dictionary.
+ */
+class ROSBAG2_COMPRESSION_PUBLIC CompressionDictionaryTrainer
+{
+public:
+  using MessageSharedPtr = std::shared_ptr<const rosbag2_storage::SerializedBagMessage>;
+  /// Called once for every trained dictionary, to store it with the bag.
+  using DictionaryCallback = std::function<
+    void (const std::string & topic_name, const std::vector<uint8_t> & dictionary)>;
+
+  /**
+   * \param num_samples Number of messages per topic to train the topic's dictionary on.
+   * \param on_dictionary_trained Receives every dictionary before compressors start using it.
+   */
+  CompressionDictionaryTrainer(uint64_t num_samples, DictionaryCallback on_dictionary_trained);
+
+  /**
+   * Keeps an uncompressed message as training sample, unless its topic has enough samples already.
+   * Safe to call from several threads at once.
+   *
+   * \param message The uncompressed message.
+   * \param compressor Trains the dictionary if this was the last sample missing for the topic.
+   */
+  void add_sample(MessageSharedPtr message, BaseCompressorInterface & compressor);
+
+  /**
+   * Hands the dictionaries trained since the previous call to a compressor.
+   *
+   * \param compressor The compressor to update.
+   * \param applied_count Number of dictionaries the compressor already has; updated by the call.
+   */
+  void apply_new_dictionaries(BaseCompressorInterface & compressor, size_t & applied_count) const;
+
+private:
+  const uint64_t num_samples_;
+  const DictionaryCallback on_dictionary_trained_;
+
+  mutable std::mutex mutex_;
+  std::unordered_map<std::string, std::vector<MessageSharedPtr>> samples_;
+  // Topics which are trained or being trained, and take no more samples.
+  std::unordered_set<std::string> complete_topics_;
+  std::vector<std::pair<std::string, std::vector<uint8_t>>> dictionaries_;
+  // Size of dictionaries_, readable without taking the mutex.
+  std::atomic<size_t> dictionary_count_{0};
+};
+
+}  // namespace rosbag2_compression
+
+#ifdef _WIN32
+# pragma warning(pop)
+#endif
+
+#endif  // ROSBAG2_COMPRESSION__COMPRESSION_DICTIONARY_TRAINER_HPP_
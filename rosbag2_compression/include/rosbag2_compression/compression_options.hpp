@@ -15,7 +15,9 @@
 #ifndef ROSBAG2_COMPRESSION__COMPRESSION_OPTIONS_HPP_
 #define ROSBAG2_COMPRESSION__COMPRESSION_OPTIONS_HPP_
 
+#include <cstdint>
 #include <string>
+#include <unordered_map>
 
 #include "visibility_control.hpp"
 
@@ -23,7 +25,8 @@ namespace rosbag2_compression
 {
 
 /**
- * Modes are used to specify whether to compress by individual serialized bag messages or by file.
+ * Modes are used to specify whether to compress by individual serialized bag messages, by chunks
+ * of consecutive messages or by file.
  * rosbag2_cpp defaults to NONE.
  */
 enum class ROSBAG2_COMPRESSION_PUBLIC CompressionMode: uint32_t
@@ -31,14 +34,15 @@ enum class ROSBAG2_COMPRESSION_PUBLIC CompressionMode: uint32_t
   NONE = 0,
   FILE,
   MESSAGE,
-  LAST_MODE = MESSAGE
+  CHUNK,
+  LAST_MODE = CHUNK
 };
 
 /**
  * Converts a string into a rosbag2_compression::CompressionMode enum.
  *
- * \param compression_mode A case insensitive string that is either "FILE" or "MESSAGE".
- * \return CompressionMode NONE if compression_mode is invalid. FILE or MESSAGE otherwise.
+ * \param compression_mode A case insensitive string that is either "FILE", "MESSAGE" or "CHUNK".
+ * \return CompressionMode NONE if compression_mode is invalid. FILE, MESSAGE or CHUNK otherwise.
  */
 ROSBAG2_COMPRESSION_PUBLIC CompressionMode compression_mode_from_string(
   const std::string & compression_mode);
@@ -51,6 +55,40 @@ ROSBAG2_COMPRESSION_PUBLIC CompressionMode compression_mode_from_string(
  */
 ROSBAG2_COMPRESSION_PUBLIC std::string compression_mode_to_string(CompressionMode compression_mode);
 
+/**
+ * Policies are used to specify whether the messages of a topic are compressed in MESSAGE mode.
+ * AUTO compresses the first messages of a topic and stores the following ones uncompressed if
+ * those did not compress well, e.g. for already compressed images or video.
+ */
+enum class ROSBAG2_COMPRESSION_PUBLIC TopicCompressionPolicy: uint32_t
+{
+  ALWAYS = 0,
+  NEVER,
+  AUTO,
+  LAST_POLICY = AUTO
+};
+
+/**
+ * Converts a string into a rosbag2_compression::TopicCompressionPolicy enum.
+ *
+ * \param policy A case insensitive string that is either "ALWAYS", "NEVER" or "AUTO".
+ * \return TopicCompressionPolicy ALWAYS if policy is empty or invalid, the named policy otherwise.
+ */
+ROSBAG2_COMPRESSION_PUBLIC TopicCompressionPolicy topic_compression_policy_from_string(
+  const std::string & policy);
+
+/**
+ * Converts a rosbag2_compression::TopicCompressionPolicy enum into a string.
+ *
+ * \param policy A TopicCompressionPolicy enum.
+ * \return The corresponding policy as a string.
+ */
+ROSBAG2_COMPRESSION_PUBLIC std::string topic_compression_policy_to_string(
+  TopicCompressionPolicy policy);
+
+/// Default chunk size of the CHUNK compression mode.
+constexpr uint64_t kDefaultCompressionChunkSize = 1024 * 1024;
+
 /**
  * Compression options used in the writer which are passed down from the CLI in rosbag2_transport.
  */
@@ -60,6 +98,35 @@ struct CompressionOptions
   CompressionMode compression_mode;
   uint64_t compression_queue_size;
   uint64_t compression_threads;
+  // Uncompressed size in bytes of the chunks written in CHUNK mode. If 0, one chunk is written
+  // per cache flush.
+  uint64_t compression_chunk_size = kDefaultCompressionChunkSize;
+  // Number of messages per topic to train a compression dictionary on in MESSAGE mode, for
+  // compressors supporting dictionaries. If 0, messages are compressed without dictionaries.
+  uint64_t compression_dictionary_samples = 0;
+  // Compression level, with the meaning the compressor gives it. If 0, the compressor's default
+  // level is used.
+  int32_t compression_level = 0;
+  // In MESSAGE mode, lower the level down to min_compression_level while the compression threads
+  // fall behind, and raise it back up to compression_level while they keep up. Requires a
+  // compression_level other than 0.
+  bool adaptive_compression_level = false;
+  int32_t min_compression_level = 1;
+  // In FILE mode, number of worker threads each file is compressed with, shared between the files
+  // compressed at the same time, for compressors supporting it. If 0, every file is compressed on
+  // its compression thread alone.
+  uint64_t compression_file_workers = 0;
+  // In FILE mode, uncompressed size in bytes of the independently compressed frames of seekable
+  // files, for compressors supporting it. Readers decompress only the frames they read from.
+  // If 0, files are compressed as a whole.
+  uint64_t compression_seekable_frame_size = 0;
+  // In MESSAGE mode, policy of the topics without an entry in compression_topic_policies.
+  TopicCompressionPolicy compression_policy = TopicCompressionPolicy::ALWAYS;
+  std::unordered_map<std::string, TopicCompressionPolicy> compression_topic_policies{};
+  // Number of messages per topic compressed by the AUTO policy to decide on, and the ratio of
+  // uncompressed to compressed size below which the following messages are stored uncompressed.
+  uint64_t compression_policy_samples = 16;
+  double compression_policy_min_ratio = 1.1;
 };
 
 }  // namespace rosbag2_compression
@@ -0,0 +1,84 @@
+// Copyright 2022, Open Source Robotics Corporation.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ROSBAG2_COMPRESSION__COMPRESSION_STATISTICS_COLLECTOR_HPP_
+#define ROSBAG2_COMPRESSION__COMPRESSION_STATISTICS_COLLECTOR_HPP_
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "rosbag2_storage/bag_metadata.hpp"
+
+#include "visibility_control.hpp"
+
+#ifdef _WIN32
+# pragma warning(push)
+# pragma warning(disable:4251)
+#endif
+
+namespace rosbag2_compression
+{
+
+/**
+ * Sums up the bytes in and out of the compressors and the time they took, by topic.
+ *
+ * The sums are split into shards picked by the calling thread, so that compression threads
+ * adding to them at the same time rarely wait for each other. All functions are safe to call from
+ * several threads at once.
+ */
+class ROSBAG2_COMPRESSION_PUBLIC CompressionStatisticsCollector
+{
+public:
+  /// Number of shards, more than the usual number of compression threads.
+  static constexpr size_t kNumShards = 16;
+
+  /**
+   * Adds one compression.
+   *
+   * \param topic Topic of the compressed data, empty if it holds several topics.
+   * \param input_bytes Size of the data before compression.
+   * \param output_bytes Size of the data after compression.
+   * \param compression_time Time the compression took.
+   */
+  void add(
+    const std::string & topic,
+    uint64_t input_bytes,
+    uint64_t output_bytes,
+    std::chrono::nanoseconds compression_time);
+
+  /// Sums of all compressions added so far, by topic.
+  std::map<std::string, rosbag2_storage::CompressionStatistics> get_statistics() const;
+
+private:
+  struct Shard
+  {
+    mutable std::mutex mutex;
+    std::unordered_map<std::string, rosbag2_storage::CompressionStatistics> statistics;
+  };
+
+  std::array<Shard, kNumShards> shards_;
+};
+
+}  // namespace rosbag2_compression
+
+#ifdef _WIN32
+# pragma warning(pop)
+#endif
+
+#endif  // ROSBAG2_COMPRESSION__COMPRESSION_STATISTICS_COLLECTOR_HPP_
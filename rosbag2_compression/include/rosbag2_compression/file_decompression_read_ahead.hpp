@@ -0,0 +1,124 @@
+// Copyright 2022, Open Source Robotics Corporation.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ROSBAG2_COMPRESSION__FILE_DECOMPRESSION_READ_AHEAD_HPP_
+#define ROSBAG2_COMPRESSION__FILE_DECOMPRESSION_READ_AHEAD_HPP_
+
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "visibility_control.hpp"
+
+#ifdef _WIN32
+# pragma warning(push)
+# pragma warning(disable:4251)
+#endif
+
+namespace rosbag2_compression
+{
+
+/**
+ * Files of a FILE compressed bag decompressed on a background thread ahead of a reader.
+ *
+ * When the reader takes a file, the following files up to the read ahead count are decompressed
+ * in order, so that the next file is usually ready by the time the reader reaches it. At most
+ * num_files files are held besides the one being taken, which bounds the memory and disk space
+ * used. Files decompressed to disk which are dropped without being taken are removed.
+ *
+ * take() is meant to be called from a single reader thread.
+ */
+class ROSBAG2_COMPRESSION_PUBLIC FileDecompressionReadAhead
+{
+public:
+  struct DecompressedFile
+  {
+    // Content of the file if it was decompressed into memory, otherwise nullptr.
+    std::shared_ptr<std::vector<uint8_t>> buffer;
+    // Path of the file if it was decompressed to disk, otherwise empty.
+    std::string uri;
+  };
+
+  /// Decompresses the file at a compressed uri into memory or to disk.
+  using DecompressFunction = std::function<DecompressedFile(const std::string & uri)>;
+
+  /**
+   * Starts the decompression thread, which waits for the first take().
+   *
+   * \param uris Compressed files in the order in which they are read.
+   * \param num_files Number of files decompressed ahead of the file taken last.
+   * \param decompress Decompresses a file, called on the decompression thread only.
+   */
+  FileDecompressionReadAhead(
+    std::vector<std::string> uris,
+    uint64_t num_files,
+    DecompressFunction decompress);
+
+  /// Stops the thread, removing the files decompressed to disk that were not taken.
+  ~FileDecompressionReadAhead();
+
+  /**
+   * Waits until a file is decompressed and takes it. The files following it are decompressed
+   * next, files before it or further ahead are dropped, e.g. after seeking back.
+   * Files decompressed to disk belong to the caller once taken.
+   *
+   * \param uri Compressed file to take.
+   * \param[out] file The decompressed file.
+   * \return false if uri is not one of the files of the read ahead.
+   * \throws Anything thrown while decompressing the file.
+   */
+  bool take(const std::string & uri, DecompressedFile & file);
+
+private:
+  struct Entry
+  {
+    DecompressedFile file;
+    bool is_started{false};
+    bool is_decompressed{false};
+    // Dropped while being decompressed, the decompression thread cleans up after it.
+    bool is_dropped{false};
+    std::exception_ptr error;
+  };
+
+  void decompression_thread_fn();
+  static void remove_file(const DecompressedFile & file);
+
+  const std::vector<std::string> uris_;
+  const uint64_t num_files_;
+  const DecompressFunction decompress_;
+
+  std::mutex mutex_;
+  std::condition_variable jobs_available_;
+  std::condition_variable file_decompressed_;
+  // Files of the current window by their index in uris_, decompressed in ascending order.
+  std::map<size_t, std::shared_ptr<Entry>> window_;
+  bool is_running_{true};
+
+  std::thread decompression_thread_;
+};
+
+}  // namespace rosbag2_compression
+
+#ifdef _WIN32
+# pragma warning(pop)
+#endif
+
+#endif  // ROSBAG2_COMPRESSION__FILE_DECOMPRESSION_READ_AHEAD_HPP_
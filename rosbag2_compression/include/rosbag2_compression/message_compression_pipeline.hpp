@@ -0,0 +1,189 @@
+// Copyright 2022, Open Source Robotics Corporation.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ROSBAG2_COMPRESSION__MESSAGE_COMPRESSION_PIPELINE_HPP_
+#define ROSBAG2_COMPRESSION__MESSAGE_COMPRESSION_PIPELINE_HPP_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "rosbag2_storage/serialized_bag_message.hpp"
+
+#include "visibility_control.hpp"
+
+#ifdef _WIN32
+# pragma warning(push)
+# pragma warning(disable:4251)
+#endif
+
+namespace rosbag2_compression
+{
+
+/**
+ * Sequenced pipeline used to compress messages on several threads while keeping the order in
+ * which they were pushed.
+ *
+ * Every pushed message is tagged with a sequence number and placed in a bounded lock-free job
+ * ring. Compression threads take jobs from the ring and publish their results into a reorder
+ * buffer slot owned by that sequence number. A single writer stage drains the reorder buffer
+ * strictly in sequence order and is the only place that hands messages to storage, so the
+ * compression threads never contend on storage and the output keeps the input order.
+ */
+class ROSBAG2_COMPRESSION_PUBLIC MessageCompressionPipeline
+{
+public:
+  using MessageSharedPtr = std::shared_ptr<const rosbag2_storage::SerializedBagMessage>;
+  using CompressFunction = std::function<MessageSharedPtr(MessageSharedPtr)>;
+  /// Called once on every compression thread to create its own compression context.
+  using CompressFunctionFactory = std::function<CompressFunction()>;
+  using WriteFunction = std::function<void(MessageSharedPtr)>;
+
+  /**
+   * Starts the compression threads and the writer stage.
+   *
+   * \param num_threads Number of compression threads; at least one thread is started.
+   * \param queue_size Number of messages that may wait for a compression thread. If 0, push()
+   *   blocks while the pipeline is full. Otherwise the oldest waiting message is dropped to make
+   *   room for the new one.
+   * \param make_compress_function Creates the compression function of each thread.
+   * \param write_function Receives every compressed message, in push order, from one thread.
+   */
+  MessageCompressionPipeline(
+    uint64_t num_threads,
+    uint64_t queue_size,
+    CompressFunctionFactory make_compress_function,
+    WriteFunction write_function);
+
+  /// Flushes all pending messages and stops the threads.
+  ~MessageCompressionPipeline();
+
+  /**
+   * Adds a message to the pipeline. Safe to call from several threads at once, and concurrently
+   * with stop().
+   *
+   * \param message The message to compress and write.
+   * \returns false if the message had to be dropped because the writer stage is falling behind
+   *   or the pipeline is stopping.
+   */
+  bool push(MessageSharedPtr message);
+
+  /// Stops accepting messages, waits until every accepted message has been written or dropped,
+  /// then stops all threads.
+  void stop();
+
+  /// Number of messages that were dropped instead of written.
+  uint64_t get_dropped_count() const;
+
+  /// Fraction of the pipeline taken by messages pushed but not written yet, between 0 and 1.
+  double get_load() const;
+
+private:
+  struct Job
+  {
+    uint64_t sequence{0};
+    MessageSharedPtr message;
+  };
+
+  /// Bounded multi-producer multi-consumer ring of jobs; see D. Vyukov's bounded MPMC queue.
+  class JobRing
+  {
+public:
+    explicit JobRing(size_t capacity);
+
+    /// Moves from job only if it was pushed.
+    bool try_push(Job & job);
+    bool try_pop(Job & job);
+    bool can_push() const;
+    bool can_pop() const;
+
+private:
+    struct Cell
+    {
+      std::atomic<uint64_t> turn;
+      Job job;
+    };
+
+    const size_t capacity_;
+    std::unique_ptr<Cell[]> cells_;
+    std::atomic<uint64_t> enqueue_position_{0};
+    std::atomic<uint64_t> dequeue_position_{0};
+  };
+
+  /// Reorder buffer entry; `ready` holds sequence + 1 once the result for sequence is in place.
+  struct ResultSlot
+  {
+    std::atomic<uint64_t> ready{0};
+    MessageSharedPtr message;
+  };
+
+  bool push_job(MessageSharedPtr message);
+
+  void compression_thread_fn();
+  void writer_thread_fn();
+
+  bool reserve_sequence(uint64_t & sequence);
+  void publish_result(uint64_t sequence, MessageSharedPtr message);
+  bool result_ready(uint64_t sequence) const;
+
+  // Parking used only when a stage has nothing to do; the data path itself takes no locks.
+  void notify(std::condition_variable & condition, const std::atomic<uint32_t> & waiters);
+  template<typename PredicateT>
+  void park(
+    std::condition_variable & condition, std::atomic<uint32_t> & waiters, PredicateT predicate);
+
+  const uint64_t queue_size_;
+  const uint64_t window_size_;
+  const CompressFunctionFactory make_compress_function_;
+  const WriteFunction write_function_;
+
+  JobRing jobs_;
+  std::unique_ptr<ResultSlot[]> results_;
+
+  std::atomic<uint64_t> next_sequence_{0};
+  std::atomic<uint64_t> written_sequence_{0};
+  std::atomic<uint64_t> dropped_count_{0};
+  // Cleared by stop(), which then waits for the pushes that are past the check to finish.
+  std::atomic_bool accepts_messages_{true};
+  std::atomic<uint32_t> active_pushes_{0};
+  std::atomic_bool compression_is_running_{true};
+  std::atomic_bool writer_is_running_{true};
+
+  std::mutex park_mutex_;
+  std::condition_variable jobs_available_;
+  std::condition_variable results_available_;
+  std::condition_variable space_available_;
+  std::condition_variable pushes_finished_;
+  std::atomic<uint32_t> compression_waiters_{0};
+  std::atomic<uint32_t> writer_waiters_{0};
+  std::atomic<uint32_t> producer_waiters_{0};
+  std::atomic<uint32_t> stop_waiters_{0};
+
+  std::vector<std::thread> compression_threads_;
+  std::thread writer_thread_;
+  std::mutex stop_mutex_;
+};
+
+}  // namespace rosbag2_compression
+
+#ifdef _WIN32
+# pragma warning(pop)
+#endif
+
+#endif  // ROSBAG2_COMPRESSION__MESSAGE_COMPRESSION_PIPELINE_HPP_
@@ -0,0 +1,130 @@
+// Copyright 2022, Open Source Robotics Corporation.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ROSBAG2_COMPRESSION__MESSAGE_DECOMPRESSION_READ_AHEAD_HPP_
+#define ROSBAG2_COMPRESSION__MESSAGE_DECOMPRESSION_READ_AHEAD_HPP_
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "rosbag2_storage/serialized_bag_message.hpp"
+
+#include "visibility_control.hpp"
+
+#ifdef _WIN32
+# pragma warning(push)
+# pragma warning(disable:4251)
+#endif
+
+namespace rosbag2_compression
+{
+
+/**
+ * Window of messages decompressed on several threads ahead of a reader.
+ *
+ * The reader pushes compressed messages in the order in which they were read while the window is
+ * not full, and pops them in the same order once they are decompressed. The window is measured in
+ * bytes of the messages it holds, compressed or decompressed, so that its memory stays bounded
+ * however well the messages compress.
+ *
+ * push(), pop() and the other functions are meant to be called from a single reader thread.
+ */
+class ROSBAG2_COMPRESSION_PUBLIC MessageDecompressionReadAhead
+{
+public:
+  using MessageSharedPtr = std::shared_ptr<rosbag2_storage::SerializedBagMessage>;
+  /// Decompresses a message in place.
+  using DecompressFunction = std::function<void(rosbag2_storage::SerializedBagMessage *)>;
+  /// Called once on every decompression thread to create its own decompression context.
+  using DecompressFunctionFactory = std::function<DecompressFunction()>;
+
+  /**
+   * Starts the decompression threads.
+   *
+   * \param num_threads Number of decompression threads; at least one thread is started.
+   * \param window_size Size in bytes of the messages held by the window before it is full.
+   * \param make_decompress_function Creates the decompression function of each thread.
+   */
+  MessageDecompressionReadAhead(
+    uint64_t num_threads,
+    uint64_t window_size,
+    DecompressFunctionFactory make_decompress_function);
+
+  /// Stops the threads, dropping the messages in the window.
+  ~MessageDecompressionReadAhead();
+
+  /// Adds a compressed message to the end of the window, which is decompressed in the background.
+  void push(MessageSharedPtr message);
+
+  /// Whether the window holds window_size bytes or more; it is never full while empty.
+  bool is_full() const;
+
+  bool empty() const;
+
+  /**
+   * Waits until the first message in the window is decompressed and takes it out.
+   *
+   * \throws std::runtime_error if the window is empty.
+   * \throws Anything thrown while decompressing the message.
+   */
+  MessageSharedPtr pop();
+
+  /// Drops the messages in the window for which predicate returns true.
+  void remove_if(
+    const std::function<bool(const rosbag2_storage::SerializedBagMessage &)> & predicate);
+
+  /// Drops all messages in the window.
+  void clear();
+
+private:
+  struct Entry
+  {
+    MessageSharedPtr message;
+    size_t size{0};
+    bool is_decompressed{false};
+    bool in_window{true};
+    std::exception_ptr error;
+  };
+
+  void decompression_thread_fn();
+  void remove_from_window(Entry & entry);
+
+  const uint64_t window_size_;
+  const DecompressFunctionFactory make_decompress_function_;
+
+  mutable std::mutex mutex_;
+  std::condition_variable jobs_available_;
+  std::condition_variable message_decompressed_;
+  std::deque<std::shared_ptr<Entry>> jobs_;
+  std::deque<std::shared_ptr<Entry>> window_;
+  uint64_t window_bytes_{0};
+  bool is_running_{true};
+
+  std::vector<std::thread> decompression_threads_;
+};
+
+}  // namespace rosbag2_compression
+
+#ifdef _WIN32
+# pragma warning(pop)
+#endif
+
+#endif  // ROSBAG2_COMPRESSION__MESSAGE_DECOMPRESSION_READ_AHEAD_HPP_
@@ -17,10 +17,12 @@
 
 #include <memory>
 #include <string>
+#include <unordered_set>
 #include <vector>
 
 #include "rosbag2_compression/base_decompressor_interface.hpp"
 #include "rosbag2_compression/compression_options.hpp"
+#include "rosbag2_compression/message_decompression_read_ahead.hpp"
 
 #include "rosbag2_cpp/converter.hpp"
 #include "rosbag2_cpp/readers/sequential_reader.hpp"
@@ -65,17 +67,35 @@ public:
     const rosbag2_storage::StorageOptions & storage_options,
     const rosbag2_cpp::ConverterOptions & converter_options) override;
 
+  void close() override;
+
+  bool has_next() override;
+
+  /**
+   * Reads the next message and decompresses it if the bag is compressed by message.
+   *
+   * With StorageOptions::decompression_threads set, messages are read and decompressed ahead in
+   * a window of StorageOptions::decompression_read_ahead_size bytes, and handed out in order.
+   */
   std::shared_ptr<rosbag2_storage::SerializedBagMessage> read_next() override;
 
+  void set_filter(const rosbag2_storage::StorageFilter & storage_filter) override;
+
+  void seek(const rcutils_time_point_value_t & timestamp) override;
+
 protected:
   /**
-   * Decompress the current bagfile so that it can be opened by the storage implementation.
+   * Prepare the current bagfile to be opened by the storage implementation.
+   * Compressed files are decompressed while opening them, see setup_decompression.
+   * With StorageOptions::decompression_read_ahead_files set, the files following the current
+   * file are decompressed on a background thread while it is read.
    */
   void preprocess_current_file() override;
 
 private:
   /**
-   * Initializes the decompressor if a compression mode is specified in the metadata.
+   * Initializes the decompressor if a compression mode is specified in the metadata, and wraps
+   * the storage factory so that the storage reads decompressed files or chunks.
    *
    * \throw std::invalid_argument If compression mode is NONE
    * \throw std::invalid_argument If compression format could not be found
@@ -84,12 +104,24 @@ private:
    */
   void setup_decompression();
 
+  /**
+   * Decompresses a message of a MESSAGE-compressed bag, unless its topic was written with
+   * uncompressed messages and the message is one of them.
+   */
+  void decompress_message(
+    BaseDecompressorInterface & decompressor,
+    rosbag2_storage::SerializedBagMessage * message) const;
+
   std::shared_ptr<rosbag2_compression::BaseDecompressorInterface> decompressor_{};
   rosbag2_compression::CompressionMode compression_mode_{
     rosbag2_compression::CompressionMode::NONE};
   std::unique_ptr<rosbag2_compression::CompressionFactory> compression_factory_{};
+  // Topics of which some messages were stored uncompressed, from the metadata.
+  std::unordered_set<std::string> uncompressed_topics_{};
 
   rosbag2_storage::StorageOptions storage_options_;
+  // Only used for MESSAGE mode with decompression threads.
+  std::unique_ptr<rosbag2_compression::MessageDecompressionReadAhead> read_ahead_{};
 };
 
 }  // namespace rosbag2_compression
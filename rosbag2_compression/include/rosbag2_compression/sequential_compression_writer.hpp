@@ -41,9 +41,14 @@
 
 #include "rosbag2_compression/compression_options.hpp"
 
+#include "adaptive_compression_level.hpp"
 #include "base_compressor_interface.hpp"
+#include "compression_dictionary_trainer.hpp"
 #include "compression_factory.hpp"
 #include "compression_options.hpp"
+#include "compression_statistics_collector.hpp"
+#include "message_compression_pipeline.hpp"
+#include "topic_compression_policies.hpp"
 #include "visibility_control.hpp"
 
 #ifdef _WIN32
@@ -92,8 +97,10 @@ public:
 
   /**
    * If the compression mode is FILE, write a message to a bagfile.
-   * If the compression mode is MESSAGE, pushes the message into a queue that will be processed
-   * by the compression threads.
+   * If the compression mode is CHUNK, write a message to a bagfile through a storage that
+   * compresses consecutive messages together, see ChunkCompressingStorage.
+   * If the compression mode is MESSAGE, pushes the message into a pipeline that compresses it on
+   * the compression threads and writes it to the bagfile in the order it was pushed.
    *
    * The topic needs to have been created before writing is possible.
    *
@@ -158,7 +165,8 @@ protected:
 
   /**
    * Initializes a number of threads to do file or message compression equal to the
-   * value of the compression_threads parameter.
+   * value of the compression_threads parameter. In MESSAGE mode the threads belong to a
+   * MessageCompressionPipeline that also owns the single stage writing to storage.
    * \throws rcpputils::IllegalStateException if compressor could not be created
    */
   virtual void setup_compressor_threads();
@@ -172,22 +180,34 @@ private:
   std::shared_ptr<rosbag2_compression::BaseCompressorInterface> compressor_{};
   std::unique_ptr<rosbag2_compression::CompressionFactory> compression_factory_{};
   std::mutex compressor_queue_mutex_;
-  std::queue<std::shared_ptr<const rosbag2_storage::SerializedBagMessage>>
-  compressor_message_queue_ RCPPUTILS_TSA_GUARDED_BY(compressor_queue_mutex_);
   std::queue<std::string> compressor_file_queue_ RCPPUTILS_TSA_GUARDED_BY(compressor_queue_mutex_);
   std::vector<std::thread> compression_threads_;
   /* *INDENT-OFF* */  // uncrustify doesn't understand the macro + brace initializer
   std::atomic_bool compression_is_running_
     RCPPUTILS_TSA_GUARDED_BY(compressor_queue_mutex_) {false};
   /* *INDENT-ON* */
+  // Files the compression threads are compressing right now, which share the worker budget.
+  uint64_t files_in_compression_ RCPPUTILS_TSA_GUARDED_BY(compressor_queue_mutex_) = 0;
+  // Serializes the compressed writes with topic and metadata changes. Always taken before
+  // writer_state_mutex_, which in turn is taken before compressor_queue_mutex_. Never taken
+  // while holding writer_state_mutex_, so not in split_bagfile().
   std::recursive_mutex storage_mutex_;
   std::condition_variable compressor_condition_;
+  std::unique_ptr<MessageCompressionPipeline> message_compression_pipeline_;
+  // Only used in MESSAGE mode when compression_dictionary_samples is set.
+  std::unique_ptr<CompressionDictionaryTrainer> dictionary_trainer_;
+  // Only used in MESSAGE mode when compression_level is set.
+  std::unique_ptr<AdaptiveCompressionLevel> compression_level_;
+  // Only used in MESSAGE mode when a topic has a compression policy other than ALWAYS.
+  std::unique_ptr<TopicCompressionPolicies> topic_policies_;
+  // Stored in the metadata when the bag is closed.
+  std::shared_ptr<CompressionStatisticsCollector> compression_statistics_;
 
   rosbag2_compression::CompressionOptions compression_options_{};
 
   bool should_compress_last_file_{true};
 
-  // Runs a while loop that pulls data from the compression queue until
+  // Runs a while loop that pulls files from the compression queue until
   // compression_is_running_ is false; should be run in a separate thread
   void compression_thread_fn();
 
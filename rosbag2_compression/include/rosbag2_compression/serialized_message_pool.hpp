@@ -0,0 +1,69 @@
+// Copyright 2022, Open Source Robotics Corporation.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ROSBAG2_COMPRESSION__SERIALIZED_MESSAGE_POOL_HPP_
+#define ROSBAG2_COMPRESSION__SERIALIZED_MESSAGE_POOL_HPP_
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include "rcutils/types/uint8_array.h"
+
+#include "visibility_control.hpp"
+
+#ifdef _WIN32
+# pragma warning(push)
+# pragma warning(disable:4251)
+#endif
+
+namespace rosbag2_compression
+{
+
+// Number of output arrays kept for reuse by every compression or decompression context.
+constexpr const size_t kMaxPooledSerializedMessages = 16;
+
+/**
+ * Output arrays of one compression or decompression context, reused once nobody else holds them.
+ *
+ * Arrays are handed out as shared pointers that the pool keeps a copy of, so an array is free again
+ * as soon as the message holding it is dropped, and neither the array nor its shared pointer
+ * control block have to be allocated again. Arrays keep the largest capacity they were given.
+ * Not thread safe; the arrays handed out may be released on any thread.
+ */
+class ROSBAG2_COMPRESSION_PUBLIC SerializedMessagePool
+{
+public:
+  explicit SerializedMessagePool(size_t max_size = kMaxPooledSerializedMessages);
+
+  /**
+   * Returns an array of at least the given capacity, with a buffer_length of 0.
+   * Allocates a new array only if all pooled arrays are in use.
+   */
+  std::shared_ptr<rcutils_uint8_array_t> acquire(size_t capacity);
+
+private:
+  const size_t max_size_;
+  std::vector<std::shared_ptr<rcutils_uint8_array_t>> arrays_;
+  // Where to start looking for a free array, the array after the one handed out last.
+  size_t next_ = 0;
+};
+
+}  // namespace rosbag2_compression
+
+#ifdef _WIN32
+# pragma warning(pop)
+#endif
+
+#endif  // ROSBAG2_COMPRESSION__SERIALIZED_MESSAGE_POOL_HPP_
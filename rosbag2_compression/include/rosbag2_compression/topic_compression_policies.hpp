@@ -0,0 +1,106 @@
+// Copyright 2022, Open Source Robotics Corporation.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ROSBAG2_COMPRESSION__TOPIC_COMPRESSION_POLICIES_HPP_
+#define ROSBAG2_COMPRESSION__TOPIC_COMPRESSION_POLICIES_HPP_
+
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "compression_options.hpp"
+#include "visibility_control.hpp"
+
+#ifdef _WIN32
+# pragma warning(push)
+# pragma warning(disable:4251)
+#endif
+
+namespace rosbag2_compression
+{
+
+/**
+ * Decides which messages are compressed in MESSAGE mode, following the TopicCompressionPolicy of
+ * their topic.
+ *
+ * Topics with the AUTO policy are compressed until compression_policy_samples of their messages
+ * have been added as samples. If those compressed by less than compression_policy_min_ratio, the
+ * following messages of the topic are stored uncompressed.
+ * All functions are safe to call from several threads at once.
+ */
+class ROSBAG2_COMPRESSION_PUBLIC TopicCompressionPolicies
+{
+public:
+  /// Called once for every topic, when should_compress() first returns false for it.
+  using UncompressedTopicCallback = std::function<void (const std::string & topic_name)>;
+
+  /**
+   * \param compression_options Options holding the policies and the parameters of AUTO.
+   * \param on_uncompressed_topic Receives every topic before its first message is stored
+   *   uncompressed.
+   * \throws std::invalid_argument if AUTO is used with no samples.
+   */
+  explicit TopicCompressionPolicies(
+    const CompressionOptions & compression_options,
+    UncompressedTopicCallback on_uncompressed_topic = nullptr);
+
+  /// Whether the next message of a topic is to be compressed.
+  bool should_compress(const std::string & topic_name);
+
+  /**
+   * Adds the sizes of a compressed message, which decide on the topic if its policy is AUTO and
+   * it still needs samples.
+   *
+   * \param topic_name Topic of the message.
+   * \param input_bytes Size of the message before compression.
+   * \param output_bytes Size of the message after compression.
+   */
+  void add_sample(const std::string & topic_name, uint64_t input_bytes, uint64_t output_bytes);
+
+  /// Sorted names of the topics for which should_compress() returned false at least once.
+  std::vector<std::string> get_uncompressed_topics() const;
+
+private:
+  struct Topic
+  {
+    TopicCompressionPolicy policy;
+    uint64_t samples = 0;
+    uint64_t input_bytes = 0;
+    uint64_t output_bytes = 0;
+    bool is_compressed = true;
+    bool has_uncompressed_messages = false;
+  };
+
+  Topic & get_topic(const std::string & topic_name);
+
+  const TopicCompressionPolicy default_policy_;
+  const std::unordered_map<std::string, TopicCompressionPolicy> topic_policies_;
+  const uint64_t num_samples_;
+  const double min_ratio_;
+  const UncompressedTopicCallback on_uncompressed_topic_;
+
+  mutable std::mutex mutex_;
+  std::unordered_map<std::string, Topic> topics_;
+};
+
+}  // namespace rosbag2_compression
+
+#ifdef _WIN32
+# pragma warning(pop)
+#endif
+
+#endif  // ROSBAG2_COMPRESSION__TOPIC_COMPRESSION_POLICIES_HPP_
@@ -0,0 +1,93 @@
+// Copyright 2022, Open Source Robotics Corporation.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "rosbag2_compression/adaptive_compression_level.hpp"
+
+#include <algorithm>
+#include <map>
+#include <stdexcept>
+
+#include "logging.hpp"
+
+namespace rosbag2_compression
+{
+
+constexpr uint64_t AdaptiveCompressionLevel::kUpdateInterval;
+constexpr double AdaptiveCompressionLevel::kHighLoad;
+constexpr double AdaptiveCompressionLevel::kLowLoad;
+
+AdaptiveCompressionLevel::AdaptiveCompressionLevel(int32_t min_level, int32_t max_level)
+: min_level_(min_level),
+  max_level_(max_level),
+  level_(max_level)
+{
+  if (min_level > max_level) {
+    throw std::invalid_argument(
+            "Minimum compression level must not be greater than the maximum compression level.");
+  }
+  const auto num_levels = static_cast<size_t>(max_level - min_level) + 1u;
+  message_counts_.reset(new std::atomic<uint64_t>[num_levels]);
+  for (size_t i = 0; i < num_levels; i++) {
+    message_counts_[i].store(0u, std::memory_order_relaxed);
+  }
+}
+
+void AdaptiveCompressionLevel::update(double load)
+{
+  if (min_level_ == max_level_ ||
+    update_count_.fetch_add(1u, std::memory_order_relaxed) % kUpdateInterval != 0)
+  {
+    return;
+  }
+
+  auto level = level_.load(std::memory_order_relaxed);
+  int32_t new_level = level;
+  if (load > kHighLoad) {
+    // Back off fast, the pipeline drops or blocks once it is full.
+    new_level = std::max(min_level_, level - std::max(1, (level - min_level_) / 2));
+  } else if (load < kLowLoad) {
+    new_level = std::min(max_level_, level + 1);
+  }
+  if (new_level != level && level_.compare_exchange_strong(level, new_level)) {
+    ROSBAG2_COMPRESSION_LOG_DEBUG_STREAM(
+      "Compression load " << load << ", changed compression level from " << level << " to " <<
+        new_level << ".");
+  }
+}
+
+int32_t AdaptiveCompressionLevel::get_level() const
+{
+  return level_.load(std::memory_order_relaxed);
+}
+
+void AdaptiveCompressionLevel::count_message(int32_t level)
+{
+  if (level >= min_level_ && level <= max_level_) {
+    message_counts_[level - min_level_].fetch_add(1u, std::memory_order_relaxed);
+  }
+}
+
+std::map<int32_t, uint64_t> AdaptiveCompressionLevel::get_message_counts() const
+{
+  std::map<int32_t, uint64_t> message_counts;
+  for (int32_t level = min_level_; level <= max_level_; level++) {
+    const auto count = message_counts_[level - min_level_].load(std::memory_order_relaxed);
+    if (count > 0) {
+      message_counts.emplace(level, count);
+    }
+  }
+  return message_counts;
+}
+
+}  // namespace rosbag2_compression
@@ -0,0 +1,452 @@
+// Copyright 2022, Open Source Robotics Corporation.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "rosbag2_compression/chunk_compression_storage.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "rosbag2_storage/ros_helper.hpp"
+#include "rosbag2_storage/storage_filter.hpp"
+
+#include "logging.hpp"
+
+namespace rosbag2_compression
+{
+
+const char kCompressedChunkTopic[] = "/_rosbag2/compressed_chunk";
+
+namespace
+{
+
+// A chunk is the concatenation of its messages, each stored as
+//   uint32 topic name length | topic name | int64 time stamp | uint64 data length | data
+// with all integers in little endian.
+template<typename T>
+void append_integer(std::vector<uint8_t> & chunk, T value)
+{
+  const auto unsigned_value = static_cast<uint64_t>(value);
+  for (size_t i = 0; i < sizeof(T); ++i) {
+    chunk.push_back(static_cast<uint8_t>(unsigned_value >> (8 * i)));
+  }
+}
+
+template<typename T>
+T read_integer(const uint8_t * & cursor, const uint8_t * end)
+{
+  if (static_cast<size_t>(end - cursor) < sizeof(T)) {
+    throw std::runtime_error("Compressed chunk is truncated.");
+  }
+  uint64_t value = 0;
+  for (size_t i = 0; i < sizeof(T); ++i) {
+    value |= static_cast<uint64_t>(cursor[i]) << (8 * i);
+  }
+  cursor += sizeof(T);
+  return static_cast<T>(value);
+}
+
+const uint8_t * take_bytes(const uint8_t * & cursor, const uint8_t * end, uint64_t size)
+{
+  if (static_cast<uint64_t>(end - cursor) < size) {
+    throw std::runtime_error("Compressed chunk is truncated.");
+  }
+  const auto bytes = cursor;
+  cursor += size;
+  return bytes;
+}
+
+std::vector<std::shared_ptr<rosbag2_storage::SerializedBagMessage>> unpack_chunk(
+  const rosbag2_storage::SerializedBagMessage & chunk)
+{
+  std::vector<std::shared_ptr<rosbag2_storage::SerializedBagMessage>> messages;
+  if (!chunk.serialized_data) {
+    return messages;
+  }
+  const uint8_t * cursor = chunk.serialized_data->buffer;
+  const uint8_t * end = cursor + chunk.serialized_data->buffer_length;
+  while (cursor != end) {
+    auto message = std::make_shared<rosbag2_storage::SerializedBagMessage>();
+    const auto topic_length = read_integer<uint32_t>(cursor, end);
+    const auto topic = take_bytes(cursor, end, topic_length);
+    message->topic_name.assign(reinterpret_cast<const char *>(topic), topic_length);
+    message->time_stamp = read_integer<rcutils_time_point_value_t>(cursor, end);
+    const auto data_length = read_integer<uint64_t>(cursor, end);
+    const auto data = take_bytes(cursor, end, data_length);
+    message->serialized_data = rosbag2_storage::make_serialized_message(
+      data, static_cast<size_t>(data_length));
+    messages.push_back(std::move(message));
+  }
+  return messages;
+}
+
+std::vector<rosbag2_storage::TopicMetadata> remove_chunk_topic(
+  std::vector<rosbag2_storage::TopicMetadata> topics)
+{
+  topics.erase(
+    std::remove_if(
+      topics.begin(), topics.end(),
+      [](const rosbag2_storage::TopicMetadata & topic) {
+        return topic.name == kCompressedChunkTopic;
+      }),
+    topics.end());
+  return topics;
+}
+
+rosbag2_storage::BagMetadata remove_chunk_topic(rosbag2_storage::BagMetadata metadata)
+{
+  auto & topics = metadata.topics_with_message_count;
+  topics.erase(
+    std::remove_if(
+      topics.begin(), topics.end(),
+      [](const rosbag2_storage::TopicInformation & topic) {
+        return topic.topic_metadata.name == kCompressedChunkTopic;
+      }),
+    topics.end());
+  return metadata;
+}
+}  // namespace
+
+ChunkCompressingStorage::ChunkCompressingStorage(
+  std::shared_ptr<rosbag2_storage::storage_interfaces::ReadWriteInterface> storage,
+  std::shared_ptr<BaseCompressorInterface> compressor,
+  uint64_t chunk_size,
+  std::shared_ptr<CompressionStatisticsCollector> statistics)
+: storage_(std::move(storage)),
+  compressor_(std::move(compressor)),
+  chunk_size_(chunk_size),
+  statistics_(std::move(statistics))
+{
+  if (!storage_ || !compressor_) {
+    throw std::invalid_argument("ChunkCompressingStorage needs a storage and a compressor.");
+  }
+}
+
+ChunkCompressingStorage::~ChunkCompressingStorage()
+{
+  try {
+    flush_chunk();
+  } catch (const std::exception & e) {
+    ROSBAG2_COMPRESSION_LOG_ERROR_STREAM("Could not write the last compressed chunk: " << e.what());
+  }
+}
+
+void ChunkCompressingStorage::open(
+  const rosbag2_storage::StorageOptions & storage_options,
+  rosbag2_storage::storage_interfaces::IOFlag io_flag)
+{
+  storage_->open(storage_options, io_flag);
+}
+
+void ChunkCompressingStorage::write(
+  std::shared_ptr<const rosbag2_storage::SerializedBagMessage> message)
+{
+  append_to_chunk(*message);
+  if (chunk_size_ == 0u || chunk_.size() >= chunk_size_) {
+    flush_chunk();
+  }
+}
+
+void ChunkCompressingStorage::write(
+  const std::vector<std::shared_ptr<const rosbag2_storage::SerializedBagMessage>> & messages)
+{
+  for (const auto & message : messages) {
+    append_to_chunk(*message);
+    if (chunk_size_ > 0u && chunk_.size() >= chunk_size_) {
+      flush_chunk();
+    }
+  }
+  if (chunk_size_ == 0u) {
+    flush_chunk();
+  }
+}
+
+void ChunkCompressingStorage::append_to_chunk(const rosbag2_storage::SerializedBagMessage & message)
+{
+  if (chunk_.empty()) {
+    chunk_time_stamp_ = message.time_stamp;
+  }
+  chunk_time_stamp_ = std::max(chunk_time_stamp_, message.time_stamp);
+
+  const auto data_length = message.serialized_data ? message.serialized_data->buffer_length : 0u;
+  append_integer<uint32_t>(chunk_, static_cast<uint32_t>(message.topic_name.size()));
+  chunk_.insert(chunk_.end(), message.topic_name.begin(), message.topic_name.end());
+  append_integer<rcutils_time_point_value_t>(chunk_, message.time_stamp);
+  append_integer<uint64_t>(chunk_, data_length);
+  if (data_length > 0u) {
+    const auto data = message.serialized_data->buffer;
+    chunk_.insert(chunk_.end(), data, data + data_length);
+  }
+}
+
+void ChunkCompressingStorage::flush_chunk()
+{
+  if (chunk_.empty()) {
+    return;
+  }
+  if (!chunk_topic_created_) {
+    storage_->create_topic({kCompressedChunkTopic, "rosbag2_compression/CompressedChunk", "", ""});
+    chunk_topic_created_ = true;
+  }
+
+  rosbag2_storage::SerializedBagMessage uncompressed_chunk;
+  uncompressed_chunk.topic_name = kCompressedChunkTopic;
+  uncompressed_chunk.time_stamp = chunk_time_stamp_;
+  uncompressed_chunk.serialized_data =
+    rosbag2_storage::make_serialized_message(chunk_.data(), chunk_.size());
+  chunk_.clear();
+
+  auto compressed_chunk = std::make_shared<rosbag2_storage::SerializedBagMessage>();
+  compressed_chunk->topic_name = kCompressedChunkTopic;
+  compressed_chunk->time_stamp = uncompressed_chunk.time_stamp;
+  const auto start = std::chrono::steady_clock::now();
+  compressor_->compress_serialized_bag_message(&uncompressed_chunk, compressed_chunk.get());
+  if (statistics_) {
+    // A chunk holds messages of several topics.
+    const auto compression_time = std::chrono::steady_clock::now() - start;
+    const auto compressed_length =
+      compressed_chunk->serialized_data ? compressed_chunk->serialized_data->buffer_length : 0u;
+    statistics_->add(
+      "", uncompressed_chunk.serialized_data->buffer_length, compressed_length, compression_time);
+  }
+  storage_->write(compressed_chunk);
+}
+
+void ChunkCompressingStorage::create_topic(const rosbag2_storage::TopicMetadata & topic)
+{
+  storage_->create_topic(topic);
+}
+
+void ChunkCompressingStorage::remove_topic(const rosbag2_storage::TopicMetadata & topic)
+{
+  storage_->remove_topic(topic);
+}
+
+bool ChunkCompressingStorage::has_next()
+{
+  return storage_->has_next();
+}
+
+std::shared_ptr<rosbag2_storage::SerializedBagMessage> ChunkCompressingStorage::read_next()
+{
+  return storage_->read_next();
+}
+
+std::vector<rosbag2_storage::TopicMetadata> ChunkCompressingStorage::get_all_topics_and_types()
+{
+  return remove_chunk_topic(storage_->get_all_topics_and_types());
+}
+
+rosbag2_storage::BagMetadata ChunkCompressingStorage::get_metadata()
+{
+  return remove_chunk_topic(storage_->get_metadata());
+}
+
+std::string ChunkCompressingStorage::get_relative_file_path() const
+{
+  return storage_->get_relative_file_path();
+}
+
+uint64_t ChunkCompressingStorage::get_bagfile_size() const
+{
+  return storage_->get_bagfile_size();
+}
+
+uint64_t ChunkCompressingStorage::get_bagfile_size_estimate() const
+{
+  return storage_->get_bagfile_size_estimate();
+}
+
+std::string ChunkCompressingStorage::get_storage_identifier() const
+{
+  return storage_->get_storage_identifier();
+}
+
+uint64_t ChunkCompressingStorage::get_minimum_split_file_size() const
+{
+  return storage_->get_minimum_split_file_size();
+}
+
+void ChunkCompressingStorage::set_filter(const rosbag2_storage::StorageFilter & storage_filter)
+{
+  storage_->set_filter(storage_filter);
+}
+
+void ChunkCompressingStorage::reset_filter()
+{
+  storage_->reset_filter();
+}
+
+void ChunkCompressingStorage::seek(const rcutils_time_point_value_t & timestamp)
+{
+  storage_->seek(timestamp);
+}
+
+ChunkDecompressingStorage::ChunkDecompressingStorage(
+  std::shared_ptr<rosbag2_storage::storage_interfaces::ReadOnlyInterface> storage,
+  std::shared_ptr<BaseDecompressorInterface> decompressor)
+: storage_(std::move(storage)),
+  decompressor_(std::move(decompressor)),
+  seek_time_(std::numeric_limits<rcutils_time_point_value_t>::min())
+{
+  if (!storage_ || !decompressor_) {
+    throw std::invalid_argument("ChunkDecompressingStorage needs a storage and a decompressor.");
+  }
+}
+
+void ChunkDecompressingStorage::open(
+  const rosbag2_storage::StorageOptions & storage_options,
+  rosbag2_storage::storage_interfaces::IOFlag io_flag)
+{
+  storage_->open(storage_options, io_flag);
+}
+
+bool ChunkDecompressingStorage::has_next()
+{
+  fill_pending_messages();
+  return !pending_messages_.empty();
+}
+
+std::shared_ptr<rosbag2_storage::SerializedBagMessage> ChunkDecompressingStorage::read_next()
+{
+  fill_pending_messages();
+  if (pending_messages_.empty()) {
+    throw std::runtime_error("No more messages in compressed chunks.");
+  }
+  auto message = std::move(pending_messages_.front());
+  pending_messages_.pop_front();
+  return message;
+}
+
+void ChunkDecompressingStorage::fill_pending_messages()
+{
+  while (pending_messages_.empty() && storage_->has_next()) {
+    auto chunk = storage_->read_next();
+    if (chunk->topic_name != kCompressedChunkTopic) {
+      // Not part of a chunk, hand it out as it is
+      if (is_wanted(*chunk)) {
+        pending_messages_.push_back(std::move(chunk));
+      }
+      continue;
+    }
+    decompressor_->decompress_serialized_bag_message(chunk.get());
+    for (auto & message : unpack_chunk(*chunk)) {
+      if (is_wanted(*message)) {
+        pending_messages_.push_back(std::move(message));
+      }
+    }
+  }
+}
+
+bool ChunkDecompressingStorage::is_wanted(const rosbag2_storage::SerializedBagMessage & message)
+const
+{
+  return message.time_stamp >= seek_time_ &&
+         rosbag2_storage::topic_passes_filter(message.topic_name, storage_filter_);
+}
+
+std::vector<rosbag2_storage::TopicMetadata> ChunkDecompressingStorage::get_all_topics_and_types()
+{
+  return remove_chunk_topic(storage_->get_all_topics_and_types());
+}
+
+rosbag2_storage::BagMetadata ChunkDecompressingStorage::get_metadata()
+{
+  return remove_chunk_topic(storage_->get_metadata());
+}
+
+std::string ChunkDecompressingStorage::get_relative_file_path() const
+{
+  return storage_->get_relative_file_path();
+}
+
+uint64_t ChunkDecompressingStorage::get_bagfile_size() const
+{
+  return storage_->get_bagfile_size();
+}
+
+std::string ChunkDecompressingStorage::get_storage_identifier() const
+{
+  return storage_->get_storage_identifier();
+}
+
+void ChunkDecompressingStorage::set_filter(const rosbag2_storage::StorageFilter & storage_filter)
+{
+  // The wrapped storage only holds chunks, so topics are filtered after unpacking
+  storage_filter_ = storage_filter;
+  pending_messages_.erase(
+    std::remove_if(
+      pending_messages_.begin(), pending_messages_.end(),
+      [this](const std::shared_ptr<rosbag2_storage::SerializedBagMessage> & message) {
+        return !is_wanted(*message);
+      }),
+    pending_messages_.end());
+}
+
+void ChunkDecompressingStorage::reset_filter()
+{
+  storage_filter_ = rosbag2_storage::StorageFilter();
+}
+
+void ChunkDecompressingStorage::seek(const rcutils_time_point_value_t & timestamp)
+{
+  // Chunks are stamped with their latest message, so this finds the chunk holding the first
+  // message at or after timestamp; earlier messages of that chunk are skipped when unpacking.
+  pending_messages_.clear();
+  seek_time_ = timestamp;
+  storage_->seek(timestamp);
+}
+
+ChunkCompressionStorageFactory::ChunkCompressionStorageFactory(
+  std::unique_ptr<rosbag2_storage::StorageFactoryInterface> storage_factory,
+  std::shared_ptr<BaseCompressorInterface> compressor,
+  std::shared_ptr<BaseDecompressorInterface> decompressor,
+  uint64_t chunk_size,
+  std::shared_ptr<CompressionStatisticsCollector> statistics)
+: storage_factory_(std::move(storage_factory)),
+  compressor_(std::move(compressor)),
+  decompressor_(std::move(decompressor)),
+  chunk_size_(chunk_size),
+  statistics_(std::move(statistics))
+{}
+
+std::shared_ptr<rosbag2_storage::storage_interfaces::ReadOnlyInterface>
+ChunkCompressionStorageFactory::open_read_only(
+  const rosbag2_storage::StorageOptions & storage_options)
+{
+  auto storage = storage_factory_->open_read_only(storage_options);
+  if (!storage) {
+    return nullptr;
+  }
+  return std::make_shared<ChunkDecompressingStorage>(std::move(storage), decompressor_);
+}
+
+std::shared_ptr<rosbag2_storage::storage_interfaces::ReadWriteInterface>
+ChunkCompressionStorageFactory::open_read_write(
+  const rosbag2_storage::StorageOptions & storage_options)
+{
+  auto storage = storage_factory_->open_read_write(storage_options);
+  if (!storage) {
+    return nullptr;
+  }
+  return std::make_shared<ChunkCompressingStorage>(
+    std::move(storage), compressor_, chunk_size_, statistics_);
+}
+
+}  // namespace rosbag2_compression
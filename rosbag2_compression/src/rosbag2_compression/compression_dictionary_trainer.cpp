@@ -0,0 +1,86 @@
+// Copyright 2022, Open Source Robotics Corporation.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "rosbag2_compression/compression_dictionary_trainer.hpp"
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "logging.hpp"
+
+namespace rosbag2_compression
+{
+
+CompressionDictionaryTrainer::CompressionDictionaryTrainer(
+  uint64_t num_samples, DictionaryCallback on_dictionary_trained)
+: num_samples_(num_samples),
+  on_dictionary_trained_(std::move(on_dictionary_trained))
+{}
+
+void CompressionDictionaryTrainer::add_sample(
+  MessageSharedPtr message, BaseCompressorInterface & compressor)
+{
+  std::vector<MessageSharedPtr> samples;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (complete_topics_.count(message->topic_name) > 0) {
+      return;
+    }
+    auto & topic_samples = samples_[message->topic_name];
+    topic_samples.push_back(std::move(message));
+    if (topic_samples.size() < num_samples_) {
+      return;
+    }
+    // Train outside of the lock, other threads keep compressing meanwhile.
+    complete_topics_.insert(topic_samples.front()->topic_name);
+    samples = std::move(topic_samples);
+    samples_.erase(samples.front()->topic_name);
+  }
+
+  const auto & topic_name = samples.front()->topic_name;
+  auto dictionary = compressor.train_dictionary(samples);
+  if (dictionary.empty()) {
+    ROSBAG2_COMPRESSION_LOG_DEBUG_STREAM(
+      "No compression dictionary trained for topic " << topic_name << ".");
+    return;
+  }
+  ROSBAG2_COMPRESSION_LOG_DEBUG_STREAM(
+    "Trained a compression dictionary of " << dictionary.size() << " bytes for topic " <<
+      topic_name << " from " << samples.size() << " messages.");
+
+  // The dictionary must be stored with the bag before any message is compressed with it.
+  if (on_dictionary_trained_) {
+    on_dictionary_trained_(topic_name, dictionary);
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  dictionaries_.emplace_back(topic_name, std::move(dictionary));
+  dictionary_count_.store(dictionaries_.size(), std::memory_order_release);
+}
+
+void CompressionDictionaryTrainer::apply_new_dictionaries(
+  BaseCompressorInterface & compressor, size_t & applied_count) const
+{
+  if (dictionary_count_.load(std::memory_order_acquire) == applied_count) {
+    return;
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (; applied_count < dictionaries_.size(); applied_count++) {
+    compressor.set_dictionary(
+      dictionaries_[applied_count].first, dictionaries_[applied_count].second);
+  }
+}
+
+}  // namespace rosbag2_compression
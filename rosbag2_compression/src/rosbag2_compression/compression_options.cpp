@@ -27,6 +27,11 @@ namespace
 constexpr const char kCompressionModeNoneStr[] = "NONE";
 constexpr const char kCompressionModeFileStr[] = "FILE";
 constexpr const char kCompressionModeMessageStr[] = "MESSAGE";
+constexpr const char kCompressionModeChunkStr[] = "CHUNK";
+
+constexpr const char kTopicCompressionPolicyAlwaysStr[] = "ALWAYS";
+constexpr const char kTopicCompressionPolicyNeverStr[] = "NEVER";
+constexpr const char kTopicCompressionPolicyAutoStr[] = "AUTO";
 
 std::string to_upper(const std::string & text)
 {
@@ -45,6 +50,8 @@ CompressionMode compression_mode_from_string(const std::string & compression_mod
     return CompressionMode::FILE;
   } else if (compression_mode_upper == kCompressionModeMessageStr) {
     return CompressionMode::MESSAGE;
+  } else if (compression_mode_upper == kCompressionModeChunkStr) {
+    return CompressionMode::CHUNK;
   } else {
     ROSBAG2_COMPRESSION_LOG_ERROR_STREAM(
       "CompressionMode: \"" << compression_mode << "\" is not supported!");
@@ -61,9 +68,42 @@ std::string compression_mode_to_string(const CompressionMode compression_mode)
       return kCompressionModeFileStr;
     case CompressionMode::MESSAGE:
       return kCompressionModeMessageStr;
+    case CompressionMode::CHUNK:
+      return kCompressionModeChunkStr;
     default:
       ROSBAG2_COMPRESSION_LOG_ERROR_STREAM("CompressionMode not supported!");
       return kCompressionModeNoneStr;
   }
 }
+
+TopicCompressionPolicy topic_compression_policy_from_string(const std::string & policy)
+{
+  const auto policy_upper = to_upper(policy);
+  if (policy.empty() || policy_upper == kTopicCompressionPolicyAlwaysStr) {
+    return TopicCompressionPolicy::ALWAYS;
+  } else if (policy_upper == kTopicCompressionPolicyNeverStr) {
+    return TopicCompressionPolicy::NEVER;
+  } else if (policy_upper == kTopicCompressionPolicyAutoStr) {
+    return TopicCompressionPolicy::AUTO;
+  } else {
+    ROSBAG2_COMPRESSION_LOG_ERROR_STREAM(
+      "TopicCompressionPolicy: \"" << policy << "\" is not supported!");
+    return TopicCompressionPolicy::ALWAYS;
+  }
+}
+
+std::string topic_compression_policy_to_string(const TopicCompressionPolicy policy)
+{
+  switch (policy) {
+    case TopicCompressionPolicy::ALWAYS:
+      return kTopicCompressionPolicyAlwaysStr;
+    case TopicCompressionPolicy::NEVER:
+      return kTopicCompressionPolicyNeverStr;
+    case TopicCompressionPolicy::AUTO:
+      return kTopicCompressionPolicyAutoStr;
+    default:
+      ROSBAG2_COMPRESSION_LOG_ERROR_STREAM("TopicCompressionPolicy not supported!");
+      return kTopicCompressionPolicyAlwaysStr;
+  }
+}
 }  // namespace rosbag2_compression
@@ -0,0 +1,57 @@
+// Copyright 2022, Open Source Robotics Corporation.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "rosbag2_compression/compression_statistics_collector.hpp"
+
+#include <functional>
+#include <map>
+#include <string>
+#include <thread>
+
+namespace rosbag2_compression
+{
+
+constexpr size_t CompressionStatisticsCollector::kNumShards;
+
+void CompressionStatisticsCollector::add(
+  const std::string & topic,
+  uint64_t input_bytes,
+  uint64_t output_bytes,
+  std::chrono::nanoseconds compression_time)
+{
+  auto & shard = shards_[std::hash<std::thread::id>{}(std::this_thread::get_id()) % kNumShards];
+  std::lock_guard<std::mutex> lock(shard.mutex);
+  auto & statistics = shard.statistics[topic];
+  statistics.input_bytes += input_bytes;
+  statistics.output_bytes += output_bytes;
+  statistics.compression_time += compression_time;
+}
+
+std::map<std::string, rosbag2_storage::CompressionStatistics>
+CompressionStatisticsCollector::get_statistics() const
+{
+  std::map<std::string, rosbag2_storage::CompressionStatistics> sums;
+  for (const auto & shard : shards_) {
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    for (const auto & topic_statistics : shard.statistics) {
+      auto & sum = sums[topic_statistics.first];
+      sum.input_bytes += topic_statistics.second.input_bytes;
+      sum.output_bytes += topic_statistics.second.output_bytes;
+      sum.compression_time += topic_statistics.second.compression_time;
+    }
+  }
+  return sums;
+}
+
+}  // namespace rosbag2_compression
@@ -0,0 +1,144 @@
+// Copyright 2022, Open Source Robotics Corporation.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "rosbag2_compression/file_decompression_read_ahead.hpp"
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "rcpputils/filesystem_helper.hpp"
+
+namespace rosbag2_compression
+{
+
+FileDecompressionReadAhead::FileDecompressionReadAhead(
+  std::vector<std::string> uris,
+  uint64_t num_files,
+  DecompressFunction decompress)
+: uris_(std::move(uris)),
+  num_files_(num_files),
+  decompress_(std::move(decompress)),
+  decompression_thread_([this] {decompression_thread_fn();})
+{}
+
+FileDecompressionReadAhead::~FileDecompressionReadAhead()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    is_running_ = false;
+  }
+  jobs_available_.notify_all();
+  decompression_thread_.join();
+  for (const auto & entry : window_) {
+    remove_file(entry.second->file);
+  }
+}
+
+bool FileDecompressionReadAhead::take(const std::string & uri, DecompressedFile & file)
+{
+  const auto uri_it = std::find(uris_.begin(), uris_.end(), uri);
+  if (uri_it == uris_.end()) {
+    return false;
+  }
+  const auto index = static_cast<size_t>(uri_it - uris_.begin());
+  const auto last_index = std::min<uint64_t>(index + num_files_, uris_.size() - 1);
+
+  std::shared_ptr<Entry> entry;
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (auto it = window_.begin(); it != window_.end(); ) {
+      if (it->first >= index && it->first <= last_index) {
+        ++it;
+        continue;
+      }
+      if (it->second->is_decompressed) {
+        remove_file(it->second->file);
+      } else if (it->second->is_started) {
+        it->second->is_dropped = true;
+      }
+      it = window_.erase(it);
+    }
+    for (auto i = index; i <= last_index; i++) {
+      window_.emplace(i, std::make_shared<Entry>());
+    }
+    entry = window_.at(index);
+    jobs_available_.notify_one();
+    file_decompressed_.wait(lock, [&entry] {return entry->is_decompressed;});
+    window_.erase(index);
+  }
+
+  if (entry->error) {
+    std::rethrow_exception(entry->error);
+  }
+  file = std::move(entry->file);
+  return true;
+}
+
+void FileDecompressionReadAhead::decompression_thread_fn()
+{
+  const auto next_job = [this] {
+      return std::find_if(
+        window_.begin(), window_.end(), [](const auto & entry) {
+          return !entry.second->is_started;
+        });
+    };
+
+  while (true) {
+    size_t index = 0;
+    std::shared_ptr<Entry> entry;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      jobs_available_.wait(lock, [&] {return !is_running_ || next_job() != window_.end();});
+      if (!is_running_) {
+        return;
+      }
+      const auto job = next_job();
+      index = job->first;
+      entry = job->second;
+      entry->is_started = true;
+    }
+
+    DecompressedFile file;
+    std::exception_ptr error;
+    try {
+      file = decompress_(uris_[index]);
+    } catch (...) {
+      error = std::current_exception();
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (entry->is_dropped) {
+        remove_file(file);
+        continue;
+      }
+      entry->file = std::move(file);
+      entry->error = error;
+      entry->is_decompressed = true;
+    }
+    file_decompressed_.notify_all();
+  }
+}
+
+void FileDecompressionReadAhead::remove_file(const DecompressedFile & file)
+{
+  if (!file.uri.empty()) {
+    rcpputils::fs::remove(rcpputils::fs::path{file.uri});
+  }
+}
+
+}  // namespace rosbag2_compression
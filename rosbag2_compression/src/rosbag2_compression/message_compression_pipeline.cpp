@@ -0,0 +1,327 @@
+// Copyright 2022, Open Source Robotics Corporation.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "rosbag2_compression/message_compression_pipeline.hpp"
+
+#include <algorithm>
+#include <exception>
+#include <memory>
+#include <utility>
+
+#include "logging.hpp"
+
+namespace rosbag2_compression
+{
+
+// With a single cell, a full cell of one lap looks like the empty cell of the next lap, so the
+// ring needs at least two cells.
+MessageCompressionPipeline::JobRing::JobRing(size_t capacity)
+: capacity_(std::max<size_t>(capacity, 2u)),
+  cells_(new Cell[capacity_])
+{
+  for (size_t i = 0; i < capacity_; i++) {
+    cells_[i].turn.store(i, std::memory_order_relaxed);
+  }
+}
+
+bool MessageCompressionPipeline::JobRing::try_push(Job & job)
+{
+  auto position = enqueue_position_.load(std::memory_order_relaxed);
+  while (true) {
+    auto & cell = cells_[position % capacity_];
+    const auto turn = cell.turn.load(std::memory_order_acquire);
+    if (turn == position) {
+      if (enqueue_position_.compare_exchange_weak(
+          position, position + 1, std::memory_order_relaxed))
+      {
+        cell.job = std::move(job);
+        cell.turn.store(position + 1, std::memory_order_release);
+        return true;
+      }
+    } else if (turn < position) {
+      // The cell still holds the job from the previous lap; the ring is full.
+      return false;
+    } else {
+      position = enqueue_position_.load(std::memory_order_relaxed);
+    }
+  }
+}
+
+bool MessageCompressionPipeline::JobRing::try_pop(Job & job)
+{
+  auto position = dequeue_position_.load(std::memory_order_relaxed);
+  while (true) {
+    auto & cell = cells_[position % capacity_];
+    const auto turn = cell.turn.load(std::memory_order_acquire);
+    if (turn == position + 1) {
+      if (dequeue_position_.compare_exchange_weak(
+          position, position + 1, std::memory_order_relaxed))
+      {
+        job = std::move(cell.job);
+        cell.job.message.reset();
+        cell.turn.store(position + capacity_, std::memory_order_release);
+        return true;
+      }
+    } else if (turn < position + 1) {
+      // Nothing has been published into this cell yet; the ring is empty.
+      return false;
+    } else {
+      position = dequeue_position_.load(std::memory_order_relaxed);
+    }
+  }
+}
+
+bool MessageCompressionPipeline::JobRing::can_push() const
+{
+  const auto position = enqueue_position_.load();
+  return cells_[position % capacity_].turn.load() >= position;
+}
+
+bool MessageCompressionPipeline::JobRing::can_pop() const
+{
+  const auto position = dequeue_position_.load();
+  return cells_[position % capacity_].turn.load() >= position + 1;
+}
+
+void MessageCompressionPipeline::notify(
+  std::condition_variable & condition, const std::atomic<uint32_t> & waiters)
+{
+  // Pairs with the fence in park(): either the waiter sees the new state in its predicate or we
+  // see the waiter and wake it up.
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (waiters.load() > 0) {
+    std::lock_guard<std::mutex> lock(park_mutex_);
+    condition.notify_all();
+  }
+}
+
+template<typename PredicateT>
+void MessageCompressionPipeline::park(
+  std::condition_variable & condition, std::atomic<uint32_t> & waiters, PredicateT predicate)
+{
+  waiters++;
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  {
+    std::unique_lock<std::mutex> lock(park_mutex_);
+    condition.wait(lock, predicate);
+  }
+  waiters--;
+}
+
+MessageCompressionPipeline::MessageCompressionPipeline(
+  uint64_t num_threads,
+  uint64_t queue_size,
+  CompressFunctionFactory make_compress_function,
+  WriteFunction write_function)
+: queue_size_(queue_size),
+  // Messages in flight: the ones waiting in the ring, the ones being compressed and the same
+  // amount again so that compression can run ahead while the writer stage is busy.
+  window_size_(2 * ((queue_size > 0 ? queue_size : std::max<uint64_t>(num_threads, 1u)) +
+    std::max<uint64_t>(num_threads, 1u))),
+  make_compress_function_(std::move(make_compress_function)),
+  write_function_(std::move(write_function)),
+  jobs_(queue_size > 0 ? queue_size : std::max<uint64_t>(num_threads, 1u)),
+  results_(new ResultSlot[window_size_])
+{
+  writer_thread_ = std::thread([this] {writer_thread_fn();});
+  for (uint64_t i = 0; i < std::max<uint64_t>(num_threads, 1u); i++) {
+    compression_threads_.emplace_back([this] {compression_thread_fn();});
+  }
+}
+
+MessageCompressionPipeline::~MessageCompressionPipeline()
+{
+  stop();
+}
+
+bool MessageCompressionPipeline::push(MessageSharedPtr message)
+{
+  // Counted before checking the flag, pairing with stop() which clears the flag before waiting
+  // for the count: either this push sees the flag cleared, or stop() waits for it to finish.
+  active_pushes_++;
+  const bool pushed = accepts_messages_ && push_job(std::move(message));
+  if (!pushed) {
+    dropped_count_++;
+  }
+  active_pushes_--;
+  notify(pushes_finished_, stop_waiters_);
+  return pushed;
+}
+
+bool MessageCompressionPipeline::push_job(MessageSharedPtr message)
+{
+  uint64_t sequence = 0;
+  if (!reserve_sequence(sequence)) {
+    return false;
+  }
+
+  Job job{sequence, std::move(message)};
+  while (!jobs_.try_push(job)) {
+    if (queue_size_ > 0) {
+      // Make room by dropping the oldest message still waiting for compression. Its sequence
+      // number is resolved with an empty result so that the writer stage skips over it.
+      Job oldest;
+      if (jobs_.try_pop(oldest)) {
+        dropped_count_++;
+        publish_result(oldest.sequence, nullptr);
+      }
+    } else {
+      park(space_available_, producer_waiters_, [this] {return jobs_.can_push();});
+    }
+  }
+  notify(jobs_available_, compression_waiters_);
+  return true;
+}
+
+void MessageCompressionPipeline::stop()
+{
+  std::lock_guard<std::mutex> lock(stop_mutex_);
+  if (compression_threads_.empty() && !writer_thread_.joinable()) {
+    return;
+  }
+
+  // Pushes in progress still need the compression threads and the writer stage to make room.
+  accepts_messages_ = false;
+  park(pushes_finished_, stop_waiters_, [this] {return active_pushes_.load() == 0;});
+
+  // Compression threads drain the job ring before they exit, so every reserved sequence number
+  // has its result published once they are joined. Only then can the writer stage finish.
+  compression_is_running_ = false;
+  notify(jobs_available_, compression_waiters_);
+  for (auto & thread : compression_threads_) {
+    thread.join();
+  }
+  compression_threads_.clear();
+
+  writer_is_running_ = false;
+  notify(results_available_, writer_waiters_);
+  if (writer_thread_.joinable()) {
+    writer_thread_.join();
+  }
+}
+
+uint64_t MessageCompressionPipeline::get_dropped_count() const
+{
+  return dropped_count_.load();
+}
+
+double MessageCompressionPipeline::get_load() const
+{
+  // Read written_sequence_ first, so that it never overtakes the value of next_sequence_.
+  const auto written = written_sequence_.load();
+  const auto in_flight = next_sequence_.load() - written;
+  return std::min(1.0, static_cast<double>(in_flight) / static_cast<double>(window_size_));
+}
+
+bool MessageCompressionPipeline::reserve_sequence(uint64_t & sequence)
+{
+  auto next = next_sequence_.load();
+  while (true) {
+    if (next - written_sequence_.load() < window_size_) {
+      if (next_sequence_.compare_exchange_weak(next, next + 1)) {
+        sequence = next;
+        return true;
+      }
+      continue;
+    }
+    if (queue_size_ > 0) {
+      // The writer stage is too far behind to keep a slot for this message.
+      return false;
+    }
+    park(
+      space_available_, producer_waiters_, [this] {
+        return next_sequence_.load() - written_sequence_.load() < window_size_;
+      });
+    next = next_sequence_.load();
+  }
+}
+
+void MessageCompressionPipeline::publish_result(uint64_t sequence, MessageSharedPtr message)
+{
+  auto & slot = results_[sequence % window_size_];
+  slot.message = std::move(message);
+  slot.ready.store(sequence + 1, std::memory_order_release);
+  notify(results_available_, writer_waiters_);
+}
+
+bool MessageCompressionPipeline::result_ready(uint64_t sequence) const
+{
+  return results_[sequence % window_size_].ready.load(std::memory_order_acquire) == sequence + 1;
+}
+
+void MessageCompressionPipeline::compression_thread_fn()
+{
+  // Every thread needs to have its own compression context for thread safety.
+  auto compress = make_compress_function_();
+
+  Job job;
+  while (true) {
+    // Read the flag before looking at the ring: once it is cleared no more jobs are pushed, so an
+    // empty ring after that point means this thread is done.
+    const bool is_running = compression_is_running_.load();
+    if (jobs_.try_pop(job)) {
+      notify(space_available_, producer_waiters_);
+      MessageSharedPtr compressed_message;
+      try {
+        compressed_message = compress(std::move(job.message));
+      } catch (const std::exception & e) {
+        dropped_count_++;
+        ROSBAG2_COMPRESSION_LOG_ERROR_STREAM("Failed to compress message: " << e.what());
+      }
+      publish_result(job.sequence, std::move(compressed_message));
+      continue;
+    }
+    if (!is_running) {
+      break;
+    }
+    park(
+      jobs_available_, compression_waiters_, [this] {
+        return jobs_.can_pop() || !compression_is_running_;
+      });
+  }
+}
+
+void MessageCompressionPipeline::writer_thread_fn()
+{
+  while (true) {
+    const bool is_running = writer_is_running_.load();
+    // Only this thread advances written_sequence_.
+    const auto sequence = written_sequence_.load(std::memory_order_relaxed);
+    if (result_ready(sequence)) {
+      auto & slot = results_[sequence % window_size_];
+      auto message = std::move(slot.message);
+      slot.message.reset();
+      if (message) {
+        try {
+          write_function_(std::move(message));
+        } catch (const std::exception & e) {
+          dropped_count_++;
+          ROSBAG2_COMPRESSION_LOG_ERROR_STREAM("Failed to write compressed message: " << e.what());
+        }
+      }
+      written_sequence_.store(sequence + 1);
+      notify(space_available_, producer_waiters_);
+      continue;
+    }
+    if (!is_running && sequence == next_sequence_.load()) {
+      break;
+    }
+    park(
+      results_available_, writer_waiters_, [this, sequence] {
+        return result_ready(sequence) || !writer_is_running_;
+      });
+  }
+}
+
+}  // namespace rosbag2_compression
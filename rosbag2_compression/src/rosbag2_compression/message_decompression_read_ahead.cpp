@@ -0,0 +1,165 @@
+// Copyright 2022, Open Source Robotics Corporation.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "rosbag2_compression/message_decompression_read_ahead.hpp"
+
+#include <algorithm>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+
+namespace rosbag2_compression
+{
+
+MessageDecompressionReadAhead::MessageDecompressionReadAhead(
+  uint64_t num_threads,
+  uint64_t window_size,
+  DecompressFunctionFactory make_decompress_function)
+: window_size_(window_size),
+  make_decompress_function_(std::move(make_decompress_function))
+{
+  for (uint64_t i = 0; i < std::max<uint64_t>(num_threads, 1u); i++) {
+    decompression_threads_.emplace_back([this] {decompression_thread_fn();});
+  }
+}
+
+MessageDecompressionReadAhead::~MessageDecompressionReadAhead()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    is_running_ = false;
+    jobs_.clear();
+  }
+  jobs_available_.notify_all();
+  for (auto & thread : decompression_threads_) {
+    thread.join();
+  }
+}
+
+void MessageDecompressionReadAhead::push(MessageSharedPtr message)
+{
+  auto entry = std::make_shared<Entry>();
+  entry->size = message->serialized_data ? message->serialized_data->buffer_length : 0u;
+  entry->message = std::move(message);
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    window_bytes_ += entry->size;
+    window_.push_back(entry);
+    jobs_.push_back(std::move(entry));
+  }
+  jobs_available_.notify_one();
+}
+
+bool MessageDecompressionReadAhead::is_full() const
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  return !window_.empty() && window_bytes_ >= window_size_;
+}
+
+bool MessageDecompressionReadAhead::empty() const
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  return window_.empty();
+}
+
+MessageDecompressionReadAhead::MessageSharedPtr MessageDecompressionReadAhead::pop()
+{
+  std::unique_lock<std::mutex> lock(mutex_);
+  if (window_.empty()) {
+    throw std::runtime_error("No message was read ahead.");
+  }
+  auto entry = window_.front();
+  message_decompressed_.wait(lock, [&entry] {return entry->is_decompressed;});
+  window_.pop_front();
+  remove_from_window(*entry);
+  if (entry->error) {
+    std::rethrow_exception(entry->error);
+  }
+  return std::move(entry->message);
+}
+
+void MessageDecompressionReadAhead::remove_if(
+  const std::function<bool(const rosbag2_storage::SerializedBagMessage &)> & predicate)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  // Only the topic and time stamp may be looked at, the data may be in the middle of
+  // decompression.
+  const auto remove = [this, &predicate](const std::shared_ptr<Entry> & entry) {
+      if (!predicate(*entry->message)) {
+        return false;
+      }
+      remove_from_window(*entry);
+      return true;
+    };
+  window_.erase(std::remove_if(window_.begin(), window_.end(), remove), window_.end());
+  jobs_.erase(
+    std::remove_if(
+      jobs_.begin(), jobs_.end(),
+      [](const std::shared_ptr<Entry> & entry) {return !entry->in_window;}),
+    jobs_.end());
+}
+
+void MessageDecompressionReadAhead::clear()
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  // Messages being decompressed right now are dropped by their thread once it is done.
+  for (auto & entry : window_) {
+    remove_from_window(*entry);
+  }
+  window_.clear();
+  jobs_.clear();
+}
+
+void MessageDecompressionReadAhead::remove_from_window(Entry & entry)
+{
+  entry.in_window = false;
+  window_bytes_ -= entry.size;
+}
+
+void MessageDecompressionReadAhead::decompression_thread_fn()
+{
+  // Every thread needs to have its own decompression context for thread safety.
+  const auto decompress = make_decompress_function_();
+
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true) {
+    jobs_available_.wait(lock, [this] {return !jobs_.empty() || !is_running_;});
+    if (!is_running_) {
+      return;
+    }
+    auto entry = std::move(jobs_.front());
+    jobs_.pop_front();
+
+    lock.unlock();
+    std::exception_ptr error;
+    try {
+      decompress(entry->message.get());
+    } catch (...) {
+      error = std::current_exception();
+    }
+    const size_t size =
+      entry->message->serialized_data ? entry->message->serialized_data->buffer_length : 0u;
+    lock.lock();
+
+    entry->error = error;
+    entry->is_decompressed = true;
+    if (entry->in_window) {
+      window_bytes_ = window_bytes_ - entry->size + size;
+      entry->size = size;
+      message_decompressed_.notify_all();
+    }
+  }
+}
+
+}  // namespace rosbag2_compression
@@ -14,21 +14,190 @@
 
 #include "rosbag2_compression/sequential_compression_reader.hpp"
 
+#include <atomic>
 #include <memory>
 #include <stdexcept>
 #include <string>
+#include <unordered_map>
+#include <unordered_set>
 #include <utility>
 #include <vector>
 
 #include "rcpputils/asserts.hpp"
 #include "rcpputils/filesystem_helper.hpp"
 
+#include "rosbag2_compression/chunk_compression_storage.hpp"
 #include "rosbag2_compression/compression_options.hpp"
+#include "rosbag2_compression/file_decompression_read_ahead.hpp"
+
+#include "rosbag2_storage/storage_filter.hpp"
 
 #include "logging.hpp"
 
 namespace rosbag2_compression
 {
+namespace
+{
+/**
+ * Storage factory opening the files of a FILE compressed bag.
+ *
+ * Files which the decompressor can read ranges of, e.g. in a seekable format, are handed to the
+ * storage plugin as range readers if it supports them, so that only the parts of the file which
+ * the storage reads get decompressed.
+ * Other files are decompressed into memory and handed to the storage plugin from there, as long as
+ * they fit into StorageOptions::max_decompression_buffer_size and the plugin can read from memory.
+ * Otherwise they are decompressed next to the compressed file, once per file.
+ *
+ * With a read ahead decompressor, the files following the one being opened are decompressed in
+ * the background. Files it decompresses to disk are removed once their storage is released.
+ */
+class FileDecompressionStorageFactory : public rosbag2_storage::StorageFactoryInterface
+{
+public:
+  FileDecompressionStorageFactory(
+    std::unique_ptr<rosbag2_storage::StorageFactoryInterface> storage_factory,
+    std::shared_ptr<BaseDecompressorInterface> decompressor,
+    std::shared_ptr<BaseDecompressorInterface> read_ahead_decompressor,
+    const std::vector<std::string> & uris,
+    const rosbag2_storage::StorageOptions & storage_options)
+  : storage_factory_(std::move(storage_factory)),
+    decompressor_(std::move(decompressor))
+  {
+    if (!read_ahead_decompressor) {
+      return;
+    }
+    const auto max_buffer_size = storage_options.max_decompression_buffer_size;
+    read_ahead_ = std::make_unique<FileDecompressionReadAhead>(
+      uris, storage_options.decompression_read_ahead_files,
+      [this, read_ahead_decompressor, max_buffer_size](const std::string & uri) {
+        FileDecompressionReadAhead::DecompressedFile file;
+        auto buffer = std::make_shared<std::vector<uint8_t>>();
+        if (decompress_to_memory_ &&
+        read_ahead_decompressor->decompress_uri_to_buffer(uri, max_buffer_size, *buffer))
+        {
+          file.buffer = std::move(buffer);
+        } else {
+          file.uri = read_ahead_decompressor->decompress_uri(uri);
+        }
+        return file;
+      });
+  }
+
+  std::shared_ptr<rosbag2_storage::storage_interfaces::ReadOnlyInterface>
+  open_read_only(const rosbag2_storage::StorageOptions & storage_options) override
+  {
+    const auto & uri = storage_options.uri;
+    auto decompressed_options = storage_options;
+    const auto decompressed_uri = decompressed_uris_.find(uri);
+    if (decompressed_uri != decompressed_uris_.end()) {
+      decompressed_options.uri = decompressed_uri->second;
+      return storage_factory_->open_read_only(decompressed_options);
+    }
+
+    if (read_ranges_) {
+      auto range_reader = decompressor_->open_uri_for_range_reads(uri);
+      if (range_reader) {
+        decompressed_options.uri =
+          rcpputils::fs::remove_extension(rcpputils::fs::path{uri}).string();
+        auto storage = storage_factory_->open_read_only_from_range_reader(
+          decompressed_options, std::move(range_reader));
+        if (storage) {
+          ROSBAG2_COMPRESSION_LOG_DEBUG_STREAM("Reading " << uri << " through range reads.");
+          return storage;
+        }
+        // The storage plugin can not read through range reads, no need to try again.
+        read_ranges_ = false;
+      }
+    }
+
+    FileDecompressionReadAhead::DecompressedFile file;
+    if (read_ahead_ && read_ahead_->take(uri, file)) {
+      if (file.buffer) {
+        decompressed_options.uri =
+          rcpputils::fs::remove_extension(rcpputils::fs::path{uri}).string();
+        auto storage = open_read_only_from_buffer(decompressed_options, std::move(file.buffer));
+        if (storage) {
+          return storage;
+        }
+      } else {
+        decompressed_options.uri = file.uri;
+        return open_read_only_and_remove(decompressed_options);
+      }
+    }
+
+    auto buffer = std::make_shared<std::vector<uint8_t>>();
+    if (decompress_to_memory_ &&
+      decompressor_->decompress_uri_to_buffer(
+        uri, storage_options.max_decompression_buffer_size, *buffer))
+    {
+      ROSBAG2_COMPRESSION_LOG_DEBUG_STREAM(
+        "Decompressed " << uri << " into memory, " << buffer->size() << " bytes.");
+      decompressed_options.uri = rcpputils::fs::remove_extension(rcpputils::fs::path{uri}).string();
+      auto storage = open_read_only_from_buffer(decompressed_options, std::move(buffer));
+      if (storage) {
+        return storage;
+      }
+    }
+
+    ROSBAG2_COMPRESSION_LOG_INFO_STREAM("Decompressing " << uri);
+    decompressed_options.uri = decompressor_->decompress_uri(uri);
+    decompressed_uris_.emplace(uri, decompressed_options.uri);
+    return storage_factory_->open_read_only(decompressed_options);
+  }
+
+  std::shared_ptr<rosbag2_storage::storage_interfaces::ReadWriteInterface>
+  open_read_write(const rosbag2_storage::StorageOptions & storage_options) override
+  {
+    return storage_factory_->open_read_write(storage_options);
+  }
+
+private:
+  std::shared_ptr<rosbag2_storage::storage_interfaces::ReadOnlyInterface>
+  open_read_only_from_buffer(
+    const rosbag2_storage::StorageOptions & storage_options,
+    std::shared_ptr<std::vector<uint8_t>> buffer)
+  {
+    auto storage = storage_factory_->open_read_only_from_buffer(storage_options, std::move(buffer));
+    if (!storage) {
+      // The storage plugin can not read from memory, no need to try again for further files.
+      decompress_to_memory_ = false;
+    }
+    return storage;
+  }
+
+  // Opens a file decompressed to disk, which is removed again when the storage is released.
+  std::shared_ptr<rosbag2_storage::storage_interfaces::ReadOnlyInterface>
+  open_read_only_and_remove(const rosbag2_storage::StorageOptions & storage_options)
+  {
+    auto storage = storage_factory_->open_read_only(storage_options);
+    const rcpputils::fs::path path{storage_options.uri};
+    if (!storage) {
+      rcpputils::fs::remove(path);
+      return nullptr;
+    }
+    auto * const storage_ptr = storage.get();
+    return std::shared_ptr<rosbag2_storage::storage_interfaces::ReadOnlyInterface>(
+      storage_ptr,
+      [storage, path](rosbag2_storage::storage_interfaces::ReadOnlyInterface *) mutable {
+        // Close the file before removing it.
+        storage.reset();
+        rcpputils::fs::remove(path);
+      });
+  }
+
+  std::unique_ptr<rosbag2_storage::StorageFactoryInterface> storage_factory_;
+  std::shared_ptr<BaseDecompressorInterface> decompressor_;
+  // Files decompressed to disk, by the path of their compressed file.
+  std::unordered_map<std::string, std::string> decompressed_uris_;
+  // Cleared once the storage plugin turned out not to read through range reads.
+  bool read_ranges_{true};
+  // Cleared once the storage plugin turned out not to read from memory.
+  std::atomic_bool decompress_to_memory_{true};
+  // Declared last, its decompression thread uses the members above.
+  std::unique_ptr<FileDecompressionReadAhead> read_ahead_;
+};
+}  // namespace
+
 SequentialCompressionReader::SequentialCompressionReader(
   std::unique_ptr<rosbag2_compression::CompressionFactory> compression_factory,
   std::unique_ptr<rosbag2_storage::StorageFactoryInterface> storage_factory,
@@ -54,6 +223,58 @@ void SequentialCompressionReader::setup_decompression()
 
   decompressor_ = compression_factory_->create_decompressor(metadata_.compression_format);
   rcpputils::check_true(decompressor_ != nullptr, "Couldn't initialize decompressor.");
+  for (const auto & dictionary : metadata_.compression_dictionaries) {
+    decompressor_->add_dictionary(dictionary.first, dictionary.second);
+  }
+  uncompressed_topics_ = std::unordered_set<std::string>(
+    metadata_.uncompressed_topics.begin(), metadata_.uncompressed_topics.end());
+
+  if (compression_mode_ == rosbag2_compression::CompressionMode::CHUNK) {
+    // Chunks are unpacked in memory by the storage, no file needs to be decompressed.
+    storage_factory_ = std::make_unique<ChunkCompressionStorageFactory>(
+      std::move(storage_factory_), nullptr, decompressor_, 0u);
+  } else if (compression_mode_ == rosbag2_compression::CompressionMode::FILE) {
+    // Files are decompressed when the storage opens them, into memory where possible, or ahead
+    // of that on a thread with its own decompressor.
+    std::shared_ptr<BaseDecompressorInterface> read_ahead_decompressor;
+    if (storage_options_.decompression_read_ahead_files > 0) {
+      read_ahead_decompressor =
+        compression_factory_->create_decompressor(metadata_.compression_format);
+      rcpputils::check_true(
+        read_ahead_decompressor != nullptr, "Couldn't initialize decompressor.");
+    }
+    storage_factory_ = std::make_unique<FileDecompressionStorageFactory>(
+      std::move(storage_factory_), decompressor_, read_ahead_decompressor, file_paths_,
+      storage_options_);
+  } else if (storage_options_.decompression_threads > 0) {
+    read_ahead_ = std::make_unique<MessageDecompressionReadAhead>(
+      storage_options_.decompression_threads,
+      storage_options_.decompression_read_ahead_size,
+      [this]() -> MessageDecompressionReadAhead::DecompressFunction {
+        std::shared_ptr<BaseDecompressorInterface> thread_decompressor =
+        compression_factory_->create_decompressor(metadata_.compression_format);
+        rcpputils::check_true(thread_decompressor != nullptr, "Couldn't initialize decompressor.");
+        for (const auto & dictionary : metadata_.compression_dictionaries) {
+          thread_decompressor->add_dictionary(dictionary.first, dictionary.second);
+        }
+        return [this, thread_decompressor](rosbag2_storage::SerializedBagMessage * message) {
+                 decompress_message(*thread_decompressor, message);
+               };
+      });
+  }
+}
+
+void SequentialCompressionReader::decompress_message(
+  BaseDecompressorInterface & decompressor,
+  rosbag2_storage::SerializedBagMessage * message) const
+{
+  // The writer only stores messages uncompressed which can't be mistaken for compressed ones.
+  if (uncompressed_topics_.count(message->topic_name) != 0 &&
+    !decompressor.is_compressed_message(*message))
+  {
+    return;
+  }
+  decompressor.decompress_serialized_bag_message(message);
 }
 
 void SequentialCompressionReader::preprocess_current_file()
@@ -82,11 +303,6 @@ void SequentialCompressionReader::preprocess_current_file()
       *current_file_iterator_ = resolved_stripped.string();
     }
   }
-
-  if (compression_mode_ == CompressionMode::FILE) {
-    ROSBAG2_COMPRESSION_LOG_INFO_STREAM("Decompressing " << get_current_file().c_str());
-    *current_file_iterator_ = decompressor_->decompress_uri(get_current_file());
-  }
 }
 
 void SequentialCompressionReader::open(
@@ -99,21 +315,71 @@ void SequentialCompressionReader::open(
       "\". Bags without metadata (such as from ROS 1) not supported by rosbag2 decompression.";
     throw std::runtime_error{errmsg.str()};
   }
+  storage_options_ = storage_options;
   SequentialReader::open(storage_options, converter_options);
 }
 
+void SequentialCompressionReader::close()
+{
+  if (read_ahead_) {
+    read_ahead_->clear();
+  }
+  SequentialReader::close();
+}
+
+bool SequentialCompressionReader::has_next()
+{
+  if (read_ahead_ && !read_ahead_->empty()) {
+    return true;
+  }
+  return SequentialReader::has_next();
+}
+
 std::shared_ptr<rosbag2_storage::SerializedBagMessage> SequentialCompressionReader::read_next()
 {
+  if (storage_ && read_ahead_) {
+    // Top up the window, which rolls over to the next file if necessary. A file without
+    // messages ends the top up until the window has been drained.
+    while (!read_ahead_->is_full() && SequentialReader::has_next() && storage_->has_next()) {
+      read_ahead_->push(storage_->read_next());
+    }
+    if (read_ahead_->empty()) {
+      throw std::runtime_error("Bag is at end. No next message.");
+    }
+    auto message = read_ahead_->pop();
+    return converter_ ? converter_->convert(message) : message;
+  }
   if (storage_ && decompressor_) {
     // roll over if necessary
     has_next();
     auto message = storage_->read_next();
     if (compression_mode_ == rosbag2_compression::CompressionMode::MESSAGE) {
-      decompressor_->decompress_serialized_bag_message(message.get());
+      decompress_message(*decompressor_, message.get());
     }
     return converter_ ? converter_->convert(message) : message;
   }
   throw std::runtime_error{"Bag is not open. Call open() before reading."};
 }
 
+void SequentialCompressionReader::set_filter(
+  const rosbag2_storage::StorageFilter & storage_filter)
+{
+  if (read_ahead_) {
+    // Messages read ahead with the previous filter are still handed out if the new one keeps them.
+    read_ahead_->remove_if(
+      [&storage_filter](const rosbag2_storage::SerializedBagMessage & message) {
+        return !rosbag2_storage::topic_passes_filter(message.topic_name, storage_filter);
+      });
+  }
+  SequentialReader::set_filter(storage_filter);
+}
+
+void SequentialCompressionReader::seek(const rcutils_time_point_value_t & timestamp)
+{
+  if (read_ahead_) {
+    read_ahead_->clear();
+  }
+  SequentialReader::seek(timestamp);
+}
+
 }  // namespace rosbag2_compression
@@ -18,9 +18,11 @@
 #include <chrono>
 #include <functional>
 #include <memory>
+#include <shared_mutex>
 #include <stdexcept>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include "rcpputils/asserts.hpp"
 #include "rcpputils/filesystem_helper.hpp"
@@ -32,10 +34,28 @@
 #include "rosbag2_storage/storage_options.hpp"
 #include "rosbag2_storage/storage_interfaces/read_write_interface.hpp"
 
+#include "rosbag2_compression/chunk_compression_storage.hpp"
+
 #include "logging.hpp"
 
 namespace rosbag2_compression
 {
+namespace
+{
+size_t get_data_length(const rosbag2_storage::SerializedBagMessage & message)
+{
+  return message.serialized_data ? message.serialized_data->buffer_length : 0u;
+}
+
+bool has_topic_policies(const CompressionOptions & compression_options)
+{
+  return compression_options.compression_policy != TopicCompressionPolicy::ALWAYS ||
+         std::any_of(
+    compression_options.compression_topic_policies.begin(),
+    compression_options.compression_topic_policies.end(),
+    [](const auto & topic_policy) {return topic_policy.second != TopicCompressionPolicy::ALWAYS;});
+}
+}  // namespace
 
 SequentialCompressionWriter::SequentialCompressionWriter(
   const rosbag2_compression::CompressionOptions & compression_options)
@@ -66,44 +86,43 @@ void SequentialCompressionWriter::compression_thread_fn()
   auto compressor = compression_factory_->create_compressor(
     compression_options_.compression_format);
   rcpputils::check_true(compressor != nullptr, "Could not create compressor.");
+  if (compression_options_.compression_level != 0) {
+    compressor->set_compression_level(compression_options_.compression_level);
+  }
+  compressor->set_seekable_frame_size(compression_options_.compression_seekable_frame_size);
 
   while (true) {
-    std::shared_ptr<const rosbag2_storage::SerializedBagMessage> message;
     std::string file;
+    uint64_t workers = 0;
     {
       std::unique_lock<std::mutex> lock(compressor_queue_mutex_);
       compressor_condition_.wait(
         lock,
         [&] {
-          return !compression_is_running_ ||
-          !compressor_message_queue_.empty() ||
-          !compressor_file_queue_.empty();
+          return !compression_is_running_ || !compressor_file_queue_.empty();
         });
 
-      if (!compressor_message_queue_.empty()) {
-        message = compressor_message_queue_.front();
-        compressor_message_queue_.pop();
-        compressor_condition_.notify_all();
-      } else if (!compressor_file_queue_.empty()) {
+      if (!compressor_file_queue_.empty()) {
         file = compressor_file_queue_.front();
         compressor_file_queue_.pop();
+        // Split the worker budget between the files compressed at the same time. Files already
+        // being compressed keep their workers, so the budget is only exceeded while they finish.
+        files_in_compression_++;
+        if (compression_options_.compression_file_workers > 0) {
+          workers = std::max<uint64_t>(
+            1, compression_options_.compression_file_workers / files_in_compression_);
+        }
       } else if (!compression_is_running_) {
         // I woke up, all work queues are empty, and the main thread has stopped execution. Exit.
         break;
       }
     }
 
-    if (message) {
-      auto compressed_message = compress_message(*compressor, message);
-
-      {
-        // Now that the message is compressed, it can be written to file using the
-        // normal method.
-        std::lock_guard<std::recursive_mutex> storage_lock(storage_mutex_);
-        SequentialWriter::write(compressed_message);
-      }
-    } else if (!file.empty()) {
+    if (!file.empty()) {
+      compressor->set_compression_workers(workers);
       compress_file(*compressor, file);
+      std::lock_guard<std::mutex> lock(compressor_queue_mutex_);
+      files_in_compression_--;
     }
   }
 }
@@ -124,6 +143,45 @@ void SequentialCompressionWriter::setup_compression()
             "SequentialCompressionWriter requires a CompressionMode that is not NONE!"};
   }
 
+  if (compression_options_.adaptive_compression_level) {
+    // The default level of a format is unknown here, so the range needs an explicit upper bound
+    if (compression_options_.compression_level == 0) {
+      throw std::invalid_argument{
+              "Adaptive compression level requires a compression level other than 0."};
+    }
+    if (compression_options_.compression_level <= compression_options_.min_compression_level) {
+      throw std::invalid_argument{
+              "Adaptive compression level requires a compression level greater than the minimum "
+              "compression level."};
+    }
+    if (compression_options_.compression_mode != CompressionMode::MESSAGE) {
+      ROSBAG2_COMPRESSION_LOG_WARN(
+        "Adaptive compression level is only supported in MESSAGE mode, using a fixed level.");
+    }
+  }
+
+  if (compression_options_.compression_file_workers > 0 &&
+    compression_options_.compression_mode != CompressionMode::FILE)
+  {
+    ROSBAG2_COMPRESSION_LOG_WARN("Compression file workers are only used in FILE mode.");
+  }
+  if (compression_options_.compression_seekable_frame_size > 0 &&
+    compression_options_.compression_mode != CompressionMode::FILE)
+  {
+    ROSBAG2_COMPRESSION_LOG_WARN("Seekable compression frames are only written in FILE mode.");
+  }
+  if (has_topic_policies(compression_options_) &&
+    compression_options_.compression_mode != CompressionMode::MESSAGE)
+  {
+    ROSBAG2_COMPRESSION_LOG_WARN(
+      "Topic compression policies are only used in MESSAGE mode, compressing all topics.");
+  }
+
+  if (compression_options_.compression_mode == rosbag2_compression::CompressionMode::CHUNK) {
+    // No compressor threads, chunks are compressed while they are written to storage.
+    return;
+  }
+
   setup_compressor_threads();
 }
 
@@ -150,6 +208,104 @@ void SequentialCompressionWriter::setup_compressor_threads()
   auto compressor = compression_factory_->create_compressor(
     compression_options_.compression_format);
   rcpputils::check_true(compressor != nullptr, "Could not create compressor.");
+  // Likewise for the levels, which the compressor validates.
+  if (compression_options_.compression_level != 0) {
+    compressor->set_compression_level(compression_options_.compression_level);
+  }
+
+  if (compression_options_.compression_mode == CompressionMode::MESSAGE) {
+    if (compression_options_.compression_level != 0) {
+      auto min_level = compression_options_.compression_level;
+      if (compression_options_.adaptive_compression_level) {
+        min_level = compression_options_.min_compression_level;
+        compressor->set_compression_level(min_level);
+      }
+      compression_level_ = std::make_unique<AdaptiveCompressionLevel>(
+        min_level, compression_options_.compression_level);
+    }
+    if (has_topic_policies(compression_options_)) {
+      topic_policies_ = std::make_unique<TopicCompressionPolicies>(
+        compression_options_,
+        [this](const std::string & topic_name) {
+          std::lock_guard<std::recursive_mutex> storage_lock(storage_mutex_);
+          std::lock_guard<std::shared_timed_mutex> state_lock(writer_state_mutex_);
+          auto & topics = metadata_.uncompressed_topics;
+          topics.insert(std::upper_bound(topics.begin(), topics.end(), topic_name), topic_name);
+        });
+    }
+    if (compression_options_.compression_dictionary_samples > 0) {
+      dictionary_trainer_ = std::make_unique<CompressionDictionaryTrainer>(
+        compression_options_.compression_dictionary_samples,
+        [this](const std::string & topic_name, const std::vector<uint8_t> & dictionary) {
+          std::lock_guard<std::recursive_mutex> storage_lock(storage_mutex_);
+          std::lock_guard<std::shared_timed_mutex> state_lock(writer_state_mutex_);
+          metadata_.compression_dictionaries[topic_name] = dictionary;
+        });
+    }
+    // Compression threads only compress; the pipeline hands the results to storage from a
+    // single thread, in the order in which the messages were written.
+    message_compression_pipeline_ = std::make_unique<MessageCompressionPipeline>(
+      compression_options_.compression_threads,
+      compression_options_.compression_queue_size,
+      [this]() -> MessageCompressionPipeline::CompressFunction {
+        std::shared_ptr<BaseCompressorInterface> thread_compressor =
+        compression_factory_->create_compressor(compression_options_.compression_format);
+        rcpputils::check_true(thread_compressor != nullptr, "Could not create compressor.");
+        // Tells which messages could be mistaken for compressed ones if stored uncompressed.
+        std::shared_ptr<BaseDecompressorInterface> thread_decompressor;
+        if (topic_policies_) {
+          thread_decompressor =
+            compression_factory_->create_decompressor(compression_options_.compression_format);
+          rcpputils::check_true(thread_decompressor != nullptr, "Could not create decompressor.");
+        }
+        // Each function object is only ever called from its own thread, so it keeps the state of
+        // its compressor in mutable captures.
+        return [this, thread_compressor, thread_decompressor,
+          applied_dictionaries = size_t{0}, level = int32_t{0}](
+          std::shared_ptr<const rosbag2_storage::SerializedBagMessage> message) mutable
+          -> std::shared_ptr<const rosbag2_storage::SerializedBagMessage> {
+            if (topic_policies_ && !topic_policies_->should_compress(message->topic_name) &&
+              !thread_decompressor->is_compressed_message(*message))
+            {
+              const auto data_length = get_data_length(*message);
+              compression_statistics_->add(
+                message->topic_name, data_length, data_length, std::chrono::nanoseconds{0});
+              return message;
+            }
+            if (compression_level_) {
+              const auto new_level = compression_level_->get_level();
+              if (new_level != level) {
+                thread_compressor->set_compression_level(new_level);
+                level = new_level;
+              }
+              compression_level_->count_message(level);
+            }
+            if (dictionary_trainer_) {
+              dictionary_trainer_->apply_new_dictionaries(
+                *thread_compressor, applied_dictionaries);
+            }
+            const auto start = std::chrono::steady_clock::now();
+            auto compressed_message = compress_message(*thread_compressor, message);
+            compression_statistics_->add(
+              message->topic_name, get_data_length(*message),
+              get_data_length(*compressed_message), std::chrono::steady_clock::now() - start);
+            if (topic_policies_) {
+              topic_policies_->add_sample(
+                message->topic_name, get_data_length(*message),
+                get_data_length(*compressed_message));
+            }
+            if (dictionary_trainer_) {
+              dictionary_trainer_->add_sample(message, *thread_compressor);
+            }
+            return compressed_message;
+          };
+      },
+      [this](std::shared_ptr<const rosbag2_storage::SerializedBagMessage> compressed_message) {
+        std::lock_guard<std::recursive_mutex> storage_lock(storage_mutex_);
+        SequentialWriter::write(compressed_message);
+      });
+    return;
+  }
 
   for (uint64_t i = 0; i < compression_options_.compression_threads; i++) {
     compression_threads_.emplace_back([&] {compression_thread_fn();});
@@ -158,6 +314,25 @@ void SequentialCompressionWriter::setup_compressor_threads()
 
 void SequentialCompressionWriter::stop_compressor_threads()
 {
+  if (message_compression_pipeline_) {
+    ROSBAG2_COMPRESSION_LOG_DEBUG("Waiting for message compression pipeline to finish.");
+    message_compression_pipeline_->stop();
+    const auto dropped_count = message_compression_pipeline_->get_dropped_count();
+    if (dropped_count > 0) {
+      ROSBAG2_COMPRESSION_LOG_WARN_STREAM(
+        "Dropped " << dropped_count << " messages because the compression queue was full.");
+    }
+    message_compression_pipeline_.reset();
+    dictionary_trainer_.reset();
+    if (compression_level_) {
+      std::lock_guard<std::recursive_mutex> storage_lock(storage_mutex_);
+      std::lock_guard<std::shared_timed_mutex> state_lock(writer_state_mutex_);
+      metadata_.compression_levels = compression_level_->get_message_counts();
+      compression_level_.reset();
+    }
+    // Uncompressed topics were added to the metadata as they came up
+    topic_policies_.reset();
+  }
   if (!compression_threads_.empty()) {
     ROSBAG2_COMPRESSION_LOG_DEBUG("Waiting for compressor threads to finish.");
     {
@@ -177,13 +352,40 @@ void SequentialCompressionWriter::open(
   const rosbag2_cpp::ConverterOptions & converter_options)
 {
   std::lock_guard<std::recursive_mutex> lock(storage_mutex_);
+  compression_statistics_ = std::make_shared<CompressionStatisticsCollector>();
+  if (compression_options_.compression_mode == CompressionMode::CHUNK) {
+    // Chunks are compressed by the storage itself, on the thread writing to it.
+    auto compressor = compression_factory_->create_compressor(
+      compression_options_.compression_format);
+    rcpputils::check_true(compressor != nullptr, "Could not create compressor.");
+    if (compression_options_.compression_level != 0) {
+      compressor->set_compression_level(compression_options_.compression_level);
+    }
+    storage_factory_ = std::make_unique<ChunkCompressionStorageFactory>(
+      std::move(storage_factory_), compressor, nullptr,
+      compression_options_.compression_chunk_size, compression_statistics_);
+  }
   SequentialWriter::open(storage_options, converter_options);
   setup_compression();
 }
 
 void SequentialCompressionWriter::close()
 {
+  // The metadata is written a last time below, once the last file is compressed
+  stop_checkpointing();
+
   if (!base_folder_.empty()) {
+    if (compression_options_.compression_mode == rosbag2_compression::CompressionMode::CHUNK) {
+      // Drain the cache into the storage first, then close the storage so that it writes its
+      // last chunk before the file sizes are collected for the metadata.
+      if (use_cache_) {
+        cache_consumer_.reset();
+        message_cache_.reset();
+      }
+      std::lock_guard<std::recursive_mutex> lock(storage_mutex_);
+      storage_.reset();
+    }
+
     // Reset may be called before initializing the compressor (ex. bad options).
     // We compress the last file only if it hasn't been compressed earlier (ex. in split_bagfile()).
     if (compression_options_.compression_mode == rosbag2_compression::CompressionMode::FILE &&
@@ -205,6 +407,9 @@ void SequentialCompressionWriter::close()
 
     stop_compressor_threads();
 
+    if (compression_statistics_) {
+      metadata_.compression_statistics = compression_statistics_->get_statistics();
+    }
     finalize_metadata();
     metadata_io_->write_metadata(base_folder_, metadata_);
   }
@@ -241,13 +446,24 @@ void SequentialCompressionWriter::compress_file(
   ROSBAG2_COMPRESSION_LOG_INFO_STREAM("Compressing file: " << file_relative_to_pwd.string());
 
   if (file_relative_to_pwd.exists() && file_relative_to_pwd.file_size() > 0u) {
+    const auto file_size = file_relative_to_pwd.file_size();
+    const auto start = std::chrono::steady_clock::now();
     const auto compressed_uri = compressor.compress_uri(file_relative_to_pwd.string());
-    const auto relative_compressed_uri = path(compressed_uri).filename();
+    const auto compression_time = std::chrono::steady_clock::now() - start;
+    const auto compressed_path = path(compressed_uri);
+    // A file holds messages of several topics.
+    compression_statistics_->add(
+      "", file_size, compressed_path.exists() ? compressed_path.file_size() : 0u,
+      compression_time);
+    const auto relative_compressed_uri = compressed_path.filename();
+    MetadataCheckpoint checkpoint;
     {
       // After we've compressed the file, replace the name in the file list with the new name.
       // Must search for the entry because other threads may have changed the order of the vector
       // and invalidated any index or iterator we held to it.
-      std::lock_guard<std::recursive_mutex> lock(storage_mutex_);
+      // Only the writer state is locked: writes hold it while splitting, which takes the storage
+      // lock.
+      std::lock_guard<std::shared_timed_mutex> state_lock(writer_state_mutex_);
       const auto iter = std::find(
         metadata_.relative_file_paths.begin(),
         metadata_.relative_file_paths.end(),
@@ -259,6 +475,18 @@ void SequentialCompressionWriter::compress_file(
           "Failed to find path to uncompressed bag: \"" << file_relative_to_pwd.string() <<
             "\"; this shouldn't happen.");
       }
+      if (storage_options_.metadata_checkpoint_interval > 0u) {
+        checkpoint = take_metadata_checkpoint();
+      }
+    }
+    if (checkpoint.sequence > 0u) {
+      // List the compressed file before removing the uncompressed one, so that checkpointed
+      // metadata always names files which exist.
+      try {
+        write_metadata_checkpoint(checkpoint);
+      } catch (const std::exception & e) {
+        ROSBAG2_COMPRESSION_LOG_WARN_STREAM("Failed to checkpoint metadata: " << e.what());
+      }
     }
 
     if (!rcpputils::fs::remove(file_relative_to_pwd)) {
@@ -276,7 +504,8 @@ void SequentialCompressionWriter::compress_file(
 
 void SequentialCompressionWriter::split_bagfile()
 {
-  std::lock_guard<std::recursive_mutex> lock(storage_mutex_);
+  // Called holding writer_state_mutex_ exclusively, which already guards the storage. Taking
+  // storage_mutex_ here would invert the lock order.
   std::lock_guard<std::mutex> compressor_lock(compressor_queue_mutex_);
 
   // Grab last file before calling common splitting logic, which pushes the new filename
@@ -313,34 +542,22 @@ void SequentialCompressionWriter::write(
   std::shared_ptr<const rosbag2_storage::SerializedBagMessage> message)
 {
   // If the compression mode is FILE, write as normal here.  Compressing files doesn't
-  // occur until after the bag file is split.
-  // If the compression mode is MESSAGE, push the message into a queue that will be handled
-  // by the compression threads.
-  if (compression_options_.compression_mode == CompressionMode::FILE) {
+  // occur until after the bag file is split. In CHUNK mode the storage compresses the messages.
+  // If the compression mode is MESSAGE, push the message into the compression pipeline, which
+  // drops the oldest waiting message when the queue is full and compression_queue_size > 0.
+  // With an adaptive compression level, the pipeline's load then steers the level.
+  if (compression_options_.compression_mode == CompressionMode::FILE ||
+    compression_options_.compression_mode == CompressionMode::CHUNK)
+  {
     SequentialWriter::write(message);
   } else {
-    std::unique_lock<std::mutex> lock(compressor_queue_mutex_);
-    while (compressor_message_queue_.size() > compression_options_.compression_queue_size &&
-      compression_options_.compression_queue_size > 0u)
-    {
-      compressor_message_queue_.pop();
+    if (!message_compression_pipeline_) {
+      throw std::runtime_error("Bag is not open. Call open() before writing.");
     }
-
-    // If no message should be dropped and the queue has still messages,
-    // compress and write immediately
-    if (compression_options_.compression_queue_size == 0u &&
-      compressor_message_queue_.size() > compression_options_.compression_threads)
-    {
-      compressor_condition_.wait(
-        lock,
-        [&] {
-          return !compression_is_running_ ||
-          compressor_message_queue_.size() <= compression_options_.compression_threads;
-        });
+    message_compression_pipeline_->push(message);
+    if (compression_options_.adaptive_compression_level && compression_level_) {
+      compression_level_->update(message_compression_pipeline_->get_load());
     }
-
-    compressor_message_queue_.push(message);
-    compressor_condition_.notify_one();
   }
 }
 
@@ -352,7 +569,7 @@ bool SequentialCompressionWriter::should_split_bagfile(
   {
     return false;
   } else {
-    std::lock_guard<std::recursive_mutex> lock(storage_mutex_);
+    // Called holding writer_state_mutex_, see split_bagfile()
     return SequentialWriter::should_split_bagfile(current_time);
   }
 }
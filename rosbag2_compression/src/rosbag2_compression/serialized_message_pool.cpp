@@ -0,0 +1,61 @@
+// Copyright 2022, Open Source Robotics Corporation.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "rosbag2_compression/serialized_message_pool.hpp"
+
+#include <atomic>
+#include <memory>
+#include <stdexcept>
+
+#include "rosbag2_storage/ros_helper.hpp"
+
+namespace rosbag2_compression
+{
+
+SerializedMessagePool::SerializedMessagePool(size_t max_size)
+: max_size_(max_size)
+{
+  arrays_.reserve(max_size_);
+}
+
+std::shared_ptr<rcutils_uint8_array_t> SerializedMessagePool::acquire(size_t capacity)
+{
+  for (size_t i = 0; i < arrays_.size(); i++) {
+    const auto index = (next_ + i) % arrays_.size();
+    auto & array = arrays_[index];
+    if (array.use_count() != 1) {
+      continue;
+    }
+    // The last other owner released the array with a release decrement of the use count; make its
+    // accesses to the buffer happen before ours.
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (array->buffer_capacity < capacity) {
+      if (rcutils_uint8_array_resize(array.get(), capacity) != RCUTILS_RET_OK) {
+        throw std::runtime_error{"Failed to resize a pooled serialized message."};
+      }
+    }
+    array->buffer_length = 0;
+    next_ = index + 1;
+    return array;
+  }
+
+  auto array = rosbag2_storage::make_empty_serialized_message(capacity);
+  if (arrays_.size() < max_size_) {
+    arrays_.push_back(array);
+    next_ = 0;
+  }
+  return array;
+}
+
+}  // namespace rosbag2_compression
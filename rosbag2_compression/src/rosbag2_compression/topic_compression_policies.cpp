@@ -0,0 +1,118 @@
+// Copyright 2022, Open Source Robotics Corporation.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "rosbag2_compression/topic_compression_policies.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "logging.hpp"
+
+namespace rosbag2_compression
+{
+
+TopicCompressionPolicies::TopicCompressionPolicies(
+  const CompressionOptions & compression_options,
+  UncompressedTopicCallback on_uncompressed_topic)
+: default_policy_(compression_options.compression_policy),
+  topic_policies_(compression_options.compression_topic_policies),
+  num_samples_(compression_options.compression_policy_samples),
+  min_ratio_(compression_options.compression_policy_min_ratio),
+  on_uncompressed_topic_(std::move(on_uncompressed_topic))
+{
+  const auto uses_auto = default_policy_ == TopicCompressionPolicy::AUTO || std::any_of(
+    topic_policies_.begin(), topic_policies_.end(), [](const auto & topic_policy) {
+      return topic_policy.second == TopicCompressionPolicy::AUTO;
+    });
+  if (uses_auto && num_samples_ == 0) {
+    throw std::invalid_argument("The AUTO compression policy needs at least one sample.");
+  }
+}
+
+bool TopicCompressionPolicies::should_compress(const std::string & topic_name)
+{
+  bool is_first_uncompressed = false;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto & topic = get_topic(topic_name);
+    if (topic.is_compressed) {
+      return true;
+    }
+    is_first_uncompressed = !topic.has_uncompressed_messages;
+    topic.has_uncompressed_messages = true;
+  }
+  // The topic must be listed with the bag before any of its messages is stored uncompressed.
+  if (is_first_uncompressed && on_uncompressed_topic_) {
+    on_uncompressed_topic_(topic_name);
+  }
+  return false;
+}
+
+void TopicCompressionPolicies::add_sample(
+  const std::string & topic_name, uint64_t input_bytes, uint64_t output_bytes)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto & topic = get_topic(topic_name);
+  if (topic.policy != TopicCompressionPolicy::AUTO || topic.samples >= num_samples_) {
+    return;
+  }
+  topic.samples++;
+  topic.input_bytes += input_bytes;
+  topic.output_bytes += output_bytes;
+  if (topic.samples < num_samples_ || topic.output_bytes == 0) {
+    return;
+  }
+  const auto ratio =
+    static_cast<double>(topic.input_bytes) / static_cast<double>(topic.output_bytes);
+  if (ratio < min_ratio_) {
+    topic.is_compressed = false;
+    ROSBAG2_COMPRESSION_LOG_INFO_STREAM(
+      "Storing messages of topic " << topic_name << " uncompressed, its first " << num_samples_ <<
+        " messages compressed with a ratio of " << ratio << " only.");
+  }
+}
+
+std::vector<std::string> TopicCompressionPolicies::get_uncompressed_topics() const
+{
+  std::vector<std::string> topic_names;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto & topic : topics_) {
+      if (topic.second.has_uncompressed_messages) {
+        topic_names.push_back(topic.first);
+      }
+    }
+  }
+  std::sort(topic_names.begin(), topic_names.end());
+  return topic_names;
+}
+
+TopicCompressionPolicies::Topic & TopicCompressionPolicies::get_topic(
+  const std::string & topic_name)
+{
+  auto it = topics_.find(topic_name);
+  if (it == topics_.end()) {
+    const auto policy_it = topic_policies_.find(topic_name);
+    Topic topic;
+    topic.policy = policy_it != topic_policies_.end() ? policy_it->second : default_policy_;
+    topic.is_compressed = topic.policy != TopicCompressionPolicy::NEVER;
+    it = topics_.emplace(topic_name, topic).first;
+  }
+  return it->second;
+}
+
+}  // namespace rosbag2_compression
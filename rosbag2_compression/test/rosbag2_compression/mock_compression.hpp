@@ -19,6 +19,7 @@
 
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "rosbag2_compression/base_compressor_interface.hpp"
 #include "rosbag2_compression/base_decompressor_interface.hpp"
@@ -37,9 +38,21 @@ class MockDecompressor : public rosbag2_compression::BaseDecompressorInterface
 {
 public:
   MOCK_METHOD1(decompress_uri, std::string(const std::string & uri));
+  MOCK_METHOD3(
+    decompress_uri_to_buffer,
+    bool(const std::string & uri, uint64_t max_size, std::vector<uint8_t> & buffer));
+  MOCK_METHOD1(
+    open_uri_for_range_reads,
+    std::shared_ptr<rosbag2_storage::RangeReaderInterface>(const std::string & uri));
   MOCK_METHOD1(
     decompress_serialized_bag_message,
     void(rosbag2_storage::SerializedBagMessage * bag_message));
+  MOCK_METHOD2(
+    add_dictionary,
+    void(const std::string & topic_name, const std::vector<uint8_t> & dictionary));
+  MOCK_CONST_METHOD1(
+    is_compressed_message,
+    bool(const rosbag2_storage::SerializedBagMessage & bag_message));
   MOCK_CONST_METHOD0(get_decompression_identifier, std::string());
 };
 
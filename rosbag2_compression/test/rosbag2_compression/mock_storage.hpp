@@ -47,6 +47,7 @@ public:
   MOCK_METHOD1(set_filter, void(const rosbag2_storage::StorageFilter &));
   MOCK_METHOD1(seek, void(const rcutils_time_point_value_t &));
   MOCK_CONST_METHOD0(get_bagfile_size, uint64_t());
+  MOCK_CONST_METHOD0(get_bagfile_size_estimate, uint64_t());
   MOCK_CONST_METHOD0(get_relative_file_path, std::string());
   MOCK_CONST_METHOD0(get_storage_identifier, std::string());
   MOCK_CONST_METHOD0(get_storage_extension, std::string());
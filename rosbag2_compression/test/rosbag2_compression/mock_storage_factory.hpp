@@ -36,6 +36,15 @@ public:
     open_read_write,
     std::shared_ptr<rosbag2_storage::storage_interfaces::ReadWriteInterface>(
       const rosbag2_storage::StorageOptions &));
+  MOCK_METHOD2(
+    open_read_only_from_buffer,
+    std::shared_ptr<rosbag2_storage::storage_interfaces::ReadOnlyInterface>(
+      const rosbag2_storage::StorageOptions &, std::shared_ptr<std::vector<uint8_t>>));
+  MOCK_METHOD2(
+    open_read_only_from_range_reader,
+    std::shared_ptr<rosbag2_storage::storage_interfaces::ReadOnlyInterface>(
+      const rosbag2_storage::StorageOptions &,
+      std::shared_ptr<rosbag2_storage::RangeReaderInterface>));
 };
 
 #endif  // ROSBAG2_COMPRESSION__MOCK_STORAGE_FACTORY_HPP_
@@ -0,0 +1,101 @@
+// Copyright 2022, Open Source Robotics Corporation.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gmock/gmock.h>
+
+#include <stdexcept>
+
+#include "rosbag2_compression/adaptive_compression_level.hpp"
+
+using namespace testing;  // NOLINT
+using rosbag2_compression::AdaptiveCompressionLevel;
+
+namespace
+{
+// Feeds enough updates for exactly one level change
+void update_once(AdaptiveCompressionLevel & compression_level, double load)
+{
+  for (uint64_t i = 0; i < AdaptiveCompressionLevel::kUpdateInterval; i++) {
+    compression_level.update(load);
+  }
+}
+}  // namespace
+
+TEST(AdaptiveCompressionLevelTest, starts_at_max_level)
+{
+  AdaptiveCompressionLevel compression_level(1, 9);
+  EXPECT_EQ(compression_level.get_level(), 9);
+}
+
+TEST(AdaptiveCompressionLevelTest, lowers_level_fast_under_high_load)
+{
+  AdaptiveCompressionLevel compression_level(1, 9);
+  update_once(compression_level, 0.9);
+  EXPECT_EQ(compression_level.get_level(), 5);
+  update_once(compression_level, 0.9);
+  EXPECT_EQ(compression_level.get_level(), 3);
+  update_once(compression_level, 0.9);
+  EXPECT_EQ(compression_level.get_level(), 2);
+  update_once(compression_level, 0.9);
+  update_once(compression_level, 0.9);
+  EXPECT_EQ(compression_level.get_level(), 1);
+}
+
+TEST(AdaptiveCompressionLevelTest, raises_level_by_one_with_headroom)
+{
+  AdaptiveCompressionLevel compression_level(1, 9);
+  update_once(compression_level, 1.0);
+  ASSERT_EQ(compression_level.get_level(), 5);
+
+  update_once(compression_level, 0.0);
+  EXPECT_EQ(compression_level.get_level(), 6);
+  for (int i = 0; i < 10; i++) {
+    update_once(compression_level, 0.0);
+  }
+  EXPECT_EQ(compression_level.get_level(), 9);
+}
+
+TEST(AdaptiveCompressionLevelTest, keeps_level_at_moderate_load)
+{
+  AdaptiveCompressionLevel compression_level(1, 9);
+  update_once(compression_level, 1.0);
+  for (int i = 0; i < 10; i++) {
+    update_once(compression_level, 0.3);
+  }
+  EXPECT_EQ(compression_level.get_level(), 5);
+}
+
+TEST(AdaptiveCompressionLevelTest, fixed_level_ignores_load)
+{
+  AdaptiveCompressionLevel compression_level(7, 7);
+  update_once(compression_level, 1.0);
+  EXPECT_EQ(compression_level.get_level(), 7);
+}
+
+TEST(AdaptiveCompressionLevelTest, counts_messages_per_used_level)
+{
+  AdaptiveCompressionLevel compression_level(-3, 9);
+  compression_level.count_message(9);
+  compression_level.count_message(9);
+  compression_level.count_message(-3);
+  compression_level.count_message(4);
+  EXPECT_THAT(
+    compression_level.get_message_counts(),
+    ElementsAre(Pair(-3, 1u), Pair(4, 1u), Pair(9, 2u)));
+}
+
+TEST(AdaptiveCompressionLevelTest, rejects_min_level_above_max_level)
+{
+  EXPECT_THROW(AdaptiveCompressionLevel(5, 4), std::invalid_argument);
+}
@@ -0,0 +1,211 @@
+// Copyright 2022, Open Source Robotics Corporation.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gmock/gmock.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "rosbag2_compression/base_compressor_interface.hpp"
+#include "rosbag2_compression/base_decompressor_interface.hpp"
+#include "rosbag2_compression/chunk_compression_storage.hpp"
+
+#include "rosbag2_storage/ros_helper.hpp"
+
+#include "mock_storage.hpp"
+
+using namespace testing;  // NOLINT
+
+namespace
+{
+// Leaves the data as it is, which keeps the chunk layout observable from the tests
+class CopyCompressor : public rosbag2_compression::BaseCompressorInterface
+{
+public:
+  std::string compress_uri(const std::string & uri) override {return uri;}
+
+  void compress_serialized_bag_message(
+    const rosbag2_storage::SerializedBagMessage * bag_message,
+    rosbag2_storage::SerializedBagMessage * compressed_message) override
+  {
+    compressed_message->serialized_data = rosbag2_storage::make_serialized_message(
+      bag_message->serialized_data->buffer, bag_message->serialized_data->buffer_length);
+  }
+
+  std::string get_compression_identifier() const override {return "copy";}
+};
+
+class CopyDecompressor : public rosbag2_compression::BaseDecompressorInterface
+{
+public:
+  std::string decompress_uri(const std::string & uri) override {return uri;}
+
+  void decompress_serialized_bag_message(rosbag2_storage::SerializedBagMessage *) override {}
+
+  std::string get_decompression_identifier() const override {return "copy";}
+};
+
+std::shared_ptr<const rosbag2_storage::SerializedBagMessage> make_message(
+  const std::string & topic, rcutils_time_point_value_t time_stamp, size_t size)
+{
+  auto message = std::make_shared<rosbag2_storage::SerializedBagMessage>();
+  message->topic_name = topic;
+  message->time_stamp = time_stamp;
+  std::vector<uint8_t> data(size, static_cast<uint8_t>(time_stamp));
+  message->serialized_data = rosbag2_storage::make_serialized_message(data.data(), data.size());
+  return message;
+}
+}  // namespace
+
+class ChunkCompressionStorageTest : public Test
+{
+public:
+  ChunkCompressionStorageTest()
+  : storage_(std::make_shared<NiceMock<MockStorage>>())
+  {
+    ON_CALL(
+      *storage_,
+      write(An<std::shared_ptr<const rosbag2_storage::SerializedBagMessage>>())).WillByDefault(
+      [this](std::shared_ptr<const rosbag2_storage::SerializedBagMessage> message) {
+        stored_.push_back(std::make_shared<rosbag2_storage::SerializedBagMessage>(*message));
+      });
+    ON_CALL(*storage_, has_next()).WillByDefault(
+      [this]() {return read_position_ < stored_.size();});
+    ON_CALL(*storage_, read_next()).WillByDefault(
+      [this]() {return stored_.at(read_position_++);});
+    ON_CALL(*storage_, seek(_)).WillByDefault(
+      [this](const rcutils_time_point_value_t & time_stamp) {
+        read_position_ = 0;
+        while (read_position_ < stored_.size() &&
+        stored_[read_position_]->time_stamp < time_stamp)
+        {
+          ++read_position_;
+        }
+      });
+  }
+
+  std::unique_ptr<rosbag2_compression::ChunkCompressingStorage> make_writer(uint64_t chunk_size)
+  {
+    return std::make_unique<rosbag2_compression::ChunkCompressingStorage>(
+      storage_, std::make_shared<CopyCompressor>(), chunk_size);
+  }
+
+  std::unique_ptr<rosbag2_compression::ChunkDecompressingStorage> make_reader()
+  {
+    return std::make_unique<rosbag2_compression::ChunkDecompressingStorage>(
+      storage_, std::make_shared<CopyDecompressor>());
+  }
+
+  std::shared_ptr<NiceMock<MockStorage>> storage_;
+  std::vector<std::shared_ptr<rosbag2_storage::SerializedBagMessage>> stored_;
+  size_t read_position_ = 0;
+};
+
+TEST_F(ChunkCompressionStorageTest, writes_one_chunk_per_batch_when_chunk_size_is_zero)
+{
+  EXPECT_CALL(
+    *storage_,
+    create_topic(Field(&rosbag2_storage::TopicMetadata::name,
+    rosbag2_compression::kCompressedChunkTopic))).Times(1);
+  auto writer = make_writer(0);
+  writer->write({make_message("a", 1, 10), make_message("b", 3, 10), make_message("a", 2, 10)});
+  writer->write({make_message("a", 4, 10)});
+
+  ASSERT_EQ(stored_.size(), 2u);
+  EXPECT_EQ(stored_[0]->topic_name, rosbag2_compression::kCompressedChunkTopic);
+  // A chunk is stamped with the latest time stamp of its messages
+  EXPECT_EQ(stored_[0]->time_stamp, 3);
+  EXPECT_EQ(stored_[1]->time_stamp, 4);
+}
+
+TEST_F(ChunkCompressionStorageTest, starts_a_new_chunk_once_chunk_size_is_reached)
+{
+  // Every message takes 4 + 1 + 8 + 8 + 50 = 71 bytes in a chunk
+  auto writer = make_writer(100);
+  for (rcutils_time_point_value_t i = 0; i < 5; i++) {
+    writer->write(make_message("a", i, 50));
+  }
+  EXPECT_EQ(stored_.size(), 2u);
+
+  writer.reset();  // writes the remaining message
+  ASSERT_EQ(stored_.size(), 3u);
+  EXPECT_EQ(stored_[2]->time_stamp, 4);
+}
+
+TEST_F(ChunkCompressionStorageTest, reader_restores_messages_in_write_order)
+{
+  auto writer = make_writer(200);
+  for (rcutils_time_point_value_t i = 0; i < 10; i++) {
+    writer->write(make_message(i % 2 ? "odd" : "even", i, 20 + i));
+  }
+  writer.reset();
+  ASSERT_LT(stored_.size(), 10u);
+
+  auto reader = make_reader();
+  for (rcutils_time_point_value_t i = 0; i < 10; i++) {
+    ASSERT_TRUE(reader->has_next());
+    auto message = reader->read_next();
+    EXPECT_EQ(message->time_stamp, i);
+    EXPECT_EQ(message->topic_name, i % 2 ? "odd" : "even");
+    ASSERT_EQ(message->serialized_data->buffer_length, static_cast<size_t>(20 + i));
+    EXPECT_EQ(message->serialized_data->buffer[0], static_cast<uint8_t>(i));
+  }
+  EXPECT_FALSE(reader->has_next());
+}
+
+TEST_F(ChunkCompressionStorageTest, reader_applies_filter_and_seek_inside_chunks)
+{
+  auto writer = make_writer(0);
+  std::vector<std::shared_ptr<const rosbag2_storage::SerializedBagMessage>> batch;
+  for (rcutils_time_point_value_t i = 0; i < 10; i++) {
+    batch.push_back(make_message(i % 2 ? "odd" : "even", i, 8));
+  }
+  writer->write(batch);
+  writer.reset();
+  ASSERT_EQ(stored_.size(), 1u);
+
+  auto reader = make_reader();
+  rosbag2_storage::StorageFilter filter;
+  filter.topics = {"odd"};
+  reader->set_filter(filter);
+  reader->seek(4);
+
+  std::vector<rcutils_time_point_value_t> read_time_stamps;
+  while (reader->has_next()) {
+    read_time_stamps.push_back(reader->read_next()->time_stamp);
+  }
+  EXPECT_THAT(read_time_stamps, ElementsAre(5, 7, 9));
+
+  reader->reset_filter();
+  reader->seek(8);
+  read_time_stamps.clear();
+  while (reader->has_next()) {
+    read_time_stamps.push_back(reader->read_next()->time_stamp);
+  }
+  EXPECT_THAT(read_time_stamps, ElementsAre(8, 9));
+}
+
+TEST_F(ChunkCompressionStorageTest, chunk_topic_is_hidden_from_topic_listing)
+{
+  ON_CALL(*storage_, get_all_topics_and_types()).WillByDefault(
+    Return(
+      std::vector<rosbag2_storage::TopicMetadata>{
+    {"a", "type", "cdr", ""},
+    {rosbag2_compression::kCompressedChunkTopic, "rosbag2_compression/CompressedChunk", "", ""}}));
+  auto reader = make_reader();
+  auto topics = reader->get_all_topics_and_types();
+  ASSERT_EQ(topics.size(), 1u);
+  EXPECT_EQ(topics[0].name, "a");
+}
@@ -74,6 +74,14 @@ TEST(CompressionOptionsFromStringTest, MessageStringReturnsMessageMode)
   EXPECT_EQ(compression_mode, rosbag2_compression::CompressionMode::MESSAGE);
 }
 
+TEST(CompressionOptionsFromStringTest, MixedCaseChunkStringReturnsChunkMode)
+{
+  const std::string compression_mode_string{"cHuNk"};
+  const auto compression_mode = rosbag2_compression::compression_mode_from_string(
+    compression_mode_string);
+  EXPECT_EQ(compression_mode, rosbag2_compression::CompressionMode::CHUNK);
+}
+
 TEST(CompressionOptionsToStringTest, BadModeReturnsNoneString)
 {
   // Get an out of bounds enum from CompressionMode
@@ -92,6 +100,14 @@ TEST(CompressionOptionsToStringTest, MessageModeReturnsMessageString)
   EXPECT_EQ(compression_mode_string, "MESSAGE");
 }
 
+TEST(CompressionOptionsToStringTest, ChunkModeReturnsChunkString)
+{
+  const auto compression_mode = rosbag2_compression::CompressionMode::CHUNK;
+  const auto compression_mode_string = rosbag2_compression::compression_mode_to_string(
+    compression_mode);
+  EXPECT_EQ(compression_mode_string, "CHUNK");
+}
+
 TEST(CompressionOptionsToStringTest, FileModeReturnsFileString)
 {
   const auto compression_mode = rosbag2_compression::CompressionMode::FILE;
@@ -107,3 +123,29 @@ TEST(CompressionOptionsToStringTest, NoneModeReturnsNoneString)
     compression_mode);
   EXPECT_EQ(compression_mode_string, "NONE");
 }
+
+TEST(TopicCompressionPolicyFromStringTest, MixedCaseStringsReturnPolicies)
+{
+  using rosbag2_compression::TopicCompressionPolicy;
+  using rosbag2_compression::topic_compression_policy_from_string;
+  EXPECT_EQ(topic_compression_policy_from_string("aLwAyS"), TopicCompressionPolicy::ALWAYS);
+  EXPECT_EQ(topic_compression_policy_from_string("never"), TopicCompressionPolicy::NEVER);
+  EXPECT_EQ(topic_compression_policy_from_string("AUTO"), TopicCompressionPolicy::AUTO);
+}
+
+TEST(TopicCompressionPolicyFromStringTest, EmptyOrBadInputReturnsAlwaysPolicy)
+{
+  using rosbag2_compression::TopicCompressionPolicy;
+  using rosbag2_compression::topic_compression_policy_from_string;
+  EXPECT_EQ(topic_compression_policy_from_string(""), TopicCompressionPolicy::ALWAYS);
+  EXPECT_EQ(topic_compression_policy_from_string("sometimes"), TopicCompressionPolicy::ALWAYS);
+}
+
+TEST(TopicCompressionPolicyToStringTest, PoliciesReturnStrings)
+{
+  using rosbag2_compression::TopicCompressionPolicy;
+  using rosbag2_compression::topic_compression_policy_to_string;
+  EXPECT_EQ(topic_compression_policy_to_string(TopicCompressionPolicy::ALWAYS), "ALWAYS");
+  EXPECT_EQ(topic_compression_policy_to_string(TopicCompressionPolicy::NEVER), "NEVER");
+  EXPECT_EQ(topic_compression_policy_to_string(TopicCompressionPolicy::AUTO), "AUTO");
+}
@@ -0,0 +1,74 @@
+// Copyright 2022, Open Source Robotics Corporation.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gmock/gmock.h>
+
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "rosbag2_compression/compression_statistics_collector.hpp"
+
+using namespace testing;  // NOLINT
+using rosbag2_compression::CompressionStatisticsCollector;
+
+TEST(CompressionStatisticsCollectorTest, starts_empty)
+{
+  CompressionStatisticsCollector collector;
+  EXPECT_THAT(collector.get_statistics(), IsEmpty());
+}
+
+TEST(CompressionStatisticsCollectorTest, sums_compressions_by_topic)
+{
+  CompressionStatisticsCollector collector;
+  collector.add("/a", 100, 10, std::chrono::nanoseconds{5});
+  collector.add("/b", 200, 50, std::chrono::nanoseconds{7});
+  collector.add("/a", 300, 20, std::chrono::nanoseconds{6});
+
+  const auto statistics = collector.get_statistics();
+  ASSERT_THAT(statistics, SizeIs(2u));
+  EXPECT_EQ(statistics.at("/a").input_bytes, 400u);
+  EXPECT_EQ(statistics.at("/a").output_bytes, 30u);
+  EXPECT_EQ(statistics.at("/a").compression_time, std::chrono::nanoseconds{11});
+  EXPECT_EQ(statistics.at("/b").input_bytes, 200u);
+  EXPECT_EQ(statistics.at("/b").output_bytes, 50u);
+  EXPECT_EQ(statistics.at("/b").compression_time, std::chrono::nanoseconds{7});
+}
+
+TEST(CompressionStatisticsCollectorTest, sums_compressions_of_all_threads)
+{
+  constexpr size_t kNumThreads = 2 * CompressionStatisticsCollector::kNumShards;
+  constexpr uint64_t kCompressionsPerThread = 1000;
+  CompressionStatisticsCollector collector;
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < kNumThreads; i++) {
+    threads.emplace_back(
+      [&collector] {
+        for (uint64_t j = 0; j < kCompressionsPerThread; j++) {
+          collector.add("/topic", 3, 2, std::chrono::nanoseconds{1});
+        }
+      });
+  }
+  for (auto & thread : threads) {
+    thread.join();
+  }
+
+  const auto statistics = collector.get_statistics();
+  ASSERT_THAT(statistics, SizeIs(1u));
+  EXPECT_EQ(statistics.at("/topic").input_bytes, 3 * kNumThreads * kCompressionsPerThread);
+  EXPECT_EQ(statistics.at("/topic").output_bytes, 2 * kNumThreads * kCompressionsPerThread);
+  EXPECT_EQ(
+    statistics.at("/topic").compression_time.count(),
+    static_cast<int64_t>(kNumThreads * kCompressionsPerThread));
+}
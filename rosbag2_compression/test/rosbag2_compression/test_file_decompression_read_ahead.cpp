@@ -0,0 +1,178 @@
+// Copyright 2022, Open Source Robotics Corporation.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gmock/gmock.h>
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "rcpputils/filesystem_helper.hpp"
+
+#include "rosbag2_compression/file_decompression_read_ahead.hpp"
+
+using namespace testing;  // NOLINT
+using rosbag2_compression::FileDecompressionReadAhead;
+
+class FileDecompressionReadAheadTest : public Test
+{
+public:
+  FileDecompressionReadAheadTest()
+  : tmp_dir_{rcpputils::fs::temp_directory_path() / "FileDecompressionReadAheadTest"}
+  {
+    rcpputils::fs::remove_all(tmp_dir_);
+    rcpputils::fs::create_directories(tmp_dir_);
+  }
+
+  ~FileDecompressionReadAheadTest() override
+  {
+    rcpputils::fs::remove_all(tmp_dir_);
+  }
+
+  // Decompresses a file into memory as its uri, recording the decompressed files.
+  FileDecompressionReadAhead::DecompressFunction decompress_to_memory()
+  {
+    return [this](const std::string & uri) {
+             {
+               std::lock_guard<std::mutex> lock(mutex_);
+               decompressed_.push_back(uri);
+             }
+             FileDecompressionReadAhead::DecompressedFile file;
+             file.buffer = std::make_shared<std::vector<uint8_t>>(uri.begin(), uri.end());
+             return file;
+           };
+  }
+
+  std::vector<std::string> decompressed()
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return decompressed_;
+  }
+
+  // Waits until the number of decompressed files reaches count, and a bit longer to catch more.
+  size_t wait_for_decompressed(size_t count)
+  {
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (decompressed().size() < count && std::chrono::steady_clock::now() < deadline) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    return decompressed().size();
+  }
+
+  std::string take(FileDecompressionReadAhead & read_ahead, const std::string & uri)
+  {
+    FileDecompressionReadAhead::DecompressedFile file;
+    EXPECT_TRUE(read_ahead.take(uri, file));
+    EXPECT_NE(file.buffer, nullptr);
+    return file.buffer ? std::string(file.buffer->begin(), file.buffer->end()) : "";
+  }
+
+  rcpputils::fs::path tmp_dir_;
+  std::mutex mutex_;
+  std::vector<std::string> decompressed_;
+};
+
+TEST_F(FileDecompressionReadAheadTest, decompresses_the_files_following_the_taken_file)
+{
+  const std::vector<std::string> uris{"a", "b", "c", "d", "e"};
+  FileDecompressionReadAhead read_ahead(uris, 2, decompress_to_memory());
+  // Nothing is decompressed before the reader opens its first file.
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  EXPECT_TRUE(decompressed().empty());
+
+  EXPECT_EQ(take(read_ahead, "a"), "a");
+  EXPECT_EQ(wait_for_decompressed(3), 3u);
+  EXPECT_EQ(take(read_ahead, "b"), "b");
+  EXPECT_EQ(wait_for_decompressed(4), 4u);
+  EXPECT_EQ(take(read_ahead, "c"), "c");
+  EXPECT_EQ(take(read_ahead, "d"), "d");
+  EXPECT_EQ(take(read_ahead, "e"), "e");
+  EXPECT_THAT(decompressed(), ElementsAreArray(uris));
+}
+
+TEST_F(FileDecompressionReadAheadTest, decompresses_again_after_seeking_back)
+{
+  FileDecompressionReadAhead read_ahead({"a", "b", "c"}, 1, decompress_to_memory());
+  EXPECT_EQ(take(read_ahead, "a"), "a");
+  EXPECT_EQ(take(read_ahead, "b"), "b");
+  EXPECT_EQ(take(read_ahead, "a"), "a");
+  EXPECT_EQ(take(read_ahead, "b"), "b");
+  const auto files = decompressed();
+  EXPECT_EQ(std::count(files.begin(), files.end(), "a"), 2);
+}
+
+TEST_F(FileDecompressionReadAheadTest, removes_files_decompressed_to_disk_unless_taken)
+{
+  std::vector<std::string> uris;
+  for (const auto & name : {"a", "b", "c", "d", "e"}) {
+    uris.push_back((tmp_dir_ / name).string());
+  }
+  {
+    FileDecompressionReadAhead read_ahead(
+      uris, 2,
+      [](const std::string & uri) {
+        FileDecompressionReadAhead::DecompressedFile file;
+        file.uri = uri + ".decompressed";
+        std::ofstream output(file.uri);
+        output << uri;
+        return file;
+      });
+
+    FileDecompressionReadAhead::DecompressedFile file;
+    ASSERT_TRUE(read_ahead.take(uris[0], file));
+    EXPECT_EQ(file.buffer, nullptr);
+    EXPECT_EQ(file.uri, uris[0] + ".decompressed");
+    // Skipping over files drops those decompressed ahead of the first one.
+    ASSERT_TRUE(read_ahead.take(uris[3], file));
+  }
+
+  EXPECT_TRUE(rcpputils::fs::exists(uris[0] + ".decompressed"));
+  EXPECT_FALSE(rcpputils::fs::exists(uris[1] + ".decompressed"));
+  EXPECT_FALSE(rcpputils::fs::exists(uris[2] + ".decompressed"));
+  EXPECT_TRUE(rcpputils::fs::exists(uris[3] + ".decompressed"));
+  EXPECT_FALSE(rcpputils::fs::exists(uris[4] + ".decompressed"));
+}
+
+TEST_F(FileDecompressionReadAheadTest, take_rethrows_decompression_errors)
+{
+  FileDecompressionReadAhead read_ahead(
+    {"a", "b", "c"}, 2,
+    [](const std::string & uri) {
+      if (uri == "b") {
+        throw std::runtime_error("corrupt file");
+      }
+      FileDecompressionReadAhead::DecompressedFile file;
+      file.buffer = std::make_shared<std::vector<uint8_t>>(uri.begin(), uri.end());
+      return file;
+    });
+
+  EXPECT_EQ(take(read_ahead, "a"), "a");
+  FileDecompressionReadAhead::DecompressedFile file;
+  EXPECT_THROW(read_ahead.take("b", file), std::runtime_error);
+  EXPECT_EQ(take(read_ahead, "c"), "c");
+}
+
+TEST_F(FileDecompressionReadAheadTest, take_returns_false_for_unknown_files)
+{
+  FileDecompressionReadAhead read_ahead({"a"}, 1, decompress_to_memory());
+  FileDecompressionReadAhead::DecompressedFile file;
+  EXPECT_FALSE(read_ahead.take("b", file));
+  EXPECT_TRUE(decompressed().empty());
+}
@@ -0,0 +1,264 @@
+// Copyright 2022, Open Source Robotics Corporation.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gmock/gmock.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+
+#include "rosbag2_compression/message_compression_pipeline.hpp"
+
+using namespace testing;  // NOLINT
+using rosbag2_compression::MessageCompressionPipeline;
+
+namespace
+{
+MessageCompressionPipeline::MessageSharedPtr make_message(rcutils_time_point_value_t time_stamp)
+{
+  auto message = std::make_shared<rosbag2_storage::SerializedBagMessage>();
+  message->time_stamp = time_stamp;
+  message->topic_name = "topic";
+  return message;
+}
+}  // namespace
+
+class MessageCompressionPipelineTest : public Test
+{
+public:
+  MessageCompressionPipeline::WriteFunction record_writes()
+  {
+    return [this](MessageCompressionPipeline::MessageSharedPtr message) {
+             std::lock_guard<std::mutex> lock(mutex_);
+             written_.push_back(message->time_stamp);
+             writer_threads_.insert(std::this_thread::get_id());
+           };
+  }
+
+  std::mutex mutex_;
+  std::vector<rcutils_time_point_value_t> written_;
+  std::set<std::thread::id> writer_threads_;
+};
+
+TEST_F(MessageCompressionPipelineTest, writes_messages_in_push_order_from_one_thread)
+{
+  const size_t kNumMessages = 500;
+  {
+    MessageCompressionPipeline pipeline(
+      8, 0,
+      [] {
+        return [](MessageCompressionPipeline::MessageSharedPtr message) {
+                 // Later messages finish first, so results arrive out of order.
+                 const auto delay = std::chrono::microseconds(50 * (message->time_stamp % 7));
+                 std::this_thread::sleep_for(delay);
+                 return message;
+               };
+      },
+      record_writes());
+    for (size_t i = 0; i < kNumMessages; i++) {
+      EXPECT_TRUE(pipeline.push(make_message(static_cast<rcutils_time_point_value_t>(i))));
+    }
+    pipeline.stop();
+    EXPECT_EQ(pipeline.get_dropped_count(), 0u);
+  }
+
+  ASSERT_EQ(written_.size(), kNumMessages);
+  for (size_t i = 0; i < kNumMessages; i++) {
+    EXPECT_EQ(written_[i], static_cast<rcutils_time_point_value_t>(i));
+  }
+  EXPECT_EQ(writer_threads_.size(), 1u);
+  EXPECT_EQ(writer_threads_.count(std::this_thread::get_id()), 0u);
+}
+
+TEST_F(MessageCompressionPipelineTest, compresses_on_all_threads_concurrently)
+{
+  const size_t kNumThreads = 4;
+  std::mutex barrier_mutex;
+  std::condition_variable barrier_condition;
+  size_t threads_inside = 0;
+  std::atomic_bool all_threads_met{false};
+
+  MessageCompressionPipeline pipeline(
+    kNumThreads, 0,
+    [&] {
+      return [&](MessageCompressionPipeline::MessageSharedPtr message) {
+               std::unique_lock<std::mutex> lock(barrier_mutex);
+               threads_inside++;
+               barrier_condition.notify_all();
+               if (barrier_condition.wait_for(
+                 lock, std::chrono::seconds(10),
+                 [&] {return threads_inside >= kNumThreads;}))
+               {
+                 all_threads_met = true;
+               }
+               return message;
+             };
+    },
+    record_writes());
+  for (size_t i = 0; i < kNumThreads; i++) {
+    pipeline.push(make_message(static_cast<rcutils_time_point_value_t>(i)));
+  }
+  pipeline.stop();
+
+  EXPECT_TRUE(all_threads_met);
+  EXPECT_THAT(written_, ElementsAre(0, 1, 2, 3));
+}
+
+TEST_F(MessageCompressionPipelineTest, zero_queue_size_blocks_instead_of_dropping)
+{
+  const size_t kNumMessages = 200;
+  MessageCompressionPipeline pipeline(
+    2, 0,
+    [] {return [](MessageCompressionPipeline::MessageSharedPtr message) {return message;};},
+    [this](MessageCompressionPipeline::MessageSharedPtr message) {
+      // A slow writer stage fills the pipeline, which must push back on the producer.
+      std::this_thread::sleep_for(std::chrono::microseconds(100));
+      std::lock_guard<std::mutex> lock(mutex_);
+      written_.push_back(message->time_stamp);
+    });
+  for (size_t i = 0; i < kNumMessages; i++) {
+    EXPECT_TRUE(pipeline.push(make_message(static_cast<rcutils_time_point_value_t>(i))));
+  }
+  pipeline.stop();
+
+  EXPECT_EQ(pipeline.get_dropped_count(), 0u);
+  EXPECT_EQ(written_.size(), kNumMessages);
+}
+
+TEST_F(MessageCompressionPipelineTest, single_thread_without_queue_writes_all_messages)
+{
+  const size_t kNumMessages = 100;
+  MessageCompressionPipeline pipeline(
+    1, 0,
+    [] {return [](MessageCompressionPipeline::MessageSharedPtr message) {return message;};},
+    record_writes());
+  for (size_t i = 0; i < kNumMessages; i++) {
+    EXPECT_TRUE(pipeline.push(make_message(static_cast<rcutils_time_point_value_t>(i))));
+  }
+  pipeline.stop();
+
+  ASSERT_EQ(written_.size(), kNumMessages);
+  for (size_t i = 0; i < kNumMessages; i++) {
+    EXPECT_EQ(written_[i], static_cast<rcutils_time_point_value_t>(i));
+  }
+}
+
+TEST_F(MessageCompressionPipelineTest, drops_oldest_waiting_message_when_queue_is_full)
+{
+  std::promise<void> compression_started;
+  std::promise<void> release_compression;
+  auto release_future = release_compression.get_future().share();
+  std::atomic_bool first{true};
+
+  MessageCompressionPipeline pipeline(
+    1, 2,
+    [&] {
+      return [&](MessageCompressionPipeline::MessageSharedPtr message) {
+               if (first.exchange(false)) {
+                 compression_started.set_value();
+                 release_future.wait();
+               }
+               return message;
+             };
+    },
+    record_writes());
+
+  // The only compression thread holds message 0, so messages 1..4 queue up behind it.
+  pipeline.push(make_message(0));
+  compression_started.get_future().wait();
+  for (rcutils_time_point_value_t i = 1; i < 5; i++) {
+    EXPECT_TRUE(pipeline.push(make_message(i)));
+  }
+  release_compression.set_value();
+  pipeline.stop();
+
+  EXPECT_EQ(pipeline.get_dropped_count(), 2u);
+  EXPECT_THAT(written_, ElementsAre(0, 3, 4));
+}
+
+TEST_F(MessageCompressionPipelineTest, accepts_messages_from_several_producers)
+{
+  const size_t kNumProducers = 4;
+  const size_t kMessagesPerProducer = 250;
+  {
+    MessageCompressionPipeline pipeline(
+      3, 0,
+      [] {return [](MessageCompressionPipeline::MessageSharedPtr message) {return message;};},
+      record_writes());
+    std::vector<std::thread> producers;
+    for (size_t p = 0; p < kNumProducers; p++) {
+      producers.emplace_back(
+        [&pipeline, p] {
+          for (size_t i = 0; i < kMessagesPerProducer; i++) {
+            pipeline.push(
+              make_message(static_cast<rcutils_time_point_value_t>(p * kMessagesPerProducer + i)));
+          }
+        });
+    }
+    for (auto & producer : producers) {
+      producer.join();
+    }
+  }
+
+  ASSERT_EQ(written_.size(), kNumProducers * kMessagesPerProducer);
+  // Each producer's messages keep their relative order.
+  std::vector<rcutils_time_point_value_t> last(kNumProducers, -1);
+  for (const auto time_stamp : written_) {
+    const auto producer = static_cast<size_t>(time_stamp) / kMessagesPerProducer;
+    EXPECT_GT(time_stamp, last[producer]);
+    last[producer] = time_stamp;
+  }
+}
+
+TEST_F(MessageCompressionPipelineTest, stops_while_producers_keep_pushing)
+{
+  const size_t kNumProducers = 4;
+  const size_t kNumStops = 50;
+  for (size_t stop = 0; stop < kNumStops; stop++) {
+    written_.clear();
+    std::atomic<uint64_t> pushes{0};
+    std::atomic_bool stopped{false};
+    MessageCompressionPipeline pipeline(
+      2, 1,
+      [] {return [](MessageCompressionPipeline::MessageSharedPtr message) {return message;};},
+      record_writes());
+    std::vector<std::thread> producers;
+    for (size_t p = 0; p < kNumProducers; p++) {
+      producers.emplace_back(
+        [&pipeline, &pushes, &stopped] {
+          while (!stopped) {
+            pipeline.push(make_message(0));
+            pushes++;
+          }
+        });
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    // Must not wait forever for a message pushed while stopping
+    pipeline.stop();
+    stopped = true;
+    for (auto & producer : producers) {
+      producer.join();
+    }
+
+    // Every message is either written or dropped
+    std::lock_guard<std::mutex> lock(mutex_);
+    EXPECT_EQ(written_.size() + pipeline.get_dropped_count(), pushes.load());
+  }
+}
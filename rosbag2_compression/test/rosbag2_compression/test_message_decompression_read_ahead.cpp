@@ -0,0 +1,199 @@
+// Copyright 2022, Open Source Robotics Corporation.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gmock/gmock.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "rosbag2_compression/message_decompression_read_ahead.hpp"
+
+#include "rosbag2_storage/ros_helper.hpp"
+
+using namespace testing;  // NOLINT
+using rosbag2_compression::MessageDecompressionReadAhead;
+
+namespace
+{
+MessageDecompressionReadAhead::MessageSharedPtr make_message(
+  rcutils_time_point_value_t time_stamp, size_t size = 1, const std::string & topic = "topic")
+{
+  auto message = std::make_shared<rosbag2_storage::SerializedBagMessage>();
+  message->time_stamp = time_stamp;
+  message->topic_name = topic;
+  message->serialized_data = rosbag2_storage::make_empty_serialized_message(size);
+  message->serialized_data->buffer_length = size;
+  return message;
+}
+
+MessageDecompressionReadAhead::DecompressFunctionFactory no_decompression()
+{
+  return [] {
+           return [](rosbag2_storage::SerializedBagMessage *) {};
+         };
+}
+}  // namespace
+
+TEST(MessageDecompressionReadAheadTest, pops_messages_in_push_order)
+{
+  const size_t kNumMessages = 500;
+  MessageDecompressionReadAhead read_ahead(
+    8, 64,
+    [] {
+      return [](rosbag2_storage::SerializedBagMessage * message) {
+               // Later messages finish first, so results arrive out of order.
+               const auto delay = std::chrono::microseconds(50 * (message->time_stamp % 7));
+               std::this_thread::sleep_for(delay);
+             };
+    });
+
+  std::vector<rcutils_time_point_value_t> popped;
+  size_t pushed = 0;
+  while (popped.size() < kNumMessages) {
+    while (!read_ahead.is_full() && pushed < kNumMessages) {
+      read_ahead.push(make_message(static_cast<rcutils_time_point_value_t>(pushed++)));
+    }
+    popped.push_back(read_ahead.pop()->time_stamp);
+  }
+
+  EXPECT_TRUE(read_ahead.empty());
+  for (size_t i = 0; i < kNumMessages; i++) {
+    EXPECT_EQ(popped[i], static_cast<rcutils_time_point_value_t>(i));
+  }
+}
+
+TEST(MessageDecompressionReadAheadTest, decompresses_on_all_threads_concurrently)
+{
+  const size_t kNumThreads = 4;
+  std::atomic<size_t> num_contexts{0};
+  std::mutex barrier_mutex;
+  std::condition_variable barrier_condition;
+  size_t threads_inside = 0;
+  std::atomic_bool all_threads_met{false};
+
+  MessageDecompressionReadAhead read_ahead(
+    kNumThreads, 1024,
+    [&] {
+      num_contexts++;
+      return [&](rosbag2_storage::SerializedBagMessage *) {
+               std::unique_lock<std::mutex> lock(barrier_mutex);
+               threads_inside++;
+               barrier_condition.notify_all();
+               if (barrier_condition.wait_for(
+                 lock, std::chrono::seconds(10),
+                 [&] {return threads_inside >= kNumThreads;}))
+               {
+                 all_threads_met = true;
+               }
+             };
+    });
+  for (size_t i = 0; i < kNumThreads; i++) {
+    read_ahead.push(make_message(static_cast<rcutils_time_point_value_t>(i)));
+  }
+  for (size_t i = 0; i < kNumThreads; i++) {
+    read_ahead.pop();
+  }
+
+  EXPECT_TRUE(all_threads_met);
+  EXPECT_EQ(num_contexts.load(), kNumThreads);
+}
+
+TEST(MessageDecompressionReadAheadTest, window_is_sized_by_bytes_of_decompressed_messages)
+{
+  MessageDecompressionReadAhead read_ahead(
+    1, 50,
+    [] {
+      return [](rosbag2_storage::SerializedBagMessage * message) {
+               // Every message decompresses to ten times its size.
+               const auto size = message->serialized_data->buffer_length * 10;
+               message->serialized_data = rosbag2_storage::make_empty_serialized_message(size);
+               message->serialized_data->buffer_length = size;
+             };
+    });
+
+  EXPECT_FALSE(read_ahead.is_full());
+  read_ahead.push(make_message(0, 6));
+  // The window fills up once the message has grown from 6 to 60 bytes.
+  const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+  while (!read_ahead.is_full() && std::chrono::steady_clock::now() < deadline) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  EXPECT_TRUE(read_ahead.is_full());
+
+  EXPECT_EQ(read_ahead.pop()->serialized_data->buffer_length, 60u);
+  EXPECT_FALSE(read_ahead.is_full());
+  EXPECT_TRUE(read_ahead.empty());
+}
+
+TEST(MessageDecompressionReadAheadTest, a_single_message_larger_than_the_window_is_read_ahead)
+{
+  MessageDecompressionReadAhead read_ahead(1, 10, no_decompression());
+  read_ahead.push(make_message(0, 100));
+  EXPECT_TRUE(read_ahead.is_full());
+  EXPECT_EQ(read_ahead.pop()->time_stamp, 0);
+}
+
+TEST(MessageDecompressionReadAheadTest, pop_rethrows_decompression_errors_in_order)
+{
+  MessageDecompressionReadAhead read_ahead(
+    2, 1024,
+    [] {
+      return [](rosbag2_storage::SerializedBagMessage * message) {
+               if (message->time_stamp == 1) {
+                 throw std::runtime_error("corrupt frame");
+               }
+             };
+    });
+  read_ahead.push(make_message(0));
+  read_ahead.push(make_message(1));
+  read_ahead.push(make_message(2));
+
+  EXPECT_EQ(read_ahead.pop()->time_stamp, 0);
+  EXPECT_THROW(read_ahead.pop(), std::runtime_error);
+  EXPECT_EQ(read_ahead.pop()->time_stamp, 2);
+  EXPECT_THROW(read_ahead.pop(), std::runtime_error);
+}
+
+TEST(MessageDecompressionReadAheadTest, remove_if_and_clear_drop_messages)
+{
+  MessageDecompressionReadAhead read_ahead(2, 1024, no_decompression());
+  read_ahead.push(make_message(0, 1, "kept"));
+  read_ahead.push(make_message(1, 1, "removed"));
+  read_ahead.push(make_message(2, 1, "kept"));
+
+  read_ahead.remove_if(
+    [](const rosbag2_storage::SerializedBagMessage & message) {
+      return message.topic_name == "removed";
+    });
+  EXPECT_EQ(read_ahead.pop()->time_stamp, 0);
+  EXPECT_EQ(read_ahead.pop()->time_stamp, 2);
+  EXPECT_TRUE(read_ahead.empty());
+
+  read_ahead.push(make_message(3, 600));
+  read_ahead.push(make_message(4, 600));
+  EXPECT_TRUE(read_ahead.is_full());
+  read_ahead.clear();
+  EXPECT_TRUE(read_ahead.empty());
+  EXPECT_FALSE(read_ahead.is_full());
+
+  read_ahead.push(make_message(5));
+  EXPECT_EQ(read_ahead.pop()->time_stamp, 5);
+}
@@ -14,6 +14,7 @@
 
 #include <gmock/gmock.h>
 
+#include <atomic>
 #include <fstream>
 #include <memory>
 #include <string>
@@ -27,6 +28,8 @@
 
 #include "rosbag2_cpp/reader.hpp"
 
+#include "rosbag2_storage/ros_helper.hpp"
+
 #include "mock_converter_factory.hpp"
 #include "mock_metadata_io.hpp"
 #include "mock_storage.hpp"
@@ -307,3 +310,319 @@ TEST_F(SequentialCompressionReaderTest, does_not_decompress_again_on_seek)
   reader_->open(storage_options_, converter_options_);
   reader_->seek(0);
 }
+
+TEST_F(SequentialCompressionReaderTest, reader_opens_decompressed_file_from_memory)
+{
+  storage_options_.max_decompression_buffer_size = 4096;
+  auto decompressor = std::make_unique<NiceMock<MockDecompressor>>();
+  EXPECT_CALL(*decompressor, decompress_uri_to_buffer(_, 4096u, _)).Times(1)
+  .WillOnce(
+    [](auto, auto, auto & buffer) {
+      buffer = {1, 2, 3};
+      return true;
+    });
+  EXPECT_CALL(*decompressor, decompress_uri(_)).Times(0);
+
+  auto compression_factory = std::make_unique<NiceMock<MockCompressionFactory>>();
+  ON_CALL(*compression_factory, create_decompressor(_))
+  .WillByDefault(Return(ByMove(std::move(decompressor))));
+
+  EXPECT_CALL(*storage_factory_, open_read_only(_)).Times(0);
+  EXPECT_CALL(
+    *storage_factory_,
+    open_read_only_from_buffer(
+      Field(&rosbag2_storage::StorageOptions::uri, EndsWith("bagfile_0")),
+      Pointee(ElementsAre(1, 2, 3)))).Times(1).WillOnce(Return(storage_));
+
+  auto sequential_reader = std::make_unique<rosbag2_compression::SequentialCompressionReader>(
+    std::move(compression_factory),
+    std::move(storage_factory_),
+    converter_factory_,
+    std::move(metadata_io_));
+
+  reader_ = std::make_unique<rosbag2_cpp::Reader>(std::move(sequential_reader));
+  reader_->open(storage_options_, converter_options_);
+}
+
+TEST_F(SequentialCompressionReaderTest, reader_decompresses_to_disk_if_storage_can_not_read_memory)
+{
+  auto decompressor = std::make_unique<NiceMock<MockDecompressor>>();
+  ON_CALL(*decompressor, decompress_uri_to_buffer(_, _, _)).WillByDefault(Return(true));
+  ON_CALL(*decompressor, decompress_uri(_)).WillByDefault(Return("some/path"));
+  EXPECT_CALL(*decompressor, decompress_uri(_)).Times(1);
+
+  auto compression_factory = std::make_unique<NiceMock<MockCompressionFactory>>();
+  ON_CALL(*compression_factory, create_decompressor(_))
+  .WillByDefault(Return(ByMove(std::move(decompressor))));
+
+  EXPECT_CALL(*storage_factory_, open_read_only_from_buffer(_, _)).WillOnce(Return(nullptr));
+  EXPECT_CALL(
+    *storage_factory_,
+    open_read_only(Field(&rosbag2_storage::StorageOptions::uri, "some/path"))).Times(1);
+
+  auto sequential_reader = std::make_unique<rosbag2_compression::SequentialCompressionReader>(
+    std::move(compression_factory),
+    std::move(storage_factory_),
+    converter_factory_,
+    std::move(metadata_io_));
+
+  reader_ = std::make_unique<rosbag2_cpp::Reader>(std::move(sequential_reader));
+  reader_->open(storage_options_, converter_options_);
+}
+
+class FakeRangeReader : public rosbag2_storage::RangeReaderInterface
+{
+public:
+  uint64_t size() const override
+  {
+    return 0;
+  }
+
+  void read(uint64_t, uint64_t, uint8_t *) override {}
+};
+
+TEST_F(SequentialCompressionReaderTest, reader_prefers_range_reads_over_decompressing_files)
+{
+  const auto range_reader = std::make_shared<FakeRangeReader>();
+  auto decompressor = std::make_unique<NiceMock<MockDecompressor>>();
+  ON_CALL(*decompressor, open_uri_for_range_reads(_)).WillByDefault(Return(range_reader));
+  EXPECT_CALL(*decompressor, decompress_uri_to_buffer(_, _, _)).Times(0);
+  EXPECT_CALL(*decompressor, decompress_uri(_)).Times(0);
+
+  auto compression_factory = std::make_unique<NiceMock<MockCompressionFactory>>();
+  ON_CALL(*compression_factory, create_decompressor(_))
+  .WillByDefault(Return(ByMove(std::move(decompressor))));
+
+  EXPECT_CALL(*storage_factory_, open_read_only(_)).Times(0);
+  EXPECT_CALL(
+    *storage_factory_,
+    open_read_only_from_range_reader(
+      Field(&rosbag2_storage::StorageOptions::uri, EndsWith("bagfile_0")),
+      Eq(range_reader))).Times(1).WillOnce(Return(storage_));
+
+  auto sequential_reader = std::make_unique<rosbag2_compression::SequentialCompressionReader>(
+    std::move(compression_factory),
+    std::move(storage_factory_),
+    converter_factory_,
+    std::move(metadata_io_));
+
+  reader_ = std::make_unique<rosbag2_cpp::Reader>(std::move(sequential_reader));
+  reader_->open(storage_options_, converter_options_);
+}
+
+TEST_F(SequentialCompressionReaderTest, reader_decompresses_files_if_storage_can_not_read_ranges)
+{
+  auto decompressor = std::make_unique<NiceMock<MockDecompressor>>();
+  EXPECT_CALL(*decompressor, open_uri_for_range_reads(_)).Times(1)
+  .WillOnce(Return(std::make_shared<FakeRangeReader>()));
+  ON_CALL(*decompressor, decompress_uri_to_buffer(_, _, _)).WillByDefault(Return(true));
+  EXPECT_CALL(*decompressor, decompress_uri_to_buffer(_, _, _)).Times(2);
+
+  auto compression_factory = std::make_unique<NiceMock<MockCompressionFactory>>();
+  ON_CALL(*compression_factory, create_decompressor(_))
+  .WillByDefault(Return(ByMove(std::move(decompressor))));
+
+  EXPECT_CALL(*storage_factory_, open_read_only_from_range_reader(_, _)).WillOnce(Return(nullptr));
+  EXPECT_CALL(*storage_factory_, open_read_only_from_buffer(_, _)).Times(2)
+  .WillRepeatedly(Return(storage_));
+  ON_CALL(*storage_, has_next()).WillByDefault(Return(false));
+
+  auto sequential_reader = std::make_unique<rosbag2_compression::SequentialCompressionReader>(
+    std::move(compression_factory),
+    std::move(storage_factory_),
+    converter_factory_,
+    std::move(metadata_io_));
+
+  reader_ = std::make_unique<rosbag2_cpp::Reader>(std::move(sequential_reader));
+  reader_->open(storage_options_, converter_options_);
+  // Moves on to the second file, which is not tried with range reads again.
+  EXPECT_FALSE(reader_->has_next());
+}
+
+TEST_F(SequentialCompressionReaderTest, reader_loads_compression_dictionaries_from_metadata)
+{
+  metadata_.compression_mode =
+    rosbag2_compression::compression_mode_to_string(rosbag2_compression::CompressionMode::MESSAGE);
+  metadata_.compression_dictionaries["topic"] = {1, 2, 3};
+
+  auto decompressor = std::make_unique<NiceMock<MockDecompressor>>();
+  EXPECT_CALL(*decompressor, add_dictionary("topic", ElementsAre(1, 2, 3))).Times(1);
+  auto compression_factory = std::make_unique<NiceMock<MockCompressionFactory>>();
+  ON_CALL(*compression_factory, create_decompressor(_))
+  .WillByDefault(Return(ByMove(std::move(decompressor))));
+
+  auto sequential_reader = std::make_unique<rosbag2_compression::SequentialCompressionReader>(
+    std::move(compression_factory),
+    std::move(storage_factory_),
+    converter_factory_,
+    std::move(metadata_io_));
+
+  reader_ = std::make_unique<rosbag2_cpp::Reader>(std::move(sequential_reader));
+  reader_->open(storage_options_, converter_options_);
+}
+
+TEST_F(SequentialCompressionReaderTest, reader_decompresses_messages_ahead_on_threads_in_order)
+{
+  const int64_t kNumMessages = 10;
+  metadata_.compression_mode =
+    rosbag2_compression::compression_mode_to_string(rosbag2_compression::CompressionMode::MESSAGE);
+  storage_options_.decompression_threads = 3;
+  storage_options_.decompression_read_ahead_size = 64;
+
+  std::atomic<int64_t> next_message{0};
+  ON_CALL(*storage_, has_next()).WillByDefault(
+    [&next_message, kNumMessages] {return next_message < kNumMessages;});
+  ON_CALL(*storage_, read_next()).WillByDefault(
+    [&next_message] {
+      auto message = std::make_shared<rosbag2_storage::SerializedBagMessage>();
+      message->topic_name = "topic";
+      message->time_stamp = next_message++;
+      message->serialized_data = rosbag2_storage::make_empty_serialized_message(16);
+      message->serialized_data->buffer_length = 16;
+      return message;
+    });
+
+  auto compression_factory = std::make_unique<NiceMock<MockCompressionFactory>>();
+  // One decompressor for the reader and one for every decompression thread.
+  EXPECT_CALL(*compression_factory, create_decompressor(_)).Times(4)
+  .WillRepeatedly(
+    [](auto) {
+      auto decompressor = std::make_shared<NiceMock<MockDecompressor>>();
+      ON_CALL(*decompressor, decompress_serialized_bag_message(_)).WillByDefault(
+        [](rosbag2_storage::SerializedBagMessage * message) {
+          message->topic_name = "decompressed";
+        });
+      return decompressor;
+    });
+
+  auto sequential_reader = std::make_unique<rosbag2_compression::SequentialCompressionReader>(
+    std::move(compression_factory),
+    std::move(storage_factory_),
+    converter_factory_,
+    std::move(metadata_io_));
+  reader_ = std::make_unique<rosbag2_cpp::Reader>(std::move(sequential_reader));
+  reader_->open(storage_options_, converter_options_);
+
+  for (int64_t i = 0; i < kNumMessages; i++) {
+    ASSERT_TRUE(reader_->has_next());
+    const auto message = reader_->read_next();
+    EXPECT_EQ(message->time_stamp, i);
+    EXPECT_EQ(message->topic_name, "decompressed");
+  }
+  EXPECT_FALSE(reader_->has_next());
+}
+
+TEST_F(SequentialCompressionReaderTest, reader_passes_through_messages_stored_uncompressed)
+{
+  metadata_.compression_mode =
+    rosbag2_compression::compression_mode_to_string(rosbag2_compression::CompressionMode::MESSAGE);
+  metadata_.uncompressed_topics = {"topic"};
+
+  int64_t next_message = 0;
+  ON_CALL(*storage_, has_next()).WillByDefault([&next_message] {return next_message < 4;});
+  ON_CALL(*storage_, read_next()).WillByDefault(
+    [&next_message] {
+      auto message = std::make_shared<rosbag2_storage::SerializedBagMessage>();
+      message->topic_name = "topic";
+      message->time_stamp = next_message++;
+      // Every other message is marked as compressed
+      const uint8_t data = message->time_stamp % 2 ? 0xff : 0x00;
+      message->serialized_data = rosbag2_storage::make_serialized_message(&data, 1);
+      return message;
+    });
+
+  auto decompressor = std::make_unique<NiceMock<MockDecompressor>>();
+  ON_CALL(*decompressor, is_compressed_message(_)).WillByDefault(
+    [](const rosbag2_storage::SerializedBagMessage & message) {
+      return message.serialized_data->buffer[0] == 0xff;
+    });
+  ON_CALL(*decompressor, decompress_serialized_bag_message(_)).WillByDefault(
+    [](rosbag2_storage::SerializedBagMessage * message) {
+      message->topic_name = "decompressed";
+    });
+  auto compression_factory = std::make_unique<NiceMock<MockCompressionFactory>>();
+  ON_CALL(*compression_factory, create_decompressor(_))
+  .WillByDefault(Return(ByMove(std::move(decompressor))));
+
+  auto sequential_reader = std::make_unique<rosbag2_compression::SequentialCompressionReader>(
+    std::move(compression_factory),
+    std::move(storage_factory_),
+    converter_factory_,
+    std::move(metadata_io_));
+  reader_ = std::make_unique<rosbag2_cpp::Reader>(std::move(sequential_reader));
+  reader_->open(storage_options_, converter_options_);
+
+  std::vector<std::string> topic_names;
+  while (reader_->has_next()) {
+    topic_names.push_back(reader_->read_next()->topic_name);
+  }
+  EXPECT_THAT(topic_names, ElementsAre("topic", "decompressed", "topic", "decompressed"));
+}
+
+TEST_F(SequentialCompressionReaderTest, reader_decompresses_files_ahead_and_removes_them_once_read)
+{
+  storage_options_.decompression_read_ahead_files = 1;
+  storage_options_.max_decompression_buffer_size = 0;
+
+  auto compression_factory = std::make_unique<NiceMock<MockCompressionFactory>>();
+  // One decompressor for the reader and one for the read ahead thread, which does all the work.
+  std::atomic<int> num_decompressors{0};
+  std::atomic<int> num_decompressed_by_reader{0};
+  EXPECT_CALL(*compression_factory, create_decompressor(_)).Times(2)
+  .WillRepeatedly(
+    [&num_decompressors, &num_decompressed_by_reader](auto) {
+      const bool is_reader = num_decompressors++ == 0;
+      auto decompressor = std::make_shared<NiceMock<MockDecompressor>>();
+      ON_CALL(*decompressor, decompress_uri(_)).WillByDefault(
+        [is_reader, &num_decompressed_by_reader](const std::string & uri) {
+          num_decompressed_by_reader += is_reader ? 1 : 0;
+          const auto decompressed_uri = rcpputils::fs::remove_extension(uri).string();
+          std::ofstream output(decompressed_uri);
+          output << "Decompressed storage data" << std::endl;
+          return decompressed_uri;
+        });
+      return decompressor;
+    });
+
+  // Every file holds one message.
+  int remaining_messages = 0;
+  std::vector<std::string> opened_uris;
+  ON_CALL(*storage_factory_, open_read_only(_)).WillByDefault(
+    [this, &remaining_messages, &opened_uris](const rosbag2_storage::StorageOptions & options) {
+      EXPECT_TRUE(rcpputils::fs::exists(options.uri));
+      opened_uris.push_back(options.uri);
+      remaining_messages = 1;
+      return storage_;
+    });
+  ON_CALL(*storage_, has_next()).WillByDefault(
+    [&remaining_messages] {return remaining_messages > 0;});
+  ON_CALL(*storage_, read_next()).WillByDefault(
+    [&remaining_messages] {
+      remaining_messages--;
+      return std::make_shared<rosbag2_storage::SerializedBagMessage>();
+    });
+
+  auto sequential_reader = std::make_unique<rosbag2_compression::SequentialCompressionReader>(
+    std::move(compression_factory),
+    std::move(storage_factory_),
+    converter_factory_,
+    std::move(metadata_io_));
+  reader_ = std::make_unique<rosbag2_cpp::Reader>(std::move(sequential_reader));
+  reader_->open(storage_options_, converter_options_);
+
+  const auto first_file = (tmp_dir_ / "bagfile_0").string();
+  const auto second_file = (tmp_dir_ / "bagfile_1").string();
+  ASSERT_TRUE(reader_->has_next());
+  reader_->read_next();
+  ASSERT_TRUE(reader_->has_next());
+  reader_->read_next();
+  EXPECT_THAT(opened_uris, ElementsAre(first_file, second_file));
+  // The first file is removed once the reader moved on to the second one.
+  EXPECT_FALSE(rcpputils::fs::exists(first_file));
+  EXPECT_TRUE(rcpputils::fs::exists(second_file));
+  EXPECT_FALSE(reader_->has_next());
+
+  reader_->close();
+  EXPECT_FALSE(rcpputils::fs::exists(second_file));
+  EXPECT_EQ(num_decompressed_by_reader, 0);
+}
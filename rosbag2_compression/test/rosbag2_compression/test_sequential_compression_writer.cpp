@@ -14,20 +14,29 @@
 
 #include <gmock/gmock.h>
 
+#include <atomic>
+#include <chrono>
 #include <fstream>
+#include <map>
 #include <memory>
+#include <mutex>
+#include <set>
+#include <stdexcept>
 #include <string>
+#include <thread>
 #include <utility>
 #include <vector>
 
 #include "rcpputils/asserts.hpp"
 #include "rcpputils/filesystem_helper.hpp"
 
+#include "rosbag2_compression/chunk_compression_storage.hpp"
 #include "rosbag2_compression/compression_options.hpp"
 #include "rosbag2_compression/sequential_compression_writer.hpp"
 
 #include "rosbag2_cpp/writer.hpp"
 
+#include "rosbag2_storage/ros_helper.hpp"
 #include "rosbag2_storage/storage_options.hpp"
 
 #include "mock_converter_factory.hpp"
@@ -35,12 +44,126 @@
 #include "mock_storage.hpp"
 #include "mock_storage_factory.hpp"
 
+#include "mock_compression.hpp"
 #include "mock_compression_factory.hpp"
 
 using namespace testing;  // NOLINT
 
 static constexpr const char * DefaultTestCompressor = "fake_comp";
 
+namespace
+{
+// Trains the topic name as dictionary and marks compressed messages with whether one was used
+class DictionaryCompressor : public rosbag2_compression::BaseCompressorInterface
+{
+public:
+  std::string compress_uri(const std::string & uri) override {return uri;}
+
+  void compress_serialized_bag_message(
+    const rosbag2_storage::SerializedBagMessage * bag_message,
+    rosbag2_storage::SerializedBagMessage * compressed_message) override
+  {
+    const uint8_t used_dictionary = dictionaries_.count(bag_message->topic_name) > 0;
+    compressed_message->serialized_data =
+      rosbag2_storage::make_serialized_message(&used_dictionary, 1);
+  }
+
+  std::vector<uint8_t> train_dictionary(
+    const std::vector<std::shared_ptr<const rosbag2_storage::SerializedBagMessage>> & samples)
+  override
+  {
+    const auto & topic_name = samples.front()->topic_name;
+    return std::vector<uint8_t>(topic_name.begin(), topic_name.end());
+  }
+
+  void set_dictionary(
+    const std::string & topic_name, const std::vector<uint8_t> &) override
+  {
+    dictionaries_.insert(topic_name);
+  }
+
+  std::string get_compression_identifier() const override {return "dictionary";}
+
+private:
+  std::set<std::string> dictionaries_;
+};
+
+// Marks compressed messages with the compression level they were compressed with
+class LevelCompressor : public rosbag2_compression::BaseCompressorInterface
+{
+public:
+  std::string compress_uri(const std::string & uri) override {return uri;}
+
+  void compress_serialized_bag_message(
+    const rosbag2_storage::SerializedBagMessage *,
+    rosbag2_storage::SerializedBagMessage * compressed_message) override
+  {
+    const auto level = static_cast<uint8_t>(level_);
+    compressed_message->serialized_data = rosbag2_storage::make_serialized_message(&level, 1);
+  }
+
+  void set_compression_level(int32_t level) override
+  {
+    if (level < 1 || level > 9) {
+      throw std::invalid_argument("level out of range");
+    }
+    level_ = level;
+  }
+
+  std::string get_compression_identifier() const override {return "level";}
+
+private:
+  int32_t level_ = 0;
+};
+
+// Records the number of workers every file is compressed with
+class WorkersCompressor : public rosbag2_compression::BaseCompressorInterface
+{
+public:
+  WorkersCompressor(std::mutex & mutex, std::vector<uint64_t> & used_workers)
+  : mutex_(mutex), used_workers_(used_workers) {}
+
+  std::string compress_uri(const std::string & uri) override
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    used_workers_.push_back(workers_);
+    return uri;
+  }
+
+  void compress_serialized_bag_message(
+    const rosbag2_storage::SerializedBagMessage *,
+    rosbag2_storage::SerializedBagMessage *) override {}
+
+  void set_compression_workers(uint64_t workers) override {workers_ = workers;}
+
+  std::string get_compression_identifier() const override {return "workers";}
+
+private:
+  std::mutex & mutex_;
+  std::vector<uint64_t> & used_workers_;
+  uint64_t workers_ = 0;
+};
+
+// Writes the compressed file next to the uncompressed one, like real file compressors
+class FileCompressor : public rosbag2_compression::BaseCompressorInterface
+{
+public:
+  std::string compress_uri(const std::string & uri) override
+  {
+    const auto compressed_uri = uri + ".file";
+    std::ofstream output(compressed_uri);
+    output << "Compressed data" << std::endl;
+    return compressed_uri;
+  }
+
+  void compress_serialized_bag_message(
+    const rosbag2_storage::SerializedBagMessage *,
+    rosbag2_storage::SerializedBagMessage *) override {}
+
+  std::string get_compression_identifier() const override {return "file";}
+};
+}  // namespace
+
 class SequentialCompressionWriterTest : public TestWithParam<uint64_t>
 {
 public:
@@ -93,7 +216,7 @@ public:
       [this](std::shared_ptr<const rosbag2_storage::SerializedBagMessage>) {
         fake_storage_size_ += 1;
       });
-    ON_CALL(*storage_, get_bagfile_size).WillByDefault(
+    ON_CALL(*storage_, get_bagfile_size_estimate).WillByDefault(
       [this]() {
         return fake_storage_size_;
       });
@@ -294,6 +417,562 @@ TEST_P(SequentialCompressionWriterTest, writer_writes_with_compression_queue_siz
   EXPECT_EQ(fake_storage_size_, kNumMessagesToWrite);
 }
 
+TEST_F(SequentialCompressionWriterTest, writer_keeps_message_order_with_multiple_threads)
+{
+  const std::string test_topic_name = "test_topic";
+  rosbag2_compression::CompressionOptions compression_options {
+    DefaultTestCompressor,
+    rosbag2_compression::CompressionMode::MESSAGE,
+    0,
+    kDefaultCompressionQueueThreads
+  };
+
+  std::vector<rcutils_time_point_value_t> written_time_stamps;
+  ON_CALL(
+    *storage_,
+    write(An<std::shared_ptr<const rosbag2_storage::SerializedBagMessage>>())).WillByDefault(
+    [&written_time_stamps](std::shared_ptr<const rosbag2_storage::SerializedBagMessage> message) {
+      written_time_stamps.push_back(message->time_stamp);
+    });
+  initializeWriter(compression_options);
+
+  writer_->open(tmp_dir_storage_options_);
+  writer_->create_topic({test_topic_name, "test_msgs/BasicTypes", "", ""});
+
+  const rcutils_time_point_value_t kNumMessagesToWrite = 200;
+  for (rcutils_time_point_value_t i = 0; i < kNumMessagesToWrite; i++) {
+    auto message = std::make_shared<rosbag2_storage::SerializedBagMessage>();
+    message->topic_name = test_topic_name;
+    message->time_stamp = i;
+    writer_->write(message);
+  }
+  writer_.reset();
+
+  ASSERT_EQ(written_time_stamps.size(), static_cast<size_t>(kNumMessagesToWrite));
+  for (rcutils_time_point_value_t i = 0; i < kNumMessagesToWrite; i++) {
+    EXPECT_EQ(written_time_stamps[i], i);
+  }
+}
+
+TEST_F(SequentialCompressionWriterTest, writer_writes_messages_as_chunks_in_chunk_mode)
+{
+  const std::string test_topic_name = "test_topic";
+  rosbag2_compression::CompressionOptions compression_options {
+    DefaultTestCompressor,
+    rosbag2_compression::CompressionMode::CHUNK,
+    kDefaultCompressionQueueSize,
+    kDefaultCompressionQueueThreads
+  };
+  compression_options.compression_chunk_size = 0;
+
+  std::vector<std::string> written_topics;
+  ON_CALL(
+    *storage_,
+    write(An<std::shared_ptr<const rosbag2_storage::SerializedBagMessage>>())).WillByDefault(
+    [&written_topics](std::shared_ptr<const rosbag2_storage::SerializedBagMessage> message) {
+      written_topics.push_back(message->topic_name);
+    });
+  initializeWriter(compression_options);
+
+  writer_->open(tmp_dir_storage_options_);
+  writer_->create_topic({test_topic_name, "test_msgs/BasicTypes", "", ""});
+  const size_t kNumMessagesToWrite = 3;
+  for (size_t i = 0; i < kNumMessagesToWrite; i++) {
+    auto message = std::make_shared<rosbag2_storage::SerializedBagMessage>();
+    message->topic_name = test_topic_name;
+    writer_->write(message);
+  }
+  writer_.reset();
+
+  EXPECT_THAT(
+    written_topics,
+    Each(StrEq(rosbag2_compression::kCompressedChunkTopic)));
+  EXPECT_EQ(written_topics.size(), kNumMessagesToWrite);
+  EXPECT_EQ(intercepted_metadata_.compression_mode, "CHUNK");
+  ASSERT_EQ(intercepted_metadata_.topics_with_message_count.size(), 1u);
+  EXPECT_EQ(
+    intercepted_metadata_.topics_with_message_count[0].message_count, kNumMessagesToWrite);
+  // Chunks mix topics, their statistics are kept for the whole bag.
+  EXPECT_THAT(intercepted_metadata_.compression_statistics, ElementsAre(Key("")));
+}
+
+TEST_F(SequentialCompressionWriterTest, writer_trains_dictionaries_per_topic_in_message_mode)
+{
+  rosbag2_compression::CompressionOptions compression_options {
+    "dictionary",
+    rosbag2_compression::CompressionMode::MESSAGE,
+    0,
+    1
+  };
+  compression_options.compression_dictionary_samples = 10;
+
+  std::vector<uint8_t> used_dictionary;
+  ON_CALL(
+    *storage_,
+    write(An<std::shared_ptr<const rosbag2_storage::SerializedBagMessage>>())).WillByDefault(
+    [&used_dictionary](std::shared_ptr<const rosbag2_storage::SerializedBagMessage> message) {
+      if (message->topic_name == "frequent") {
+        used_dictionary.push_back(message->serialized_data->buffer[0]);
+      }
+    });
+  auto compression_factory = std::make_unique<NiceMock<MockCompressionFactory>>();
+  ON_CALL(*compression_factory, create_compressor(_)).WillByDefault(
+    [](const std::string &) {return std::make_shared<DictionaryCompressor>();});
+  initializeWriter(compression_options, std::move(compression_factory));
+
+  writer_->open(tmp_dir_storage_options_);
+  writer_->create_topic({"frequent", "test_msgs/BasicTypes", "", ""});
+  writer_->create_topic({"rare", "test_msgs/BasicTypes", "", ""});
+  for (size_t i = 0; i < 20; i++) {
+    auto message = std::make_shared<rosbag2_storage::SerializedBagMessage>();
+    message->topic_name = i % 10 ? "frequent" : "rare";
+    writer_->write(message);
+  }
+  writer_.reset();
+
+  // With a single compression thread, the dictionary is used right after the last sample.
+  ASSERT_EQ(used_dictionary.size(), 18u);
+  EXPECT_THAT(
+    used_dictionary,
+    ElementsAre(0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 1, 1, 1, 1));
+  ASSERT_EQ(intercepted_metadata_.compression_dictionaries.size(), 1u);
+  const auto & dictionary = intercepted_metadata_.compression_dictionaries.at("frequent");
+  EXPECT_EQ(std::string(dictionary.begin(), dictionary.end()), "frequent");
+}
+
+TEST_F(SequentialCompressionWriterTest, writer_records_fixed_compression_level_in_message_mode)
+{
+  rosbag2_compression::CompressionOptions compression_options {
+    "level",
+    rosbag2_compression::CompressionMode::MESSAGE,
+    0,
+    2
+  };
+  compression_options.compression_level = 7;
+
+  std::vector<uint8_t> used_levels;
+  ON_CALL(
+    *storage_,
+    write(An<std::shared_ptr<const rosbag2_storage::SerializedBagMessage>>())).WillByDefault(
+    [&used_levels](std::shared_ptr<const rosbag2_storage::SerializedBagMessage> message) {
+      used_levels.push_back(message->serialized_data->buffer[0]);
+    });
+  auto compression_factory = std::make_unique<NiceMock<MockCompressionFactory>>();
+  ON_CALL(*compression_factory, create_compressor(_)).WillByDefault(
+    [](const std::string &) {return std::make_shared<LevelCompressor>();});
+  initializeWriter(compression_options, std::move(compression_factory));
+
+  writer_->open(tmp_dir_storage_options_);
+  writer_->create_topic({"test_topic", "test_msgs/BasicTypes", "", ""});
+  for (size_t i = 0; i < 20; i++) {
+    auto message = std::make_shared<rosbag2_storage::SerializedBagMessage>();
+    message->topic_name = "test_topic";
+    writer_->write(message);
+  }
+  writer_.reset();
+
+  EXPECT_THAT(used_levels, AllOf(SizeIs(20u), Each(7)));
+  EXPECT_THAT(intercepted_metadata_.compression_levels, ElementsAre(Pair(7, 20u)));
+}
+
+TEST_F(SequentialCompressionWriterTest, writer_stores_compression_statistics_per_topic)
+{
+  rosbag2_compression::CompressionOptions compression_options {
+    "level",
+    rosbag2_compression::CompressionMode::MESSAGE,
+    0,
+    2
+  };
+  auto compression_factory = std::make_unique<NiceMock<MockCompressionFactory>>();
+  ON_CALL(*compression_factory, create_compressor(_)).WillByDefault(
+    [](const std::string &) {return std::make_shared<LevelCompressor>();});
+  initializeWriter(compression_options, std::move(compression_factory));
+
+  writer_->open(tmp_dir_storage_options_);
+  const std::vector<uint8_t> data(10, 0);
+  for (const auto & topic_name : {"/a", "/b", "/a"}) {
+    writer_->create_topic({topic_name, "test_msgs/BasicTypes", "", ""});
+    auto message = std::make_shared<rosbag2_storage::SerializedBagMessage>();
+    message->topic_name = topic_name;
+    message->serialized_data = rosbag2_storage::make_serialized_message(data.data(), data.size());
+    writer_->write(message);
+  }
+  writer_.reset();
+
+  const auto & statistics = intercepted_metadata_.compression_statistics;
+  ASSERT_THAT(statistics, ElementsAre(Key("/a"), Key("/b")));
+  EXPECT_EQ(statistics.at("/a").input_bytes, 20u);
+  EXPECT_EQ(statistics.at("/a").output_bytes, 2u);
+  EXPECT_EQ(statistics.at("/b").input_bytes, 10u);
+  EXPECT_EQ(statistics.at("/b").output_bytes, 1u);
+}
+
+TEST_F(SequentialCompressionWriterTest, writer_stores_messages_uncompressed_following_policies)
+{
+  rosbag2_compression::CompressionOptions compression_options {
+    "level",
+    rosbag2_compression::CompressionMode::MESSAGE,
+    0,
+    1
+  };
+  compression_options.compression_policy = rosbag2_compression::TopicCompressionPolicy::AUTO;
+  compression_options.compression_topic_policies["/never"] =
+    rosbag2_compression::TopicCompressionPolicy::NEVER;
+  compression_options.compression_policy_samples = 2;
+
+  std::map<std::string, std::vector<std::vector<uint8_t>>> stored_data;
+  ON_CALL(
+    *storage_,
+    write(An<std::shared_ptr<const rosbag2_storage::SerializedBagMessage>>())).WillByDefault(
+    [&stored_data](std::shared_ptr<const rosbag2_storage::SerializedBagMessage> message) {
+      const auto & data = *message->serialized_data;
+      stored_data[message->topic_name].emplace_back(data.buffer, data.buffer + data.buffer_length);
+    });
+  auto compression_factory = std::make_unique<NiceMock<MockCompressionFactory>>();
+  ON_CALL(*compression_factory, create_compressor(_)).WillByDefault(
+    [](const std::string &) {return std::make_shared<LevelCompressor>();});
+  // Messages starting with 0xff pass for compressed ones
+  ON_CALL(*compression_factory, create_decompressor(_)).WillByDefault(
+    [](const std::string &) {
+      auto decompressor = std::make_shared<NiceMock<MockDecompressor>>();
+      ON_CALL(*decompressor, is_compressed_message(_)).WillByDefault(
+        [](const rosbag2_storage::SerializedBagMessage & message) {
+          return message.serialized_data->buffer[0] == 0xff;
+        });
+      return decompressor;
+    });
+  initializeWriter(compression_options, std::move(compression_factory));
+
+  writer_->open(tmp_dir_storage_options_);
+  const std::vector<std::pair<std::string, std::vector<uint8_t>>> messages = {
+    {"/incompressible", {42}},
+    {"/compressible", std::vector<uint8_t>(10, 7)},
+    {"/never", {5, 5}},
+    {"/incompressible", {42}},
+    {"/never", {0xff, 5}},
+    {"/compressible", std::vector<uint8_t>(10, 7)},
+    {"/incompressible", {42}},
+    {"/compressible", std::vector<uint8_t>(10, 7)},
+  };
+  for (const auto & topic_data : messages) {
+    writer_->create_topic({topic_data.first, "test_msgs/BasicTypes", "", ""});
+    auto message = std::make_shared<rosbag2_storage::SerializedBagMessage>();
+    message->topic_name = topic_data.first;
+    message->serialized_data = rosbag2_storage::make_serialized_message(
+      topic_data.second.data(), topic_data.second.size());
+    writer_->write(message);
+  }
+  writer_.reset();
+
+  // LevelCompressor compresses every message to its level, which is 0 here.
+  using Data = std::vector<uint8_t>;
+  EXPECT_THAT(stored_data["/incompressible"], ElementsAre(Data{0}, Data{0}, Data{42}));
+  EXPECT_THAT(stored_data["/compressible"], ElementsAre(Data{0}, Data{0}, Data{0}));
+  EXPECT_THAT(stored_data["/never"], ElementsAre(Data{5, 5}, Data{0}));
+  EXPECT_THAT(
+    intercepted_metadata_.uncompressed_topics, ElementsAre("/incompressible", "/never"));
+}
+
+TEST_F(SequentialCompressionWriterTest, writer_checkpoints_uncompressed_topics_while_recording)
+{
+  rosbag2_compression::CompressionOptions compression_options {
+    "level",
+    rosbag2_compression::CompressionMode::MESSAGE,
+    0,
+    1
+  };
+  compression_options.compression_topic_policies["/never"] =
+    rosbag2_compression::TopicCompressionPolicy::NEVER;
+
+  std::mutex metadata_mutex;
+  std::vector<rosbag2_storage::BagMetadata> checkpoints;
+  ON_CALL(*metadata_io_, write_metadata).WillByDefault(
+    [&](const std::string &, const rosbag2_storage::BagMetadata & metadata) {
+      std::lock_guard<std::mutex> lock(metadata_mutex);
+      checkpoints.push_back(metadata);
+    });
+  auto compression_factory = std::make_unique<NiceMock<MockCompressionFactory>>();
+  ON_CALL(*compression_factory, create_compressor(_)).WillByDefault(
+    [](const std::string &) {return std::make_shared<LevelCompressor>();});
+  ON_CALL(*compression_factory, create_decompressor(_)).WillByDefault(
+    [](const std::string &) {return std::make_shared<NiceMock<MockDecompressor>>();});
+  initializeFakeFileStorage();
+  initializeWriter(compression_options, std::move(compression_factory));
+
+  // Splits checkpoint the metadata
+  tmp_dir_storage_options_.max_bagfile_size = 1;
+  tmp_dir_storage_options_.metadata_checkpoint_interval = 3600;
+  writer_->open(tmp_dir_storage_options_);
+  writer_->create_topic({"/never", "test_msgs/BasicTypes", "", ""});
+  const std::vector<uint8_t> data = {5, 5};
+  for (size_t i = 0; i < 3; i++) {
+    auto message = std::make_shared<rosbag2_storage::SerializedBagMessage>();
+    message->topic_name = "/never";
+    message->serialized_data = rosbag2_storage::make_serialized_message(data.data(), data.size());
+    writer_->write(message);
+  }
+  writer_.reset();
+
+  std::lock_guard<std::mutex> lock(metadata_mutex);
+  ASSERT_THAT(checkpoints, SizeIs(Gt(1u)));
+  EXPECT_THAT(checkpoints.front().uncompressed_topics, ElementsAre("/never"));
+}
+
+TEST_F(SequentialCompressionWriterTest, writer_compresses_files_with_worker_budget_in_file_mode)
+{
+  rosbag2_compression::CompressionOptions compression_options {
+    "workers",
+    rosbag2_compression::CompressionMode::FILE,
+    0,
+    1
+  };
+  compression_options.compression_file_workers = 6;
+
+  std::mutex mutex;
+  std::vector<uint64_t> used_workers;
+  auto compression_factory = std::make_unique<NiceMock<MockCompressionFactory>>();
+  ON_CALL(*compression_factory, create_compressor(_)).WillByDefault(
+    [&](const std::string &) {return std::make_shared<WorkersCompressor>(mutex, used_workers);});
+  initializeFakeFileStorage();
+  initializeWriter(compression_options, std::move(compression_factory));
+
+  tmp_dir_storage_options_.max_bagfile_size = 1;
+  writer_->open(tmp_dir_storage_options_);
+  writer_->create_topic({"test_topic", "test_msgs/BasicTypes", "", ""});
+  auto message = std::make_shared<rosbag2_storage::SerializedBagMessage>();
+  message->topic_name = "test_topic";
+  for (size_t i = 0; i < 3; i++) {
+    writer_->write(message);
+  }
+  writer_.reset();
+
+  // With a single compression thread, every file gets the whole budget.
+  EXPECT_THAT(used_workers, AllOf(SizeIs(3u), Each(6u)));
+}
+
+TEST_F(SequentialCompressionWriterTest, writer_stops_checkpointing_on_close)
+{
+  rosbag2_compression::CompressionOptions compression_options {
+    DefaultTestCompressor,
+    rosbag2_compression::CompressionMode::FILE,
+    kDefaultCompressionQueueSize,
+    kDefaultCompressionQueueThreads
+  };
+  std::atomic<size_t> metadata_writes {0u};
+  ON_CALL(*metadata_io_, write_metadata).WillByDefault(
+    [&metadata_writes](const std::string &, const rosbag2_storage::BagMetadata &) {
+      ++metadata_writes;
+    });
+  initializeFakeFileStorage();
+  rosbag2_compression::SequentialCompressionWriter writer(
+    compression_options,
+    std::make_unique<rosbag2_compression::CompressionFactory>(),
+    std::move(storage_factory_),
+    converter_factory_,
+    std::move(metadata_io_));
+
+  tmp_dir_storage_options_.metadata_checkpoint_interval = 1;
+  writer.open(tmp_dir_storage_options_, {serialization_format_, serialization_format_});
+  writer.close();
+  const auto writes_on_close = metadata_writes.load();
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(1500));
+  EXPECT_EQ(metadata_writes.load(), writes_on_close);
+}
+
+TEST_F(SequentialCompressionWriterTest, writer_checkpoints_only_existing_files_in_file_mode)
+{
+  rosbag2_compression::CompressionOptions compression_options {
+    "file",
+    rosbag2_compression::CompressionMode::FILE,
+    0,
+    1
+  };
+  std::mutex metadata_mutex;
+  std::vector<rosbag2_storage::BagMetadata> checkpoints;
+  ON_CALL(*metadata_io_, write_metadata).WillByDefault(
+    [&](const std::string &, const rosbag2_storage::BagMetadata & metadata) {
+      std::lock_guard<std::mutex> lock(metadata_mutex);
+      // Checked on write, since files may be compressed and removed right afterwards
+      for (const auto & path : metadata.relative_file_paths) {
+        EXPECT_TRUE((tmp_dir_ / path).exists()) << path;
+      }
+      checkpoints.push_back(metadata);
+    });
+  auto compression_factory = std::make_unique<NiceMock<MockCompressionFactory>>();
+  ON_CALL(*compression_factory, create_compressor(_)).WillByDefault(
+    [](const std::string &) {return std::make_shared<FileCompressor>();});
+  initializeFakeFileStorage();
+  initializeWriter(compression_options, std::move(compression_factory));
+
+  tmp_dir_storage_options_.max_bagfile_size = 1;
+  tmp_dir_storage_options_.metadata_checkpoint_interval = 3600;
+  writer_->open(tmp_dir_storage_options_);
+  writer_->create_topic({"test_topic", "test_msgs/BasicTypes", "", ""});
+  auto message = std::make_shared<rosbag2_storage::SerializedBagMessage>();
+  message->topic_name = "test_topic";
+  for (size_t i = 0; i < 3; i++) {
+    writer_->write(message);
+  }
+  writer_.reset();
+
+  // Every compressed file is checkpointed before its uncompressed file is removed
+  std::lock_guard<std::mutex> lock(metadata_mutex);
+  ASSERT_FALSE(checkpoints.empty());
+  EXPECT_THAT(
+    checkpoints.back().relative_file_paths,
+    ElementsAre(bag_name_ + "_0.file", bag_name_ + "_1.file", bag_name_ + "_2.file"));
+}
+
+TEST_F(SequentialCompressionWriterTest, writer_splits_while_topics_are_created_in_file_mode)
+{
+  rosbag2_compression::CompressionOptions compression_options {
+    "file",
+    rosbag2_compression::CompressionMode::FILE,
+    0,
+    1
+  };
+  auto compression_factory = std::make_unique<NiceMock<MockCompressionFactory>>();
+  ON_CALL(*compression_factory, create_compressor(_)).WillByDefault(
+    [](const std::string &) {return std::make_shared<FileCompressor>();});
+  initializeFakeFileStorage();
+  // Widen the window between taking the writer state and splitting
+  ON_CALL(*storage_, get_bagfile_size_estimate).WillByDefault(
+    [this]() {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      return fake_storage_size_;
+    });
+  // rosbag2_cpp::Writer serializes topic creation with writes, so use the writer directly
+  rosbag2_compression::SequentialCompressionWriter writer(
+    compression_options,
+    std::move(compression_factory),
+    std::move(storage_factory_),
+    converter_factory_,
+    std::move(metadata_io_));
+
+  tmp_dir_storage_options_.max_bagfile_size = 1;
+  writer.open(tmp_dir_storage_options_, {serialization_format_, serialization_format_});
+  writer.create_topic({"test_topic", "test_msgs/BasicTypes", "", ""});
+
+  // Every write splits, which must not deadlock with topics being created meanwhile
+  const size_t kNumMessagesToWrite = 100;
+  std::atomic_bool writing {true};
+  std::thread topic_creator([&writer, &writing]() {
+      for (size_t i = 0; writing; i++) {
+        writer.create_topic({"topic_" + std::to_string(i), "test_msgs/BasicTypes", "", ""});
+      }
+    });
+  auto message = std::make_shared<rosbag2_storage::SerializedBagMessage>();
+  message->topic_name = "test_topic";
+  for (size_t i = 0; i < kNumMessagesToWrite; i++) {
+    writer.write(message);
+  }
+  writing = false;
+  topic_creator.join();
+  writer.close();
+
+  EXPECT_THAT(intercepted_metadata_.relative_file_paths, SizeIs(kNumMessagesToWrite));
+}
+
+TEST_F(SequentialCompressionWriterTest, writer_lowers_adaptive_compression_level_under_load)
+{
+  rosbag2_compression::CompressionOptions compression_options {
+    "level",
+    rosbag2_compression::CompressionMode::MESSAGE,
+    0,
+    1
+  };
+  compression_options.compression_level = 9;
+  compression_options.adaptive_compression_level = true;
+  compression_options.min_compression_level = 1;
+
+  // A slow storage keeps the compression pipeline full
+  ON_CALL(
+    *storage_,
+    write(An<std::shared_ptr<const rosbag2_storage::SerializedBagMessage>>())).WillByDefault(
+    [](std::shared_ptr<const rosbag2_storage::SerializedBagMessage>) {
+      std::this_thread::sleep_for(std::chrono::microseconds(200));
+    });
+  auto compression_factory = std::make_unique<NiceMock<MockCompressionFactory>>();
+  ON_CALL(*compression_factory, create_compressor(_)).WillByDefault(
+    [](const std::string &) {return std::make_shared<LevelCompressor>();});
+  initializeWriter(compression_options, std::move(compression_factory));
+
+  const size_t kNumMessagesToWrite = 256;
+  writer_->open(tmp_dir_storage_options_);
+  writer_->create_topic({"test_topic", "test_msgs/BasicTypes", "", ""});
+  for (size_t i = 0; i < kNumMessagesToWrite; i++) {
+    auto message = std::make_shared<rosbag2_storage::SerializedBagMessage>();
+    message->topic_name = "test_topic";
+    writer_->write(message);
+  }
+  writer_.reset();
+
+  const auto & compression_levels = intercepted_metadata_.compression_levels;
+  ASSERT_FALSE(compression_levels.empty());
+  EXPECT_LT(compression_levels.begin()->first, 9);
+  size_t message_count = 0;
+  for (const auto & level : compression_levels) {
+    message_count += level.second;
+  }
+  EXPECT_EQ(message_count, kNumMessagesToWrite);
+}
+
+TEST_F(SequentialCompressionWriterTest, writer_rejects_adaptive_compression_level_without_range)
+{
+  rosbag2_compression::CompressionOptions compression_options {
+    "level",
+    rosbag2_compression::CompressionMode::MESSAGE,
+    0,
+    1
+  };
+  compression_options.compression_level = 1;
+  compression_options.adaptive_compression_level = true;
+  compression_options.min_compression_level = 1;
+  auto compression_factory = std::make_unique<NiceMock<MockCompressionFactory>>();
+  ON_CALL(*compression_factory, create_compressor(_)).WillByDefault(
+    [](const std::string &) {return std::make_shared<LevelCompressor>();});
+  initializeWriter(compression_options, std::move(compression_factory));
+
+  EXPECT_THROW(writer_->open(tmp_dir_storage_options_), std::invalid_argument);
+}
+
+TEST_F(SequentialCompressionWriterTest, writer_rejects_adaptive_default_compression_level)
+{
+  rosbag2_compression::CompressionOptions compression_options {
+    "level",
+    rosbag2_compression::CompressionMode::MESSAGE,
+    0,
+    1
+  };
+  compression_options.compression_level = 0;
+  compression_options.adaptive_compression_level = true;
+  compression_options.min_compression_level = -1;
+  auto compression_factory = std::make_unique<NiceMock<MockCompressionFactory>>();
+  ON_CALL(*compression_factory, create_compressor(_)).WillByDefault(
+    [](const std::string &) {return std::make_shared<LevelCompressor>();});
+  initializeWriter(compression_options, std::move(compression_factory));
+
+  EXPECT_THROW(writer_->open(tmp_dir_storage_options_), std::invalid_argument);
+}
+
+TEST_F(SequentialCompressionWriterTest, writer_rejects_compression_level_unknown_to_compressor)
+{
+  rosbag2_compression::CompressionOptions compression_options {
+    "level",
+    rosbag2_compression::CompressionMode::MESSAGE,
+    0,
+    1
+  };
+  compression_options.compression_level = 10;
+  auto compression_factory = std::make_unique<NiceMock<MockCompressionFactory>>();
+  ON_CALL(*compression_factory, create_compressor(_)).WillByDefault(
+    [](const std::string &) {return std::make_shared<LevelCompressor>();});
+  initializeWriter(compression_options, std::move(compression_factory));
+
+  EXPECT_THROW(writer_->open(tmp_dir_storage_options_), std::invalid_argument);
+}
+
 INSTANTIATE_TEST_SUITE_P(
   SequentialCompressionWriterTestQueueSizes,
   SequentialCompressionWriterTest,
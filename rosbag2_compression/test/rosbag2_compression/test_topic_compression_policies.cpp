@@ -0,0 +1,103 @@
+// Copyright 2022, Open Source Robotics Corporation.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gmock/gmock.h>
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "rosbag2_compression/topic_compression_policies.hpp"
+
+using namespace testing;  // NOLINT
+using rosbag2_compression::CompressionOptions;
+using rosbag2_compression::TopicCompressionPolicies;
+using rosbag2_compression::TopicCompressionPolicy;
+
+namespace
+{
+CompressionOptions make_options(TopicCompressionPolicy default_policy)
+{
+  CompressionOptions options{"fake_comp", rosbag2_compression::CompressionMode::MESSAGE, 0, 1};
+  options.compression_policy = default_policy;
+  options.compression_policy_samples = 4;
+  options.compression_policy_min_ratio = 1.5;
+  return options;
+}
+}  // namespace
+
+TEST(TopicCompressionPoliciesTest, follows_default_and_topic_policies)
+{
+  auto options = make_options(TopicCompressionPolicy::ALWAYS);
+  options.compression_topic_policies["/image/compressed"] = TopicCompressionPolicy::NEVER;
+  TopicCompressionPolicies policies(options);
+
+  EXPECT_TRUE(policies.should_compress("/odom"));
+  EXPECT_FALSE(policies.should_compress("/image/compressed"));
+  EXPECT_FALSE(policies.should_compress("/image/compressed"));
+  EXPECT_THAT(policies.get_uncompressed_topics(), ElementsAre("/image/compressed"));
+}
+
+TEST(TopicCompressionPoliciesTest, auto_stops_compressing_topics_with_low_ratio)
+{
+  TopicCompressionPolicies policies(make_options(TopicCompressionPolicy::AUTO));
+
+  for (int i = 0; i < 4; i++) {
+    EXPECT_TRUE(policies.should_compress("/video"));
+    policies.add_sample("/video", 1000, 990);
+    EXPECT_TRUE(policies.should_compress("/odom"));
+    policies.add_sample("/odom", 1000, 200);
+  }
+  EXPECT_FALSE(policies.should_compress("/video"));
+  EXPECT_TRUE(policies.should_compress("/odom"));
+  EXPECT_THAT(policies.get_uncompressed_topics(), ElementsAre("/video"));
+}
+
+TEST(TopicCompressionPoliciesTest, auto_decides_on_the_first_samples_only)
+{
+  TopicCompressionPolicies policies(make_options(TopicCompressionPolicy::AUTO));
+
+  for (int i = 0; i < 4; i++) {
+    policies.add_sample("/odom", 1000, 200);
+  }
+  policies.add_sample("/odom", 1000, 1000);
+  EXPECT_TRUE(policies.should_compress("/odom"));
+  EXPECT_THAT(policies.get_uncompressed_topics(), IsEmpty());
+}
+
+TEST(TopicCompressionPoliciesTest, reports_each_uncompressed_topic_once)
+{
+  std::vector<std::string> reported_topics;
+  TopicCompressionPolicies policies(
+    make_options(TopicCompressionPolicy::AUTO),
+    [&reported_topics](const std::string & topic_name) {reported_topics.push_back(topic_name);});
+
+  for (int i = 0; i < 4; i++) {
+    policies.add_sample("/video", 1000, 990);
+    policies.add_sample("/odom", 1000, 200);
+  }
+  EXPECT_THAT(reported_topics, IsEmpty());
+  EXPECT_FALSE(policies.should_compress("/video"));
+  EXPECT_FALSE(policies.should_compress("/video"));
+  EXPECT_TRUE(policies.should_compress("/odom"));
+  EXPECT_THAT(reported_topics, ElementsAre("/video"));
+}
+
+TEST(TopicCompressionPoliciesTest, auto_needs_samples)
+{
+  auto options = make_options(TopicCompressionPolicy::ALWAYS);
+  options.compression_topic_policies["/video"] = TopicCompressionPolicy::AUTO;
+  options.compression_policy_samples = 0;
+  EXPECT_THROW(TopicCompressionPolicies{options}, std::invalid_argument);
+}
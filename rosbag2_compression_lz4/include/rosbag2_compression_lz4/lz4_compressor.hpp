@@ -0,0 +1,72 @@
+// Copyright 2022, Open Source Robotics Corporation.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ROSBAG2_COMPRESSION_LZ4__LZ4_COMPRESSOR_HPP_
+#define ROSBAG2_COMPRESSION_LZ4__LZ4_COMPRESSOR_HPP_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "rosbag2_compression/base_compressor_interface.hpp"
+#include "rosbag2_compression/serialized_message_pool.hpp"
+
+#include "rosbag2_compression_lz4/visibility_control.hpp"
+
+// Declared by lz4frame.h, which users of the compressor do not need.
+struct LZ4F_cctx_s;
+
+namespace rosbag2_compression_lz4
+{
+
+/**
+ * A BaseCompressorInterface that compresses bagfiles and messages into LZ4 frames.
+ *
+ * LZ4 compresses and decompresses several times faster than zstd at a lower compression ratio,
+ * for recording more data than zstd can keep up with.
+ */
+class ROSBAG2_COMPRESSION_LZ4_PUBLIC Lz4Compressor
+  : public rosbag2_compression::BaseCompressorInterface
+{
+public:
+  Lz4Compressor();
+
+  ~Lz4Compressor() override;
+
+  std::string compress_uri(const std::string & uri) override;
+
+  void compress_serialized_bag_message(
+    const rosbag2_storage::SerializedBagMessage * bag_message,
+    rosbag2_storage::SerializedBagMessage * compressed_message) override;
+
+  /**
+   * Set the LZ4 compression level, between -65537 and LZ4F_compressionLevel_max().
+   * Negative levels accelerate compression, levels of 3 and above use LZ4 HC.
+   * Files and messages are compressed with level 0, LZ4's default, until this is called.
+   */
+  void set_compression_level(int32_t level) override;
+
+  std::string get_compression_identifier() const override;
+
+private:
+  LZ4F_cctx_s * lz4_context_;
+  int compression_level_;
+  // Reused for every message and file compressed by this context.
+  std::vector<uint8_t> compression_buffer_;
+  rosbag2_compression::SerializedMessagePool message_pool_;
+};
+
+}  // namespace rosbag2_compression_lz4
+
+#endif  // ROSBAG2_COMPRESSION_LZ4__LZ4_COMPRESSOR_HPP_
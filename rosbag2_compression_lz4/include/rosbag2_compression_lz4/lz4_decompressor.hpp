@@ -0,0 +1,65 @@
+// Copyright 2022, Open Source Robotics Corporation.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ROSBAG2_COMPRESSION_LZ4__LZ4_DECOMPRESSOR_HPP_
+#define ROSBAG2_COMPRESSION_LZ4__LZ4_DECOMPRESSOR_HPP_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "rosbag2_compression/base_decompressor_interface.hpp"
+#include "rosbag2_compression/serialized_message_pool.hpp"
+
+#include "rosbag2_compression_lz4/visibility_control.hpp"
+
+// Declared by lz4frame.h, which users of the decompressor do not need.
+struct LZ4F_dctx_s;
+
+namespace rosbag2_compression_lz4
+{
+
+/**
+ * A BaseDecompressorInterface that decompresses bagfiles and messages compressed by Lz4Compressor.
+ */
+class ROSBAG2_COMPRESSION_LZ4_PUBLIC Lz4Decompressor
+  : public rosbag2_compression::BaseDecompressorInterface
+{
+public:
+  Lz4Decompressor();
+
+  ~Lz4Decompressor() override;
+
+  std::string decompress_uri(const std::string & uri) override;
+
+  bool decompress_uri_to_buffer(
+    const std::string & uri, uint64_t max_size, std::vector<uint8_t> & buffer) override;
+
+  void decompress_serialized_bag_message(
+    rosbag2_storage::SerializedBagMessage * bag_message) override;
+
+  /// Whether the message starts with the magic number of an LZ4 frame.
+  bool is_compressed_message(const rosbag2_storage::SerializedBagMessage & bag_message)
+  const override;
+
+  std::string get_decompression_identifier() const override;
+
+private:
+  LZ4F_dctx_s * lz4_context_;
+  rosbag2_compression::SerializedMessagePool message_pool_;
+};
+
+}  // namespace rosbag2_compression_lz4
+
+#endif  // ROSBAG2_COMPRESSION_LZ4__LZ4_DECOMPRESSOR_HPP_
@@ -0,0 +1,72 @@
+// Copyright 2022, Open Source Robotics Corporation.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "compression_utils.hpp"
+
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+#include "rcutils/logging.h"
+
+namespace rosbag2_compression_lz4
+{
+
+size_t throw_on_lz4_error(const size_t result)
+{
+  if (LZ4F_isError(result)) {
+    std::stringstream error;
+    error << "LZ4 error: " << LZ4F_getErrorName(result);
+
+    throw std::runtime_error{error.str()};
+  }
+  return result;
+}
+
+std::fstream open_file(const std::string & uri, std::ios::openmode mode)
+{
+  std::fstream file(uri, mode | std::ios::binary);
+  if (!file.is_open()) {
+    std::stringstream errmsg;
+    errmsg << "Failed to open file: \"" << uri << "\" for binary " <<
+      ((mode & std::ios::out) ? "writing" : "reading") << "! errno(" << errno << ")";
+
+    throw std::runtime_error{errmsg.str()};
+  }
+  return file;
+}
+
+void print_compression_statistics(
+  const std::chrono::high_resolution_clock::time_point start,
+  const std::chrono::high_resolution_clock::time_point end,
+  const size_t decompressed_size,
+  const size_t compressed_size)
+{
+  if (!rcutils_logging_logger_is_enabled_for(
+      ROSBAG2_COMPRESSION_LZ4_PACKAGE_NAME, RCUTILS_LOG_SEVERITY_DEBUG))
+  {
+    return;
+  }
+  const auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end - start);
+  const auto decompression_ratio =
+    static_cast<double>(decompressed_size) / static_cast<double>(compressed_size);
+
+  ROSBAG2_COMPRESSION_LZ4_LOG_DEBUG_STREAM(
+    "\"Compression statistics\" : {" <<
+      "\"Time\" : " << (duration.count() / 1000.0) <<
+      ", \"Compression Ratio\" : " << decompression_ratio <<
+      "}");
+}
+
+}  // namespace rosbag2_compression_lz4
@@ -0,0 +1,75 @@
+// Copyright 2022, Open Source Robotics Corporation.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ROSBAG2_COMPRESSION_LZ4__COMPRESSION_UTILS_HPP_
+#define ROSBAG2_COMPRESSION_LZ4__COMPRESSION_UTILS_HPP_
+
+#include <lz4frame.h>
+
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <string>
+
+#include "logging.hpp"
+
+namespace rosbag2_compression_lz4
+{
+// LZ4 compression levels:
+//   - 0 is LZ4's default fast compression
+//   - Negative levels trade ratio for speed, accelerating compression
+//   - 3 and above use the much slower LZ4 HC compressor
+constexpr const int kDefaultLz4CompressionLevel = 0;
+// Highest acceleration of LZ4, higher accelerations are clamped to it.
+constexpr const int kMinLz4CompressionLevel = -65537;
+// Size of the chunks in which files are read when compressed or decompressed.
+constexpr const size_t kLz4FileChunkSize = 64 * 1024;
+// String constant used to identify Lz4Compressor.
+constexpr const char kCompressionIdentifier[] = "lz4";
+// String constant used to identify Lz4Decompressor.
+constexpr const char kDecompressionIdentifier[] = "lz4";
+// First four bytes of every LZ4 frame, in little endian.
+constexpr const uint32_t kLz4FrameMagicNumber = 0x184D2204;
+
+/**
+ * Checks the result of an LZ4F function and throws a runtime_error if it is an error.
+ * \param result is the return value of an LZ4F function.
+ * \return result, if it is no error.
+ */
+size_t throw_on_lz4_error(const size_t result);
+
+/**
+ * Opens a file for binary reading or writing and throws a runtime_error if that fails.
+ * \param uri is the path of the file.
+ * \param mode is std::ios::in or std::ios::out.
+ */
+std::fstream open_file(const std::string & uri, std::ios::openmode mode);
+
+/**
+ * Prints compression statistics to the debug log stream, formatted like those of the zstd
+ * plugin. Nothing is formatted unless debug logging is enabled.
+ *
+ * \param start is the time_point when compression or decompression started.
+ * \param end is the time_point when compression or decompression ended.
+ * \param decompressed_size is the decompressed data size
+ * \param compressed_size is the compressed data size
+ */
+void print_compression_statistics(
+  const std::chrono::high_resolution_clock::time_point start,
+  const std::chrono::high_resolution_clock::time_point end,
+  const size_t decompressed_size,
+  const size_t compressed_size);
+}  // namespace rosbag2_compression_lz4
+
+#endif  // ROSBAG2_COMPRESSION_LZ4__COMPRESSION_UTILS_HPP_
@@ -0,0 +1,155 @@
+// Copyright 2022, Open Source Robotics Corporation.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <chrono>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "rcpputils/filesystem_helper.hpp"
+
+#include "compression_utils.hpp"
+#include "rosbag2_compression_lz4/lz4_compressor.hpp"
+
+namespace rosbag2_compression_lz4
+{
+namespace
+{
+LZ4F_preferences_t make_preferences(int compression_level, uint64_t content_size)
+{
+  LZ4F_preferences_t preferences = LZ4F_INIT_PREFERENCES;
+  preferences.compressionLevel = compression_level;
+  // Output is produced right away instead of being buffered in the context.
+  preferences.autoFlush = 1;
+  // Lets the decompressor size its output up front and verify it.
+  preferences.frameInfo.contentSize = content_size;
+  return preferences;
+}
+}  // namespace
+
+Lz4Compressor::Lz4Compressor()
+: compression_level_(kDefaultLz4CompressionLevel)
+{
+  // As for zstd, a context is allocated once and reused for every compression.
+  throw_on_lz4_error(LZ4F_createCompressionContext(&lz4_context_, LZ4F_VERSION));
+}
+
+Lz4Compressor::~Lz4Compressor()
+{
+  LZ4F_freeCompressionContext(lz4_context_);
+}
+
+std::string Lz4Compressor::compress_uri(const std::string & uri)
+{
+  const auto start = std::chrono::high_resolution_clock::now();
+  const auto compressed_uri = uri + "." + get_compression_identifier();
+
+  auto input = open_file(uri, std::ios::in);
+  auto output = open_file(compressed_uri, std::ios::out);
+
+  const auto file_size = rcpputils::fs::file_size(rcpputils::fs::path{uri});
+  const auto preferences = make_preferences(compression_level_, file_size);
+  std::vector<char> in_buffer(kLz4FileChunkSize);
+  compression_buffer_.resize(
+    std::max(LZ4F_compressBound(kLz4FileChunkSize, &preferences), size_t{LZ4F_HEADER_SIZE_MAX}));
+
+  auto size = throw_on_lz4_error(
+    LZ4F_compressBegin(
+      lz4_context_, compression_buffer_.data(), compression_buffer_.size(), &preferences));
+  output.write(reinterpret_cast<const char *>(compression_buffer_.data()), size);
+  size_t total_size = size;
+  while (input.read(in_buffer.data(), in_buffer.size()) || input.gcount() > 0) {
+    size = throw_on_lz4_error(
+      LZ4F_compressUpdate(
+        lz4_context_, compression_buffer_.data(), compression_buffer_.size(),
+        in_buffer.data(), static_cast<size_t>(input.gcount()), nullptr));
+    output.write(reinterpret_cast<const char *>(compression_buffer_.data()), size);
+    total_size += size;
+  }
+  size = throw_on_lz4_error(
+    LZ4F_compressEnd(
+      lz4_context_, compression_buffer_.data(), compression_buffer_.size(), nullptr));
+  output.write(reinterpret_cast<const char *>(compression_buffer_.data()), size);
+  total_size += size;
+
+  output.flush();
+  if (!output) {
+    std::stringstream errmsg;
+    errmsg << "Unable to write data to file: \"" << compressed_uri << "\"!";
+    throw std::runtime_error{errmsg.str()};
+  }
+
+  const auto end = std::chrono::high_resolution_clock::now();
+  print_compression_statistics(start, end, file_size, total_size);
+  return compressed_uri;
+}
+
+void Lz4Compressor::compress_serialized_bag_message(
+  const rosbag2_storage::SerializedBagMessage * bag_message,
+  rosbag2_storage::SerializedBagMessage * compressed_message)
+{
+  const auto start = std::chrono::high_resolution_clock::now();
+  const auto & data = *bag_message->serialized_data;
+  const auto preferences = make_preferences(compression_level_, data.buffer_length);
+
+  // Compress into the scratch buffer, sized for a whole frame, so that the message only holds
+  // on to as much memory as the compressed data needs.
+  const auto maximum_compressed_length = LZ4F_compressFrameBound(data.buffer_length, &preferences);
+  if (compression_buffer_.size() < maximum_compressed_length) {
+    compression_buffer_.resize(maximum_compressed_length);
+  }
+  auto * output = compression_buffer_.data();
+  auto * const output_end = output + maximum_compressed_length;
+  output += throw_on_lz4_error(
+    LZ4F_compressBegin(lz4_context_, output, output_end - output, &preferences));
+  output += throw_on_lz4_error(
+    LZ4F_compressUpdate(
+      lz4_context_, output, output_end - output, data.buffer, data.buffer_length, nullptr));
+  output += throw_on_lz4_error(
+    LZ4F_compressEnd(lz4_context_, output, output_end - output, nullptr));
+  const size_t compression_result = output - compression_buffer_.data();
+
+  compressed_message->serialized_data = message_pool_.acquire(compression_result);
+  std::copy(
+    compression_buffer_.data(), output, compressed_message->serialized_data->buffer);
+  compressed_message->serialized_data->buffer_length = compression_result;
+
+  const auto end = std::chrono::high_resolution_clock::now();
+  print_compression_statistics(start, end, data.buffer_length, compression_result);
+}
+
+void Lz4Compressor::set_compression_level(int32_t level)
+{
+  if (level < kMinLz4CompressionLevel || level > LZ4F_compressionLevel_max()) {
+    std::stringstream errmsg;
+    errmsg << "LZ4 compression level " << level << " is not between " <<
+      kMinLz4CompressionLevel << " and " << LZ4F_compressionLevel_max() << ".";
+    throw std::invalid_argument{errmsg.str()};
+  }
+  compression_level_ = level;
+}
+
+std::string Lz4Compressor::get_compression_identifier() const
+{
+  return kCompressionIdentifier;
+}
+
+}  // namespace rosbag2_compression_lz4
+
+#include "pluginlib/class_list_macros.hpp"  // NOLINT
+PLUGINLIB_EXPORT_CLASS(
+  rosbag2_compression_lz4::Lz4Compressor,
+  rosbag2_compression::BaseCompressorInterface)
@@ -0,0 +1,232 @@
+// Copyright 2022, Open Source Robotics Corporation.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <chrono>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "rcpputils/filesystem_helper.hpp"
+
+#include "compression_utils.hpp"
+#include "rosbag2_compression_lz4/lz4_decompressor.hpp"
+
+namespace rosbag2_compression_lz4
+{
+Lz4Decompressor::Lz4Decompressor()
+{
+  throw_on_lz4_error(LZ4F_createDecompressionContext(&lz4_context_, LZ4F_VERSION));
+}
+
+Lz4Decompressor::~Lz4Decompressor()
+{
+  LZ4F_freeDecompressionContext(lz4_context_);
+}
+
+std::string Lz4Decompressor::decompress_uri(const std::string & uri)
+{
+  const auto start = std::chrono::high_resolution_clock::now();
+  const auto uri_path = rcpputils::fs::path{uri};
+  const auto decompressed_uri = rcpputils::fs::remove_extension(uri_path).string();
+
+  auto input = open_file(uri, std::ios::in);
+  auto output = open_file(decompressed_uri, std::ios::out);
+  // A previous frame may have been abandoned half way.
+  LZ4F_resetDecompressionContext(lz4_context_);
+
+  std::vector<char> in_buffer(kLz4FileChunkSize);
+  std::vector<char> out_buffer(kLz4FileChunkSize);
+  size_t compressed_size = 0;
+  size_t total_size = 0;
+  size_t remaining = 0;
+  while (input.read(in_buffer.data(), in_buffer.size()) || input.gcount() > 0) {
+    const auto size = static_cast<size_t>(input.gcount());
+    compressed_size += size;
+    size_t position = 0;
+    while (position < size) {
+      size_t out_size = out_buffer.size();
+      size_t in_size = size - position;
+      remaining = throw_on_lz4_error(
+        LZ4F_decompress(
+          lz4_context_, out_buffer.data(), &out_size, in_buffer.data() + position, &in_size,
+          nullptr));
+      output.write(out_buffer.data(), out_size);
+      total_size += out_size;
+      position += in_size;
+    }
+  }
+  // Some more output may be pending once all input is consumed.
+  while (remaining != 0) {
+    size_t out_size = out_buffer.size();
+    size_t in_size = 0;
+    remaining = throw_on_lz4_error(
+      LZ4F_decompress(lz4_context_, out_buffer.data(), &out_size, nullptr, &in_size, nullptr));
+    if (out_size == 0) {
+      throw std::runtime_error{"LZ4 file \"" + uri + "\" is truncated."};
+    }
+    output.write(out_buffer.data(), out_size);
+    total_size += out_size;
+  }
+  output.flush();
+  if (!output) {
+    std::stringstream errmsg;
+    errmsg << "Unable to write data to file: \"" << decompressed_uri << "\"!";
+    throw std::runtime_error{errmsg.str()};
+  }
+
+  const auto end = std::chrono::high_resolution_clock::now();
+  print_compression_statistics(start, end, total_size, compressed_size);
+  return decompressed_uri;
+}
+
+bool Lz4Decompressor::decompress_uri_to_buffer(
+  const std::string & uri, uint64_t max_size, std::vector<uint8_t> & buffer)
+{
+  const auto start = std::chrono::high_resolution_clock::now();
+  buffer.clear();
+
+  auto input = open_file(uri, std::ios::in);
+  LZ4F_resetDecompressionContext(lz4_context_);
+  const auto give_up = [this, &buffer] {
+      buffer.clear();
+      buffer.shrink_to_fit();
+      LZ4F_resetDecompressionContext(lz4_context_);
+      return false;
+    };
+
+  std::vector<char> in_buffer(kLz4FileChunkSize);
+  size_t compressed_size = 0;
+  bool first_chunk = true;
+  size_t remaining = 1;
+  while (input.read(in_buffer.data(), in_buffer.size()) || input.gcount() > 0) {
+    const auto size = static_cast<size_t>(input.gcount());
+    compressed_size += size;
+    size_t position = 0;
+    if (first_chunk) {
+      // Files written by Lz4Compressor carry their decompressed size, which saves reallocations
+      // and rejects files over budget right away.
+      LZ4F_frameInfo_t frame_info;
+      position = size;
+      throw_on_lz4_error(LZ4F_getFrameInfo(lz4_context_, &frame_info, in_buffer.data(), &position));
+      if (frame_info.contentSize > max_size) {
+        return give_up();
+      }
+      buffer.reserve(frame_info.contentSize);
+      first_chunk = false;
+    }
+    while (position < size) {
+      const auto offset = buffer.size();
+      if (offset > max_size) {
+        return give_up();
+      }
+      buffer.resize(offset + kLz4FileChunkSize);
+      size_t out_size = kLz4FileChunkSize;
+      size_t in_size = size - position;
+      remaining = throw_on_lz4_error(
+        LZ4F_decompress(
+          lz4_context_, buffer.data() + offset, &out_size, in_buffer.data() + position, &in_size,
+          nullptr));
+      buffer.resize(offset + out_size);
+      position += in_size;
+    }
+  }
+  while (remaining != 0) {
+    const auto offset = buffer.size();
+    if (offset > max_size) {
+      return give_up();
+    }
+    buffer.resize(offset + kLz4FileChunkSize);
+    size_t out_size = kLz4FileChunkSize;
+    size_t in_size = 0;
+    remaining = throw_on_lz4_error(
+      LZ4F_decompress(lz4_context_, buffer.data() + offset, &out_size, nullptr, &in_size, nullptr));
+    buffer.resize(offset + out_size);
+    if (out_size == 0) {
+      LZ4F_resetDecompressionContext(lz4_context_);
+      throw std::runtime_error{"LZ4 file \"" + uri + "\" is truncated."};
+    }
+  }
+
+  if (buffer.size() > max_size) {
+    return give_up();
+  }
+
+  const auto end = std::chrono::high_resolution_clock::now();
+  print_compression_statistics(start, end, buffer.size(), compressed_size);
+  return true;
+}
+
+void Lz4Decompressor::decompress_serialized_bag_message(
+  rosbag2_storage::SerializedBagMessage * message)
+{
+  const auto start = std::chrono::high_resolution_clock::now();
+  const auto * compressed_buffer = message->serialized_data->buffer;
+  const auto compressed_buffer_length = message->serialized_data->buffer_length;
+  // A previous message may have failed to decompress half way.
+  LZ4F_resetDecompressionContext(lz4_context_);
+
+  LZ4F_frameInfo_t frame_info;
+  size_t header_size = compressed_buffer_length;
+  throw_on_lz4_error(
+    LZ4F_getFrameInfo(lz4_context_, &frame_info, compressed_buffer, &header_size));
+
+  // Decompress into an array of this context, which replaces the compressed one in the message.
+  const auto decompressed_buffer_length = static_cast<size_t>(frame_info.contentSize);
+  auto decompressed_data = message_pool_.acquire(decompressed_buffer_length);
+  size_t out_size = decompressed_buffer_length;
+  size_t in_size = compressed_buffer_length - header_size;
+  const auto remaining = throw_on_lz4_error(
+    LZ4F_decompress(
+      lz4_context_, decompressed_data->buffer, &out_size,
+      compressed_buffer + header_size, &in_size, nullptr));
+  // Frames of messages carry their size, the data does not fit if it is missing.
+  if (remaining != 0 || out_size != decompressed_buffer_length) {
+    std::stringstream errmsg;
+    errmsg << "Message on topic " << message->topic_name <<
+      " is no complete LZ4 frame with the size of its content.";
+    throw std::runtime_error{errmsg.str()};
+  }
+
+  decompressed_data->buffer_length = out_size;
+  message->serialized_data = std::move(decompressed_data);
+
+  const auto end = std::chrono::high_resolution_clock::now();
+  print_compression_statistics(start, end, out_size, compressed_buffer_length);
+}
+
+bool Lz4Decompressor::is_compressed_message(
+  const rosbag2_storage::SerializedBagMessage & message) const
+{
+  if (!message.serialized_data || message.serialized_data->buffer_length < 4) {
+    return false;
+  }
+  const auto * bytes = message.serialized_data->buffer;
+  const auto magic_number = static_cast<uint32_t>(bytes[0]) |
+    (static_cast<uint32_t>(bytes[1]) << 8) | (static_cast<uint32_t>(bytes[2]) << 16) |
+    (static_cast<uint32_t>(bytes[3]) << 24);
+  return magic_number == kLz4FrameMagicNumber;
+}
+
+std::string Lz4Decompressor::get_decompression_identifier() const
+{
+  return kDecompressionIdentifier;
+}
+}  // namespace rosbag2_compression_lz4
+
+#include "pluginlib/class_list_macros.hpp"  // NOLINT
+PLUGINLIB_EXPORT_CLASS(
+  rosbag2_compression_lz4::Lz4Decompressor,
+  rosbag2_compression::BaseDecompressorInterface)
@@ -0,0 +1,248 @@
+// Copyright 2022, Open Source Robotics Corporation.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "rcpputils/filesystem_helper.hpp"
+
+#include "rosbag2_compression_lz4/lz4_compressor.hpp"
+#include "rosbag2_compression_lz4/lz4_decompressor.hpp"
+
+#include "rosbag2_storage/ros_helper.hpp"
+
+#include "rosbag2_test_common/temporary_directory_fixture.hpp"
+
+#include "gmock/gmock.h"
+
+using namespace ::testing;  // NOLINT
+
+namespace
+{
+// Compressible, but not trivially: lines of a log with a changing counter.
+std::string create_log_string(size_t num_lines)
+{
+  std::stringstream output;
+  for (size_t i = 0; i < num_lines; i++) {
+    output << "[INFO] [" << 1650000000 + i * 7 << "] [camera_driver]: frame " << i <<
+      " exposure " << (i * 31) % 1000 << "\n";
+  }
+  return output.str();
+}
+
+void write_file(const std::string & uri, const std::string & content)
+{
+  std::ofstream out{uri, std::ios::binary};
+  out << content;
+}
+
+std::string read_file(const std::string & uri)
+{
+  std::ifstream in{uri, std::ios::binary};
+  return std::string{std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()};
+}
+
+std::string to_string(const rcutils_uint8_array_t & array)
+{
+  return std::string{reinterpret_cast<const char *>(array.buffer), array.buffer_length};
+}
+
+rosbag2_storage::SerializedBagMessage make_message(const std::string & content)
+{
+  rosbag2_storage::SerializedBagMessage message;
+  message.topic_name = "/log";
+  message.serialized_data = rosbag2_storage::make_serialized_message(
+    content.data(), content.size());
+  return message;
+}
+}  // namespace
+
+class Lz4CompressionFixture : public rosbag2_test_common::TemporaryDirectoryFixture
+{
+protected:
+  std::string uri(const std::string & file_name) const
+  {
+    return (rcpputils::fs::path(temporary_dir_path_) / file_name).string();
+  }
+
+  // About 7 MiB, spanning many chunks of the file compression.
+  const std::string file_content_ = create_log_string(100000);
+};
+
+TEST_F(Lz4CompressionFixture, lz4_compress_and_decompress_file_uri)
+{
+  const auto file_uri = uri("file1.db3");
+  write_file(file_uri, file_content_);
+
+  rosbag2_compression_lz4::Lz4Compressor compressor;
+  const auto compressed_uri = compressor.compress_uri(file_uri);
+  EXPECT_EQ(compressed_uri, file_uri + ".lz4");
+  EXPECT_LT(rcpputils::fs::file_size(compressed_uri), file_content_.size() / 2);
+  ASSERT_EQ(0, std::remove(file_uri.c_str()));
+
+  rosbag2_compression_lz4::Lz4Decompressor decompressor;
+  EXPECT_EQ(decompressor.decompress_uri(compressed_uri), file_uri);
+  EXPECT_EQ(read_file(file_uri), file_content_);
+}
+
+TEST_F(Lz4CompressionFixture, lz4_decompress_file_to_buffer)
+{
+  const auto file_uri = uri("file2.db3");
+  write_file(file_uri, file_content_);
+  rosbag2_compression_lz4::Lz4Compressor compressor;
+  const auto compressed_uri = compressor.compress_uri(file_uri);
+  ASSERT_EQ(0, std::remove(file_uri.c_str()));
+
+  rosbag2_compression_lz4::Lz4Decompressor decompressor;
+  std::vector<uint8_t> buffer;
+  ASSERT_TRUE(decompressor.decompress_uri_to_buffer(compressed_uri, file_content_.size(), buffer));
+  EXPECT_EQ(std::string(buffer.begin(), buffer.end()), file_content_);
+  EXPECT_FALSE(rcpputils::fs::exists(file_uri)) << "Expected no decompressed file on disk.";
+}
+
+TEST_F(Lz4CompressionFixture, lz4_decompress_file_to_buffer_fails_over_max_size)
+{
+  const auto file_uri = uri("file3.db3");
+  write_file(file_uri, file_content_);
+  rosbag2_compression_lz4::Lz4Compressor compressor;
+  const auto compressed_uri = compressor.compress_uri(file_uri);
+
+  rosbag2_compression_lz4::Lz4Decompressor decompressor;
+  std::vector<uint8_t> buffer;
+  EXPECT_FALSE(
+    decompressor.decompress_uri_to_buffer(compressed_uri, file_content_.size() - 1, buffer));
+  EXPECT_TRUE(buffer.empty());
+
+  // The decompressor is still usable after giving up.
+  EXPECT_TRUE(decompressor.decompress_uri_to_buffer(compressed_uri, file_content_.size(), buffer));
+  EXPECT_EQ(file_content_.size(), buffer.size());
+}
+
+TEST_F(Lz4CompressionFixture, lz4_decompress_fails_on_bad_file)
+{
+  const auto file_uri = uri("file4.db3");
+  write_file(file_uri, file_content_);
+
+  rosbag2_compression_lz4::Lz4Decompressor decompressor;
+  EXPECT_THROW(decompressor.decompress_uri(file_uri), std::runtime_error);
+  std::vector<uint8_t> buffer;
+  EXPECT_THROW(
+    decompressor.decompress_uri_to_buffer(file_uri, file_content_.size(), buffer),
+    std::runtime_error);
+  EXPECT_THROW(
+    decompressor.decompress_uri(uri("does_not_exist.db3.lz4")), std::runtime_error);
+}
+
+TEST_F(Lz4CompressionFixture, lz4_compress_and_decompress_serialized_bag_message)
+{
+  const auto content = create_log_string(1000);
+  auto message = make_message(content);
+
+  rosbag2_compression_lz4::Lz4Compressor compressor;
+  rosbag2_storage::SerializedBagMessage compressed_message;
+  compressed_message.topic_name = message.topic_name;
+  compressor.compress_serialized_bag_message(&message, &compressed_message);
+  EXPECT_LT(compressed_message.serialized_data->buffer_length, content.size() / 2);
+
+  rosbag2_compression_lz4::Lz4Decompressor decompressor;
+  decompressor.decompress_serialized_bag_message(&compressed_message);
+  EXPECT_EQ(to_string(*compressed_message.serialized_data), content);
+  // The original message is left untouched.
+  EXPECT_EQ(to_string(*message.serialized_data), content);
+}
+
+TEST_F(Lz4CompressionFixture, lz4_compress_and_decompress_empty_and_tiny_messages)
+{
+  rosbag2_compression_lz4::Lz4Compressor compressor;
+  rosbag2_compression_lz4::Lz4Decompressor decompressor;
+  for (const std::string content : {"", "x", "0123456789"}) {
+    auto message = make_message(content);
+    rosbag2_storage::SerializedBagMessage compressed_message;
+    compressor.compress_serialized_bag_message(&message, &compressed_message);
+    decompressor.decompress_serialized_bag_message(&compressed_message);
+    EXPECT_EQ(to_string(*compressed_message.serialized_data), content);
+  }
+}
+
+TEST_F(Lz4CompressionFixture, lz4_decompress_fails_on_bad_message)
+{
+  auto message = make_message("not an lz4 frame");
+  rosbag2_compression_lz4::Lz4Decompressor decompressor;
+  EXPECT_THROW(decompressor.decompress_serialized_bag_message(&message), std::runtime_error);
+
+  // A truncated frame fails too, and leaves the decompressor usable.
+  const auto content = create_log_string(100);
+  auto original = make_message(content);
+  rosbag2_compression_lz4::Lz4Compressor compressor;
+  rosbag2_storage::SerializedBagMessage compressed_message;
+  compressor.compress_serialized_bag_message(&original, &compressed_message);
+  compressed_message.serialized_data->buffer_length /= 2;
+  EXPECT_THROW(
+    decompressor.decompress_serialized_bag_message(&compressed_message), std::runtime_error);
+
+  compressor.compress_serialized_bag_message(&original, &compressed_message);
+  decompressor.decompress_serialized_bag_message(&compressed_message);
+  EXPECT_EQ(to_string(*compressed_message.serialized_data), content);
+}
+
+TEST_F(Lz4CompressionFixture, lz4_recognizes_compressed_messages)
+{
+  rosbag2_compression_lz4::Lz4Compressor compressor;
+  rosbag2_compression_lz4::Lz4Decompressor decompressor;
+  for (const std::string content : {"", "x", "0123456789"}) {
+    auto message = make_message(content);
+    EXPECT_FALSE(decompressor.is_compressed_message(message));
+    rosbag2_storage::SerializedBagMessage compressed_message;
+    compressor.compress_serialized_bag_message(&message, &compressed_message);
+    EXPECT_TRUE(decompressor.is_compressed_message(compressed_message));
+  }
+}
+
+TEST_F(Lz4CompressionFixture, lz4_higher_compression_level_shrinks_messages)
+{
+  const auto content = create_log_string(1000);
+  auto message = make_message(content);
+  rosbag2_compression_lz4::Lz4Compressor compressor;
+  rosbag2_compression_lz4::Lz4Decompressor decompressor;
+
+  const auto compressed_size = [&](int32_t level) {
+      compressor.set_compression_level(level);
+      rosbag2_storage::SerializedBagMessage compressed_message;
+      compressor.compress_serialized_bag_message(&message, &compressed_message);
+      const auto size = compressed_message.serialized_data->buffer_length;
+      decompressor.decompress_serialized_bag_message(&compressed_message);
+      EXPECT_EQ(to_string(*compressed_message.serialized_data), content);
+      return size;
+    };
+  const auto accelerated_size = compressed_size(-10);
+  const auto default_size = compressed_size(0);
+  const auto high_compression_size = compressed_size(9);
+  EXPECT_LT(default_size, accelerated_size);
+  EXPECT_LT(high_compression_size, default_size);
+}
+
+TEST_F(Lz4CompressionFixture, lz4_rejects_invalid_compression_level)
+{
+  rosbag2_compression_lz4::Lz4Compressor compressor;
+  EXPECT_THROW(compressor.set_compression_level(100), std::invalid_argument);
+  EXPECT_THROW(compressor.set_compression_level(-100000), std::invalid_argument);
+  EXPECT_NO_THROW(compressor.set_compression_level(-1));
+  EXPECT_NO_THROW(compressor.set_compression_level(12));
+}
@@ -22,14 +22,19 @@
 #include <memory>
 #include <sstream>
 #include <string>
+#include <unordered_map>
+#include <vector>
 
 #include "rosbag2_compression/base_compressor_interface.hpp"
+#include "rosbag2_compression/serialized_message_pool.hpp"
 
 #include "rosbag2_compression_zstd/visibility_control.hpp"
 
 namespace rosbag2_compression_zstd
 {
 
+class BufferedOutputFile;
+
 /**
  * A BaseCompressorInterface that is used to compress bagfiles stored using ZStandard compression.
  */
@@ -47,10 +52,54 @@ public:
     const rosbag2_storage::SerializedBagMessage * bag_message,
     rosbag2_storage::SerializedBagMessage * compressed_message) override;
 
+  std::vector<uint8_t> train_dictionary(
+    const std::vector<std::shared_ptr<const rosbag2_storage::SerializedBagMessage>> & samples)
+  override;
+
+  void set_dictionary(
+    const std::string & topic_name, const std::vector<uint8_t> & dictionary) override;
+
+  /**
+   * Set the ZSTD compression level, between ZSTD_minCLevel() and ZSTD_maxCLevel().
+   * Messages are compressed with level 1 and files with the ZSTD default level until this is called.
+   */
+  void set_compression_level(int32_t level) override;
+
+  /**
+   * Compress further files with ZSTD worker threads, which produce the same format.
+   * If ZSTD was built without multithreading support, files keep being compressed on one thread.
+   */
+  void set_compression_workers(uint64_t workers) override;
+
+  /**
+   * Compress further files in the seekable format of ZSTD's contrib/seekable_format, as frames of
+   * up to 1 GiB each followed by a seek table. Seekable files are regular ZSTD files to readers
+   * which do not know the format.
+   */
+  void set_seekable_frame_size(uint64_t frame_size) override;
+
   std::string get_compression_identifier() const override;
 
 private:
+  struct Dictionary
+  {
+    std::vector<uint8_t> data;
+    // Digested for compression_level_, owned by the compressor; created when first needed.
+    ZSTD_CDict * digested = nullptr;
+  };
+
+  // Compresses size bytes of input as one frame, returns its compressed size.
+  uint64_t compress_frame(const char * input, uint64_t size, BufferedOutputFile & output);
+
   ZSTD_CCtx * zstd_context_;
+  int compression_level_;
+  // Uncompressed bytes per frame of seekable files, 0 for files of a single frame.
+  uint64_t seekable_frame_size_ = 0;
+  // Reused for every message compressed by this context.
+  std::vector<uint8_t> compression_buffer_;
+  rosbag2_compression::SerializedMessagePool message_pool_;
+  // Dictionaries by topic name.
+  std::unordered_map<std::string, Dictionary> dictionaries_;
 };
 
 }  // namespace rosbag2_compression_zstd
@@ -17,13 +17,17 @@
 
 #include <zstd.h>
 
+#include <cstdint>
 #include <fstream>
 #include <iostream>
 #include <memory>
 #include <sstream>
 #include <string>
+#include <unordered_map>
+#include <vector>
 
 #include "rosbag2_compression/base_decompressor_interface.hpp"
+#include "rosbag2_compression/serialized_message_pool.hpp"
 
 #include "rosbag2_compression_zstd/visibility_control.hpp"
 
@@ -43,13 +47,34 @@ public:
 
   std::string decompress_uri(const std::string & uri) override;
 
+  bool decompress_uri_to_buffer(
+    const std::string & uri, uint64_t max_size, std::vector<uint8_t> & buffer) override;
+
+  /**
+   * Open a file in the seekable format of ZSTD's contrib/seekable_format for range reads, which
+   * decompress the frames overlapping the ranges read. Files without a seek table are only
+   * decompressed as a whole.
+   */
+  std::shared_ptr<rosbag2_storage::RangeReaderInterface> open_uri_for_range_reads(
+    const std::string & uri) override;
+
   void decompress_serialized_bag_message(
     rosbag2_storage::SerializedBagMessage * bag_message) override;
 
+  /// Whether the message holds a ZSTD frame with a valid header.
+  bool is_compressed_message(const rosbag2_storage::SerializedBagMessage & bag_message)
+  const override;
+
+  void add_dictionary(
+    const std::string & topic_name, const std::vector<uint8_t> & dictionary) override;
+
   std::string get_decompression_identifier() const override;
 
 private:
   ZSTD_DCtx * zstd_context_;
+  rosbag2_compression::SerializedMessagePool message_pool_;
+  // Digested dictionaries by the dictionary ID stored in the frames, owned by the decompressor.
+  std::unordered_map<unsigned, ZSTD_DDict *> dictionaries_;
 };
 
 }  // namespace rosbag2_compression_zstd
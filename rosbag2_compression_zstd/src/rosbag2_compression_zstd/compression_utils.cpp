@@ -14,9 +14,27 @@
 
 #include "compression_utils.hpp"
 
+#ifdef _WIN32
+# include <malloc.h>
+# include <windows.h>
+#else
+# include <fcntl.h>
+# include <sys/mman.h>
+# include <sys/stat.h>
+# include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <new>
+#include <numeric>
+#include <sstream>
 #include <string>
 #include <vector>
 
+#include "rcutils/logging.h"
+
 namespace
 {
 /**
@@ -35,11 +53,193 @@ FILE * open_file(const std::string & uri, const std::string & read_mode)
 #endif
   return fp;
 }
+
+[[noreturn]] void throw_file_error(const std::string & action, const std::string & uri)
+{
+  std::stringstream errmsg;
+  errmsg << "Failed to " << action << " file: \"" << uri << "\"! errno(" << errno << ")";
+  throw std::runtime_error{errmsg.str()};
+}
+
+// The seekable format stores all numbers in little endian.
+void write_little_endian(rosbag2_compression_zstd::BufferedOutputFile & output, uint32_t value)
+{
+  const char bytes[] = {
+    static_cast<char>(value & 0xFF), static_cast<char>((value >> 8) & 0xFF),
+    static_cast<char>((value >> 16) & 0xFF), static_cast<char>((value >> 24) & 0xFF)};
+  output.write(bytes, sizeof(bytes));
+}
+
+uint32_t read_little_endian(const uint8_t * bytes)
+{
+  return static_cast<uint32_t>(bytes[0]) | (static_cast<uint32_t>(bytes[1]) << 8) |
+         (static_cast<uint32_t>(bytes[2]) << 16) | (static_cast<uint32_t>(bytes[3]) << 24);
+}
+
+// Bit 7 of the seek table descriptor marks entries with a checksum, bits 2 to 6 are reserved.
+constexpr const uint8_t kSeekTableChecksumFlag = 0x80;
+constexpr const uint8_t kSeekTableReservedBits = 0x7C;
 }  // namespace
 
 namespace rosbag2_compression_zstd
 {
 
+#ifdef _WIN32
+MappedInputFile::MappedInputFile(const std::string & uri)
+{
+  file_ = CreateFileA(
+    uri.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+    FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+  if (file_ == INVALID_HANDLE_VALUE) {
+    file_ = nullptr;
+    throw_file_error("open", uri);
+  }
+  LARGE_INTEGER file_size;
+  if (!GetFileSizeEx(file_, &file_size)) {
+    CloseHandle(file_);
+    throw_file_error("get the size of", uri);
+  }
+  size_ = static_cast<uint64_t>(file_size.QuadPart);
+  if (size_ == 0) {
+    return;
+  }
+  mapping_ = CreateFileMappingA(file_, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  if (mapping_ != nullptr) {
+    data_ = static_cast<const char *>(MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0));
+  }
+  if (data_ == nullptr) {
+    if (mapping_ != nullptr) {
+      CloseHandle(mapping_);
+    }
+    CloseHandle(file_);
+    throw_file_error("map", uri);
+  }
+}
+
+MappedInputFile::~MappedInputFile()
+{
+  if (data_ != nullptr) {
+    UnmapViewOfFile(data_);
+    CloseHandle(mapping_);
+  }
+  CloseHandle(file_);
+}
+#else
+MappedInputFile::MappedInputFile(const std::string & uri)
+{
+  file_ = ::open(uri.c_str(), O_RDONLY);
+  if (file_ < 0) {
+    throw_file_error("open", uri);
+  }
+  struct stat file_stat;
+  if (fstat(file_, &file_stat) != 0) {
+    ::close(file_);
+    throw_file_error("get the size of", uri);
+  }
+  size_ = static_cast<uint64_t>(file_stat.st_size);
+  if (size_ == 0) {
+    return;
+  }
+  void * data = mmap(nullptr, static_cast<size_t>(size_), PROT_READ, MAP_PRIVATE, file_, 0);
+  if (data == MAP_FAILED) {
+    ::close(file_);
+    throw_file_error("map", uri);
+  }
+  data_ = static_cast<const char *>(data);
+  // Both are hints, reading works the same if they are ignored.
+  madvise(data, static_cast<size_t>(size_), MADV_SEQUENTIAL);
+#ifdef POSIX_FADV_SEQUENTIAL
+  posix_fadvise(file_, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+}
+
+MappedInputFile::~MappedInputFile()
+{
+  if (data_ != nullptr) {
+    munmap(const_cast<char *>(data_), static_cast<size_t>(size_));
+  }
+  ::close(file_);
+}
+#endif
+
+void BufferedOutputFile::AlignedFree::operator()(char * buffer) const
+{
+#ifdef _WIN32
+  _aligned_free(buffer);
+#else
+  std::free(buffer);
+#endif
+}
+
+BufferedOutputFile::BufferedOutputFile(const std::string & uri)
+: uri_(uri)
+{
+#ifdef _WIN32
+  auto buffer = _aligned_malloc(kFileWriteBufferSize, kFileWriteBufferAlignment);
+#else
+  void * buffer = nullptr;
+  if (posix_memalign(&buffer, kFileWriteBufferAlignment, kFileWriteBufferSize) != 0) {
+    buffer = nullptr;
+  }
+#endif
+  if (buffer == nullptr) {
+    throw std::bad_alloc{};
+  }
+  buffer_.reset(static_cast<char *>(buffer));
+  file_ = open_file(uri, "wb");
+  if (file_ == nullptr) {
+    throw_file_error("open", uri);
+  }
+  // The buffer of this class replaces the one of the C library, whole buffers go to the system.
+  setvbuf(file_, nullptr, _IONBF, 0);
+}
+
+BufferedOutputFile::~BufferedOutputFile()
+{
+  if (file_ != nullptr) {
+    fclose(file_);
+  }
+}
+
+void BufferedOutputFile::commit(size_t size)
+{
+  buffer_used_ += size;
+  if (buffer_used_ == kFileWriteBufferSize) {
+    write_buffer();
+  }
+}
+
+void BufferedOutputFile::write(const char * data, size_t size)
+{
+  while (size > 0) {
+    const auto copy_size = std::min(size, free_size());
+    std::copy(data, data + copy_size, free_space());
+    commit(copy_size);
+    data += copy_size;
+    size -= copy_size;
+  }
+}
+
+void BufferedOutputFile::close()
+{
+  write_buffer();
+  const auto result = fclose(file_);
+  file_ = nullptr;
+  if (result != 0) {
+    throw_file_error("close", uri_);
+  }
+}
+
+void BufferedOutputFile::write_buffer()
+{
+  if (buffer_used_ > 0 && fwrite(buffer_.get(), 1, buffer_used_, file_) != buffer_used_) {
+    std::stringstream errmsg;
+    errmsg << "Unable to write data to file: \"" << uri_ << "\"!";
+    throw std::runtime_error{errmsg.str()};
+  }
+  buffer_used_ = 0;
+}
+
 void write_output_buffer(
   const std::vector<uint8_t> & output_buffer,
   const std::string & uri)
@@ -85,6 +285,74 @@ void write_output_buffer(
 }
 
 
+uint64_t write_seek_table(
+  BufferedOutputFile & output, const std::vector<ZstdSeekableFrame> & frames)
+{
+  const uint64_t entry_size = 8;
+  const auto table_size = frames.size() * entry_size + kZstdSeekTableFooterSize;
+  write_little_endian(output, kZstdSkippableFrameMagic);
+  write_little_endian(output, static_cast<uint32_t>(table_size));
+  for (const auto & frame : frames) {
+    write_little_endian(output, frame.compressed_size);
+    write_little_endian(output, frame.decompressed_size);
+  }
+  write_little_endian(output, static_cast<uint32_t>(frames.size()));
+  // No checksums, the frames carry their own if enabled.
+  const char descriptor = 0;
+  output.write(&descriptor, 1);
+  write_little_endian(output, kZstdSeekableMagic);
+  return kZstdSkippableHeaderSize + table_size;
+}
+
+bool read_seek_table(
+  std::istream & input, uint64_t file_size, std::vector<ZstdSeekableFrame> & frames)
+{
+  frames.clear();
+  if (file_size < kZstdSkippableHeaderSize + kZstdSeekTableFooterSize) {
+    return false;
+  }
+  uint8_t footer[kZstdSeekTableFooterSize];
+  input.seekg(static_cast<std::streamoff>(file_size - kZstdSeekTableFooterSize));
+  input.read(reinterpret_cast<char *>(footer), sizeof(footer));
+  if (!input || read_little_endian(footer + 5) != kZstdSeekableMagic) {
+    input.clear();
+    return false;
+  }
+
+  const auto num_frames = read_little_endian(footer);
+  const auto descriptor = footer[4];
+  const uint64_t entry_size = (descriptor & kSeekTableChecksumFlag) ? 12 : 8;
+  const auto table_size = num_frames * entry_size + kZstdSeekTableFooterSize;
+  if ((descriptor & kSeekTableReservedBits) != 0 || num_frames > kMaxZstdSeekableFrames ||
+    file_size < kZstdSkippableHeaderSize + table_size)
+  {
+    throw std::runtime_error{"Corrupt ZSTD seek table."};
+  }
+
+  std::vector<uint8_t> table(kZstdSkippableHeaderSize + table_size - kZstdSeekTableFooterSize);
+  input.seekg(static_cast<std::streamoff>(file_size - kZstdSkippableHeaderSize - table_size));
+  input.read(reinterpret_cast<char *>(table.data()), static_cast<std::streamsize>(table.size()));
+  if (!input || read_little_endian(table.data()) != kZstdSkippableFrameMagic ||
+    read_little_endian(table.data() + 4) != table_size)
+  {
+    throw std::runtime_error{"Corrupt ZSTD seek table."};
+  }
+
+  frames.reserve(num_frames);
+  for (uint64_t i = 0; i < num_frames; i++) {
+    const auto * entry = table.data() + kZstdSkippableHeaderSize + i * entry_size;
+    frames.push_back({read_little_endian(entry), read_little_endian(entry + 4)});
+  }
+  const auto compressed_size = std::accumulate(
+    frames.begin(), frames.end(), uint64_t{0}, [](uint64_t sum, const ZstdSeekableFrame & frame) {
+      return sum + frame.compressed_size;
+    });
+  if (compressed_size != file_size - kZstdSkippableHeaderSize - table_size) {
+    throw std::runtime_error{"ZSTD seek table does not match the frames of the file."};
+  }
+  return true;
+}
+
 void throw_on_zstd_error(const ZstdDecompressReturnType compression_result)
 {
   if (ZSTD_isError(compression_result)) {
@@ -135,6 +403,12 @@ void print_compression_statistics(
   const size_t decompressed_size,
   const size_t compressed_size)
 {
+  // Formatting the statistics allocates, which would be wasted for every message otherwise.
+  if (!rcutils_logging_logger_is_enabled_for(
+      ROSBAG2_COMPRESSION_ZSTD_PACKAGE_NAME, RCUTILS_LOG_SEVERITY_DEBUG))
+  {
+    return;
+  }
   const auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end - start);
   const auto decompression_ratio =
     static_cast<double>(decompressed_size) / static_cast<double>(compressed_size);
@@ -18,6 +18,9 @@
 #include <zstd.h>
 
 #include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <iostream>
 #include <memory>
 #include <string>
 #include <vector>
@@ -33,10 +36,30 @@ namespace rosbag2_compression_zstd
 //   - Decrease the size of the compressed data
 // Setting to zero uses Zstd's default value of 3.
 constexpr const int kDefaultZstdCompressionLevel = 1;
+// Upper bound for the size of a trained dictionary; zstd's own default for dictionary training.
+constexpr const size_t kMaxZstdDictionarySize = 110 * 1024;
+// Trained dictionaries are limited to this fraction of the total size of their samples, since a
+// dictionary as large as its samples only learns the samples by heart.
+constexpr const size_t kZstdDictionarySampleRatio = 10;
 // String constant used to identify ZstdCompressor.
 constexpr const char kCompressionIdentifier[] = "zstd";
 // String constant used to identify ZstdDecompressor.
 constexpr const char kDecompressionIdentifier[] = "zstd";
+// Seekable format of zstd's contrib/seekable_format: independently compressed frames followed by
+// a seek table in a skippable frame, which records the size of every frame.
+constexpr const uint32_t kZstdSkippableFrameMagic = 0x184D2A5E;
+constexpr const uint32_t kZstdSeekableMagic = 0x8F92EAB1;
+// Size of the header of a skippable frame, its magic number and the size of its content.
+constexpr const uint64_t kZstdSkippableHeaderSize = 8;
+// Size of the seek table footer, the number of frames, the descriptor and the magic number.
+constexpr const uint64_t kZstdSeekTableFooterSize = 9;
+// Limits of the seekable format for the decompressed size of a frame and the number of frames.
+constexpr const uint64_t kMaxZstdSeekableFrameSize = 0x40000000;
+constexpr const uint64_t kMaxZstdSeekableFrames = 0x8000000;
+// Size of the buffer files are written through, so that multi-GB files take few writes.
+constexpr const size_t kFileWriteBufferSize = 4 * 1024 * 1024;
+// Alignment of the file write buffer, the page size of common platforms.
+constexpr const size_t kFileWriteBufferAlignment = 4096;
 // Used as a parameter type in a function that accepts the output of ZSTD_compress.
 using ZstdCompressReturnType = decltype(ZSTD_compress(
     nullptr, 0,
@@ -57,6 +80,120 @@ void write_output_buffer(
   const std::vector<uint8_t> & output_buffer,
   const std::string & uri);
 
+/**
+ * Maps a whole file into memory for reading.
+ * The system is advised that the file is read sequentially, so that it reads ahead aggressively
+ * instead of faulting pages in one by one. Empty files are not mapped, data() is nullptr for them.
+ */
+class MappedInputFile
+{
+public:
+  /**
+   * \param uri is the path of the file.
+   * \throws std::runtime_error if the file can't be opened or mapped.
+   */
+  explicit MappedInputFile(const std::string & uri);
+  ~MappedInputFile();
+
+  MappedInputFile(const MappedInputFile &) = delete;
+  MappedInputFile & operator=(const MappedInputFile &) = delete;
+
+  const char * data() const {return data_;}
+  uint64_t size() const {return size_;}
+
+private:
+  const char * data_ = nullptr;
+  uint64_t size_ = 0;
+#ifdef _WIN32
+  void * file_ = nullptr;
+  void * mapping_ = nullptr;
+#else
+  int file_ = -1;
+#endif
+};
+
+/**
+ * Writes a file through a page aligned buffer of kFileWriteBufferSize bytes, which is handed to
+ * the system in a single unbuffered write whenever it is full.
+ * Data can be produced into the free space of the buffer directly, to save copying it.
+ */
+class BufferedOutputFile
+{
+public:
+  /**
+   * \param uri is the path of the file, which is truncated if it exists.
+   * \throws std::runtime_error if the file can't be opened.
+   */
+  explicit BufferedOutputFile(const std::string & uri);
+  /// Closes the file if close() wasn't called, without reporting errors.
+  ~BufferedOutputFile();
+
+  BufferedOutputFile(const BufferedOutputFile &) = delete;
+  BufferedOutputFile & operator=(const BufferedOutputFile &) = delete;
+
+  /// Start of the free space of the buffer, never empty.
+  char * free_space() {return buffer_.get() + buffer_used_;}
+  size_t free_size() const {return kFileWriteBufferSize - buffer_used_;}
+
+  /**
+   * Adds size bytes produced into free_space() to the file.
+   * \throws std::runtime_error if writing the full buffer fails.
+   */
+  void commit(size_t size);
+
+  /**
+   * Adds data to the file.
+   * \throws std::runtime_error if writing the full buffer fails.
+   */
+  void write(const char * data, size_t size);
+
+  /**
+   * Writes what is left in the buffer and closes the file.
+   * \throws std::runtime_error if writing or closing fails.
+   */
+  void close();
+
+private:
+  struct AlignedFree
+  {
+    void operator()(char * buffer) const;
+  };
+
+  void write_buffer();
+
+  std::string uri_;
+  FILE * file_ = nullptr;
+  std::unique_ptr<char, AlignedFree> buffer_;
+  size_t buffer_used_ = 0;
+};
+
+/// Entry of the seek table of a seekable file.
+struct ZstdSeekableFrame
+{
+  uint32_t compressed_size;
+  uint32_t decompressed_size;
+};
+
+/**
+ * Writes the seek table of a seekable file, following its frames.
+ * \param output is the compressed file.
+ * \param frames are the frames of the file, in order.
+ * \return the size of the seek table in bytes.
+ */
+uint64_t write_seek_table(
+  BufferedOutputFile & output, const std::vector<ZstdSeekableFrame> & frames);
+
+/**
+ * Reads the seek table at the end of a seekable file.
+ * \param input is the compressed file.
+ * \param file_size is the size of the compressed file.
+ * \param[out] frames are the frames of the file, in order.
+ * \return false if the file is not a seekable file.
+ * \throws std::runtime_error if the seek table is corrupt.
+ */
+bool read_seek_table(
+  std::istream & input, uint64_t file_size, std::vector<ZstdSeekableFrame> & frames);
+
 /**
  * Checks compression_result and throws a runtime_error if there was a ZSTD error.
  * \param compression_result is the return value of ZSTD_compress or ZSTD_decompress.
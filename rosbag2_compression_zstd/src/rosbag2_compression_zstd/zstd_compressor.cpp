@@ -12,10 +12,13 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <zdict.h>
+
 #include <algorithm>
 #include <chrono>
 #include <cstdio>
 #include <memory>
+#include <stdexcept>
 #include <string>
 #include <vector>
 
@@ -28,6 +31,7 @@
 namespace rosbag2_compression_zstd
 {
 ZstdCompressor::ZstdCompressor()
+: compression_level_(kDefaultZstdCompressionLevel)
 {
   // From the zstd manual: https://facebook.github.io/zstd/zstd_manual.html#Chapter4
   // When compressing many times,
@@ -43,6 +47,9 @@ ZstdCompressor::ZstdCompressor()
 
 ZstdCompressor::~ZstdCompressor()
 {
+  for (const auto & dictionary : dictionaries_) {
+    ZSTD_freeCDict(dictionary.second.digested);
+  }
   ZSTD_freeCCtx(zstd_context_);
 }
 
@@ -51,83 +58,209 @@ std::string ZstdCompressor::compress_uri(const std::string & uri)
   const auto start = std::chrono::high_resolution_clock::now();
   const auto compressed_uri = uri + "." + get_compression_identifier();
 
-  std::ifstream input(uri, std::ios::in | std::ios::binary);
-  if (!input.is_open()) {
+  // The file is compressed straight from its mapping into the buffer of the output file, which
+  // saves copying it through stream buffers in small reads and writes.
+  MappedInputFile input(uri);
+  BufferedOutputFile output(compressed_uri);
+  const auto file_size = input.size();
+  // Seekable files are compressed as frames of seekable_frame_size_, others as a single frame.
+  const auto frame_size = seekable_frame_size_ > 0 ? seekable_frame_size_ : file_size;
+  if (seekable_frame_size_ > 0 &&
+    (file_size + frame_size - 1) / frame_size > kMaxZstdSeekableFrames)
+  {
     std::stringstream errmsg;
-    errmsg << "Failed to open file: \"" << uri <<
-      "\" for binary reading! errno(" << errno << ")";
-
+    errmsg << "File \"" << uri << "\" needs more ZSTD seekable frames than the format allows.";
     throw std::runtime_error{errmsg.str()};
   }
-  std::ofstream output(compressed_uri, std::ios::out | std::ios::binary);
-  if (!output.is_open()) {
-    std::stringstream errmsg;
-    errmsg << "Failed to open file: \"" << uri <<
-      "\" for binary writing! errno(" << errno << ")";
 
-    throw std::runtime_error{errmsg.str()};
-  }
-  // Based on the example from https://github.com/facebook/zstd/blob/dev/examples/streaming_compression.c
-  const size_t buff_in_size = ZSTD_CStreamInSize();
-  const size_t buff_out_size = ZSTD_CStreamOutSize();
-  std::vector<char> in_buffer(buff_in_size);
-  std::vector<char> out_buffer(buff_out_size);
-  size_t total_size = 0;
-  size_t final_result = 0;
+  std::vector<ZstdSeekableFrame> frames;
+  uint64_t total_size = 0;
+  uint64_t remaining_size = file_size;
   do {
-    input.read(in_buffer.data(), buff_in_size);
-    const auto size = size_t(input.gcount());
-    if (size > 0) {
-      const ZSTD_EndDirective mode = input.eof() ? ZSTD_e_end : ZSTD_e_continue;
-      ZSTD_inBuffer z_in_buffer = {in_buffer.data(), static_cast<size_t>(size), 0};
-      int finished;
-      do {
-        ZSTD_outBuffer z_out_buffer = {out_buffer.data(), out_buffer.size(), 0};
-        const auto remaining =
-          ZSTD_compressStream2(zstd_context_, &z_out_buffer, &z_in_buffer, mode);
-        throw_on_zstd_error(remaining);
-        output.write(out_buffer.data(), z_out_buffer.pos);
-        total_size += z_out_buffer.pos;
-        finished = input.eof() ? (remaining == 0) : (z_in_buffer.pos == z_in_buffer.size);
-        final_result = remaining;
-      } while (!finished);
+    const auto size = std::min(frame_size, remaining_size);
+    const auto compressed_size =
+      compress_frame(input.data() + (file_size - remaining_size), size, output);
+    if (seekable_frame_size_ > 0) {
+      // Both fit, frames are limited to kMaxZstdSeekableFrameSize.
+      frames.push_back({static_cast<uint32_t>(compressed_size), static_cast<uint32_t>(size)});
     }
-  } while (!input.eof());
-  output.flush();
+    total_size += compressed_size;
+    remaining_size -= size;
+  } while (remaining_size > 0);
+  if (seekable_frame_size_ > 0) {
+    total_size += write_seek_table(output, frames);
+  }
+
   output.close();
-  input.close();
 
   const auto end = std::chrono::high_resolution_clock::now();
-  print_compression_statistics(start, end, total_size, final_result);
+  print_compression_statistics(start, end, file_size, total_size);
   return compressed_uri;
 }
 
+uint64_t ZstdCompressor::compress_frame(
+  const char * input, uint64_t size, BufferedOutputFile & output)
+{
+  // Based on the example from https://github.com/facebook/zstd/blob/dev/examples/streaming_compression.c
+  // A frame interrupted by an error must not be continued.
+  throw_on_zstd_error(ZSTD_CCtx_reset(zstd_context_, ZSTD_reset_session_only));
+  // Records the size in the frame header, and ends the frame after exactly size bytes.
+  throw_on_zstd_error(ZSTD_CCtx_setPledgedSrcSize(zstd_context_, size));
+  // The whole frame is mapped, so it is handed over at once and ended right away.
+  ZSTD_inBuffer z_in_buffer = {input, static_cast<size_t>(size), 0};
+  uint64_t compressed_size = 0;
+  size_t remaining = 0;
+  do {
+    ZSTD_outBuffer z_out_buffer = {output.free_space(), output.free_size(), 0};
+    remaining = ZSTD_compressStream2(zstd_context_, &z_out_buffer, &z_in_buffer, ZSTD_e_end);
+    throw_on_zstd_error(remaining);
+    output.commit(z_out_buffer.pos);
+    compressed_size += z_out_buffer.pos;
+  } while (remaining != 0);
+  return compressed_size;
+}
+
 void ZstdCompressor::compress_serialized_bag_message(
   const rosbag2_storage::SerializedBagMessage * bag_message,
   rosbag2_storage::SerializedBagMessage * compressed_message)
 {
   const auto start = std::chrono::high_resolution_clock::now();
-  // Allocate based on compression bound and compress
+  // Compress into the scratch buffer, sized for the compression bound, so that the message
+  // only holds on to as much memory as the compressed data needs.
   const auto maximum_compressed_length =
     ZSTD_compressBound(bag_message->serialized_data->buffer_length);
-  compressed_message->serialized_data =
-    rosbag2_storage::make_empty_serialized_message(maximum_compressed_length);
+  if (compression_buffer_.size() < maximum_compressed_length) {
+    compression_buffer_.resize(maximum_compressed_length);
+  }
 
   // Perform compression and check.
   // compression_result is either the actual compressed size or an error code.
-  const auto compression_result = ZSTD_compressCCtx(
+  // Messages of topics with a dictionary record the dictionary ID in their frame header.
+  const auto dictionary = dictionaries_.find(bag_message->topic_name);
+  if (dictionary != dictionaries_.end() && dictionary->second.digested == nullptr) {
+    dictionary->second.digested = ZSTD_createCDict(
+      dictionary->second.data.data(), dictionary->second.data.size(), compression_level_);
+    if (dictionary->second.digested == nullptr) {
+      throw std::runtime_error{
+              "Failed to load ZSTD dictionary for topic " + bag_message->topic_name};
+    }
+  }
+  const auto compression_result = dictionary == dictionaries_.end() ?
+    ZSTD_compressCCtx(
     zstd_context_,
-    compressed_message->serialized_data->buffer, maximum_compressed_length,
+    compression_buffer_.data(), maximum_compressed_length,
     bag_message->serialized_data->buffer, bag_message->serialized_data->buffer_length,
-    kDefaultZstdCompressionLevel);
+    compression_level_) :
+    ZSTD_compress_usingCDict(
+    zstd_context_,
+    compression_buffer_.data(), maximum_compressed_length,
+    bag_message->serialized_data->buffer, bag_message->serialized_data->buffer_length,
+    dictionary->second.digested);
   throw_on_zstd_error(compression_result);
 
+  compressed_message->serialized_data = message_pool_.acquire(compression_result);
+  std::copy(
+    compression_buffer_.begin(), compression_buffer_.begin() + compression_result,
+    compressed_message->serialized_data->buffer);
   compressed_message->serialized_data->buffer_length = compression_result;
 
   const auto end = std::chrono::high_resolution_clock::now();
   print_compression_statistics(start, end, maximum_compressed_length, compression_result);
 }
 
+std::vector<uint8_t> ZstdCompressor::train_dictionary(
+  const std::vector<std::shared_ptr<const rosbag2_storage::SerializedBagMessage>> & samples)
+{
+  // ZDICT expects all samples concatenated in one buffer, plus the size of every sample.
+  std::vector<uint8_t> samples_buffer;
+  std::vector<size_t> sample_sizes;
+  sample_sizes.reserve(samples.size());
+  for (const auto & sample : samples) {
+    const auto & data = *sample->serialized_data;
+    samples_buffer.insert(samples_buffer.end(), data.buffer, data.buffer + data.buffer_length);
+    sample_sizes.push_back(data.buffer_length);
+  }
+
+  std::vector<uint8_t> dictionary(
+    std::min(kMaxZstdDictionarySize, samples_buffer.size() / kZstdDictionarySampleRatio));
+  if (dictionary.empty()) {
+    return {};
+  }
+  const auto dictionary_size = ZDICT_trainFromBuffer(
+    dictionary.data(), dictionary.size(),
+    samples_buffer.data(), sample_sizes.data(), static_cast<unsigned>(sample_sizes.size()));
+  if (ZDICT_isError(dictionary_size)) {
+    // Typically too few or too small samples; the topic is compressed without a dictionary.
+    ROSBAG2_COMPRESSION_ZSTD_LOG_DEBUG_STREAM(
+      "ZSTD dictionary training failed: " << ZDICT_getErrorName(dictionary_size));
+    return {};
+  }
+  dictionary.resize(dictionary_size);
+  return dictionary;
+}
+
+void ZstdCompressor::set_dictionary(
+  const std::string & topic_name, const std::vector<uint8_t> & dictionary)
+{
+  auto compression_dictionary = ZSTD_createCDict(
+    dictionary.data(), dictionary.size(), compression_level_);
+  if (compression_dictionary == nullptr) {
+    throw std::runtime_error{"Failed to load ZSTD dictionary for topic " + topic_name};
+  }
+  auto & entry = dictionaries_[topic_name];
+  ZSTD_freeCDict(entry.digested);
+  entry.data = dictionary;
+  entry.digested = compression_dictionary;
+}
+
+void ZstdCompressor::set_compression_level(int32_t level)
+{
+  if (level < ZSTD_minCLevel() || level > ZSTD_maxCLevel()) {
+    std::stringstream errmsg;
+    errmsg << "ZSTD compression level " << level << " is not between " << ZSTD_minCLevel() <<
+      " and " << ZSTD_maxCLevel() << ".";
+    throw std::invalid_argument{errmsg.str()};
+  }
+  // Used by the streaming API of compress_uri.
+  throw_on_zstd_error(ZSTD_CCtx_setParameter(zstd_context_, ZSTD_c_compressionLevel, level));
+  if (level == compression_level_) {
+    return;
+  }
+  compression_level_ = level;
+  // A digested dictionary carries its level, digest again on next use.
+  for (auto & dictionary : dictionaries_) {
+    ZSTD_freeCDict(dictionary.second.digested);
+    dictionary.second.digested = nullptr;
+  }
+}
+
+void ZstdCompressor::set_seekable_frame_size(uint64_t frame_size)
+{
+  if (frame_size > kMaxZstdSeekableFrameSize) {
+    std::stringstream errmsg;
+    errmsg << "ZSTD seekable frame size " << frame_size << " is larger than " <<
+      kMaxZstdSeekableFrameSize << " bytes.";
+    throw std::invalid_argument{errmsg.str()};
+  }
+  seekable_frame_size_ = frame_size;
+}
+
+void ZstdCompressor::set_compression_workers(uint64_t workers)
+{
+  // Used by the streaming API of compress_uri, which hands blocks of the file to the workers.
+  // The one-shot API of messages ignores it.
+  const auto bounds = ZSTD_cParam_getBounds(ZSTD_c_nbWorkers);
+  throw_on_zstd_error(bounds.error);
+  if (workers > 0 && bounds.upperBound == 0) {
+    ROSBAG2_COMPRESSION_ZSTD_LOG_WARN(
+      "ZSTD was built without multithreading support, compressing files on one thread.");
+    return;
+  }
+  const auto nb_workers = std::min(workers, static_cast<uint64_t>(bounds.upperBound));
+  throw_on_zstd_error(
+    ZSTD_CCtx_setParameter(zstd_context_, ZSTD_c_nbWorkers, static_cast<int>(nb_workers)));
+}
+
 std::string ZstdCompressor::get_compression_identifier() const
 {
   return kCompressionIdentifier;
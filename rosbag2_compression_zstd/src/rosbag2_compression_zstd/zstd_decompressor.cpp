@@ -15,6 +15,7 @@
 #include <algorithm>
 #include <chrono>
 #include <cstdio>
+#include <memory>
 #include <sstream>
 #include <string>
 #include <vector>
@@ -23,6 +24,7 @@
 
 #include "compression_utils.hpp"
 #include "rosbag2_compression_zstd/zstd_decompressor.hpp"
+#include "zstd_seekable_range_reader.hpp"
 
 namespace rosbag2_compression_zstd
 {
@@ -39,6 +41,9 @@ ZstdDecompressor::ZstdDecompressor()
 
 ZstdDecompressor::~ZstdDecompressor()
 {
+  for (const auto & dictionary : dictionaries_) {
+    ZSTD_freeDDict(dictionary.second);
+  }
   ZSTD_freeDCtx(zstd_context_);
 }
 
@@ -48,6 +53,85 @@ std::string ZstdDecompressor::decompress_uri(const std::string & uri)
   const auto uri_path = rcpputils::fs::path{uri};
   const auto decompressed_uri = rcpputils::fs::remove_extension(uri_path).string();
 
+  // The file is decompressed straight from its mapping into the buffer of the output file, which
+  // saves copying it through stream buffers in small reads and writes.
+  MappedInputFile input(uri);
+  BufferedOutputFile output(decompressed_uri);
+  // A previous stream may have been abandoned half way.
+  ZSTD_DCtx_reset(zstd_context_, ZSTD_reset_session_only);
+
+  // Base on the example from https://github.com/facebook/zstd/blob/dev/examples/streaming_decompression.c
+  uint64_t total_size = 0;
+  ZSTD_inBuffer z_in_buffer = {input.data(), static_cast<size_t>(input.size()), 0};
+  bool output_full = false;
+  // Data may be left to flush once all input is consumed, while the output gets filled up.
+  while (z_in_buffer.pos < z_in_buffer.size || output_full) {
+    ZSTD_outBuffer z_out_buffer = {output.free_space(), output.free_size(), 0};
+    throw_on_zstd_error(ZSTD_decompressStream(zstd_context_, &z_out_buffer, &z_in_buffer));
+    output.commit(z_out_buffer.pos);
+    total_size += z_out_buffer.pos;
+    output_full = z_out_buffer.pos == z_out_buffer.size;
+  }
+  output.close();
+
+  const auto end = std::chrono::high_resolution_clock::now();
+  print_compression_statistics(start, end, total_size, input.size());
+
+  return decompressed_uri;
+}
+
+bool ZstdDecompressor::decompress_uri_to_buffer(
+  const std::string & uri, uint64_t max_size, std::vector<uint8_t> & buffer)
+{
+  const auto start = std::chrono::high_resolution_clock::now();
+  buffer.clear();
+
+  MappedInputFile input(uri);
+  // A previous stream may have been abandoned half way.
+  ZSTD_DCtx_reset(zstd_context_, ZSTD_reset_session_only);
+
+  // Files written in one go carry their decompressed size, which saves reallocations and
+  // rejects files over budget right away.
+  const auto content_size = ZSTD_getFrameContentSize(input.data(), input.size());
+  if (content_size != ZSTD_CONTENTSIZE_ERROR && content_size != ZSTD_CONTENTSIZE_UNKNOWN) {
+    if (content_size > max_size) {
+      return false;
+    }
+    buffer.reserve(content_size);
+  }
+
+  const size_t buff_out_size = ZSTD_DStreamOutSize();
+  ZSTD_inBuffer z_in_buffer = {input.data(), static_cast<size_t>(input.size()), 0};
+  bool output_full = false;
+  while (z_in_buffer.pos < z_in_buffer.size || output_full) {
+    const auto offset = buffer.size();
+    if (offset > max_size) {
+      buffer.clear();
+      buffer.shrink_to_fit();
+      ZSTD_DCtx_reset(zstd_context_, ZSTD_reset_session_only);
+      return false;
+    }
+    buffer.resize(offset + buff_out_size);
+    ZSTD_outBuffer z_out_buffer = {buffer.data() + offset, buff_out_size, 0};
+    throw_on_zstd_error(ZSTD_decompressStream(zstd_context_, &z_out_buffer, &z_in_buffer));
+    buffer.resize(offset + z_out_buffer.pos);
+    output_full = z_out_buffer.pos == buff_out_size;
+  }
+
+  if (buffer.size() > max_size) {
+    buffer.clear();
+    buffer.shrink_to_fit();
+    return false;
+  }
+
+  const auto end = std::chrono::high_resolution_clock::now();
+  print_compression_statistics(start, end, buffer.size(), input.size());
+  return true;
+}
+
+std::shared_ptr<rosbag2_storage::RangeReaderInterface> ZstdDecompressor::open_uri_for_range_reads(
+  const std::string & uri)
+{
   std::ifstream input(uri, std::ios::in | std::ios::binary);
   if (!input.is_open()) {
     std::stringstream errmsg;
@@ -56,44 +140,22 @@ std::string ZstdDecompressor::decompress_uri(const std::string & uri)
 
     throw std::runtime_error{errmsg.str()};
   }
-  std::ofstream output(decompressed_uri, std::ios::out | std::ios::binary);
-  if (!output.is_open()) {
-    std::stringstream errmsg;
-    errmsg << "Failed to open file: \"" << uri <<
-      "\" for binary writing! errno(" << errno << ")";
-
-    throw std::runtime_error{errmsg.str()};
+  std::vector<ZstdSeekableFrame> frames;
+  if (!read_seek_table(input, rcpputils::fs::file_size(rcpputils::fs::path{uri}), frames)) {
+    return nullptr;
   }
-  // Base on the example from https://github.com/facebook/zstd/blob/dev/examples/streaming_decompression.c
-  const size_t buff_in_size = ZSTD_DStreamInSize();
-  const size_t buff_out_size = ZSTD_DStreamOutSize();
-  size_t total_size = 0;
-  std::vector<char> in_buffer(buff_in_size);
-  std::vector<char> out_buffer(buff_out_size);
-  size_t final_result = 0;
-  do {
-    input.read(in_buffer.data(), buff_in_size);
-    const auto size = size_t(input.gcount());
-    if (size > 0) {
-      ZSTD_inBuffer z_in_buffer = {in_buffer.data(), static_cast<size_t>(size), 0};
-      while (z_in_buffer.pos < z_in_buffer.size) {
-        ZSTD_outBuffer z_out_buffer = {out_buffer.data(), out_buffer.size(), 0};
-        const auto ret = ZSTD_decompressStream(zstd_context_, &z_out_buffer, &z_in_buffer);
-        throw_on_zstd_error(ret);
-        output.write(out_buffer.data(), z_out_buffer.pos);
-        total_size += z_out_buffer.pos;
-        final_result = ret;
-      }
-    }
-  } while (!input.eof());
-  output.flush();
-  output.close();
-  input.close();
-
-  const auto end = std::chrono::high_resolution_clock::now();
-  print_compression_statistics(start, end, final_result, total_size);
+  return std::make_shared<ZstdSeekableRangeReader>(std::move(input), frames);
+}
 
-  return decompressed_uri;
+bool ZstdDecompressor::is_compressed_message(
+  const rosbag2_storage::SerializedBagMessage & message) const
+{
+  if (!message.serialized_data) {
+    return false;
+  }
+  return ZSTD_getFrameContentSize(
+    message.serialized_data->buffer, message.serialized_data->buffer_length) !=
+         ZSTD_CONTENTSIZE_ERROR;
 }
 
 void ZstdDecompressor::decompress_serialized_bag_message(
@@ -107,31 +169,56 @@ void ZstdDecompressor::decompress_serialized_bag_message(
 
   throw_on_invalid_frame_content(decompressed_buffer_length);
 
-  // Initializes decompressed_buffer with size = decompressed_buffer_length.
-  // Uniform initialization cannot be used here since it will choose
-  // the initializer list constructor instead.
-  std::vector<uint8_t> decompressed_buffer(decompressed_buffer_length);
+  // Decompress into an array of this context, which replaces the compressed one in the message.
+  auto decompressed_data = message_pool_.acquire(decompressed_buffer_length);
+
+  // Frames compressed with a dictionary carry its ID, frames without one have ID 0.
+  const auto dictionary_id =
+    ZSTD_getDictID_fromFrame(message->serialized_data->buffer, compressed_buffer_length);
+  ZSTD_DDict * dictionary = nullptr;
+  if (dictionary_id != 0) {
+    const auto dictionary_it = dictionaries_.find(dictionary_id);
+    if (dictionary_it == dictionaries_.end()) {
+      std::stringstream errmsg;
+      errmsg << "Message on topic " << message->topic_name <<
+        " was compressed with unknown ZSTD dictionary " << dictionary_id;
+      throw std::runtime_error{errmsg.str()};
+    }
+    dictionary = dictionary_it->second;
+  }
 
-  const auto decompression_result = ZSTD_decompressDCtx(
+  const auto decompression_result = dictionary == nullptr ?
+    ZSTD_decompressDCtx(
     zstd_context_,
-    decompressed_buffer.data(), decompressed_buffer_length,
-    message->serialized_data->buffer, compressed_buffer_length);
+    decompressed_data->buffer, decompressed_buffer_length,
+    message->serialized_data->buffer, compressed_buffer_length) :
+    ZSTD_decompress_usingDDict(
+    zstd_context_,
+    decompressed_data->buffer, decompressed_buffer_length,
+    message->serialized_data->buffer, compressed_buffer_length,
+    dictionary);
 
   throw_on_zstd_error(decompression_result);
 
-  const auto resize_result =
-    rcutils_uint8_array_resize(message->serialized_data.get(), decompression_result);
-  throw_on_rcutils_resize_error(resize_result);
-
-  message->serialized_data->buffer_length = decompression_result;
-  std::copy(
-    decompressed_buffer.begin(), decompressed_buffer.end(),
-    message->serialized_data->buffer);
+  decompressed_data->buffer_length = decompression_result;
+  message->serialized_data = std::move(decompressed_data);
 
   const auto end = std::chrono::high_resolution_clock::now();
   print_compression_statistics(start, end, decompression_result, compressed_buffer_length);
 }
 
+void ZstdDecompressor::add_dictionary(
+  const std::string & topic_name, const std::vector<uint8_t> & dictionary)
+{
+  auto decompression_dictionary = ZSTD_createDDict(dictionary.data(), dictionary.size());
+  if (decompression_dictionary == nullptr) {
+    throw std::runtime_error{"Failed to load ZSTD dictionary for topic " + topic_name};
+  }
+  auto & entry = dictionaries_[ZSTD_getDictID_fromDDict(decompression_dictionary)];
+  ZSTD_freeDDict(entry);
+  entry = decompression_dictionary;
+}
+
 std::string ZstdDecompressor::get_decompression_identifier() const
 {
   return kDecompressionIdentifier;
@@ -0,0 +1,125 @@
+// Copyright 2022, Open Source Robotics Corporation.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "zstd_seekable_range_reader.hpp"
+
+#include <algorithm>
+#include <sstream>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace rosbag2_compression_zstd
+{
+namespace
+{
+// Number of decompressed frames kept by a range reader.
+constexpr const size_t kZstdSeekableCachedFrames = 4;
+}  // namespace
+
+ZstdSeekableRangeReader::ZstdSeekableRangeReader(
+  std::ifstream input, const std::vector<ZstdSeekableFrame> & frames)
+: input_(std::move(input)),
+  zstd_context_(ZSTD_createDCtx())
+{
+  uint64_t compressed_offset = 0;
+  frames_.reserve(frames.size());
+  for (const auto & frame : frames) {
+    frames_.push_back({compressed_offset, size_, frame});
+    compressed_offset += frame.compressed_size;
+    size_ += frame.decompressed_size;
+  }
+}
+
+ZstdSeekableRangeReader::~ZstdSeekableRangeReader()
+{
+  ZSTD_freeDCtx(zstd_context_);
+}
+
+uint64_t ZstdSeekableRangeReader::size() const
+{
+  return size_;
+}
+
+void ZstdSeekableRangeReader::read(uint64_t offset, uint64_t length, uint8_t * buffer)
+{
+  if (offset > size_ || length > size_ - offset) {
+    std::stringstream errmsg;
+    errmsg << "Range of " << length << " bytes at " << offset << " is beyond the " << size_ <<
+      " bytes of the decompressed file.";
+    throw std::out_of_range{errmsg.str()};
+  }
+  if (length == 0) {
+    return;
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  // The last frame starting at or before offset.
+  auto index = static_cast<size_t>(
+    std::upper_bound(
+      frames_.begin(), frames_.end(), offset,
+      [](uint64_t value, const Frame & frame) {return value < frame.decompressed_offset;}) -
+    frames_.begin() - 1);
+  while (length > 0) {
+    const auto & content = decompress_frame(index);
+    const auto frame_offset = offset - frames_[index].decompressed_offset;
+    const auto size = std::min<uint64_t>(length, content.size() - frame_offset);
+    std::copy(content.begin() + frame_offset, content.begin() + frame_offset + size, buffer);
+    buffer += size;
+    offset += size;
+    length -= size;
+    index++;
+  }
+}
+
+const std::vector<uint8_t> & ZstdSeekableRangeReader::decompress_frame(size_t index)
+{
+  const auto cached = std::find_if(
+    cached_frames_.begin(), cached_frames_.end(),
+    [index](const std::pair<size_t, std::vector<uint8_t>> & entry) {return entry.first == index;});
+  if (cached != cached_frames_.end()) {
+    cached_frames_.splice(cached_frames_.begin(), cached_frames_, cached);
+    return cached_frames_.front().second;
+  }
+
+  const auto & frame = frames_[index];
+  compressed_buffer_.resize(frame.sizes.compressed_size);
+  input_.seekg(static_cast<std::streamoff>(frame.compressed_offset));
+  input_.read(
+    reinterpret_cast<char *>(compressed_buffer_.data()),
+    static_cast<std::streamsize>(compressed_buffer_.size()));
+  if (!input_) {
+    input_.clear();
+    throw std::runtime_error{"Failed to read ZSTD frame of seekable file."};
+  }
+
+  // The least recently used frame makes room, and lends its memory, for the new one.
+  std::vector<uint8_t> content;
+  if (cached_frames_.size() >= kZstdSeekableCachedFrames) {
+    content = std::move(cached_frames_.back().second);
+    cached_frames_.pop_back();
+  }
+  content.resize(frame.sizes.decompressed_size);
+  const auto decompressed_size = ZSTD_decompressDCtx(
+    zstd_context_, content.data(), content.size(),
+    compressed_buffer_.data(), compressed_buffer_.size());
+  throw_on_zstd_error(decompressed_size);
+  if (decompressed_size != content.size()) {
+    throw std::runtime_error{"ZSTD frame does not match the seek table of the file."};
+  }
+  cached_frames_.emplace_front(index, std::move(content));
+  return cached_frames_.front().second;
+}
+
+}  // namespace rosbag2_compression_zstd
@@ -0,0 +1,78 @@
+// Copyright 2022, Open Source Robotics Corporation.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ROSBAG2_COMPRESSION_ZSTD__ZSTD_SEEKABLE_RANGE_READER_HPP_
+#define ROSBAG2_COMPRESSION_ZSTD__ZSTD_SEEKABLE_RANGE_READER_HPP_
+
+#include <zstd.h>
+
+#include <cstdint>
+#include <fstream>
+#include <list>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include "rosbag2_storage/range_reader_interface.hpp"
+
+#include "compression_utils.hpp"
+
+namespace rosbag2_compression_zstd
+{
+
+/**
+ * Reads ranges of the decompressed content of a seekable file, decompressing only the frames
+ * which overlap the ranges. The last few decompressed frames are kept, since storages tend to read
+ * neighbouring ranges one after the other.
+ */
+class ZstdSeekableRangeReader : public rosbag2_storage::RangeReaderInterface
+{
+public:
+  /**
+   * \param input is the open seekable file.
+   * \param frames is its seek table, see read_seek_table.
+   */
+  ZstdSeekableRangeReader(std::ifstream input, const std::vector<ZstdSeekableFrame> & frames);
+
+  ~ZstdSeekableRangeReader() override;
+
+  uint64_t size() const override;
+
+  void read(uint64_t offset, uint64_t length, uint8_t * buffer) override;
+
+private:
+  struct Frame
+  {
+    uint64_t compressed_offset;
+    uint64_t decompressed_offset;
+    ZstdSeekableFrame sizes;
+  };
+
+  // Returns the decompressed content of a frame, from the cache if possible.
+  const std::vector<uint8_t> & decompress_frame(size_t index);
+
+  std::vector<Frame> frames_;
+  uint64_t size_ = 0;
+
+  std::mutex mutex_;
+  std::ifstream input_;
+  ZSTD_DCtx * zstd_context_;
+  std::vector<uint8_t> compressed_buffer_;
+  // Decompressed frames by their index, the most recently used first.
+  std::list<std::pair<size_t, std::vector<uint8_t>>> cached_frames_;
+};
+
+}  // namespace rosbag2_compression_zstd
+
+#endif  // ROSBAG2_COMPRESSION_ZSTD__ZSTD_SEEKABLE_RANGE_READER_HPP_
@@ -16,7 +16,10 @@
 #include <cstdio>
 #include <fstream>
 #include <memory>
+#include <random>
+#include <sstream>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "rclcpp/rclcpp.hpp"
@@ -247,6 +250,44 @@ TEST_F(CompressionHelperFixture, zstd_decompress_file_contents)
   EXPECT_EQ(initial_data, decompressed_data);
 }
 
+TEST_F(CompressionHelperFixture, zstd_decompress_file_to_buffer)
+{
+  const auto uri = (rcpputils::fs::path(temporary_dir_path_) / "file3.txt").string();
+  create_garbage_file(uri);
+  const auto initial_data = read_file(uri);
+
+  auto compressor = rosbag2_compression_zstd::ZstdCompressor{};
+  const auto compressed_uri = compressor.compress_uri(uri);
+  ASSERT_EQ(0, std::remove(uri.c_str()));
+
+  auto decompressor = rosbag2_compression_zstd::ZstdDecompressor{};
+  std::vector<uint8_t> buffer;
+  ASSERT_TRUE(decompressor.decompress_uri_to_buffer(compressed_uri, initial_data.size(), buffer));
+
+  EXPECT_TRUE(std::equal(initial_data.begin(), initial_data.end(), buffer.begin(), buffer.end()));
+  EXPECT_FALSE(rcpputils::fs::exists(uri)) << "Expected no decompressed file on disk.";
+}
+
+TEST_F(CompressionHelperFixture, zstd_decompress_file_to_buffer_fails_over_max_size)
+{
+  const auto uri = (rcpputils::fs::path(temporary_dir_path_) / "file4.txt").string();
+  create_garbage_file(uri);
+  const auto initial_data = read_file(uri);
+
+  auto compressor = rosbag2_compression_zstd::ZstdCompressor{};
+  const auto compressed_uri = compressor.compress_uri(uri);
+
+  auto decompressor = rosbag2_compression_zstd::ZstdDecompressor{};
+  std::vector<uint8_t> buffer;
+  EXPECT_FALSE(
+    decompressor.decompress_uri_to_buffer(compressed_uri, initial_data.size() - 1, buffer));
+  EXPECT_TRUE(buffer.empty());
+
+  // The decompressor is still usable after giving up.
+  EXPECT_TRUE(decompressor.decompress_uri_to_buffer(compressed_uri, initial_data.size(), buffer));
+  EXPECT_EQ(initial_data.size(), buffer.size());
+}
+
 TEST_F(CompressionHelperFixture, zstd_decompress_fails_on_bad_file)
 {
   const auto uri = (rcpputils::fs::path(temporary_dir_path_) / "file3.txt").string();
@@ -299,3 +340,375 @@ TEST_F(CompressionHelperFixture, zstd_decompress_serialized_bag_message)
   std::string new_msg = deserialize_message(msg->serialized_data);
   EXPECT_EQ(new_msg, message_);
 }
+
+TEST_F(CompressionHelperFixture, zstd_recognizes_compressed_messages)
+{
+  rosbag2_compression_zstd::ZstdCompressor compressor;
+  rosbag2_compression_zstd::ZstdDecompressor decompressor;
+  for (const std::string content : {std::string{}, std::string{"x"}, message_}) {
+    rosbag2_storage::SerializedBagMessage msg;
+    msg.serialized_data = rosbag2_storage::make_serialized_message(content.data(), content.size());
+    EXPECT_FALSE(decompressor.is_compressed_message(msg));
+    rosbag2_storage::SerializedBagMessage compressed_msg;
+    compressor.compress_serialized_bag_message(&msg, &compressed_msg);
+    EXPECT_TRUE(decompressor.is_compressed_message(compressed_msg));
+  }
+}
+
+TEST_F(CompressionHelperFixture, zstd_reuses_released_compressed_arrays)
+{
+  const auto msg = rosbag2_storage::make_serialized_message(message_.data(), message_.length());
+  rosbag2_storage::SerializedBagMessage bag_message;
+  bag_message.serialized_data = msg;
+  rosbag2_compression_zstd::ZstdCompressor compressor;
+
+  rosbag2_storage::SerializedBagMessage compressed_msg;
+  compressor.compress_serialized_bag_message(&bag_message, &compressed_msg);
+  const auto * first_array = compressed_msg.serialized_data.get();
+  // Still held by the caller, so the next message must be compressed into another array.
+  rosbag2_storage::SerializedBagMessage other_compressed_msg;
+  compressor.compress_serialized_bag_message(&bag_message, &other_compressed_msg);
+  EXPECT_NE(other_compressed_msg.serialized_data.get(), first_array);
+
+  compressed_msg.serialized_data.reset();
+  compressor.compress_serialized_bag_message(&bag_message, &compressed_msg);
+  EXPECT_EQ(compressed_msg.serialized_data.get(), first_array);
+  EXPECT_EQ(compressed_length_, compressed_msg.serialized_data->buffer_length);
+
+  rosbag2_compression_zstd::ZstdDecompressor decompressor;
+  decompressor.decompress_serialized_bag_message(&compressed_msg);
+  EXPECT_EQ(deserialize_message(compressed_msg.serialized_data), message_);
+}
+
+TEST_F(CompressionHelperFixture, zstd_reuses_released_decompressed_arrays)
+{
+  const auto msg = rosbag2_storage::make_serialized_message(message_.data(), message_.length());
+  rosbag2_storage::SerializedBagMessage bag_message;
+  bag_message.serialized_data = msg;
+  rosbag2_compression_zstd::ZstdCompressor compressor;
+  rosbag2_compression_zstd::ZstdDecompressor decompressor;
+
+  const rcutils_uint8_array_t * first_array = nullptr;
+  for (int i = 0; i < 3; i++) {
+    rosbag2_storage::SerializedBagMessage compressed_msg;
+    compressor.compress_serialized_bag_message(&bag_message, &compressed_msg);
+    decompressor.decompress_serialized_bag_message(&compressed_msg);
+    EXPECT_EQ(deserialize_message(compressed_msg.serialized_data), message_);
+    if (first_array == nullptr) {
+      first_array = compressed_msg.serialized_data.get();
+    }
+    EXPECT_EQ(compressed_msg.serialized_data.get(), first_array);
+  }
+}
+
+namespace
+{
+// Small messages sharing most of their layout, like odometry or diagnostics messages
+std::shared_ptr<rosbag2_storage::SerializedBagMessage> make_repetitive_message(int sequence)
+{
+  std::stringstream content;
+  content << "frame_id: odom child_frame_id: base_link seq: " << sequence <<
+    " position: {x: " << sequence * 0.25 << ", y: " << sequence % 17 << ", z: 0.0}" <<
+    " orientation: {x: 0.0, y: 0.0, z: " << (sequence % 5) * 0.1 << ", w: 1.0}";
+  const auto data = content.str();
+  auto message = std::make_shared<rosbag2_storage::SerializedBagMessage>();
+  message->topic_name = "/odom";
+  message->serialized_data = rosbag2_storage::make_serialized_message(data.data(), data.size());
+  return message;
+}
+}  // namespace
+
+TEST_F(CompressionHelperFixture, zstd_dictionary_shrinks_small_messages)
+{
+  std::vector<std::shared_ptr<const rosbag2_storage::SerializedBagMessage>> samples;
+  for (int i = 0; i < 1000; i++) {
+    samples.push_back(make_repetitive_message(i));
+  }
+  rosbag2_compression_zstd::ZstdCompressor compressor;
+  const auto dictionary = compressor.train_dictionary(samples);
+  ASSERT_FALSE(dictionary.empty());
+
+  auto message = make_repetitive_message(4242);
+  auto compressed_without_dictionary = std::make_unique<rosbag2_storage::SerializedBagMessage>();
+  compressor.compress_serialized_bag_message(message.get(), compressed_without_dictionary.get());
+
+  compressor.set_dictionary("/odom", dictionary);
+  auto compressed = std::make_unique<rosbag2_storage::SerializedBagMessage>();
+  compressed->topic_name = message->topic_name;
+  compressor.compress_serialized_bag_message(message.get(), compressed.get());
+  EXPECT_LT(
+    compressed->serialized_data->buffer_length * 2,
+    compressed_without_dictionary->serialized_data->buffer_length);
+
+  rosbag2_compression_zstd::ZstdDecompressor decompressor;
+  decompressor.add_dictionary("/odom", dictionary);
+  decompressor.decompress_serialized_bag_message(compressed.get());
+  EXPECT_EQ(
+    deserialize_message(compressed->serialized_data),
+    deserialize_message(message->serialized_data));
+
+  // Messages compressed before the dictionary existed stay readable
+  decompressor.decompress_serialized_bag_message(compressed_without_dictionary.get());
+  EXPECT_EQ(
+    deserialize_message(compressed_without_dictionary->serialized_data),
+    deserialize_message(message->serialized_data));
+}
+
+TEST_F(CompressionHelperFixture, zstd_decompress_fails_on_unknown_dictionary)
+{
+  std::vector<std::shared_ptr<const rosbag2_storage::SerializedBagMessage>> samples;
+  for (int i = 0; i < 1000; i++) {
+    samples.push_back(make_repetitive_message(i));
+  }
+  rosbag2_compression_zstd::ZstdCompressor compressor;
+  compressor.set_dictionary("/odom", compressor.train_dictionary(samples));
+
+  auto message = make_repetitive_message(0);
+  auto compressed = std::make_unique<rosbag2_storage::SerializedBagMessage>();
+  compressed->topic_name = message->topic_name;
+  compressor.compress_serialized_bag_message(message.get(), compressed.get());
+
+  rosbag2_compression_zstd::ZstdDecompressor decompressor;
+  EXPECT_THROW(
+    decompressor.decompress_serialized_bag_message(compressed.get()), std::runtime_error);
+}
+
+TEST_F(CompressionHelperFixture, zstd_no_dictionary_from_too_few_samples)
+{
+  rosbag2_compression_zstd::ZstdCompressor compressor;
+  EXPECT_TRUE(compressor.train_dictionary({make_repetitive_message(0)}).empty());
+}
+
+TEST_F(CompressionHelperFixture, zstd_higher_compression_level_shrinks_messages)
+{
+  std::string data;
+  for (int i = 0; i < 200; i++) {
+    const auto sample = make_repetitive_message(i);
+    data.append(
+      reinterpret_cast<const char *>(sample->serialized_data->buffer),
+      sample->serialized_data->buffer_length);
+  }
+  auto message = std::make_shared<rosbag2_storage::SerializedBagMessage>();
+  message->serialized_data = rosbag2_storage::make_serialized_message(data.data(), data.size());
+
+  rosbag2_compression_zstd::ZstdCompressor compressor;
+  compressor.set_compression_level(-5);
+  auto fast_compressed = std::make_unique<rosbag2_storage::SerializedBagMessage>();
+  compressor.compress_serialized_bag_message(message.get(), fast_compressed.get());
+  compressor.set_compression_level(19);
+  auto strong_compressed = std::make_unique<rosbag2_storage::SerializedBagMessage>();
+  compressor.compress_serialized_bag_message(message.get(), strong_compressed.get());
+  EXPECT_LT(
+    strong_compressed->serialized_data->buffer_length,
+    fast_compressed->serialized_data->buffer_length);
+
+  rosbag2_compression_zstd::ZstdDecompressor decompressor;
+  decompressor.decompress_serialized_bag_message(fast_compressed.get());
+  decompressor.decompress_serialized_bag_message(strong_compressed.get());
+  EXPECT_EQ(deserialize_message(fast_compressed->serialized_data), data);
+  EXPECT_EQ(deserialize_message(strong_compressed->serialized_data), data);
+}
+
+TEST_F(CompressionHelperFixture, zstd_dictionary_is_kept_across_compression_levels)
+{
+  std::vector<std::shared_ptr<const rosbag2_storage::SerializedBagMessage>> samples;
+  for (int i = 0; i < 1000; i++) {
+    samples.push_back(make_repetitive_message(i));
+  }
+  rosbag2_compression_zstd::ZstdCompressor compressor;
+  const auto dictionary = compressor.train_dictionary(samples);
+  ASSERT_FALSE(dictionary.empty());
+  compressor.set_dictionary("/odom", dictionary);
+  compressor.set_compression_level(12);
+
+  auto message = make_repetitive_message(4242);
+  auto compressed = std::make_unique<rosbag2_storage::SerializedBagMessage>();
+  compressed->topic_name = message->topic_name;
+  compressor.compress_serialized_bag_message(message.get(), compressed.get());
+
+  rosbag2_compression_zstd::ZstdDecompressor decompressor;
+  decompressor.add_dictionary("/odom", dictionary);
+  decompressor.decompress_serialized_bag_message(compressed.get());
+  EXPECT_EQ(
+    deserialize_message(compressed->serialized_data),
+    deserialize_message(message->serialized_data));
+}
+
+TEST_F(CompressionHelperFixture, zstd_rejects_invalid_compression_level)
+{
+  rosbag2_compression_zstd::ZstdCompressor compressor;
+  EXPECT_THROW(compressor.set_compression_level(ZSTD_maxCLevel() + 1), std::invalid_argument);
+  EXPECT_THROW(compressor.set_compression_level(ZSTD_minCLevel() - 1), std::invalid_argument);
+  EXPECT_NO_THROW(compressor.set_compression_level(ZSTD_maxCLevel()));
+}
+
+TEST_F(CompressionHelperFixture, zstd_compress_file_uri_with_workers)
+{
+  // Lines with a changing counter, so that the file does not collapse into a few blocks.
+  std::stringstream content;
+  for (int i = 0; i < 200000; i++) {
+    content << "[" << i << "] " << kGarbageStatement << " " << (i * 7919) % 10007 << "\n";
+  }
+  const auto original = content.str();
+
+  rosbag2_compression_zstd::ZstdCompressor compressor;
+  rosbag2_compression_zstd::ZstdDecompressor decompressor;
+  // Switching back to the calling thread alone works as well.
+  for (const uint64_t workers : {4u, 0u}) {
+    const auto uri = (rcpputils::fs::path(temporary_dir_path_) / "workers.txt").string();
+    {
+      std::ofstream out{uri, std::ios::binary};
+      out << original;
+    }
+    compressor.set_compression_workers(workers);
+    const auto compressed_uri = compressor.compress_uri(uri);
+    ASSERT_TRUE(rcpputils::fs::remove(rcpputils::fs::path{uri}));
+
+    EXPECT_EQ(decompressor.decompress_uri(compressed_uri), uri);
+    const auto decompressed = read_file(uri);
+    EXPECT_EQ(std::string(decompressed.begin(), decompressed.end()), original);
+    ASSERT_TRUE(rcpputils::fs::remove(rcpputils::fs::path{compressed_uri}));
+  }
+}
+
+TEST_F(CompressionHelperFixture, zstd_compress_file_uri_of_input_buffer_size)
+{
+  // The frame must be ended although no read runs short of the buffer size.
+  const std::string original(2 * ZSTD_CStreamInSize(), 'x');
+  const auto uri = (rcpputils::fs::path(temporary_dir_path_) / "buffer_size.txt").string();
+  {
+    std::ofstream out{uri, std::ios::binary};
+    out << original;
+  }
+
+  rosbag2_compression_zstd::ZstdCompressor compressor;
+  const auto compressed_uri = compressor.compress_uri(uri);
+  rosbag2_compression_zstd::ZstdDecompressor decompressor;
+  std::vector<uint8_t> buffer;
+  ASSERT_TRUE(decompressor.decompress_uri_to_buffer(compressed_uri, original.size(), buffer));
+  EXPECT_EQ(std::string(buffer.begin(), buffer.end()), original);
+}
+
+TEST_F(CompressionHelperFixture, zstd_compress_file_uri_of_incompressible_data)
+{
+  // Random data does not compress, so the compressed file spans several write buffers as well.
+  std::mt19937 generator(42);
+  std::string original(9 * 1024 * 1024 + 123, '\0');
+  for (auto & character : original) {
+    character = static_cast<char>(generator());
+  }
+  const auto uri = (rcpputils::fs::path(temporary_dir_path_) / "random.bin").string();
+  {
+    std::ofstream out{uri, std::ios::binary};
+    out << original;
+  }
+
+  rosbag2_compression_zstd::ZstdCompressor compressor;
+  const auto compressed_uri = compressor.compress_uri(uri);
+  ASSERT_TRUE(rcpputils::fs::remove(rcpputils::fs::path{uri}));
+  EXPECT_GT(rcpputils::fs::file_size(rcpputils::fs::path{compressed_uri}), original.size());
+
+  rosbag2_compression_zstd::ZstdDecompressor decompressor;
+  EXPECT_EQ(decompressor.decompress_uri(compressed_uri), uri);
+  const auto decompressed = read_file(uri);
+  EXPECT_TRUE(std::string(decompressed.begin(), decompressed.end()) == original);
+}
+
+TEST_F(CompressionHelperFixture, zstd_compress_empty_file_uri)
+{
+  const auto uri = (rcpputils::fs::path(temporary_dir_path_) / "empty.txt").string();
+  std::ofstream{uri, std::ios::binary}.close();
+
+  rosbag2_compression_zstd::ZstdCompressor compressor;
+  const auto compressed_uri = compressor.compress_uri(uri);
+  ASSERT_TRUE(rcpputils::fs::remove(rcpputils::fs::path{uri}));
+
+  rosbag2_compression_zstd::ZstdDecompressor decompressor;
+  EXPECT_EQ(decompressor.decompress_uri(compressed_uri), uri);
+  EXPECT_EQ(rcpputils::fs::file_size(rcpputils::fs::path{uri}), 0u);
+  std::vector<uint8_t> buffer;
+  ASSERT_TRUE(decompressor.decompress_uri_to_buffer(compressed_uri, 1024, buffer));
+  EXPECT_TRUE(buffer.empty());
+}
+
+class SeekableCompressionFixture : public CompressionHelperFixture
+{
+protected:
+  void SetUp() override
+  {
+    CompressionHelperFixture::SetUp();
+    // Lines with a changing counter, so that the frames differ from each other.
+    std::stringstream content;
+    for (int i = 0; i < 50000; i++) {
+      content << "[" << i << "] " << kGarbageStatement << "\n";
+    }
+    original_ = content.str();
+    uri_ = (rcpputils::fs::path(temporary_dir_path_) / "seekable.txt").string();
+    std::ofstream out{uri_, std::ios::binary};
+    out << original_;
+  }
+
+  std::string original_;
+  std::string uri_;
+};
+
+TEST_F(SeekableCompressionFixture, zstd_seekable_file_is_a_regular_zstd_file)
+{
+  rosbag2_compression_zstd::ZstdCompressor compressor;
+  compressor.set_seekable_frame_size(64 * 1024);
+  const auto compressed_uri = compressor.compress_uri(uri_);
+  ASSERT_TRUE(rcpputils::fs::remove(rcpputils::fs::path{uri_}));
+
+  rosbag2_compression_zstd::ZstdDecompressor decompressor;
+  std::vector<uint8_t> buffer;
+  ASSERT_TRUE(decompressor.decompress_uri_to_buffer(compressed_uri, original_.size(), buffer));
+  EXPECT_EQ(std::string(buffer.begin(), buffer.end()), original_);
+
+  EXPECT_EQ(decompressor.decompress_uri(compressed_uri), uri_);
+  const auto decompressed = read_file(uri_);
+  EXPECT_EQ(std::string(decompressed.begin(), decompressed.end()), original_);
+}
+
+TEST_F(SeekableCompressionFixture, zstd_range_reads_of_seekable_file)
+{
+  rosbag2_compression_zstd::ZstdCompressor compressor;
+  compressor.set_seekable_frame_size(64 * 1024);
+  const auto compressed_uri = compressor.compress_uri(uri_);
+
+  rosbag2_compression_zstd::ZstdDecompressor decompressor;
+  const auto range_reader = decompressor.open_uri_for_range_reads(compressed_uri);
+  ASSERT_NE(range_reader, nullptr);
+  ASSERT_EQ(range_reader->size(), original_.size());
+
+  // Within a frame, across frames, again from a decompressed frame, and up to the end.
+  const std::vector<std::pair<uint64_t, uint64_t>> ranges = {
+    {100, 1000}, {64 * 1024 - 10, 200 * 1024}, {50, 20}, {original_.size() - 300, 300},
+    {original_.size(), 0}};
+  for (const auto & range : ranges) {
+    std::vector<uint8_t> buffer(range.second);
+    range_reader->read(range.first, range.second, buffer.data());
+    EXPECT_EQ(
+      std::string(buffer.begin(), buffer.end()), original_.substr(range.first, range.second));
+  }
+
+  std::vector<uint8_t> buffer(2);
+  EXPECT_THROW(
+    range_reader->read(original_.size() - 1, 2, buffer.data()), std::out_of_range);
+}
+
+TEST_F(SeekableCompressionFixture, zstd_range_reads_need_a_seekable_file)
+{
+  rosbag2_compression_zstd::ZstdCompressor compressor;
+  const auto compressed_uri = compressor.compress_uri(uri_);
+
+  rosbag2_compression_zstd::ZstdDecompressor decompressor;
+  EXPECT_EQ(decompressor.open_uri_for_range_reads(compressed_uri), nullptr);
+}
+
+TEST_F(SeekableCompressionFixture, zstd_rejects_too_large_seekable_frame_size)
+{
+  rosbag2_compression_zstd::ZstdCompressor compressor;
+  EXPECT_THROW(
+    compressor.set_seekable_frame_size(2ull * 1024 * 1024 * 1024), std::invalid_argument);
+  EXPECT_NO_THROW(compressor.set_seekable_frame_size(1024 * 1024 * 1024));
+}
@@ -16,6 +16,7 @@
 #define ROSBAG2_CPP__CACHE__CIRCULAR_MESSAGE_CACHE_HPP_
 
 #include <atomic>
+#include <chrono>
 #include <condition_variable>
 #include <memory>
 #include <mutex>
@@ -24,6 +25,7 @@
 #include "rcpputils/thread_safety_annotations.hpp"
 
 #include "rosbag2_cpp/cache/message_cache_circular_buffer.hpp"
+#include "rosbag2_cpp/cache/message_cache_time_window_buffer.hpp"
 #include "rosbag2_cpp/cache/message_cache_interface.hpp"
 #include "rosbag2_cpp/cache/cache_buffer_interface.hpp"
 #include "rosbag2_cpp/visibility_control.hpp"
@@ -54,6 +56,11 @@ class ROSBAG2_CPP_PUBLIC CircularMessageCache
 public:
   explicit CircularMessageCache(size_t max_buffer_size);
 
+  /// Retain a time window of messages per topic instead of a single circular buffer.
+  /// max_buffer_size still bounds the total size of the retained messages.
+  /// \sa MessageCacheTimeWindowBuffer
+  CircularMessageCache(size_t max_buffer_size, std::chrono::nanoseconds per_topic_window);
+
   ~CircularMessageCache() override;
 
   /// Puts msg into circular buffer, replacing the oldest msg when buffer is full
@@ -83,13 +90,14 @@ public:
   /// Notify that flushing is complete
   void done_flushing() override;
 
-  /// Snapshot API: notify cache consumer to wake-up for dumping buffer
+  /// Snapshot API: notify cache consumer to wake-up for dumping buffer.
+  /// Triggers arriving before the consumer picked up the previous one are coalesced into it.
   void notify_data_ready() override;
 
 private:
-  std::shared_ptr<MessageCacheCircularBuffer> producer_buffer_;
+  std::shared_ptr<CacheBufferInterface> producer_buffer_;
   std::mutex producer_buffer_mutex_;
-  std::shared_ptr<MessageCacheCircularBuffer> consumer_buffer_;
+  std::shared_ptr<CacheBufferInterface> consumer_buffer_;
   std::mutex consumer_buffer_mutex_;
 
   bool data_ready_ {false};
@@ -16,6 +16,7 @@
 #define ROSBAG2_CPP__CACHE__MESSAGE_CACHE_HPP_
 
 #include <atomic>
+#include <chrono>
 #include <condition_variable>
 #include <unordered_map>
 #include <memory>
@@ -27,6 +28,7 @@
 
 #include "rosbag2_cpp/cache/message_cache_buffer.hpp"
 #include "rosbag2_cpp/cache/message_cache_interface.hpp"
+#include "rosbag2_cpp/cache/message_cache_spill_file.hpp"
 #include "rosbag2_cpp/cache/cache_buffer_interface.hpp"
 #include "rosbag2_cpp/visibility_control.hpp"
 
@@ -66,6 +68,13 @@ namespace cache
 * The cache holds infomation about dropped messages (per topic). These are
 * messages that were pushed to the cache when it was full. Such situation signals
 * performance issues, most likely with the CacheConsumer consumer callback.
+*
+* Optionally, a MessageCacheSpillFile absorbs messages which do not fit into the
+* producer buffer. While it holds messages, all new messages are appended to it,
+* and the consumer drains it in batches of max_buffer_size, so that messages are
+* consumed in the order they were pushed. Appending to the spill file happens outside
+* of the producer buffer lock, so concurrent producers don't wait on the disk for each
+* other. Messages are only dropped once the spill file is full as well.
 */
 class ROSBAG2_CPP_PUBLIC MessageCache
   : public MessageCacheInterface
@@ -73,6 +82,10 @@ class ROSBAG2_CPP_PUBLIC MessageCache
 public:
   explicit MessageCache(size_t max_buffer_size);
 
+  /// Use a spill file of at most max_spill_size bytes at spill_file_path for overflow
+  MessageCache(
+    size_t max_buffer_size, size_t max_spill_size, const std::string & spill_file_path);
+
   ~MessageCache() override;
 
   /// Puts msg into primary buffer. With full cache, msg is ignored and counted as lost
@@ -80,6 +93,7 @@ public:
 
   /// Gets a consumer buffer.
   /// In this greedy implementation, swap buffers before providing the buffer.
+  /// While draining the spill file, this is the buffer holding the drained batch.
   std::shared_ptr<CacheBufferInterface>
   get_consumer_buffer() override RCPPUTILS_TSA_ACQUIRE(consumer_buffer_mutex_);
 
@@ -96,9 +110,16 @@ public:
   * until it can be awaken, which is to happen when:
   * a) data was inserted into the producer buffer, consuming can continue after a swap
   * b) we are flushing the data (in case we missed the last notification when consuming)
+  * c) the spill file holds messages which still need to be drained
+  *
+  * If the spill file holds messages, the producer buffer and the next batch of the spill file
+  * are handed to the consumer instead. When flushing, the spill file is drained completely.
   **/
   void swap_buffers() override;
 
+  /// Push times of the messages of the buffer returned by get_consumer_buffer
+  const std::vector<std::chrono::steady_clock::time_point> & get_consumer_push_times() override;
+
   /// Set the cache to consume-only mode for final buffer flush before closing
   void begin_flushing() override;
 
@@ -111,8 +132,12 @@ public:
   /// Producer API: notify consumer to wake-up (primary buffer has data)
   void notify_data_ready() override;
 
+  /// Spill file metrics. All zero if no spill file is used.
+  SpillStatistics get_spill_statistics() const override;
+
 protected:
-  /// Dropped messages per topic. Used for printing in alphabetic order
+  /// Dropped messages per topic, guarded by producer_buffer_mutex_. Used for printing in
+  /// alphabetic order
   std::unordered_map<std::string, uint32_t> messages_dropped_per_topic_;
 
 private:
@@ -122,6 +147,13 @@ private:
   std::shared_ptr<MessageCacheBuffer> consumer_buffer_;
   std::mutex consumer_buffer_mutex_;
 
+  /// Overflow tier, may be null
+  std::unique_ptr<MessageCacheSpillFile> spill_file_;
+  /// Holds batches drained from the spill file, only used by the consumer
+  std::shared_ptr<MessageCacheBuffer> spill_drain_buffer_;
+  bool draining_spill_ {false};
+  const size_t max_buffer_size_;
+
   /// Double buffers sync (following cpp core guidelines for condition variables)
   bool data_ready_ {false};
   std::condition_variable cache_condition_var_;
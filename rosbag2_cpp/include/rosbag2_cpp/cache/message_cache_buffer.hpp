@@ -16,6 +16,7 @@
 #define ROSBAG2_CPP__CACHE__MESSAGE_CACHE_BUFFER_HPP_
 
 #include <atomic>
+#include <chrono>
 #include <memory>
 #include <vector>
 
@@ -58,6 +59,11 @@ public:
   */
   bool push(CacheBufferInterface::buffer_element_t msg) override;
 
+  /// Same as push(msg), keeping the time at which msg was originally pushed into the cache
+  bool push(
+    CacheBufferInterface::buffer_element_t msg,
+    std::chrono::steady_clock::time_point push_time);
+
   /// Clear buffer
   void clear() override;
 
@@ -67,8 +73,12 @@ public:
   /// Get buffer data
   const std::vector<CacheBufferInterface::buffer_element_t> & data() override;
 
+  /// Get the time at which each message of data() was pushed
+  const std::vector<std::chrono::steady_clock::time_point> & push_times() const;
+
 private:
   std::vector<CacheBufferInterface::buffer_element_t> buffer_;
+  std::vector<std::chrono::steady_clock::time_point> push_times_;
   size_t buffer_bytes_size_ {0u};
   const size_t max_bytes_size_;
 
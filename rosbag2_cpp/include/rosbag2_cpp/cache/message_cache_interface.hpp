@@ -15,10 +15,13 @@
 #ifndef ROSBAG2_CPP__CACHE__MESSAGE_CACHE_INTERFACE_HPP_
 #define ROSBAG2_CPP__CACHE__MESSAGE_CACHE_INTERFACE_HPP_
 
+#include <chrono>
 #include <memory>
+#include <vector>
 
 #include "rosbag2_cpp/visibility_control.hpp"
 #include "rosbag2_cpp/cache/cache_buffer_interface.hpp"
+#include "rosbag2_cpp/cache/message_cache_spill_file.hpp"
 #include "rosbag2_storage/serialized_bag_message.hpp"
 
 namespace rosbag2_cpp
@@ -61,6 +64,15 @@ public:
   /// has not been called yet to signal end of consuming.
   virtual void swap_buffers() = 0;
 
+  /// Steady clock time at which each message of the consumer buffer was pushed, in the order of
+  /// its data(). Only valid while the consumer buffer is held. Empty if the cache doesn't keep
+  /// track of push times.
+  virtual const std::vector<std::chrono::steady_clock::time_point> & get_consumer_push_times()
+  {
+    static const std::vector<std::chrono::steady_clock::time_point> no_push_times;
+    return no_push_times;
+  }
+
   /// Go into a read-only state to drain the final consumer buffer without letting in new data.
   virtual void begin_flushing() {}
 
@@ -72,6 +84,9 @@ public:
 
   /// \brief Producer API: notify wait_for_data() to wake up and unblock consumer thread.
   virtual void notify_data_ready() {}
+
+  /// Metrics of the spill file taking overflowing messages, all zero if the cache has none.
+  virtual SpillStatistics get_spill_statistics() const {return SpillStatistics{};}
 };
 
 }  // namespace cache
@@ -0,0 +1,121 @@
+// Copyright 2022, Open Source Robotics Corporation.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ROSBAG2_CPP__CACHE__MESSAGE_CACHE_SPILL_FILE_HPP_
+#define ROSBAG2_CPP__CACHE__MESSAGE_CACHE_SPILL_FILE_HPP_
+
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "rcpputils/thread_safety_annotations.hpp"
+
+#include "rosbag2_cpp/cache/cache_buffer_interface.hpp"
+#include "rosbag2_cpp/visibility_control.hpp"
+
+#include "rosbag2_storage/serialized_bag_message.hpp"
+
+// This is necessary because of using stl types here. It is completely safe, because
+// a) the member is not accessible from the outside
+// b) there are no inline functions.
+#ifdef _WIN32
+# pragma warning(push)
+# pragma warning(disable:4251)
+#endif
+
+namespace rosbag2_cpp
+{
+namespace cache
+{
+
+/// Metrics of a MessageCacheSpillFile. All sizes are in bytes as stored in the spill file.
+struct SpillStatistics
+{
+  /// Total amount of data written to the spill file
+  uint64_t bytes_spilled {0u};
+  /// Amount of data currently held in the spill file
+  uint64_t bytes_pending {0u};
+  /// Total amount of data read back from the spill file
+  uint64_t bytes_drained {0u};
+  /// Bytes per second drained by the most recent drain() call, measured since the previous one
+  double drain_rate {0.0};
+};
+
+/**
+* This class implements an append-only file which absorbs messages that do not fit into the
+* memory cache, and hands them back in the order they were pushed.
+*
+* Any number of producer threads may push while one consumer thread drains; pushes are
+* serialized. The file only grows until it has been drained completely, at which point it is
+* truncated. A push which would grow the file beyond max_bytes_size is rejected.
+*
+* The file is removed on destruction.
+*/
+class ROSBAG2_CPP_PUBLIC MessageCacheSpillFile
+{
+public:
+  // Delete default constructor since path and max_bytes_size are required
+  MessageCacheSpillFile() = delete;
+  MessageCacheSpillFile(const std::string & path, size_t max_bytes_size);
+
+  ~MessageCacheSpillFile();
+
+  /// Append msg to the file. Returns false if the file would exceed its maximum size.
+  /// The push time is stored with msg, and is handed back when draining it.
+  bool push(
+    const CacheBufferInterface::buffer_element_t & msg,
+    std::chrono::steady_clock::time_point push_time = std::chrono::steady_clock::now());
+
+  /// Read back the oldest messages, stopping after at least max_bytes bytes have been read.
+  /// If push_times is given, the push time of every drained message is appended to it.
+  std::vector<CacheBufferInterface::buffer_element_t> drain(
+    size_t max_bytes,
+    std::vector<std::chrono::steady_clock::time_point> * push_times = nullptr);
+
+  /// Amount of data pushed but not yet drained
+  size_t bytes_pending() const;
+
+  SpillStatistics get_statistics() const;
+
+private:
+  const std::string path_;
+  const size_t max_bytes_size_;
+
+  std::mutex write_mutex_;
+  std::ofstream write_stream_ RCPPUTILS_TSA_GUARDED_BY(write_mutex_);
+  size_t write_offset_ RCPPUTILS_TSA_GUARDED_BY(write_mutex_) {0u};
+  size_t read_offset_ RCPPUTILS_TSA_GUARDED_BY(write_mutex_) {0u};
+  std::chrono::steady_clock::time_point last_drain_time_ RCPPUTILS_TSA_GUARDED_BY(write_mutex_);
+
+  /// Only used by the draining thread
+  std::ifstream read_stream_;
+
+  std::atomic<size_t> bytes_pending_ {0u};
+  std::atomic<uint64_t> bytes_spilled_ {0u};
+  std::atomic<uint64_t> bytes_drained_ {0u};
+  std::atomic<double> drain_rate_ {0.0};
+};
+
+}  // namespace cache
+}  // namespace rosbag2_cpp
+
+#ifdef _WIN32
+# pragma warning(pop)
+#endif
+
+#endif  // ROSBAG2_CPP__CACHE__MESSAGE_CACHE_SPILL_FILE_HPP_
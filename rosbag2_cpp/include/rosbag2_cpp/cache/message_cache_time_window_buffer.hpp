@@ -0,0 +1,110 @@
+// Copyright 2022, Open Source Robotics Corporation.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ROSBAG2_CPP__CACHE__MESSAGE_CACHE_TIME_WINDOW_BUFFER_HPP_
+#define ROSBAG2_CPP__CACHE__MESSAGE_CACHE_TIME_WINDOW_BUFFER_HPP_
+
+#include <chrono>
+#include <deque>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "rcutils/types.h"
+
+#include "rosbag2_cpp/visibility_control.hpp"
+#include "rosbag2_cpp/cache/cache_buffer_interface.hpp"
+#include "rosbag2_storage/serialized_bag_message.hpp"
+
+// This is necessary because of using stl types here. It is completely safe, because
+// a) the member is not accessible from the outside
+// b) there are no inline functions.
+#ifdef _WIN32
+# pragma warning(push)
+# pragma warning(disable:4251)
+#endif
+
+namespace rosbag2_cpp
+{
+namespace cache
+{
+
+/**
+* This class implements a snapshot buffer which retains a time window of messages per topic.
+* Every topic is kept in its own ring, from which messages older than the configured window
+* (relative to the most recent message received on any topic) are dropped.
+*
+* The total byte size of all rings is bounded by max_cache_size. When it is exceeded, the oldest
+* message of the topic currently holding the most bytes is dropped. This way a burst on a single
+* high-bandwidth topic does not evict the history of low-rate topics.
+*
+* data() merges the per-topic rings into a single vector ordered by timestamp.
+*/
+class ROSBAG2_CPP_PUBLIC MessageCacheTimeWindowBuffer
+  : public CacheBufferInterface
+{
+public:
+  // Delete default constructor since max_cache_size and window are required
+  MessageCacheTimeWindowBuffer() = delete;
+  MessageCacheTimeWindowBuffer(size_t max_cache_size, std::chrono::nanoseconds window);
+
+  /**
+  * Append the message to the ring of its topic and drop messages which fell out of the time
+  * window. If the buffer exceeds its byte size afterwards, messages are dropped from the topic
+  * using the most memory until it fits again.
+  */
+  bool push(CacheBufferInterface::buffer_element_t msg) override;
+
+  /// Clear buffer
+  void clear() override;
+
+  /// Get number of elements in the buffer
+  size_t size() override;
+
+  /// Get buffer data, merged across topics in timestamp order
+  const std::vector<CacheBufferInterface::buffer_element_t> & data() override;
+
+private:
+  struct TopicRing
+  {
+    std::deque<CacheBufferInterface::buffer_element_t> messages;
+    size_t bytes_size {0u};
+  };
+
+  /// Drop messages older than the time window from the front of the ring
+  void drop_expired(TopicRing & ring);
+
+  /// Drop the oldest message of the topic holding the most bytes
+  void drop_oldest_of_largest_topic();
+
+  void pop_front(TopicRing & ring);
+
+  std::unordered_map<std::string, TopicRing> topic_rings_;
+  std::vector<CacheBufferInterface::buffer_element_t> msg_vector_;
+  size_t buffer_bytes_size_ {0u};
+  size_t message_count_ {0u};
+  const size_t max_bytes_size_;
+  const rcutils_time_point_value_t window_ns_;
+  rcutils_time_point_value_t newest_time_stamp_;
+};
+
+}  // namespace cache
+}  // namespace rosbag2_cpp
+
+#ifdef _WIN32
+# pragma warning(pop)
+#endif
+
+#endif  // ROSBAG2_CPP__CACHE__MESSAGE_CACHE_TIME_WINDOW_BUFFER_HPP_
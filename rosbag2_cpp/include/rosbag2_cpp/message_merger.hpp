@@ -0,0 +1,97 @@
+// Copyright 2022, Open Source Robotics Corporation.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ROSBAG2_CPP__MESSAGE_MERGER_HPP_
+#define ROSBAG2_CPP__MESSAGE_MERGER_HPP_
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "rosbag2_cpp/visibility_control.hpp"
+
+#include "rosbag2_storage/serialized_bag_message.hpp"
+
+// This is necessary because of using stl types here. It is completely safe, because
+// a) the member is not accessible from the outside
+// b) there are no inline functions.
+#ifdef _WIN32
+# pragma warning(push)
+# pragma warning(disable:4251)
+#endif
+
+namespace rosbag2_cpp
+{
+
+/**
+ * Merges the messages of several inputs, each ordered by timestamp, into a single sequence
+ * ordered by timestamp. Messages with equal timestamps are returned in the order of their inputs.
+ *
+ * The next message of every input is kept in a min-heap, so taking a message costs O(log N) for
+ * N inputs. Only the input of the message taken last is read from before the next one is known.
+ */
+class ROSBAG2_CPP_PUBLIC MessageMerger
+{
+public:
+  using Message = std::shared_ptr<rosbag2_storage::SerializedBagMessage>;
+  /// Reads the next message of an input, or returns nullptr if the input has none left.
+  using ReadNextFunction = std::function<Message(size_t input)>;
+
+  MessageMerger(size_t num_inputs, ReadNextFunction read_next);
+
+  /// Whether any input has a message left, reading the inputs which need to be read from.
+  bool has_next();
+
+  /**
+   * Takes the oldest message of all inputs.
+   * \throws std::runtime_error if no input has a message left.
+   */
+  Message read_next();
+
+  /// Drops the messages taken out of the inputs but not returned yet, e.g. after seeking them.
+  void clear();
+
+  /**
+   * Drops the messages taken out of the inputs but not returned yet which match a predicate,
+   * e.g. after a filter was applied to the inputs. Their inputs are read from again.
+   */
+  void remove_if(
+    const std::function<bool(const rosbag2_storage::SerializedBagMessage &)> & predicate);
+
+private:
+  struct Entry
+  {
+    // Copied out of the message, to compare entries without following their pointers
+    rcutils_time_point_value_t time_stamp;
+    size_t input;
+    Message message;
+  };
+
+  // Orders the heap so that its front is the oldest message, of the lowest input on ties.
+  static bool is_later(const Entry & lhs, const Entry & rhs);
+
+  ReadNextFunction read_next_;
+  std::vector<Entry> heap_;
+  // Inputs without a message in the heap which may still have one
+  std::vector<size_t> inputs_to_read_;
+  const size_t num_inputs_;
+};
+
+}  // namespace rosbag2_cpp
+
+#ifdef _WIN32
+# pragma warning(pop)
+#endif
+
+#endif  // ROSBAG2_CPP__MESSAGE_MERGER_HPP_
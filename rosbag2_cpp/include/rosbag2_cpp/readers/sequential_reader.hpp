@@ -22,6 +22,7 @@
 
 #include "rosbag2_cpp/bag_events.hpp"
 #include "rosbag2_cpp/converter.hpp"
+#include "rosbag2_cpp/message_merger.hpp"
 #include "rosbag2_cpp/reader_interfaces/base_reader_interface.hpp"
 #include "rosbag2_cpp/serialization_format_converter_factory.hpp"
 #include "rosbag2_cpp/serialization_format_converter_factory_interface.hpp"
@@ -183,10 +184,23 @@ protected:
   std::string base_folder_;
 
 private:
+  bool is_open() const;
+
+  /**
+   * Open one reader per shard of a bag recorded with several storage shards.
+   * Messages of all shards are merged in timestamp order when reading.
+   */
+  void open_shards(const ConverterOptions & converter_options);
+
   rosbag2_storage::StorageOptions storage_options_;
   std::shared_ptr<SerializationFormatConverterFactoryInterface> converter_factory_{};
 
   bag_events::EventCallbackManager callback_manager_;
+  std::vector<bag_events::ReaderEventCallbacks> event_callbacks_;
+
+  std::vector<std::unique_ptr<SequentialReader>> shard_readers_;
+  // Merges the messages of all shard readers in timestamp order
+  std::unique_ptr<MessageMerger> shard_merger_;
 };
 
 }  // namespace readers
@@ -17,8 +17,10 @@
 
 #include <memory>
 #include <mutex>
+#include <shared_mutex>
 #include <string>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 #include "rclcpp/serialization.hpp"
@@ -28,6 +30,7 @@
 #include "rosbag2_cpp/bag_events.hpp"
 #include "rosbag2_cpp/converter_options.hpp"
 #include "rosbag2_cpp/visibility_control.hpp"
+#include "rosbag2_cpp/writer_statistics.hpp"
 #include "rosbag2_cpp/writers/sequential_writer.hpp"
 
 #include "rosbag2_storage/serialized_bag_message.hpp"
@@ -211,8 +214,27 @@ public:
    */
   void add_event_callbacks(bag_events::WriterEventCallbacks & callbacks);
 
+  /**
+   * \brief Get statistics about the messages written since the bag was opened.
+   * \note Latencies cover the messages since the last get_interval_statistics() call, if any.
+   * \return per-topic message and byte counts and write latency summaries
+   */
+  WriterStatistics get_statistics() const;
+
+  /**
+   * \brief Get statistics with latencies of the messages written since the previous call only.
+   * Message and byte counts remain totals since the bag was opened.
+   * \return per-topic message and byte counts and write latency summaries of the interval
+   */
+  WriterStatistics get_interval_statistics();
+
 private:
-  std::mutex writer_mutex_;
+  // Writes only take it shared, so they may run concurrently, e.g. from the callbacks of a
+  // multi-threaded executor. Creating and removing topics takes it exclusive. Statistics take it
+  // shared, so they never see a writer being reopened.
+  mutable std::shared_timed_mutex writer_mutex_;
+  // Topics created through this writer, to skip creating them again on every write
+  std::unordered_set<std::string> created_topics_;
   std::unique_ptr<rosbag2_cpp::writer_interfaces::BaseWriterInterface> writer_impl_;
 };
 
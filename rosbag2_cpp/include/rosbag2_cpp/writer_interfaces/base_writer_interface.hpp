@@ -20,6 +20,7 @@
 #include "rosbag2_cpp/bag_events.hpp"
 #include "rosbag2_cpp/converter_options.hpp"
 #include "rosbag2_cpp/visibility_control.hpp"
+#include "rosbag2_cpp/writer_statistics.hpp"
 
 #include "rosbag2_storage/serialized_bag_message.hpp"
 #include "rosbag2_storage/storage_options.hpp"
@@ -45,6 +46,10 @@ public:
 
   virtual void remove_topic(const rosbag2_storage::TopicMetadata & topic_with_type) = 0;
 
+  /**
+   * Write a message. rosbag2_cpp::Writer may call this concurrently from multiple threads, but
+   * never concurrently with create_topic() or remove_topic().
+   */
   virtual void write(std::shared_ptr<const rosbag2_storage::SerializedBagMessage> message) = 0;
 
   /**
@@ -54,6 +59,24 @@ public:
   virtual bool take_snapshot() = 0;
 
   virtual void add_event_callbacks(const bag_events::WriterEventCallbacks & callbacks) = 0;
+
+  /**
+   * Statistics about the messages written since the writer was opened.
+   * \returns empty statistics for writers that don't collect them
+   */
+  virtual WriterStatistics get_statistics() const
+  {
+    return WriterStatistics{};
+  }
+
+  /**
+   * Same as get_statistics(), but latencies only cover the messages written since the previous
+   * call, e.g. to publish statistics periodically. Message and byte counts remain totals.
+   */
+  virtual WriterStatistics get_interval_statistics()
+  {
+    return get_statistics();
+  }
 };
 
 }  // namespace writer_interfaces
@@ -0,0 +1,151 @@
+// Copyright 2022, Open Source Robotics Corporation.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ROSBAG2_CPP__WRITER_STATISTICS_HPP_
+#define ROSBAG2_CPP__WRITER_STATISTICS_HPP_
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+
+#include "rosbag2_cpp/visibility_control.hpp"
+
+// This is necessary because of using stl types here. It is completely safe, because
+// a) the member is not accessible from the outside
+// b) there are no inline functions.
+#ifdef _WIN32
+# pragma warning(push)
+# pragma warning(disable:4251)
+#endif
+
+namespace rosbag2_cpp
+{
+
+/// Summary of a latency distribution. All values are in nanoseconds.
+struct LatencySummary
+{
+  uint64_t count {0u};
+  uint64_t p50 {0u};
+  uint64_t p90 {0u};
+  uint64_t p99 {0u};
+  uint64_t max {0u};
+};
+
+/**
+ * Latency histogram with logarithmic buckets, in the spirit of HdrHistogram.
+ *
+ * Every power of two is split into SUB_BUCKET_COUNT linear buckets, so reported percentiles
+ * overestimate the actual value by less than 1 / SUB_BUCKET_COUNT. Recording is a relaxed atomic
+ * increment and may happen concurrently from any number of threads.
+ */
+class ROSBAG2_CPP_PUBLIC LatencyHistogram
+{
+public:
+  void record(std::chrono::nanoseconds latency);
+
+  LatencySummary summarize() const;
+
+  /// Summarize the latencies recorded since the previous reset, and start over.
+  /// Latencies recorded concurrently are accounted to either this or the next summary.
+  LatencySummary summarize_and_reset();
+
+private:
+  static constexpr unsigned SUB_BUCKET_BITS = 3;
+  static constexpr uint64_t SUB_BUCKET_COUNT = 1u << SUB_BUCKET_BITS;
+  static constexpr size_t BUCKET_COUNT = (64 - SUB_BUCKET_BITS + 1) * SUB_BUCKET_COUNT;
+
+  static size_t bucket_index(uint64_t value);
+  static uint64_t bucket_upper_bound(size_t index);
+  static LatencySummary summarize(
+    const std::array<uint64_t, BUCKET_COUNT> & buckets, uint64_t max);
+
+  std::array<std::atomic<uint64_t>, BUCKET_COUNT> buckets_ {};
+  std::atomic<uint64_t> max_ {0u};
+};
+
+/// Write statistics of a single topic
+struct TopicWriteStatistics
+{
+  /// Messages and bytes written to storage
+  uint64_t messages {0u};
+  uint64_t bytes {0u};
+  /// From the receive time stamp of a message until it was pushed into the cache
+  LatencySummary receive_to_push;
+  /// From the push of a message into the cache until the cache consumer took it for writing.
+  /// Not recorded in snapshot mode.
+  LatencySummary cache_residency;
+  /// Duration of the storage write, including the transaction commit, a message was part of
+  LatencySummary storage_write;
+  /// From the receive time stamp of a message until it was committed to storage
+  LatencySummary receive_to_commit;
+};
+
+/// Snapshot of the statistics of a writer since it was opened. Depending on how it was taken,
+/// latencies only cover the interval since the previous snapshot.
+struct WriterStatistics
+{
+  /// Time since the writer was opened
+  std::chrono::nanoseconds duration {0};
+  /// Messages and bytes written to storage over all topics
+  uint64_t messages {0u};
+  uint64_t bytes {0u};
+  /// Bytes written to the cache spill file since the writer was opened, and still held in it
+  uint64_t spill_bytes {0u};
+  uint64_t spill_bytes_pending {0u};
+  /// Bytes per second read back by the most recent drain of the cache spill file
+  double spill_drain_rate {0.0};
+  std::unordered_map<std::string, TopicWriteStatistics> topics;
+};
+
+/**
+ * Collects the statistics of a single topic while writing.
+ *
+ * Latencies relative to the receive time stamp of a message are measured against the system
+ * clock. They are only meaningful when recording with system time, and are not recorded when
+ * the message appears to be received in the future, e.g. with simulated time.
+ */
+class ROSBAG2_CPP_PUBLIC TopicWriteStatisticsCollector
+{
+public:
+  LatencyHistogram receive_to_push;
+  LatencyHistogram cache_residency;
+  LatencyHistogram storage_write;
+  LatencyHistogram receive_to_commit;
+
+  std::atomic<uint64_t> messages {0u};
+  std::atomic<uint64_t> bytes {0u};
+
+  /// Record the latency between the receive time stamp and the given system time
+  static void record_since_receive(
+    LatencyHistogram & histogram, int64_t receive_time_stamp, int64_t system_time);
+
+  /// Current system time in nanoseconds, in the same time base as receive time stamps
+  static int64_t system_now();
+
+  TopicWriteStatistics summarize() const;
+
+  /// Summarize with latencies since the previous call only, message and byte counts are totals
+  TopicWriteStatistics summarize_and_reset_latencies();
+};
+
+}  // namespace rosbag2_cpp
+
+#ifdef _WIN32
+# pragma warning(pop)
+#endif
+
+#endif  // ROSBAG2_CPP__WRITER_STATISTICS_HPP_
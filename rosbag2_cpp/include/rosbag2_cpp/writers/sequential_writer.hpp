@@ -15,9 +15,16 @@
 #ifndef ROSBAG2_CPP__WRITERS__SEQUENTIAL_WRITER_HPP_
 #define ROSBAG2_CPP__WRITERS__SEQUENTIAL_WRITER_HPP_
 
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <limits>
 #include <memory>
 #include <mutex>
+#include <shared_mutex>
 #include <string>
+#include <thread>
 #include <unordered_map>
 #include <vector>
 
@@ -29,6 +36,7 @@
 #include "rosbag2_cpp/converter.hpp"
 #include "rosbag2_cpp/serialization_format_converter_factory.hpp"
 #include "rosbag2_cpp/writer_interfaces/base_writer_interface.hpp"
+#include "rosbag2_cpp/writer_statistics.hpp"
 #include "rosbag2_cpp/visibility_control.hpp"
 
 #include "rosbag2_storage/metadata_io.hpp"
@@ -111,6 +119,10 @@ public:
 
   /**
    * Take a snapshot by triggering a circular buffer flip, writing data to disk.
+   * The snapshot is written asynchronously by the cache consumer thread, while new messages keep
+   * being recorded into the ring. Triggers arriving before a pending snapshot has been picked up
+   * are coalesced into it.
+   * If StorageOptions::snapshot_file_per_trigger is set, every snapshot goes to a new file.
    * *\returns true if snapshot is successful
    */
   bool take_snapshot() override;
@@ -121,6 +133,15 @@ public:
    */
   void add_event_callbacks(const bag_events::WriterEventCallbacks & callbacks) override;
 
+  /**
+   * Statistics since the bag was opened: per-topic message and byte counts, and latency
+   * histograms of receiving, caching, writing and committing messages.
+   * Latencies relative to the receive time stamp assume messages are recorded with system time.
+   */
+  WriterStatistics get_statistics() const override;
+
+  WriterStatistics get_interval_statistics() override;
+
 protected:
   std::string base_folder_;
   std::unique_ptr<rosbag2_storage::StorageFactoryInterface> storage_factory_;
@@ -142,8 +163,23 @@ protected:
 
   // Used to track topic -> message count. If cache is present, it is updated by CacheConsumer
   std::unordered_map<std::string, rosbag2_storage::TopicInformation> topics_names_to_info_;
-  std::mutex topics_info_mutex_;
-
+  // Write statistics per topic. Collectors themselves are atomic
+  std::unordered_map<std::string, std::shared_ptr<TopicWriteStatisticsCollector>>
+  topics_statistics_;
+  // Topic maps are only changed holding both writer_state_mutex_ exclusively and
+  // topics_info_mutex_, so holding either one is enough to look topics up.
+  mutable std::mutex topics_info_mutex_;
+
+  // Coordinates concurrent calls to write() with everything replacing the storage or changing
+  // topics. write() takes it shared when going through the cache, so concurrent writers only
+  // contend on the cache. Topic creation, removal and splits take it exclusive.
+  // The cache consumer only takes it in snapshot mode, exclusive, to split before writing a
+  // snapshot. Otherwise splits stop the consumer, so it must not wait for this lock.
+  mutable std::shared_timed_mutex writer_state_mutex_;
+  std::chrono::steady_clock::time_point open_time_;
+
+  // Only changed while holding writer_state_mutex_ exclusive, so a checkpoint taken under that
+  // lock sees a consistent copy.
   rosbag2_storage::BagMetadata metadata_;
 
   // Closes the current backed storage and opens the next bagfile.
@@ -159,6 +195,36 @@ protected:
   // Record TopicInformation into metadata
   void finalize_metadata();
 
+  // Write the metadata of the recording so far, so that the bag can be read without reindexing
+  // after an unclean shutdown. Must not run concurrently with write().
+  void checkpoint_metadata();
+
+  // Copy of the metadata to checkpoint, numbered in the order in which the copies were taken.
+  struct MetadataCheckpoint
+  {
+    rosbag2_storage::BagMetadata metadata;
+    uint64_t sequence {0u};
+  };
+
+  // Take a copy of the metadata to checkpoint. Must not run concurrently with write().
+  MetadataCheckpoint take_metadata_checkpoint();
+
+  // Write a copy of the metadata taken earlier, unless a more recent copy was written already.
+  // Takes no writer lock, so that recording goes on while the file is written.
+  void write_metadata_checkpoint(const MetadataCheckpoint & checkpoint);
+
+  // Stop the periodic checkpoints, before the metadata is written a last time on close.
+  void stop_checkpointing();
+
+  // Update bag and current file starting time and duration with a written message.
+  // Lock-free, the bounds are folded into metadata_ by sync_time_metadata().
+  void update_time_metadata(
+    const std::chrono::time_point<std::chrono::high_resolution_clock> & message_timestamp);
+
+  // Fold the time bounds and message count of the current file into metadata_.
+  // Must not run concurrently with write().
+  void sync_time_metadata();
+
   // Helper method used by write to get the message in a format that is ready to be written.
   // Common use cases include converting the message using the converter or
   // performing other operations like compression on it
@@ -170,7 +236,37 @@ private:
   /// Helper method to write messages while also updating tracked metadata.
   void write_messages(
     const std::vector<std::shared_ptr<const rosbag2_storage::SerializedBagMessage>> & messages);
-  bool is_first_message_ {true};
+  /// Split for and account a snapshot about to be written by the cache consumer.
+  void prepare_snapshot_file(
+    const std::vector<std::shared_ptr<const rosbag2_storage::SerializedBagMessage>> & messages);
+  /// Statistics with every topic summarized by the given function.
+  WriterStatistics collect_statistics(
+    const std::function<TopicWriteStatistics(TopicWriteStatisticsCollector &)> & summarize) const;
+
+  // Time bounds of the bag and of the current file in nanoseconds, and the number of messages in
+  // the current file. Updated lock-free by concurrent writes.
+  std::atomic<int64_t> bag_min_time_stamp_ {std::numeric_limits<int64_t>::max()};
+  std::atomic<int64_t> bag_max_time_stamp_ {std::numeric_limits<int64_t>::min()};
+  std::atomic<int64_t> file_min_time_stamp_ {std::numeric_limits<int64_t>::max()};
+  std::atomic<int64_t> file_max_time_stamp_ {std::numeric_limits<int64_t>::min()};
+  std::atomic<size_t> file_message_count_ {0u};
+
+  void reset_file_time_bounds();
+
+  /// Checkpoint the metadata every metadata_checkpoint_interval until the writer is closed.
+  void checkpoint_metadata_periodically();
+
+  std::thread checkpoint_thread_;
+  std::mutex checkpoint_mutex_;
+  std::condition_variable checkpoint_condition_;
+  bool stop_checkpointing_ {false};
+  // Numbers the checkpoint copies, only changed holding writer_state_mutex_ exclusively
+  uint64_t checkpoint_sequence_ {0u};
+  // Serializes writing checkpoints. Held while calling metadata_io_, so the only locks taken
+  // under it are the ones of the MetadataIo, e.g. of ShardedWriter collecting shard metadata.
+  // Never held while taking a lock of this writer.
+  std::mutex checkpoint_write_mutex_;
+  uint64_t last_written_checkpoint_ {0u};
 
   bag_events::EventCallbackManager callback_manager_;
 };
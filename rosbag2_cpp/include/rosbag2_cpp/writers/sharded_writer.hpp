@@ -0,0 +1,170 @@
+// Copyright 2022, Open Source Robotics Corporation.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ROSBAG2_CPP__WRITERS__SHARDED_WRITER_HPP_
+#define ROSBAG2_CPP__WRITERS__SHARDED_WRITER_HPP_
+
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "rosbag2_cpp/bag_events.hpp"
+#include "rosbag2_cpp/serialization_format_converter_factory.hpp"
+#include "rosbag2_cpp/visibility_control.hpp"
+#include "rosbag2_cpp/writer_interfaces/base_writer_interface.hpp"
+#include "rosbag2_cpp/writer_statistics.hpp"
+#include "rosbag2_cpp/writers/sequential_writer.hpp"
+
+#include "rosbag2_storage/bag_metadata.hpp"
+#include "rosbag2_storage/metadata_io.hpp"
+#include "rosbag2_storage/storage_factory.hpp"
+#include "rosbag2_storage/storage_factory_interface.hpp"
+#include "rosbag2_storage/storage_options.hpp"
+
+// This is necessary because of using stl types here. It is completely safe, because
+// a) the member is not accessible from the outside
+// b) there are no inline functions.
+#ifdef _WIN32
+# pragma warning(push)
+# pragma warning(disable:4251)
+#endif
+
+namespace rosbag2_cpp
+{
+namespace writers
+{
+
+/**
+ * Writer striping topics across several storages, which are written in parallel.
+ *
+ * Every shard is a SequentialWriter recording into its own subfolder of the bag, with its own
+ * cache and cache consumer thread. Each topic is recorded by a single shard. On close, the
+ * metadata of all shards is merged into the metadata of the bag, where every file is tagged
+ * with the shard it belongs to. SequentialReader merges the shards back in timestamp order.
+ *
+ * The cache size is divided between the shards, other storage options apply to every shard.
+ * With metadata checkpoints enabled, every checkpoint of a shard rewrites the merged metadata.
+ */
+class ROSBAG2_CPP_PUBLIC ShardedWriter
+  : public rosbag2_cpp::writer_interfaces::BaseWriterInterface
+{
+public:
+  using StorageFactoryCreator =
+    std::function<std::unique_ptr<rosbag2_storage::StorageFactoryInterface>()>;
+
+  explicit
+  ShardedWriter(
+    size_t shard_count,
+    StorageFactoryCreator storage_factory_creator = []() {
+      return std::make_unique<rosbag2_storage::StorageFactory>();
+    },
+    std::shared_ptr<SerializationFormatConverterFactoryInterface> converter_factory =
+    std::make_shared<SerializationFormatConverterFactory>(),
+    std::unique_ptr<rosbag2_storage::MetadataIo> metadata_io =
+    std::make_unique<rosbag2_storage::MetadataIo>());
+
+  ~ShardedWriter() override;
+
+  /**
+   * Opens a new bag folder and a shard in a subfolder of it for each of the shards.
+   *
+   * \param storage_options Options to configure the storage of every shard
+   * \param converter_options options to define in which format incoming messages are stored
+   * \throws runtime_error if the bag folder already exists
+   **/
+  void open(
+    const rosbag2_storage::StorageOptions & storage_options,
+    const ConverterOptions & converter_options) override;
+
+  void close() override;
+
+  /**
+   * Create a new topic in the shard recording the fewest topics.
+   *
+   * \param topic_with_type name and type identifier of topic to be created
+   * \throws runtime_error if the Writer is not open.
+   */
+  void create_topic(const rosbag2_storage::TopicMetadata & topic_with_type) override;
+
+  void remove_topic(const rosbag2_storage::TopicMetadata & topic_with_type) override;
+
+  /**
+   * Write a message to the shard recording its topic.
+   *
+   * \param message to be written to the bagfile
+   * \throws runtime_error if the Writer is not open or the topic has not been created.
+   */
+  void write(std::shared_ptr<const rosbag2_storage::SerializedBagMessage> message) override;
+
+  /// Take a snapshot in every shard
+  bool take_snapshot() override;
+
+  void add_event_callbacks(const bag_events::WriterEventCallbacks & callbacks) override;
+
+  WriterStatistics get_statistics() const override;
+
+  WriterStatistics get_interval_statistics() override;
+
+  /// Name of the subfolder of the bag recorded by a shard
+  static std::string shard_folder_name(size_t shard);
+
+private:
+  struct Shard
+  {
+    std::unique_ptr<SequentialWriter> writer;
+    // Last metadata written by the shard, on a checkpoint or on close
+    rosbag2_storage::BagMetadata metadata;
+    size_t topic_count {0u};
+  };
+
+  void on_shard_metadata_written(size_t shard, const rosbag2_storage::BagMetadata & metadata);
+
+  // Requires metadata_mutex_
+  rosbag2_storage::BagMetadata merge_shards_metadata() const;
+
+  static void add_shard_statistics(
+    WriterStatistics & statistics, WriterStatistics shard_statistics);
+
+  size_t shard_count_;
+  StorageFactoryCreator storage_factory_creator_;
+  std::shared_ptr<SerializationFormatConverterFactoryInterface> converter_factory_;
+  std::unique_ptr<rosbag2_storage::MetadataIo> metadata_io_;
+
+  std::string base_folder_;
+  rosbag2_storage::StorageOptions storage_options_;
+  std::vector<Shard> shards_;
+  // Topic name -> index of the shard recording it.
+  // Only changed by create_topic() and remove_topic(), which never run concurrently with write().
+  std::unordered_map<std::string, size_t> topic_shards_;
+
+  // Shards write their metadata from their own checkpoint threads, holding their checkpoint
+  // write lock while on_shard_metadata_written() takes this one. So never call into a shard
+  // while holding it.
+  std::mutex metadata_mutex_;
+  bool checkpoint_metadata_ {false};
+  // Closed shards write their metadata again when destroyed, which is ignored
+  bool collect_shards_metadata_ {false};
+};
+
+}  // namespace writers
+}  // namespace rosbag2_cpp
+
+#ifdef _WIN32
+# pragma warning(pop)
+#endif
+
+#endif  // ROSBAG2_CPP__WRITERS__SHARDED_WRITER_HPP_
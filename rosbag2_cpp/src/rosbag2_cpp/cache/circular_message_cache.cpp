@@ -13,12 +13,14 @@
 // limitations under the License.
 
 #include <algorithm>
+#include <chrono>
 #include <memory>
 #include <string>
 #include <utility>
 
 #include "rosbag2_cpp/cache/circular_message_cache.hpp"
 #include "rosbag2_cpp/cache/message_cache_circular_buffer.hpp"
+#include "rosbag2_cpp/cache/message_cache_time_window_buffer.hpp"
 #include "rosbag2_cpp/cache/cache_buffer_interface.hpp"
 #include "rosbag2_cpp/logging.hpp"
 
@@ -33,6 +35,15 @@ CircularMessageCache::CircularMessageCache(size_t max_buffer_size)
   consumer_buffer_ = std::make_shared<MessageCacheCircularBuffer>(max_buffer_size);
 }
 
+CircularMessageCache::CircularMessageCache(
+  size_t max_buffer_size, std::chrono::nanoseconds per_topic_window)
+{
+  producer_buffer_ =
+    std::make_shared<MessageCacheTimeWindowBuffer>(max_buffer_size, per_topic_window);
+  consumer_buffer_ =
+    std::make_shared<MessageCacheTimeWindowBuffer>(max_buffer_size, per_topic_window);
+}
+
 CircularMessageCache::~CircularMessageCache()
 {
   // Unblock wait_for_data on destruction
@@ -73,10 +84,17 @@ void CircularMessageCache::done_flushing()
 
 void CircularMessageCache::notify_data_ready()
 {
+  bool already_pending = false;
   {
     std::lock_guard<std::mutex> lock(producer_buffer_mutex_);
+    already_pending = data_ready_;
     data_ready_ = true;
   }
+  if (already_pending) {
+    // The pending swap hands over everything this trigger would, so both are served by one dump
+    ROSBAG2_CPP_LOG_DEBUG("Snapshot already pending, coalescing with previous trigger");
+    return;
+  }
   cache_condition_var_.notify_one();
 }
 
@@ -13,11 +13,14 @@
 // limitations under the License.
 
 #include <algorithm>
+#include <chrono>
+#include <limits>
 #include <map>
 #include <memory>
 #include <string>
 #include <unordered_map>
 #include <utility>
+#include <vector>
 
 #include "rosbag2_cpp/cache/message_cache.hpp"
 #include "rosbag2_cpp/cache/message_cache_interface.hpp"
@@ -29,11 +32,22 @@ namespace cache
 {
 
 MessageCache::MessageCache(size_t max_buffer_size)
+: max_buffer_size_(max_buffer_size)
 {
   producer_buffer_ = std::make_shared<MessageCacheBuffer>(max_buffer_size);
   consumer_buffer_ = std::make_shared<MessageCacheBuffer>(max_buffer_size);
 }
 
+MessageCache::MessageCache(
+  size_t max_buffer_size, size_t max_spill_size, const std::string & spill_file_path)
+: MessageCache(max_buffer_size)
+{
+  spill_file_ = std::make_unique<MessageCacheSpillFile>(spill_file_path, max_spill_size);
+  // Batches are bounded by the drain size rather than by the buffer
+  spill_drain_buffer_ = std::make_shared<MessageCacheBuffer>(
+    std::numeric_limits<size_t>::max());
+}
+
 MessageCache::~MessageCache()
 {
   // Initiate flushing on destruction to unblock wait_for_data. This is defensive programming
@@ -46,14 +60,28 @@ MessageCache::~MessageCache()
 
 void MessageCache::push(std::shared_ptr<const rosbag2_storage::SerializedBagMessage> msg)
 {
+  const auto push_time = std::chrono::steady_clock::now();
   // While pushing, we keep track of inserted and dropped messages as well
-  bool pushed = false;
+  bool spill = false;
   {
     std::lock_guard<std::mutex> lock(producer_buffer_mutex_);
-    pushed = producer_buffer_->push(msg);
+    bool pushed = false;
+    // Keep appending to the spill file until it is drained, to preserve the order of messages
+    if (!spill_file_ || spill_file_->bytes_pending() == 0u) {
+      pushed = producer_buffer_->push(msg, push_time);
+    }
+    spill = !pushed && spill_file_;
+    // Concurrent producers may drop messages of the same topic at once
+    if (!pushed && !spill) {
+      messages_dropped_per_topic_[msg->topic_name]++;
+    }
   }
 
-  if (!pushed) {
+  // Append outside of the buffer lock, so that other producers and buffer swaps don't wait on
+  // the disk. The message is pending before push returns, so later messages of this producer
+  // are appended behind it.
+  if (spill && !spill_file_->push(msg, push_time)) {
+    std::lock_guard<std::mutex> lock(producer_buffer_mutex_);
     messages_dropped_per_topic_[msg->topic_name]++;
   }
 
@@ -63,6 +91,9 @@ void MessageCache::push(std::shared_ptr<const rosbag2_storage::SerializedBagMess
 std::shared_ptr<CacheBufferInterface> MessageCache::get_consumer_buffer()
 {
   consumer_buffer_mutex_.lock();
+  if (draining_spill_) {
+    return spill_drain_buffer_;
+  }
   return consumer_buffer_;
 }
 
@@ -87,7 +118,7 @@ void MessageCache::wait_for_data()
     // Required condition check to protect against spurious wakeups
     cache_condition_var_.wait(
       producer_lock, [this] {
-        return data_ready_ || flushing_;
+        return data_ready_ || flushing_ || (spill_file_ && spill_file_->bytes_pending() > 0u);
       });
     data_ready_ = false;
   }
@@ -95,9 +126,36 @@ void MessageCache::wait_for_data()
 
 void MessageCache::swap_buffers()
 {
-  std::lock_guard<std::mutex> producer_lock(producer_buffer_mutex_);
+  {
+    std::lock_guard<std::mutex> producer_lock(producer_buffer_mutex_);
+    std::lock_guard<std::mutex> consumer_lock(consumer_buffer_mutex_);
+    draining_spill_ = spill_file_ && spill_file_->bytes_pending() > 0u;
+    if (!draining_spill_) {
+      std::swap(producer_buffer_, consumer_buffer_);
+      return;
+    }
+    // Messages in the producer buffer were pushed before the spill file started to fill up
+    const auto & messages = producer_buffer_->data();
+    const auto & push_times = producer_buffer_->push_times();
+    for (size_t i = 0; i < messages.size(); ++i) {
+      spill_drain_buffer_->push(messages[i], push_times[i]);
+    }
+    producer_buffer_->clear();
+  }
+
+  // Read from disk without blocking the producer, which appends behind the drained batch
   std::lock_guard<std::mutex> consumer_lock(consumer_buffer_mutex_);
-  std::swap(producer_buffer_, consumer_buffer_);
+  const size_t max_drain_size = flushing_ ? std::numeric_limits<size_t>::max() : max_buffer_size_;
+  std::vector<std::chrono::steady_clock::time_point> push_times;
+  const auto messages = spill_file_->drain(max_drain_size, &push_times);
+  for (size_t i = 0; i < messages.size(); ++i) {
+    spill_drain_buffer_->push(messages[i], push_times[i]);
+  }
+}
+
+const std::vector<std::chrono::steady_clock::time_point> & MessageCache::get_consumer_push_times()
+{
+  return draining_spill_ ? spill_drain_buffer_->push_times() : consumer_buffer_->push_times();
 }
 
 void MessageCache::begin_flushing()
@@ -120,12 +178,16 @@ void MessageCache::log_dropped()
   std::string log_text("Cache buffers lost messages per topic: ");
 
   // worse performance than sorting key vector (neglible), but cleaner
-  std::map<std::string, uint32_t> messages_dropped_per_topic_sorted(
-    messages_dropped_per_topic_.begin(), messages_dropped_per_topic_.end());
+  std::map<std::string, uint32_t> messages_dropped_per_topic_sorted;
+  {
+    std::lock_guard<std::mutex> lock(producer_buffer_mutex_);
+    messages_dropped_per_topic_sorted.insert(
+      messages_dropped_per_topic_.begin(), messages_dropped_per_topic_.end());
+  }
 
   std::for_each(
-    messages_dropped_per_topic_.begin(),
-    messages_dropped_per_topic_.end(),
+    messages_dropped_per_topic_sorted.begin(),
+    messages_dropped_per_topic_sorted.end(),
     [&total_lost, &log_text](const auto & e) {
       uint32_t lost = e.second;
       if (lost > 0) {
@@ -145,6 +207,19 @@ void MessageCache::log_dropped()
       "Cache buffers were unflushed with " << remaining << " remaining messages"
     );
   }
+
+  const auto spill_statistics = get_spill_statistics();
+  if (spill_statistics.bytes_spilled > 0u) {
+    ROSBAG2_CPP_LOG_WARN_STREAM(
+      "Cache overflowed to spill file with " << spill_statistics.bytes_spilled << " bytes, " <<
+        spill_statistics.bytes_pending << " bytes were not drained. Last drain rate: " <<
+        spill_statistics.drain_rate << " bytes/s");
+  }
+}
+
+SpillStatistics MessageCache::get_spill_statistics() const
+{
+  return spill_file_ ? spill_file_->get_statistics() : SpillStatistics{};
 }
 
 }  // namespace cache
@@ -12,7 +12,9 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <chrono>
 #include <memory>
+#include <utility>
 #include <vector>
 
 #include "rosbag2_cpp/cache/cache_buffer_interface.hpp"
@@ -29,11 +31,19 @@ MessageCacheBuffer::MessageCacheBuffer(size_t max_cache_size)
 }
 
 bool MessageCacheBuffer::push(CacheBufferInterface::buffer_element_t msg)
+{
+  return push(std::move(msg), std::chrono::steady_clock::now());
+}
+
+bool MessageCacheBuffer::push(
+  CacheBufferInterface::buffer_element_t msg,
+  std::chrono::steady_clock::time_point push_time)
 {
   bool pushed = false;
   if (!drop_messages_) {
     buffer_bytes_size_ += msg->serialized_data->buffer_length;
-    buffer_.push_back(msg);
+    buffer_.push_back(std::move(msg));
+    push_times_.push_back(push_time);
     pushed = true;
   }
 
@@ -46,6 +56,7 @@ bool MessageCacheBuffer::push(CacheBufferInterface::buffer_element_t msg)
 void MessageCacheBuffer::clear()
 {
   buffer_.clear();
+  push_times_.clear();
   buffer_bytes_size_ = 0u;
   drop_messages_ = false;
 }
@@ -60,5 +71,10 @@ const std::vector<CacheBufferInterface::buffer_element_t> & MessageCacheBuffer::
   return buffer_;
 }
 
+const std::vector<std::chrono::steady_clock::time_point> & MessageCacheBuffer::push_times() const
+{
+  return push_times_;
+}
+
 }  // namespace cache
 }  // namespace rosbag2_cpp
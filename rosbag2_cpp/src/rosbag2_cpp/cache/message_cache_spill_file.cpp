@@ -0,0 +1,199 @@
+// Copyright 2022, Open Source Robotics Corporation.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "rcpputils/filesystem_helper.hpp"
+
+#include "rosbag2_cpp/cache/message_cache_spill_file.hpp"
+#include "rosbag2_cpp/logging.hpp"
+
+#include "rosbag2_storage/ros_helper.hpp"
+
+namespace rosbag2_cpp
+{
+namespace cache
+{
+
+namespace
+{
+// Every record is laid out as
+//   int64 time stamp | int64 push time | uint32 topic name length | topic name |
+//   uint64 data length | data
+constexpr size_t record_header_size =
+  sizeof(int64_t) + sizeof(int64_t) + sizeof(uint32_t) + sizeof(uint64_t);
+
+template<typename T>
+void write_value(std::ofstream & stream, T value)
+{
+  stream.write(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+
+template<typename T>
+T read_value(std::ifstream & stream)
+{
+  T value{};
+  stream.read(reinterpret_cast<char *>(&value), sizeof(value));
+  return value;
+}
+}  // namespace
+
+MessageCacheSpillFile::MessageCacheSpillFile(const std::string & path, size_t max_bytes_size)
+: path_(path),
+  max_bytes_size_(max_bytes_size),
+  write_stream_(path, std::ios::binary | std::ios::trunc),
+  last_drain_time_(std::chrono::steady_clock::now()),
+  read_stream_(path, std::ios::binary)
+{
+  if (!write_stream_ || !read_stream_) {
+    throw std::runtime_error("Failed to open cache spill file \"" + path + "\"");
+  }
+}
+
+MessageCacheSpillFile::~MessageCacheSpillFile()
+{
+  {
+    std::lock_guard<std::mutex> lock(write_mutex_);
+    write_stream_.close();
+  }
+  read_stream_.close();
+  rcpputils::fs::remove(rcpputils::fs::path(path_));
+}
+
+bool MessageCacheSpillFile::push(
+  const CacheBufferInterface::buffer_element_t & msg,
+  std::chrono::steady_clock::time_point push_time)
+{
+  const size_t data_size = msg->serialized_data->buffer_length;
+  const size_t record_size = record_header_size + msg->topic_name.size() + data_size;
+
+  std::lock_guard<std::mutex> lock(write_mutex_);
+  if (write_offset_ + record_size > max_bytes_size_) {
+    return false;
+  }
+  if (write_offset_ == read_offset_) {
+    // Start measuring the drain rate from the moment the file starts to fill up
+    last_drain_time_ = std::chrono::steady_clock::now();
+  }
+
+  write_value<int64_t>(write_stream_, msg->time_stamp);
+  write_value<int64_t>(
+    write_stream_, std::chrono::duration_cast<std::chrono::nanoseconds>(
+      push_time.time_since_epoch()).count());
+  write_value<uint32_t>(write_stream_, static_cast<uint32_t>(msg->topic_name.size()));
+  write_stream_.write(msg->topic_name.data(), msg->topic_name.size());
+  write_value<uint64_t>(write_stream_, data_size);
+  write_stream_.write(reinterpret_cast<const char *>(msg->serialized_data->buffer), data_size);
+  // Make the record visible to the read stream before it is accounted as pending
+  write_stream_.flush();
+  if (!write_stream_) {
+    ROSBAG2_CPP_LOG_WARN_STREAM("Failed to write to cache spill file \"" << path_ << "\"");
+    write_stream_.clear();
+    write_stream_.seekp(static_cast<std::streamoff>(write_offset_));
+    return false;
+  }
+
+  write_offset_ += record_size;
+  bytes_pending_ += record_size;
+  bytes_spilled_ += record_size;
+  return true;
+}
+
+std::vector<CacheBufferInterface::buffer_element_t> MessageCacheSpillFile::drain(
+  size_t max_bytes,
+  std::vector<std::chrono::steady_clock::time_point> * push_times)
+{
+  std::vector<CacheBufferInterface::buffer_element_t> messages;
+  size_t begin = 0u;
+  size_t end = 0u;
+  {
+    std::lock_guard<std::mutex> lock(write_mutex_);
+    begin = read_offset_;
+    end = write_offset_;
+  }
+  if (begin == end) {
+    return messages;
+  }
+
+  // Records up to end are complete and flushed, so they can be read without holding the lock
+  read_stream_.clear();
+  read_stream_.seekg(static_cast<std::streamoff>(begin));
+  size_t offset = begin;
+  while (offset < end && offset - begin < max_bytes) {
+    auto msg = std::make_shared<rosbag2_storage::SerializedBagMessage>();
+    msg->time_stamp = read_value<int64_t>(read_stream_);
+    const auto push_time = std::chrono::steady_clock::time_point(
+      std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+        std::chrono::nanoseconds(read_value<int64_t>(read_stream_))));
+    msg->topic_name.resize(read_value<uint32_t>(read_stream_));
+    read_stream_.read(&msg->topic_name[0], msg->topic_name.size());
+    const auto data_size = static_cast<size_t>(read_value<uint64_t>(read_stream_));
+    msg->serialized_data = rosbag2_storage::make_empty_serialized_message(data_size);
+    read_stream_.read(reinterpret_cast<char *>(msg->serialized_data->buffer), data_size);
+    msg->serialized_data->buffer_length = data_size;
+    if (!read_stream_) {
+      throw std::runtime_error("Failed to read from cache spill file \"" + path_ + "\"");
+    }
+    offset += record_header_size + msg->topic_name.size() + data_size;
+    messages.push_back(msg);
+    if (push_times) {
+      push_times->push_back(push_time);
+    }
+  }
+
+  std::lock_guard<std::mutex> lock(write_mutex_);
+  const auto now = std::chrono::steady_clock::now();
+  const std::chrono::duration<double> elapsed = now - last_drain_time_;
+  last_drain_time_ = now;
+  if (elapsed.count() > 0.0) {
+    drain_rate_ = static_cast<double>(offset - begin) / elapsed.count();
+  }
+  bytes_drained_ += offset - begin;
+  bytes_pending_ -= offset - begin;
+
+  read_offset_ = offset;
+  if (read_offset_ == write_offset_) {
+    // Fully drained, start over at the beginning of the file
+    write_stream_.close();
+    write_stream_.open(path_, std::ios::binary | std::ios::trunc);
+    read_offset_ = 0u;
+    write_offset_ = 0u;
+  }
+  return messages;
+}
+
+size_t MessageCacheSpillFile::bytes_pending() const
+{
+  return bytes_pending_;
+}
+
+SpillStatistics MessageCacheSpillFile::get_statistics() const
+{
+  SpillStatistics statistics;
+  statistics.bytes_spilled = bytes_spilled_;
+  statistics.bytes_pending = bytes_pending_;
+  statistics.bytes_drained = bytes_drained_;
+  statistics.drain_rate = drain_rate_;
+  return statistics;
+}
+
+}  // namespace cache
+}  // namespace rosbag2_cpp
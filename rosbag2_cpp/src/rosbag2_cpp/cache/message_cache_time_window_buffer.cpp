@@ -0,0 +1,143 @@
+// Copyright 2022, Open Source Robotics Corporation.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <limits>
+#include <memory>
+#include <queue>
+#include <utility>
+#include <vector>
+
+#include "rosbag2_cpp/logging.hpp"
+#include "rosbag2_cpp/cache/cache_buffer_interface.hpp"
+#include "rosbag2_cpp/cache/message_cache_time_window_buffer.hpp"
+
+namespace rosbag2_cpp
+{
+namespace cache
+{
+
+MessageCacheTimeWindowBuffer::MessageCacheTimeWindowBuffer(
+  size_t max_cache_size, std::chrono::nanoseconds window)
+: max_bytes_size_(max_cache_size),
+  window_ns_(window.count()),
+  newest_time_stamp_(std::numeric_limits<rcutils_time_point_value_t>::min())
+{
+}
+
+bool MessageCacheTimeWindowBuffer::push(CacheBufferInterface::buffer_element_t msg)
+{
+  const size_t msg_size = msg->serialized_data->buffer_length;
+  // Drop message if it exceeds the buffer size
+  if (msg_size > max_bytes_size_) {
+    ROSBAG2_CPP_LOG_WARN_STREAM("Last message exceeds snapshot buffer size. Dropping message!");
+    return false;
+  }
+
+  newest_time_stamp_ = std::max(newest_time_stamp_, msg->time_stamp);
+
+  auto & ring = topic_rings_[msg->topic_name];
+  ring.messages.push_back(msg);
+  ring.bytes_size += msg_size;
+  buffer_bytes_size_ += msg_size;
+  ++message_count_;
+
+  drop_expired(ring);
+  while (buffer_bytes_size_ > max_bytes_size_) {
+    drop_oldest_of_largest_topic();
+  }
+  return true;
+}
+
+void MessageCacheTimeWindowBuffer::pop_front(TopicRing & ring)
+{
+  const size_t msg_size = ring.messages.front()->serialized_data->buffer_length;
+  ring.bytes_size -= msg_size;
+  buffer_bytes_size_ -= msg_size;
+  --message_count_;
+  ring.messages.pop_front();
+}
+
+void MessageCacheTimeWindowBuffer::drop_expired(TopicRing & ring)
+{
+  while (!ring.messages.empty() &&
+    newest_time_stamp_ - ring.messages.front()->time_stamp > window_ns_)
+  {
+    pop_front(ring);
+  }
+}
+
+void MessageCacheTimeWindowBuffer::drop_oldest_of_largest_topic()
+{
+  auto largest = std::max_element(
+    topic_rings_.begin(), topic_rings_.end(),
+    [](const auto & a, const auto & b) {
+      return a.second.bytes_size < b.second.bytes_size;
+    });
+  if (largest != topic_rings_.end() && !largest->second.messages.empty()) {
+    pop_front(largest->second);
+  }
+}
+
+void MessageCacheTimeWindowBuffer::clear()
+{
+  topic_rings_.clear();
+  msg_vector_.clear();
+  buffer_bytes_size_ = 0u;
+  message_count_ = 0u;
+  newest_time_stamp_ = std::numeric_limits<rcutils_time_point_value_t>::min();
+}
+
+size_t MessageCacheTimeWindowBuffer::size()
+{
+  return message_count_;
+}
+
+const std::vector<CacheBufferInterface::buffer_element_t> & MessageCacheTimeWindowBuffer::data()
+{
+  // Topics which went silent were not trimmed on push, apply the window to them as well
+  for (auto & topic_ring : topic_rings_) {
+    drop_expired(topic_ring.second);
+  }
+
+  // Each ring is ordered by time already, so a k-way merge over the topics is sufficient
+  using RingIterator = std::deque<CacheBufferInterface::buffer_element_t>::const_iterator;
+  using RingRange = std::pair<RingIterator, RingIterator>;
+  auto later = [](const RingRange & a, const RingRange & b) {
+      return (*a.first)->time_stamp > (*b.first)->time_stamp;
+    };
+  std::priority_queue<RingRange, std::vector<RingRange>, decltype(later)> heads(later);
+  for (const auto & topic_ring : topic_rings_) {
+    if (!topic_ring.second.messages.empty()) {
+      heads.emplace(topic_ring.second.messages.cbegin(), topic_ring.second.messages.cend());
+    }
+  }
+
+  msg_vector_.clear();
+  msg_vector_.reserve(message_count_);
+  while (!heads.empty()) {
+    auto head = heads.top();
+    heads.pop();
+    msg_vector_.push_back(*head.first);
+    if (++head.first != head.second) {
+      heads.push(head);
+    }
+  }
+  return msg_vector_;
+}
+
+}  // namespace cache
+}  // namespace rosbag2_cpp
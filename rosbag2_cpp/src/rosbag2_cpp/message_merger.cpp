@@ -0,0 +1,90 @@
+// Copyright 2022, Open Source Robotics Corporation.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "rosbag2_cpp/message_merger.hpp"
+
+#include <algorithm>
+#include <numeric>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace rosbag2_cpp
+{
+
+MessageMerger::MessageMerger(size_t num_inputs, ReadNextFunction read_next)
+: read_next_(std::move(read_next)),
+  inputs_to_read_(num_inputs),
+  num_inputs_(num_inputs)
+{
+  heap_.reserve(num_inputs);
+  std::iota(inputs_to_read_.begin(), inputs_to_read_.end(), size_t{0});
+}
+
+bool MessageMerger::has_next()
+{
+  for (const auto input : inputs_to_read_) {
+    auto message = read_next_(input);
+    if (message) {
+      const auto time_stamp = message->time_stamp;
+      heap_.push_back({time_stamp, input, std::move(message)});
+      std::push_heap(heap_.begin(), heap_.end(), is_later);
+    }
+  }
+  inputs_to_read_.clear();
+  return !heap_.empty();
+}
+
+MessageMerger::Message MessageMerger::read_next()
+{
+  if (!has_next()) {
+    throw std::runtime_error("Bag is at end. No next message.");
+  }
+  std::pop_heap(heap_.begin(), heap_.end(), is_later);
+  auto entry = std::move(heap_.back());
+  heap_.pop_back();
+  inputs_to_read_.push_back(entry.input);
+  return std::move(entry.message);
+}
+
+void MessageMerger::clear()
+{
+  heap_.clear();
+  inputs_to_read_.resize(num_inputs_);
+  std::iota(inputs_to_read_.begin(), inputs_to_read_.end(), size_t{0});
+}
+
+void MessageMerger::remove_if(
+  const std::function<bool(const rosbag2_storage::SerializedBagMessage &)> & predicate)
+{
+  const auto removed = std::partition(
+    heap_.begin(), heap_.end(), [&predicate](const Entry & entry) {
+      return !predicate(*entry.message);
+    });
+  for (auto it = removed; it != heap_.end(); ++it) {
+    inputs_to_read_.push_back(it->input);
+  }
+  heap_.erase(removed, heap_.end());
+  std::make_heap(heap_.begin(), heap_.end(), is_later);
+}
+
+bool MessageMerger::is_later(const Entry & lhs, const Entry & rhs)
+{
+  if (lhs.time_stamp != rhs.time_stamp) {
+    return lhs.time_stamp > rhs.time_stamp;
+  }
+  return lhs.input > rhs.input;
+}
+
+}  // namespace rosbag2_cpp
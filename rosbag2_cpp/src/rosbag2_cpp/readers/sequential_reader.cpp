@@ -12,6 +12,7 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <algorithm>
 #include <memory>
 #include <stdexcept>
 #include <string>
@@ -24,6 +25,7 @@
 #include "rosbag2_cpp/logging.hpp"
 #include "rosbag2_cpp/readers/sequential_reader.hpp"
 
+#include "rosbag2_storage/storage_filter.hpp"
 
 namespace rosbag2_cpp
 {
@@ -55,6 +57,59 @@ std::vector<std::string> resolve_relative_paths(
 
   return relative_files;
 }
+
+bool is_sharded(const rosbag2_storage::BagMetadata & metadata)
+{
+  return std::any_of(
+    metadata.files.begin(), metadata.files.end(),
+    [](const rosbag2_storage::FileInformation & file) {return file.shard > 0u;});
+}
+
+/// Hands the metadata of a single shard to the reader of that shard
+class ShardMetadataIo : public rosbag2_storage::MetadataIo
+{
+public:
+  explicit ShardMetadataIo(rosbag2_storage::BagMetadata metadata)
+  : metadata_(std::move(metadata))
+  {}
+
+  rosbag2_storage::BagMetadata read_metadata(const std::string & /* uri */) override
+  {
+    return metadata_;
+  }
+
+  bool metadata_file_exists(const std::string & /* uri */) override
+  {
+    return true;
+  }
+
+private:
+  rosbag2_storage::BagMetadata metadata_;
+};
+
+/// Lets the readers of all shards share the storage factory of the parent reader
+class ForwardingStorageFactory : public rosbag2_storage::StorageFactoryInterface
+{
+public:
+  explicit ForwardingStorageFactory(rosbag2_storage::StorageFactoryInterface & storage_factory)
+  : storage_factory_(storage_factory)
+  {}
+
+  std::shared_ptr<rosbag2_storage::storage_interfaces::ReadOnlyInterface>
+  open_read_only(const rosbag2_storage::StorageOptions & storage_options) override
+  {
+    return storage_factory_.open_read_only(storage_options);
+  }
+
+  std::shared_ptr<rosbag2_storage::storage_interfaces::ReadWriteInterface>
+  open_read_write(const rosbag2_storage::StorageOptions & storage_options) override
+  {
+    return storage_factory_.open_read_write(storage_options);
+  }
+
+private:
+  rosbag2_storage::StorageFactoryInterface & storage_factory_;
+};
 }  // namespace details
 
 SequentialReader::SequentialReader(
@@ -77,6 +132,13 @@ void SequentialReader::close()
   if (storage_) {
     storage_.reset();
   }
+  shard_merger_.reset();
+  shard_readers_.clear();
+}
+
+bool SequentialReader::is_open() const
+{
+  return storage_ != nullptr || !shard_readers_.empty();
 }
 
 void SequentialReader::open(
@@ -100,6 +162,10 @@ void SequentialReader::open(
     file_paths_ = details::resolve_relative_paths(
       storage_options.uri, metadata_.relative_file_paths, metadata_.version);
     current_file_iterator_ = file_paths_.begin();
+    if (details::is_sharded(metadata_)) {
+      open_shards(converter_options);
+      return;
+    }
     load_current_file();
   } else {
     storage_ = storage_factory_->open_read_only(storage_options_);
@@ -128,8 +194,56 @@ void SequentialReader::open(
     topics[0].topic_metadata.serialization_format);
 }
 
+void SequentialReader::open_shards(const ConverterOptions & converter_options)
+{
+  size_t shard_count = 0;
+  for (const auto & file : metadata_.files) {
+    shard_count = std::max(shard_count, file.shard + 1);
+  }
+
+  for (size_t shard = 0; shard < shard_count; ++shard) {
+    auto shard_metadata = metadata_;
+    shard_metadata.relative_file_paths.clear();
+    shard_metadata.files.clear();
+    for (const auto & file : metadata_.files) {
+      if (file.shard == shard) {
+        shard_metadata.relative_file_paths.push_back(file.path);
+        shard_metadata.files.push_back(file);
+        // Read by the shard reader as a bag of its own
+        shard_metadata.files.back().shard = 0;
+      }
+    }
+    if (shard_metadata.files.empty()) {
+      continue;
+    }
+
+    auto shard_reader = std::make_unique<SequentialReader>(
+      std::make_unique<details::ForwardingStorageFactory>(*storage_factory_),
+      converter_factory_,
+      std::make_unique<details::ShardMetadataIo>(std::move(shard_metadata)));
+    shard_reader->open(storage_options_, converter_options);
+    for (const auto & callbacks : event_callbacks_) {
+      shard_reader->add_event_callbacks(callbacks);
+    }
+    shard_readers_.push_back(std::move(shard_reader));
+  }
+  shard_merger_ = std::make_unique<MessageMerger>(
+    shard_readers_.size(),
+    [this](size_t shard) -> MessageMerger::Message {
+      return shard_readers_[shard]->has_next() ? shard_readers_[shard]->read_next() : nullptr;
+    });
+
+  fill_topics_metadata();
+  if (!metadata_.topics_with_message_count.empty()) {
+    check_topics_serialization_formats(metadata_.topics_with_message_count);
+  }
+}
+
 bool SequentialReader::has_next()
 {
+  if (!shard_readers_.empty()) {
+    return shard_merger_->has_next();
+  }
   if (storage_) {
     // If there's no new message, check if there's at least another file to read and update storage
     // to read from there. Otherwise, check if there's another message.
@@ -149,6 +263,10 @@ bool SequentialReader::has_next()
 // before the timestamp of the last read upon a file roll-over.
 std::shared_ptr<rosbag2_storage::SerializedBagMessage> SequentialReader::read_next()
 {
+  if (!shard_readers_.empty()) {
+    // Shards are read in parallel, return the oldest of their next messages
+    return shard_merger_->read_next();
+  }
   if (storage_) {
     // performs rollover if necessary
     if (has_next()) {
@@ -162,13 +280,13 @@ std::shared_ptr<rosbag2_storage::SerializedBagMessage> SequentialReader::read_ne
 
 const rosbag2_storage::BagMetadata & SequentialReader::get_metadata() const
 {
-  rcpputils::check_true(storage_ != nullptr, "Bag is not open. Call open() before reading.");
+  rcpputils::check_true(is_open(), "Bag is not open. Call open() before reading.");
   return metadata_;
 }
 
 std::vector<rosbag2_storage::TopicMetadata> SequentialReader::get_all_topics_and_types() const
 {
-  rcpputils::check_true(storage_ != nullptr, "Bag is not open. Call open() before reading.");
+  rcpputils::check_true(is_open(), "Bag is not open. Call open() before reading.");
   return topics_metadata_;
 }
 
@@ -176,6 +294,17 @@ void SequentialReader::set_filter(
   const rosbag2_storage::StorageFilter & storage_filter)
 {
   topics_filter_ = storage_filter;
+  if (!shard_readers_.empty()) {
+    for (auto & shard_reader : shard_readers_) {
+      shard_reader->set_filter(topics_filter_);
+    }
+    // Drop messages taken out of the shards before the filter changed
+    shard_merger_->remove_if(
+      [this](const rosbag2_storage::SerializedBagMessage & message) {
+        return !rosbag2_storage::topic_passes_filter(message.topic_name, topics_filter_);
+      });
+    return;
+  }
   if (storage_) {
     storage_->set_filter(topics_filter_);
     return;
@@ -192,6 +321,13 @@ void SequentialReader::reset_filter()
 void SequentialReader::seek(const rcutils_time_point_value_t & timestamp)
 {
   seek_time_ = timestamp;
+  if (!shard_readers_.empty()) {
+    for (auto & shard_reader : shard_readers_) {
+      shard_reader->seek(timestamp);
+    }
+    shard_merger_->clear();
+    return;
+  }
   if (storage_) {
     // reset to the first file
     current_file_iterator_ = file_paths_.begin();
@@ -282,7 +418,7 @@ void SequentialReader::check_converter_serialization_format(
 
 void SequentialReader::fill_topics_metadata()
 {
-  rcpputils::check_true(storage_ != nullptr, "Bag is not open. Call open() before reading.");
+  rcpputils::check_true(is_open(), "Bag is not open. Call open() before reading.");
   topics_metadata_.clear();
   topics_metadata_.reserve(metadata_.topics_with_message_count.size());
   for (const auto & topic_information : metadata_.topics_with_message_count) {
@@ -292,6 +428,11 @@ void SequentialReader::fill_topics_metadata()
 
 void SequentialReader::add_event_callbacks(const bag_events::ReaderEventCallbacks & callbacks)
 {
+  // Remembered for the readers of the shards, which are created on open
+  event_callbacks_.push_back(callbacks);
+  for (auto & shard_reader : shard_readers_) {
+    shard_reader->add_event_callbacks(callbacks);
+  }
   if (callbacks.read_split_callback) {
     callback_manager_.add_event_callback(
       callbacks.read_split_callback,
@@ -18,6 +18,8 @@
 #include <chrono>
 #include <cstring>
 #include <memory>
+#include <mutex>
+#include <shared_mutex>
 #include <stdexcept>
 #include <string>
 #include <utility>
@@ -63,18 +65,22 @@ void Writer::open(
   const rosbag2_storage::StorageOptions & storage_options,
   const ConverterOptions & converter_options)
 {
+  std::lock_guard<std::shared_timed_mutex> writer_lock(writer_mutex_);
+  created_topics_.clear();
   writer_impl_->open(storage_options, converter_options);
 }
 
 void Writer::create_topic(const rosbag2_storage::TopicMetadata & topic_with_type)
 {
-  std::lock_guard<std::mutex> writer_lock(writer_mutex_);
+  std::lock_guard<std::shared_timed_mutex> writer_lock(writer_mutex_);
   writer_impl_->create_topic(topic_with_type);
+  created_topics_.insert(topic_with_type.name);
 }
 
 void Writer::remove_topic(const rosbag2_storage::TopicMetadata & topic_with_type)
 {
-  std::lock_guard<std::mutex> writer_lock(writer_mutex_);
+  std::lock_guard<std::shared_timed_mutex> writer_lock(writer_mutex_);
+  created_topics_.erase(topic_with_type.name);
   writer_impl_->remove_topic(topic_with_type);
 }
 
@@ -85,7 +91,7 @@ bool Writer::take_snapshot()
 
 void Writer::write(std::shared_ptr<const rosbag2_storage::SerializedBagMessage> message)
 {
-  std::lock_guard<std::mutex> writer_lock(writer_mutex_);
+  std::shared_lock<std::shared_timed_mutex> writer_lock(writer_mutex_);
   writer_impl_->write(message);
 }
 
@@ -101,6 +107,14 @@ void Writer::write(
     throw std::runtime_error(err);
   }
 
+  {
+    std::shared_lock<std::shared_timed_mutex> writer_lock(writer_mutex_);
+    if (created_topics_.find(topic_name) != created_topics_.end()) {
+      writer_impl_->write(message);
+      return;
+    }
+  }
+
   rosbag2_storage::TopicMetadata tm;
   tm.name = topic_name;
   tm.type = type_name;
@@ -187,4 +201,16 @@ void Writer::add_event_callbacks(bag_events::WriterEventCallbacks & callbacks)
   writer_impl_->add_event_callbacks(callbacks);
 }
 
+WriterStatistics Writer::get_statistics() const
+{
+  std::shared_lock<std::shared_timed_mutex> writer_lock(writer_mutex_);
+  return writer_impl_->get_statistics();
+}
+
+WriterStatistics Writer::get_interval_statistics()
+{
+  std::shared_lock<std::shared_timed_mutex> writer_lock(writer_mutex_);
+  return writer_impl_->get_interval_statistics();
+}
+
 }  // namespace rosbag2_cpp
@@ -0,0 +1,173 @@
+// Copyright 2022, Open Source Robotics Corporation.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+
+#include "rosbag2_cpp/writer_statistics.hpp"
+
+namespace rosbag2_cpp
+{
+
+namespace
+{
+unsigned most_significant_bit(uint64_t value)
+{
+  unsigned msb = 0;
+  for (unsigned shift = 32; shift > 0; shift /= 2) {
+    if (value >> shift) {
+      value >>= shift;
+      msb += shift;
+    }
+  }
+  return msb;
+}
+}  // namespace
+
+size_t LatencyHistogram::bucket_index(uint64_t value)
+{
+  if (value < SUB_BUCKET_COUNT) {
+    return static_cast<size_t>(value);
+  }
+  // Keep the SUB_BUCKET_BITS bits below the most significant bit as linear sub bucket
+  const unsigned shift = most_significant_bit(value) - SUB_BUCKET_BITS;
+  const uint64_t sub_bucket = (value >> shift) & (SUB_BUCKET_COUNT - 1);
+  return static_cast<size_t>((shift + 1) * SUB_BUCKET_COUNT + sub_bucket);
+}
+
+uint64_t LatencyHistogram::bucket_upper_bound(size_t index)
+{
+  if (index < SUB_BUCKET_COUNT) {
+    return index;
+  }
+  const uint64_t shift = index / SUB_BUCKET_COUNT - 1;
+  const uint64_t sub_bucket = index % SUB_BUCKET_COUNT;
+  const uint64_t lower_bound = (SUB_BUCKET_COUNT + sub_bucket) << shift;
+  return lower_bound + ((uint64_t{1} << shift) - 1);
+}
+
+void LatencyHistogram::record(std::chrono::nanoseconds latency)
+{
+  const uint64_t value = static_cast<uint64_t>(std::max<int64_t>(latency.count(), 0));
+  buckets_[bucket_index(value)].fetch_add(1u, std::memory_order_relaxed);
+
+  uint64_t max = max_.load(std::memory_order_relaxed);
+  while (value > max && !max_.compare_exchange_weak(max, value, std::memory_order_relaxed)) {
+  }
+}
+
+LatencySummary LatencyHistogram::summarize() const
+{
+  // Buckets keep being recorded while summarizing, so take a snapshot of them first
+  std::array<uint64_t, BUCKET_COUNT> buckets;
+  for (size_t index = 0; index < BUCKET_COUNT; ++index) {
+    buckets[index] = buckets_[index].load(std::memory_order_relaxed);
+  }
+  return summarize(buckets, max_.load(std::memory_order_relaxed));
+}
+
+LatencySummary LatencyHistogram::summarize_and_reset()
+{
+  std::array<uint64_t, BUCKET_COUNT> buckets;
+  for (size_t index = 0; index < BUCKET_COUNT; ++index) {
+    buckets[index] = buckets_[index].exchange(0u, std::memory_order_relaxed);
+  }
+  return summarize(buckets, max_.exchange(0u, std::memory_order_relaxed));
+}
+
+LatencySummary LatencyHistogram::summarize(
+  const std::array<uint64_t, BUCKET_COUNT> & buckets, uint64_t max)
+{
+  LatencySummary summary;
+  summary.max = max;
+  for (const auto bucket_count : buckets) {
+    summary.count += bucket_count;
+  }
+  if (summary.count == 0u) {
+    return summary;
+  }
+  // A latency recorded while resetting may be counted here, but raise the max of the next summary
+  size_t max_index = BUCKET_COUNT - 1;
+  while (buckets[max_index] == 0u) {
+    --max_index;
+  }
+  if (max_index > 0 && summary.max <= bucket_upper_bound(max_index - 1)) {
+    summary.max = bucket_upper_bound(max_index);
+  }
+
+  const uint64_t p50_rank = (summary.count * 50 + 99) / 100;
+  const uint64_t p90_rank = (summary.count * 90 + 99) / 100;
+  const uint64_t p99_rank = (summary.count * 99 + 99) / 100;
+  uint64_t seen = 0;
+  for (size_t index = 0; index < BUCKET_COUNT && seen < p99_rank; ++index) {
+    const uint64_t bucket_count = buckets[index];
+    if (bucket_count == 0u) {
+      continue;
+    }
+    const uint64_t upper_bound = std::min(bucket_upper_bound(index), summary.max);
+    if (seen < p50_rank && seen + bucket_count >= p50_rank) {
+      summary.p50 = upper_bound;
+    }
+    if (seen < p90_rank && seen + bucket_count >= p90_rank) {
+      summary.p90 = upper_bound;
+    }
+    if (seen + bucket_count >= p99_rank) {
+      summary.p99 = upper_bound;
+    }
+    seen += bucket_count;
+  }
+  return summary;
+}
+
+void TopicWriteStatisticsCollector::record_since_receive(
+  LatencyHistogram & histogram, int64_t receive_time_stamp, int64_t system_time)
+{
+  if (system_time >= receive_time_stamp) {
+    histogram.record(std::chrono::nanoseconds(system_time - receive_time_stamp));
+  }
+}
+
+int64_t TopicWriteStatisticsCollector::system_now()
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+    std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+TopicWriteStatistics TopicWriteStatisticsCollector::summarize() const
+{
+  TopicWriteStatistics statistics;
+  statistics.messages = messages.load(std::memory_order_relaxed);
+  statistics.bytes = bytes.load(std::memory_order_relaxed);
+  statistics.receive_to_push = receive_to_push.summarize();
+  statistics.cache_residency = cache_residency.summarize();
+  statistics.storage_write = storage_write.summarize();
+  statistics.receive_to_commit = receive_to_commit.summarize();
+  return statistics;
+}
+
+TopicWriteStatistics TopicWriteStatisticsCollector::summarize_and_reset_latencies()
+{
+  TopicWriteStatistics statistics;
+  statistics.messages = messages.load(std::memory_order_relaxed);
+  statistics.bytes = bytes.load(std::memory_order_relaxed);
+  statistics.receive_to_push = receive_to_push.summarize_and_reset();
+  statistics.cache_residency = cache_residency.summarize_and_reset();
+  statistics.storage_write = storage_write.summarize_and_reset();
+  statistics.receive_to_commit = receive_to_commit.summarize_and_reset();
+  return statistics;
+}
+
+}  // namespace rosbag2_cpp
@@ -16,10 +16,16 @@
 
 #include <algorithm>
 #include <chrono>
+#include <functional>
+#include <exception>
+#include <limits>
 #include <memory>
+#include <mutex>
+#include <shared_mutex>
 #include <stdexcept>
 #include <string>
 #include <sstream>
+#include <thread>
 #include <unordered_map>
 #include <utility>
 #include <vector>
@@ -42,6 +48,24 @@ std::string strip_parent_path(const std::string & relative_path)
 {
   return rcpputils::fs::path(relative_path).filename().string();
 }
+
+void store_min(std::atomic<int64_t> & target, int64_t value)
+{
+  int64_t current = target.load(std::memory_order_relaxed);
+  while (value < current &&
+    !target.compare_exchange_weak(current, value, std::memory_order_relaxed))
+  {
+  }
+}
+
+void store_max(std::atomic<int64_t> & target, int64_t value)
+{
+  int64_t current = target.load(std::memory_order_relaxed);
+  while (value > current &&
+    !target.compare_exchange_weak(current, value, std::memory_order_relaxed))
+  {
+  }
+}
 }  // namespace
 
 SequentialWriter::SequentialWriter(
@@ -76,6 +100,17 @@ void SequentialWriter::init_metadata()
   file_info.message_count = 0;
   metadata_.custom_data = storage_options_.custom_data;
   metadata_.files = {file_info};
+
+  bag_min_time_stamp_ = std::numeric_limits<int64_t>::max();
+  bag_max_time_stamp_ = std::numeric_limits<int64_t>::min();
+  reset_file_time_bounds();
+}
+
+void SequentialWriter::reset_file_time_bounds()
+{
+  file_min_time_stamp_ = std::numeric_limits<int64_t>::max();
+  file_max_time_stamp_ = std::numeric_limits<int64_t>::min();
+  file_message_count_ = 0u;
 }
 
 void SequentialWriter::open(
@@ -129,9 +164,18 @@ void SequentialWriter::open(
   }
 
   if (use_cache_) {
-    if (storage_options.snapshot_mode) {
+    if (storage_options.snapshot_mode && storage_options.snapshot_duration > 0u) {
+      message_cache_ = std::make_shared<rosbag2_cpp::cache::CircularMessageCache>(
+        storage_options.max_cache_size,
+        std::chrono::seconds(storage_options.snapshot_duration));
+    } else if (storage_options.snapshot_mode) {
       message_cache_ = std::make_shared<rosbag2_cpp::cache::CircularMessageCache>(
         storage_options.max_cache_size);
+    } else if (storage_options.max_cache_spill_size > 0u) {
+      message_cache_ = std::make_shared<rosbag2_cpp::cache::MessageCache>(
+        storage_options.max_cache_size,
+        storage_options.max_cache_spill_size,
+        (rcpputils::fs::path(base_folder_) / "message_cache.spill").string());
     } else {
       message_cache_ = std::make_shared<rosbag2_cpp::cache::MessageCache>(
         storage_options.max_cache_size);
@@ -141,11 +185,19 @@ void SequentialWriter::open(
       std::bind(&SequentialWriter::write_messages, this, std::placeholders::_1));
   }
 
+  open_time_ = std::chrono::steady_clock::now();
   init_metadata();
+
+  if (storage_options_.metadata_checkpoint_interval > 0u) {
+    stop_checkpointing_ = false;
+    checkpoint_thread_ = std::thread(&SequentialWriter::checkpoint_metadata_periodically, this);
+  }
 }
 
 void SequentialWriter::close()
 {
+  stop_checkpointing();
+
   if (use_cache_) {
     // destructor will flush message cache
     cache_consumer_.reset();
@@ -163,6 +215,7 @@ void SequentialWriter::close()
 
 void SequentialWriter::create_topic(const rosbag2_storage::TopicMetadata & topic_with_type)
 {
+  std::lock_guard<std::shared_timed_mutex> state_lock(writer_state_mutex_);
   if (topics_names_to_info_.find(topic_with_type.name) !=
     topics_names_to_info_.end())
   {
@@ -183,6 +236,11 @@ void SequentialWriter::create_topic(const rosbag2_storage::TopicMetadata & topic
     const auto insert_res = topics_names_to_info_.insert(
       std::make_pair(topic_with_type.name, info));
     insert_succeded = insert_res.second;
+    if (insert_succeded) {
+      // Keep statistics of removed topics, so they are reported for the whole recording
+      topics_statistics_.emplace(
+        topic_with_type.name, std::make_shared<TopicWriteStatisticsCollector>());
+    }
   }
 
   if (!insert_succeded) {
@@ -201,6 +259,7 @@ void SequentialWriter::create_topic(const rosbag2_storage::TopicMetadata & topic
 
 void SequentialWriter::remove_topic(const rosbag2_storage::TopicMetadata & topic_with_type)
 {
+  std::lock_guard<std::shared_timed_mutex> state_lock(writer_state_mutex_);
   if (!storage_) {
     throw std::runtime_error("Bag is not open. Call open() before removing.");
   }
@@ -236,8 +295,12 @@ std::string SequentialWriter::format_storage_uri(
 
 void SequentialWriter::switch_to_next_storage()
 {
+  // In snapshot mode, splitting is done by the cache consumer itself while writing a snapshot.
+  // Untriggered messages in the ring must not be flushed, so there is nothing to consume.
+  const bool restart_cache_consumer = use_cache_ && !storage_options_.snapshot_mode;
+
   // consume remaining message cache
-  if (use_cache_) {
+  if (restart_cache_consumer) {
     cache_consumer_->stop();
     message_cache_->log_dropped();
   }
@@ -259,7 +322,7 @@ void SequentialWriter::switch_to_next_storage()
     storage_->create_topic(topic.second.topic_metadata);
   }
 
-  if (use_cache_) {
+  if (restart_cache_consumer) {
     // restart consumer thread for cache
     cache_consumer_->start();
   }
@@ -267,6 +330,8 @@ void SequentialWriter::switch_to_next_storage()
 
 void SequentialWriter::split_bagfile()
 {
+  sync_time_metadata();
+
   auto info = std::make_shared<bag_events::BagSplitInfo>();
   info->closed_file = storage_->get_relative_file_path();
   switch_to_next_storage();
@@ -279,62 +344,106 @@ void SequentialWriter::split_bagfile()
     std::chrono::nanoseconds::max());
   file_info.path = strip_parent_path(storage_->get_relative_file_path());
   metadata_.files.push_back(file_info);
+  reset_file_time_bounds();
+
+  if (storage_options_.metadata_checkpoint_interval > 0u) {
+    // List the new file right away, a crash would otherwise leave it out of the bag
+    checkpoint_metadata();
+  }
 
   callback_manager_.execute_callbacks(bag_events::BagEvent::WRITE_SPLIT, info);
 }
 
 void SequentialWriter::write(std::shared_ptr<const rosbag2_storage::SerializedBagMessage> message)
 {
+  // Storage plugins are not thread-safe, so writing directly to storage stays serialized.
+  // Through the cache, concurrent writes only contend on the cache itself.
+  const bool write_directly = storage_options_.max_cache_size == 0u;
+  std::shared_lock<std::shared_timed_mutex> shared_state_lock(
+    writer_state_mutex_, std::defer_lock);
+  std::unique_lock<std::shared_timed_mutex> exclusive_state_lock(
+    writer_state_mutex_, std::defer_lock);
+  if (write_directly) {
+    exclusive_state_lock.lock();
+  } else {
+    shared_state_lock.lock();
+  }
+
   if (!storage_) {
     throw std::runtime_error("Bag is not open. Call open() before writing.");
   }
 
   // Get TopicInformation handler for counting messages.
   rosbag2_storage::TopicInformation * topic_information {nullptr};
-  try {
-    topic_information = &topics_names_to_info_.at(message->topic_name);
-  } catch (const std::out_of_range & /* oor */) {
-    std::stringstream errmsg;
-    errmsg << "Failed to write on topic '" << message->topic_name <<
-      "'. Call create_topic() before first write.";
-    throw std::runtime_error(errmsg.str());
+  TopicWriteStatisticsCollector * topic_statistics {nullptr};
+  const auto find_topic = [this, &message, &topic_information, &topic_statistics]() {
+      auto topic_it = topics_names_to_info_.find(message->topic_name);
+      if (topic_it == topics_names_to_info_.end()) {
+        std::stringstream errmsg;
+        errmsg << "Failed to write on topic '" << message->topic_name <<
+          "'. Call create_topic() before first write.";
+        throw std::runtime_error(errmsg.str());
+      }
+      topic_information = &topic_it->second;
+      topic_statistics = topics_statistics_.at(message->topic_name).get();
+    };
+  find_topic();
+
+  if (storage_options_.snapshot_mode) {
+    // Only push into the ring here, so recording is never held up by a snapshot being written.
+    // Metadata and splitting are handled by the cache consumer once a snapshot is triggered.
+    message_cache_->push(get_writeable_message(message));
+    TopicWriteStatisticsCollector::record_since_receive(
+      topic_statistics->receive_to_push, message->time_stamp,
+      TopicWriteStatisticsCollector::system_now());
+    return;
   }
 
   const auto message_timestamp = std::chrono::time_point<std::chrono::high_resolution_clock>(
     std::chrono::nanoseconds(message->time_stamp));
 
-  if (is_first_message_) {
-    // Update bagfile starting time
-    metadata_.starting_time = message_timestamp;
-    is_first_message_ = false;
-  }
-
   if (should_split_bagfile(message_timestamp)) {
-    split_bagfile();
-    metadata_.files.back().starting_time = message_timestamp;
+    if (write_directly) {
+      split_bagfile();
+    } else {
+      shared_state_lock.unlock();
+      {
+        std::lock_guard<std::shared_timed_mutex> split_lock(writer_state_mutex_);
+        // Another writer may have split while waiting for the lock
+        if (should_split_bagfile(message_timestamp)) {
+          split_bagfile();
+        }
+      }
+      shared_state_lock.lock();
+      // The topic may have been removed meanwhile
+      find_topic();
+    }
   }
 
-  metadata_.starting_time = std::min(metadata_.starting_time, message_timestamp);
-
-  metadata_.files.back().starting_time =
-    std::min(metadata_.files.back().starting_time, message_timestamp);
-  const auto duration = message_timestamp - metadata_.starting_time;
-  metadata_.duration = std::max(metadata_.duration, duration);
-
-  const auto file_duration = message_timestamp - metadata_.files.back().starting_time;
-  metadata_.files.back().duration =
-    std::max(metadata_.files.back().duration, file_duration);
+  update_time_metadata(message_timestamp);
+  file_message_count_.fetch_add(1u, std::memory_order_relaxed);
 
   auto converted_msg = get_writeable_message(message);
 
-  metadata_.files.back().message_count++;
-  if (storage_options_.max_cache_size == 0u) {
+  if (write_directly) {
     // If cache size is set to zero, we write to storage directly
+    const auto write_start = std::chrono::steady_clock::now();
     storage_->write(converted_msg);
+    topic_statistics->storage_write.record(std::chrono::steady_clock::now() - write_start);
+    TopicWriteStatisticsCollector::record_since_receive(
+      topic_statistics->receive_to_commit, message->time_stamp,
+      TopicWriteStatisticsCollector::system_now());
+    topic_statistics->messages.fetch_add(1u, std::memory_order_relaxed);
+    topic_statistics->bytes.fetch_add(
+      converted_msg->serialized_data ? converted_msg->serialized_data->buffer_length : 0u,
+      std::memory_order_relaxed);
     ++topic_information->message_count;
   } else {
     // Otherwise, use cache buffer
     message_cache_->push(converted_msg);
+    TopicWriteStatisticsCollector::record_since_receive(
+      topic_statistics->receive_to_push, message->time_stamp,
+      TopicWriteStatisticsCollector::system_now());
   }
 }
 
@@ -344,10 +453,46 @@ bool SequentialWriter::take_snapshot()
     ROSBAG2_CPP_LOG_WARN("SequentialWriter take_snaphot called when snapshot mode is disabled");
     return false;
   }
+  // Only hand the ring over to the cache consumer thread, which writes the snapshot
   message_cache_->notify_data_ready();
   return true;
 }
 
+void SequentialWriter::update_time_metadata(
+  const std::chrono::time_point<std::chrono::high_resolution_clock> & message_timestamp)
+{
+  const int64_t time_stamp = std::chrono::duration_cast<std::chrono::nanoseconds>(
+    message_timestamp.time_since_epoch()).count();
+  store_min(bag_min_time_stamp_, time_stamp);
+  store_max(bag_max_time_stamp_, time_stamp);
+  store_min(file_min_time_stamp_, time_stamp);
+  store_max(file_max_time_stamp_, time_stamp);
+}
+
+void SequentialWriter::sync_time_metadata()
+{
+  using TimePoint = std::chrono::time_point<std::chrono::high_resolution_clock>;
+  const int64_t bag_min = bag_min_time_stamp_.load();
+  const int64_t bag_max = bag_max_time_stamp_.load();
+  if (bag_min <= bag_max) {
+    metadata_.starting_time = TimePoint(std::chrono::nanoseconds(bag_min));
+    metadata_.duration = std::chrono::nanoseconds(bag_max - bag_min);
+  }
+
+  if (metadata_.files.empty()) {
+    // Opening the bag failed before the metadata was initialized
+    return;
+  }
+  auto & file_info = metadata_.files.back();
+  const int64_t file_min = file_min_time_stamp_.load();
+  const int64_t file_max = file_max_time_stamp_.load();
+  if (file_min <= file_max) {
+    file_info.starting_time = TimePoint(std::chrono::nanoseconds(file_min));
+    file_info.duration = std::chrono::nanoseconds(file_max - file_min);
+  }
+  file_info.message_count = file_message_count_.load();
+}
+
 std::shared_ptr<const rosbag2_storage::SerializedBagMessage>
 SequentialWriter::get_writeable_message(
   std::shared_ptr<const rosbag2_storage::SerializedBagMessage> message)
@@ -361,11 +506,12 @@ bool SequentialWriter::should_split_bagfile(
   // Assume we aren't splitting
   bool should_split = false;
 
-  // Splitting by size
+  // Splitting by size. This runs for every message, so use the storage's running estimate
+  // instead of querying the actual file size.
   if (storage_options_.max_bagfile_size !=
     rosbag2_storage::storage_interfaces::MAX_BAGFILE_SIZE_NO_SPLIT)
   {
-    should_split = (storage_->get_bagfile_size() >= storage_options_.max_bagfile_size);
+    should_split = (storage_->get_bagfile_size_estimate() >= storage_options_.max_bagfile_size);
   }
 
   // Splitting by time
@@ -374,8 +520,9 @@ bool SequentialWriter::should_split_bagfile(
   {
     auto max_duration_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
       std::chrono::seconds(storage_options_.max_bagfile_duration));
-    should_split = should_split ||
-      ((current_time - metadata_.files.back().starting_time) > max_duration_ns);
+    const auto file_starting_time = std::chrono::time_point<std::chrono::high_resolution_clock>(
+      std::chrono::nanoseconds(file_min_time_stamp_.load(std::memory_order_relaxed)));
+    should_split = should_split || ((current_time - file_starting_time) > max_duration_ns);
   }
 
   return should_split;
@@ -383,6 +530,8 @@ bool SequentialWriter::should_split_bagfile(
 
 void SequentialWriter::finalize_metadata()
 {
+  sync_time_metadata();
+
   metadata_.bag_size = 0;
 
   for (const auto & path : metadata_.relative_file_paths) {
@@ -393,6 +542,8 @@ void SequentialWriter::finalize_metadata()
     }
   }
 
+  // Message counts are updated by the cache consumer while recording
+  std::lock_guard<std::mutex> lock(topics_info_mutex_);
   metadata_.topics_with_message_count.clear();
   metadata_.topics_with_message_count.reserve(topics_names_to_info_.size());
   metadata_.message_count = 0;
@@ -403,19 +554,164 @@ void SequentialWriter::finalize_metadata()
   }
 }
 
+void SequentialWriter::checkpoint_metadata()
+{
+  try {
+    write_metadata_checkpoint(take_metadata_checkpoint());
+  } catch (const std::exception & e) {
+    // Recording goes on, the metadata is written again on the next checkpoint or on close
+    ROSBAG2_CPP_LOG_WARN_STREAM("Failed to checkpoint metadata: " << e.what());
+  }
+}
+
+SequentialWriter::MetadataCheckpoint SequentialWriter::take_metadata_checkpoint()
+{
+  finalize_metadata();
+  return {metadata_, ++checkpoint_sequence_};
+}
+
+void SequentialWriter::write_metadata_checkpoint(const MetadataCheckpoint & checkpoint)
+{
+  std::lock_guard<std::mutex> lock(checkpoint_write_mutex_);
+  // Copies may be taken by one thread and written after a more recent copy of another one
+  if (checkpoint.sequence <= last_written_checkpoint_) {
+    return;
+  }
+  metadata_io_->write_metadata(base_folder_, checkpoint.metadata);
+  last_written_checkpoint_ = checkpoint.sequence;
+}
+
+void SequentialWriter::stop_checkpointing()
+{
+  if (checkpoint_thread_.joinable()) {
+    {
+      std::lock_guard<std::mutex> lock(checkpoint_mutex_);
+      stop_checkpointing_ = true;
+    }
+    checkpoint_condition_.notify_all();
+    checkpoint_thread_.join();
+  }
+}
+
+void SequentialWriter::checkpoint_metadata_periodically()
+{
+  const auto interval = std::chrono::seconds(storage_options_.metadata_checkpoint_interval);
+  std::unique_lock<std::mutex> lock(checkpoint_mutex_);
+  while (!checkpoint_condition_.wait_for(lock, interval, [this]() {return stop_checkpointing_;})) {
+    lock.unlock();
+    try {
+      // Writes only pause while the metadata is copied, not while the file is written
+      MetadataCheckpoint checkpoint;
+      {
+        std::lock_guard<std::shared_timed_mutex> state_lock(writer_state_mutex_);
+        checkpoint = take_metadata_checkpoint();
+      }
+      write_metadata_checkpoint(checkpoint);
+    } catch (const std::exception & e) {
+      ROSBAG2_CPP_LOG_WARN_STREAM("Failed to checkpoint metadata: " << e.what());
+    }
+    lock.lock();
+  }
+}
+
 void SequentialWriter::write_messages(
   const std::vector<std::shared_ptr<const rosbag2_storage::SerializedBagMessage>> & messages)
 {
   if (messages.empty()) {
     return;
   }
+  // Clocks are read once per batch, every message of the batch shares the same measurements
+  const auto dequeue_time = std::chrono::steady_clock::now();
+  // Messages are handed over in the order of their push times
+  const auto & push_times = message_cache_->get_consumer_push_times();
+  const bool has_push_times = push_times.size() == messages.size();
+  if (storage_options_.snapshot_mode) {
+    prepare_snapshot_file(messages);
+  }
+  const auto write_start = std::chrono::steady_clock::now();
   storage_->write(messages);
+  const auto write_duration = std::chrono::steady_clock::now() - write_start;
+  const int64_t commit_time = TopicWriteStatisticsCollector::system_now();
+
   std::lock_guard<std::mutex> lock(topics_info_mutex_);
-  for (const auto & msg : messages) {
+  for (size_t i = 0; i < messages.size(); ++i) {
+    const auto & msg = messages[i];
     if (topics_names_to_info_.find(msg->topic_name) != topics_names_to_info_.end()) {
       topics_names_to_info_[msg->topic_name].message_count++;
     }
+    auto statistics_it = topics_statistics_.find(msg->topic_name);
+    if (statistics_it != topics_statistics_.end()) {
+      auto & topic_statistics = *statistics_it->second;
+      if (has_push_times) {
+        topic_statistics.cache_residency.record(dequeue_time - push_times[i]);
+      }
+      topic_statistics.storage_write.record(write_duration);
+      TopicWriteStatisticsCollector::record_since_receive(
+        topic_statistics.receive_to_commit, msg->time_stamp, commit_time);
+      topic_statistics.messages.fetch_add(1u, std::memory_order_relaxed);
+      topic_statistics.bytes.fetch_add(
+        msg->serialized_data ? msg->serialized_data->buffer_length : 0u,
+        std::memory_order_relaxed);
+    }
+  }
+}
+
+void SequentialWriter::prepare_snapshot_file(
+  const std::vector<std::shared_ptr<const rosbag2_storage::SerializedBagMessage>> & messages)
+{
+  // A snapshot is never split across files, so check once before writing it
+  const auto first_timestamp = std::chrono::time_point<std::chrono::high_resolution_clock>(
+    std::chrono::nanoseconds(messages.front()->time_stamp));
+  const bool file_has_snapshot = file_message_count_.load() > 0u;
+  if (file_has_snapshot &&
+    (storage_options_.snapshot_file_per_trigger || should_split_bagfile(first_timestamp)))
+  {
+    // Recording keeps pushing into the ring concurrently, pause it while replacing the storage
+    std::lock_guard<std::shared_timed_mutex> state_lock(writer_state_mutex_);
+    split_bagfile();
+  }
+
+  for (const auto & msg : messages) {
+    update_time_metadata(
+      std::chrono::time_point<std::chrono::high_resolution_clock>(
+        std::chrono::nanoseconds(msg->time_stamp)));
+  }
+  file_message_count_.fetch_add(messages.size());
+}
+
+WriterStatistics SequentialWriter::get_statistics() const
+{
+  return collect_statistics(
+    [](TopicWriteStatisticsCollector & collector) {return collector.summarize();});
+}
+
+WriterStatistics SequentialWriter::get_interval_statistics()
+{
+  return collect_statistics(
+    [](TopicWriteStatisticsCollector & collector) {
+      return collector.summarize_and_reset_latencies();
+    });
+}
+
+WriterStatistics SequentialWriter::collect_statistics(
+  const std::function<TopicWriteStatistics(TopicWriteStatisticsCollector &)> & summarize) const
+{
+  WriterStatistics statistics;
+  statistics.duration = std::chrono::steady_clock::now() - open_time_;
+  if (message_cache_) {
+    const auto spill_statistics = message_cache_->get_spill_statistics();
+    statistics.spill_bytes = spill_statistics.bytes_spilled;
+    statistics.spill_bytes_pending = spill_statistics.bytes_pending;
+    statistics.spill_drain_rate = spill_statistics.drain_rate;
+  }
+  std::lock_guard<std::mutex> lock(topics_info_mutex_);
+  for (const auto & topic_statistics : topics_statistics_) {
+    auto summary = summarize(*topic_statistics.second);
+    statistics.messages += summary.messages;
+    statistics.bytes += summary.bytes;
+    statistics.topics.emplace(topic_statistics.first, std::move(summary));
   }
+  return statistics;
 }
 
 void SequentialWriter::add_event_callbacks(const bag_events::WriterEventCallbacks & callbacks)
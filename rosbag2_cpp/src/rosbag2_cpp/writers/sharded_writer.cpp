@@ -0,0 +1,343 @@
+// Copyright 2022, Open Source Robotics Corporation.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "rosbag2_cpp/writers/sharded_writer.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <future>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "rcpputils/filesystem_helper.hpp"
+
+namespace rosbag2_cpp
+{
+namespace writers
+{
+
+namespace
+{
+/// Hands the metadata of a shard over, to be merged into the metadata of the bag
+class ShardMetadataIo : public rosbag2_storage::MetadataIo
+{
+public:
+  using MetadataCallback = std::function<void (const rosbag2_storage::BagMetadata &)>;
+
+  explicit ShardMetadataIo(MetadataCallback callback)
+  : callback_(std::move(callback))
+  {}
+
+  void write_metadata(
+    const std::string & /* uri */, const rosbag2_storage::BagMetadata & metadata) override
+  {
+    callback_(metadata);
+  }
+
+private:
+  MetadataCallback callback_;
+};
+
+const std::chrono::time_point<std::chrono::high_resolution_clock> kNoStartingTime{
+  std::chrono::nanoseconds::max()};
+}  // namespace
+
+ShardedWriter::ShardedWriter(
+  size_t shard_count,
+  StorageFactoryCreator storage_factory_creator,
+  std::shared_ptr<SerializationFormatConverterFactoryInterface> converter_factory,
+  std::unique_ptr<rosbag2_storage::MetadataIo> metadata_io)
+: shard_count_(shard_count),
+  storage_factory_creator_(std::move(storage_factory_creator)),
+  converter_factory_(std::move(converter_factory)),
+  metadata_io_(std::move(metadata_io))
+{
+  if (shard_count_ == 0u) {
+    throw std::runtime_error("ShardedWriter needs at least one shard");
+  }
+}
+
+ShardedWriter::~ShardedWriter()
+{
+  close();
+}
+
+std::string ShardedWriter::shard_folder_name(size_t shard)
+{
+  return "shard_" + std::to_string(shard);
+}
+
+void ShardedWriter::open(
+  const rosbag2_storage::StorageOptions & storage_options,
+  const ConverterOptions & converter_options)
+{
+  rcpputils::fs::path db_path(storage_options.uri);
+  if (db_path.is_directory()) {
+    std::stringstream error;
+    error << "Database directory already exists (" << db_path.string() <<
+      "), can't overwrite existing database";
+    throw std::runtime_error{error.str()};
+  }
+  if (!rcpputils::fs::create_directories(db_path)) {
+    std::stringstream error;
+    error << "Failed to create database directory (" << db_path.string() << ").";
+    throw std::runtime_error{error.str()};
+  }
+
+  base_folder_ = storage_options.uri;
+  storage_options_ = storage_options;
+
+  // Keep the total memory and disk used for caching within the configured bounds
+  auto shard_options = storage_options;
+  if (storage_options.max_cache_size > 0u) {
+    shard_options.max_cache_size = std::max<uint64_t>(
+      storage_options.max_cache_size / shard_count_, 1u);
+  }
+  if (storage_options.max_cache_spill_size > 0u) {
+    shard_options.max_cache_spill_size = std::max<uint64_t>(
+      storage_options.max_cache_spill_size / shard_count_, 1u);
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(metadata_mutex_);
+    checkpoint_metadata_ = storage_options.metadata_checkpoint_interval > 0u;
+    collect_shards_metadata_ = true;
+  }
+
+  shards_.resize(shard_count_);
+  for (size_t i = 0; i < shard_count_; ++i) {
+    auto & shard = shards_[i];
+    shard.metadata.starting_time = kNoStartingTime;
+    shard.writer = std::make_unique<SequentialWriter>(
+      storage_factory_creator_(),
+      converter_factory_,
+      std::make_unique<ShardMetadataIo>(
+        [this, i](const rosbag2_storage::BagMetadata & metadata) {
+          on_shard_metadata_written(i, metadata);
+        }));
+    shard_options.uri = (db_path / shard_folder_name(i)).string();
+    shard.writer->open(shard_options, converter_options);
+  }
+}
+
+void ShardedWriter::close()
+{
+  if (shards_.empty()) {
+    return;
+  }
+
+  {
+    // The complete metadata is written once all shards are closed
+    std::lock_guard<std::mutex> lock(metadata_mutex_);
+    checkpoint_metadata_ = false;
+  }
+
+  // Every shard flushes its cache when closing, so close them in parallel
+  std::vector<std::future<void>> closing_shards;
+  closing_shards.reserve(shards_.size());
+  for (auto & shard : shards_) {
+    closing_shards.push_back(
+      std::async(std::launch::async, [&shard]() {shard.writer->close();}));
+  }
+  for (auto & closing_shard : closing_shards) {
+    closing_shard.get();
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(metadata_mutex_);
+    collect_shards_metadata_ = false;
+    metadata_io_->write_metadata(base_folder_, merge_shards_metadata());
+  }
+
+  shards_.clear();
+  topic_shards_.clear();
+}
+
+void ShardedWriter::create_topic(const rosbag2_storage::TopicMetadata & topic_with_type)
+{
+  if (shards_.empty()) {
+    throw std::runtime_error("Bag is not open. Call open() before writing.");
+  }
+  if (topic_shards_.find(topic_with_type.name) != topic_shards_.end()) {
+    // nothing to do, topic already created
+    return;
+  }
+
+  const auto shard_it = std::min_element(
+    shards_.begin(), shards_.end(),
+    [](const Shard & a, const Shard & b) {return a.topic_count < b.topic_count;});
+  shard_it->writer->create_topic(topic_with_type);
+  ++shard_it->topic_count;
+  topic_shards_.emplace(
+    topic_with_type.name, static_cast<size_t>(std::distance(shards_.begin(), shard_it)));
+}
+
+void ShardedWriter::remove_topic(const rosbag2_storage::TopicMetadata & topic_with_type)
+{
+  if (shards_.empty()) {
+    throw std::runtime_error("Bag is not open. Call open() before removing.");
+  }
+  const auto topic_it = topic_shards_.find(topic_with_type.name);
+  if (topic_it == topic_shards_.end()) {
+    std::stringstream errmsg;
+    errmsg << "Failed to remove the non-existing topic \"" <<
+      topic_with_type.name << "\"!";
+    throw std::runtime_error(errmsg.str());
+  }
+
+  auto & shard = shards_[topic_it->second];
+  shard.writer->remove_topic(topic_with_type);
+  --shard.topic_count;
+  topic_shards_.erase(topic_it);
+}
+
+void ShardedWriter::write(std::shared_ptr<const rosbag2_storage::SerializedBagMessage> message)
+{
+  if (shards_.empty()) {
+    throw std::runtime_error("Bag is not open. Call open() before writing.");
+  }
+  const auto topic_it = topic_shards_.find(message->topic_name);
+  if (topic_it == topic_shards_.end()) {
+    std::stringstream errmsg;
+    errmsg << "Failed to write on topic '" << message->topic_name <<
+      "'. Call create_topic() before first write.";
+    throw std::runtime_error(errmsg.str());
+  }
+  shards_[topic_it->second].writer->write(message);
+}
+
+bool ShardedWriter::take_snapshot()
+{
+  bool success = !shards_.empty();
+  for (auto & shard : shards_) {
+    success = shard.writer->take_snapshot() && success;
+  }
+  return success;
+}
+
+void ShardedWriter::add_event_callbacks(const bag_events::WriterEventCallbacks & callbacks)
+{
+  for (auto & shard : shards_) {
+    shard.writer->add_event_callbacks(callbacks);
+  }
+}
+
+WriterStatistics ShardedWriter::get_statistics() const
+{
+  WriterStatistics statistics;
+  for (const auto & shard : shards_) {
+    add_shard_statistics(statistics, shard.writer->get_statistics());
+  }
+  return statistics;
+}
+
+WriterStatistics ShardedWriter::get_interval_statistics()
+{
+  WriterStatistics statistics;
+  for (auto & shard : shards_) {
+    add_shard_statistics(statistics, shard.writer->get_interval_statistics());
+  }
+  return statistics;
+}
+
+void ShardedWriter::add_shard_statistics(
+  WriterStatistics & statistics, WriterStatistics shard_statistics)
+{
+  statistics.duration = std::max(statistics.duration, shard_statistics.duration);
+  statistics.messages += shard_statistics.messages;
+  statistics.bytes += shard_statistics.bytes;
+  statistics.spill_bytes += shard_statistics.spill_bytes;
+  statistics.spill_bytes_pending += shard_statistics.spill_bytes_pending;
+  statistics.spill_drain_rate += shard_statistics.spill_drain_rate;
+  for (auto & topic : shard_statistics.topics) {
+    statistics.topics.emplace(topic.first, std::move(topic.second));
+  }
+}
+
+void ShardedWriter::on_shard_metadata_written(
+  size_t shard, const rosbag2_storage::BagMetadata & metadata)
+{
+  std::lock_guard<std::mutex> lock(metadata_mutex_);
+  if (!collect_shards_metadata_) {
+    return;
+  }
+  shards_[shard].metadata = metadata;
+  if (checkpoint_metadata_) {
+    metadata_io_->write_metadata(base_folder_, merge_shards_metadata());
+  }
+}
+
+rosbag2_storage::BagMetadata ShardedWriter::merge_shards_metadata() const
+{
+  rosbag2_storage::BagMetadata metadata;
+  for (const auto & shard : shards_) {
+    // Shards which did not checkpoint yet have no metadata
+    if (!shard.metadata.storage_identifier.empty()) {
+      metadata.storage_identifier = shard.metadata.storage_identifier;
+      metadata.compression_format = shard.metadata.compression_format;
+      metadata.compression_mode = shard.metadata.compression_mode;
+      break;
+    }
+  }
+  metadata.custom_data = storage_options_.custom_data;
+  metadata.starting_time = kNoStartingTime;
+  metadata.duration = std::chrono::nanoseconds(0);
+  metadata.message_count = 0u;
+
+  auto ending_time = kNoStartingTime;
+  for (size_t i = 0; i < shards_.size(); ++i) {
+    const auto & shard_metadata = shards_[i].metadata;
+    const rcpputils::fs::path shard_folder(shard_folder_name(i));
+
+    for (const auto & path : shard_metadata.relative_file_paths) {
+      metadata.relative_file_paths.push_back((shard_folder / path).string());
+    }
+    for (auto file : shard_metadata.files) {
+      file.path = (shard_folder / file.path).string();
+      file.shard = i;
+      metadata.files.push_back(std::move(file));
+    }
+    metadata.bag_size += shard_metadata.bag_size;
+    metadata.message_count += shard_metadata.message_count;
+    metadata.topics_with_message_count.insert(
+      metadata.topics_with_message_count.end(),
+      shard_metadata.topics_with_message_count.begin(),
+      shard_metadata.topics_with_message_count.end());
+
+    if (shard_metadata.starting_time == kNoStartingTime) {
+      // Nothing was recorded by this shard
+      continue;
+    }
+    const auto shard_ending_time = shard_metadata.starting_time + shard_metadata.duration;
+    if (metadata.starting_time == kNoStartingTime) {
+      metadata.starting_time = shard_metadata.starting_time;
+      ending_time = shard_ending_time;
+    } else {
+      metadata.starting_time = std::min(metadata.starting_time, shard_metadata.starting_time);
+      ending_time = std::max(ending_time, shard_ending_time);
+    }
+  }
+  if (metadata.starting_time != kNoStartingTime) {
+    metadata.duration = ending_time - metadata.starting_time;
+  }
+  return metadata;
+}
+
+}  // namespace writers
+}  // namespace rosbag2_cpp
@@ -14,11 +14,13 @@
 
 #include <gmock/gmock.h>
 
+#include <chrono>
 #include <cmath>
 #include <list>
 #include <memory>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include "rosbag2_storage/ros_helper.hpp"
 #include "rosbag2_storage/serialized_bag_message.hpp"
@@ -46,6 +48,28 @@ std::shared_ptr<rosbag2_storage::SerializedBagMessage> make_test_msg()
   return message;
 }
 
+std::shared_ptr<rosbag2_storage::SerializedBagMessage> make_test_msg(
+  const std::string & topic_name, rcutils_time_point_value_t time_stamp, size_t size = 10)
+{
+  auto message = make_test_msg();
+  message->topic_name = topic_name;
+  message->time_stamp = time_stamp;
+  std::string msg_content(size, 'x');
+  message->serialized_data = rosbag2_storage::make_serialized_message(
+    msg_content.c_str(), msg_content.length());
+  return message;
+}
+
+std::vector<std::shared_ptr<const rosbag2_storage::SerializedBagMessage>> take_snapshot(
+  rosbag2_cpp::cache::CircularMessageCache & cache)
+{
+  cache.notify_data_ready();
+  cache.swap_buffers();
+  auto messages = cache.get_consumer_buffer()->data();
+  cache.release_consumer_buffer();
+  return messages;
+}
+
 std::string deserialize_message(std::shared_ptr<rcutils_uint8_array_t> serialized_message)
 {
   std::unique_ptr<uint8_t[]> copied(new uint8_t[serialized_message->buffer_length + 1]);
@@ -133,3 +157,78 @@ TEST_F(CircularMessageCacheTest, circular_message_cache_ensure_empty) {
   EXPECT_THAT(circular_message_cache->get_consumer_buffer()->size(), Eq(0u));
   circular_message_cache->release_consumer_buffer();
 }
+
+TEST_F(CircularMessageCacheTest, time_window_cache_burst_does_not_evict_other_topics) {
+  rosbag2_cpp::cache::CircularMessageCache cache(cache_size_, std::chrono::seconds(10));
+
+  cache.push(make_test_msg("/slow", 0));
+  // Burst on a single topic with several times the cache size
+  for (rcutils_time_point_value_t t = 1; t <= 200; ++t) {
+    cache.push(make_test_msg("/fast", t));
+  }
+
+  auto messages = take_snapshot(cache);
+  size_t bytes_size = 0;
+  size_t slow_count = 0;
+  for (const auto & msg : messages) {
+    bytes_size += msg->serialized_data->buffer_length;
+    slow_count += msg->topic_name == "/slow" ? 1u : 0u;
+  }
+  EXPECT_THAT(slow_count, Eq(1u));
+  EXPECT_THAT(bytes_size, Le(cache_size_));
+  EXPECT_THAT(messages.back()->time_stamp, Eq(200));
+}
+
+TEST_F(CircularMessageCacheTest, time_window_cache_drops_messages_outside_window) {
+  const auto window = std::chrono::seconds(1);
+  const rcutils_time_point_value_t second = std::chrono::nanoseconds(window).count();
+  rosbag2_cpp::cache::CircularMessageCache cache(cache_size_, window);
+
+  cache.push(make_test_msg("/a", 0));
+  cache.push(make_test_msg("/b", second / 2));
+  cache.push(make_test_msg("/a", 2 * second));
+
+  auto messages = take_snapshot(cache);
+  ASSERT_THAT(messages, SizeIs(1u));
+  EXPECT_THAT(messages[0]->topic_name, StrEq("/a"));
+  EXPECT_THAT(messages[0]->time_stamp, Eq(2 * second));
+}
+
+TEST_F(CircularMessageCacheTest, time_window_cache_merges_topics_in_time_order) {
+  rosbag2_cpp::cache::CircularMessageCache cache(cache_size_, std::chrono::seconds(10));
+
+  cache.push(make_test_msg("/a", 1));
+  cache.push(make_test_msg("/b", 2));
+  cache.push(make_test_msg("/a", 4));
+  cache.push(make_test_msg("/c", 3));
+  cache.push(make_test_msg("/b", 5));
+
+  auto messages = take_snapshot(cache);
+  ASSERT_THAT(messages, SizeIs(5u));
+  for (size_t i = 0; i < messages.size(); ++i) {
+    EXPECT_THAT(messages[i]->time_stamp, Eq(static_cast<rcutils_time_point_value_t>(i + 1)));
+  }
+}
+
+TEST_F(CircularMessageCacheTest, overlapping_snapshot_triggers_are_coalesced) {
+  rosbag2_cpp::cache::CircularMessageCache cache(cache_size_);
+
+  for (unsigned i = 0; i < 5; ++i) {
+    cache.push(make_test_msg());
+  }
+  cache.notify_data_ready();
+  cache.notify_data_ready();
+  cache.swap_buffers();
+  auto consumer_buffer = cache.get_consumer_buffer();
+  EXPECT_THAT(consumer_buffer->size(), Eq(5u));
+  consumer_buffer->clear();
+  cache.release_consumer_buffer();
+
+  // Recording continues, but the second trigger was served by the first swap
+  for (unsigned i = 0; i < 5; ++i) {
+    cache.push(make_test_msg());
+  }
+  cache.swap_buffers();
+  EXPECT_THAT(cache.get_consumer_buffer()->size(), Eq(0u));
+  cache.release_consumer_buffer();
+}
@@ -105,3 +105,54 @@ TEST_F(MessageCacheTest, message_cache_writes_full_producer_buffer) {
   mock_cache_consumer->stop();
   EXPECT_EQ(consumed_message_count, message_count - should_be_dropped_count);
 }
+
+TEST_F(MessageCacheTest, message_cache_counts_dropped_messages_of_concurrent_producers) {
+  const size_t producer_count = 8;
+  const size_t messages_per_producer = 1000;
+  size_t consumed_message_count {0};
+
+  // Only a few messages fit, so most of them are dropped while producers race
+  auto mock_message_cache = std::make_shared<NiceMock<MockMessageCache>>(50u);
+
+  std::vector<std::vector<std::shared_ptr<rosbag2_storage::SerializedBagMessage>>> messages(
+    producer_count);
+  for (size_t producer = 0; producer < producer_count; ++producer) {
+    for (size_t i = 0; i < messages_per_producer; ++i) {
+      auto msg = make_test_msg();
+      // Distinct topics make producers insert into the drop counters concurrently
+      msg->topic_name = "topic_" + std::to_string(producer) + "_" + std::to_string(i % 10);
+      messages[producer].push_back(msg);
+    }
+  }
+
+  std::vector<std::thread> producers;
+  for (size_t producer = 0; producer < producer_count; ++producer) {
+    producers.emplace_back(
+      [&mock_message_cache, &messages, producer]() {
+        for (const auto & msg : messages[producer]) {
+          mock_message_cache->push(msg);
+        }
+      });
+  }
+  for (auto & producer : producers) {
+    producer.join();
+  }
+
+  auto total_actually_dropped = sum_up(mock_message_cache->messages_dropped());
+  EXPECT_GT(total_actually_dropped, 0u);
+
+  auto cb = [&consumed_message_count](
+    const std::vector<std::shared_ptr<const rosbag2_storage::SerializedBagMessage>> & msgs) {
+      consumed_message_count += msgs.size();
+    };
+  auto mock_cache_consumer = std::make_unique<NiceMock<MockCacheConsumer>>(
+    mock_message_cache,
+    cb);
+
+  using namespace std::chrono_literals;
+  std::this_thread::sleep_for(20ms);
+
+  mock_cache_consumer->stop();
+  EXPECT_EQ(
+    consumed_message_count + total_actually_dropped, producer_count * messages_per_producer);
+}
@@ -0,0 +1,214 @@
+// Copyright 2022, Open Source Robotics Corporation.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gmock/gmock.h>
+
+#include <algorithm>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "rcpputils/filesystem_helper.hpp"
+
+#include "rosbag2_cpp/cache/message_cache.hpp"
+#include "rosbag2_cpp/cache/message_cache_spill_file.hpp"
+
+#include "rosbag2_storage/ros_helper.hpp"
+#include "rosbag2_storage/serialized_bag_message.hpp"
+
+#include "rosbag2_test_common/temporary_directory_fixture.hpp"
+
+using namespace testing;  // NOLINT
+using rosbag2_test_common::TemporaryDirectoryFixture;
+
+namespace
+{
+std::shared_ptr<rosbag2_storage::SerializedBagMessage> make_test_msg(
+  rcutils_time_point_value_t time_stamp)
+{
+  std::string msg_content = "Hello" + std::to_string(time_stamp);
+  auto message = std::make_shared<rosbag2_storage::SerializedBagMessage>();
+  message->topic_name = "test_topic";
+  message->time_stamp = time_stamp;
+  message->serialized_data = rosbag2_storage::make_serialized_message(
+    msg_content.c_str(), msg_content.length());
+  return message;
+}
+
+std::string deserialize_message(std::shared_ptr<rcutils_uint8_array_t> serialized_message)
+{
+  return std::string(
+    reinterpret_cast<char *>(serialized_message->buffer), serialized_message->buffer_length);
+}
+}  // namespace
+
+class MessageCacheSpillFileTest : public TemporaryDirectoryFixture
+{
+public:
+  std::string spill_file_path() const
+  {
+    return (rcpputils::fs::path(temporary_dir_path_) / "message_cache.spill").string();
+  }
+};
+
+TEST_F(MessageCacheSpillFileTest, drains_messages_in_push_order) {
+  rosbag2_cpp::cache::MessageCacheSpillFile spill_file(spill_file_path(), 1024 * 1024);
+
+  for (rcutils_time_point_value_t t = 0; t < 10; ++t) {
+    ASSERT_TRUE(spill_file.push(make_test_msg(t)));
+  }
+  EXPECT_THAT(spill_file.bytes_pending(), Gt(0u));
+
+  auto messages = spill_file.drain(1024 * 1024);
+  ASSERT_THAT(messages, SizeIs(10u));
+  for (size_t i = 0; i < messages.size(); ++i) {
+    EXPECT_THAT(messages[i]->time_stamp, Eq(static_cast<rcutils_time_point_value_t>(i)));
+    EXPECT_THAT(messages[i]->topic_name, StrEq("test_topic"));
+    EXPECT_THAT(
+      deserialize_message(messages[i]->serialized_data), StrEq("Hello" + std::to_string(i)));
+  }
+  EXPECT_THAT(spill_file.bytes_pending(), Eq(0u));
+
+  const auto statistics = spill_file.get_statistics();
+  EXPECT_THAT(statistics.bytes_spilled, Eq(statistics.bytes_drained));
+  EXPECT_THAT(statistics.bytes_pending, Eq(0u));
+}
+
+TEST_F(MessageCacheSpillFileTest, drains_in_batches_and_reuses_file_once_empty) {
+  rosbag2_cpp::cache::MessageCacheSpillFile spill_file(spill_file_path(), 1024 * 1024);
+
+  for (rcutils_time_point_value_t t = 0; t < 10; ++t) {
+    spill_file.push(make_test_msg(t));
+  }
+  // A single byte budget still makes progress by one message
+  auto first_batch = spill_file.drain(1);
+  ASSERT_THAT(first_batch, SizeIs(1u));
+  EXPECT_THAT(first_batch[0]->time_stamp, Eq(0));
+
+  // Messages pushed while draining are appended behind the pending ones
+  spill_file.push(make_test_msg(10));
+  auto second_batch = spill_file.drain(1024 * 1024);
+  ASSERT_THAT(second_batch, SizeIs(10u));
+  EXPECT_THAT(second_batch.front()->time_stamp, Eq(1));
+  EXPECT_THAT(second_batch.back()->time_stamp, Eq(10));
+
+  spill_file.push(make_test_msg(11));
+  auto third_batch = spill_file.drain(1024 * 1024);
+  ASSERT_THAT(third_batch, SizeIs(1u));
+  EXPECT_THAT(third_batch[0]->time_stamp, Eq(11));
+  EXPECT_THAT(rcpputils::fs::path(spill_file_path()).file_size(), Eq(0u));
+}
+
+TEST_F(MessageCacheSpillFileTest, rejects_messages_beyond_max_size) {
+  rosbag2_cpp::cache::MessageCacheSpillFile spill_file(spill_file_path(), 100);
+
+  size_t pushed = 0;
+  for (rcutils_time_point_value_t t = 0; t < 10; ++t) {
+    pushed += spill_file.push(make_test_msg(t)) ? 1u : 0u;
+  }
+  EXPECT_THAT(pushed, AllOf(Gt(0u), Lt(10u)));
+  EXPECT_THAT(spill_file.bytes_pending(), Le(100u));
+  EXPECT_THAT(spill_file.drain(100), SizeIs(pushed));
+}
+
+TEST_F(MessageCacheSpillFileTest, spill_file_is_removed_on_destruction) {
+  {
+    rosbag2_cpp::cache::MessageCacheSpillFile spill_file(spill_file_path(), 100);
+    EXPECT_TRUE(rcpputils::fs::exists(spill_file_path()));
+  }
+  EXPECT_FALSE(rcpputils::fs::exists(spill_file_path()));
+}
+
+TEST_F(MessageCacheSpillFileTest, message_cache_overflows_to_spill_file_in_order) {
+  const size_t cache_size = 100;
+  rosbag2_cpp::cache::MessageCache cache(cache_size, 1024 * 1024, spill_file_path());
+
+  const rcutils_time_point_value_t message_count = 100;
+  for (rcutils_time_point_value_t t = 0; t < message_count; ++t) {
+    cache.push(make_test_msg(t));
+  }
+  EXPECT_THAT(cache.get_spill_statistics().bytes_pending, Gt(0u));
+
+  std::vector<rosbag2_storage::SerializedBagMessageConstSharedPtr> consumed;
+  std::vector<std::chrono::steady_clock::time_point> push_times;
+  for (int i = 0; i < message_count && consumed.size() < message_count; ++i) {
+    cache.swap_buffers();
+    auto consumer_buffer = cache.get_consumer_buffer();
+    const auto & data = consumer_buffer->data();
+    consumed.insert(consumed.end(), data.begin(), data.end());
+    const auto & batch_push_times = cache.get_consumer_push_times();
+    push_times.insert(push_times.end(), batch_push_times.begin(), batch_push_times.end());
+    consumer_buffer->clear();
+    cache.release_consumer_buffer();
+  }
+
+  ASSERT_THAT(consumed, SizeIs(message_count));
+  for (size_t i = 0; i < consumed.size(); ++i) {
+    EXPECT_THAT(consumed[i]->time_stamp, Eq(static_cast<rcutils_time_point_value_t>(i)));
+  }
+  // Spilled messages keep the time they were pushed into the cache
+  ASSERT_THAT(push_times, SizeIs(message_count));
+  EXPECT_TRUE(std::is_sorted(push_times.begin(), push_times.end()));
+  const auto statistics = cache.get_spill_statistics();
+  EXPECT_THAT(statistics.bytes_pending, Eq(0u));
+  EXPECT_THAT(statistics.bytes_drained, Eq(statistics.bytes_spilled));
+}
+
+TEST_F(MessageCacheSpillFileTest, message_cache_keeps_order_of_concurrent_producers) {
+  const size_t cache_size = 100;
+  rosbag2_cpp::cache::MessageCache cache(cache_size, 1024 * 1024, spill_file_path());
+
+  const size_t producer_count = 4;
+  const rcutils_time_point_value_t messages_per_producer = 200;
+  std::vector<std::thread> producers;
+  for (size_t producer = 0; producer < producer_count; ++producer) {
+    producers.emplace_back(
+      [&cache, producer]() {
+        for (rcutils_time_point_value_t t = 0; t < messages_per_producer; ++t) {
+          auto message = make_test_msg(t);
+          message->topic_name = "topic_" + std::to_string(producer);
+          cache.push(message);
+        }
+      });
+  }
+
+  // Consume while producers alternate between the buffer and the spill file
+  std::map<std::string, std::vector<rcutils_time_point_value_t>> consumed;
+  size_t consumed_count = 0;
+  const size_t message_count = producer_count * messages_per_producer;
+  const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+  while (consumed_count < message_count && std::chrono::steady_clock::now() < deadline) {
+    cache.swap_buffers();
+    auto consumer_buffer = cache.get_consumer_buffer();
+    for (const auto & message : consumer_buffer->data()) {
+      consumed[message->topic_name].push_back(message->time_stamp);
+    }
+    consumed_count += consumer_buffer->size();
+    consumer_buffer->clear();
+    cache.release_consumer_buffer();
+  }
+  for (auto & producer : producers) {
+    producer.join();
+  }
+
+  ASSERT_THAT(consumed, SizeIs(producer_count));
+  for (const auto & topic : consumed) {
+    ASSERT_THAT(topic.second, SizeIs(messages_per_producer)) << topic.first;
+    EXPECT_TRUE(std::is_sorted(topic.second.begin(), topic.second.end())) << topic.first;
+  }
+  EXPECT_THAT(cache.get_spill_statistics().bytes_spilled, Gt(0u));
+}
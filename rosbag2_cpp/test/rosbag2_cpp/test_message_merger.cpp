@@ -0,0 +1,141 @@
+// Copyright 2022, Open Source Robotics Corporation.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gmock/gmock.h>
+
+#include <deque>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "rosbag2_cpp/message_merger.hpp"
+
+using namespace testing;  // NOLINT
+using rosbag2_cpp::MessageMerger;
+
+namespace
+{
+MessageMerger::Message make_message(rcutils_time_point_value_t time_stamp, std::string topic)
+{
+  auto message = std::make_shared<rosbag2_storage::SerializedBagMessage>();
+  message->time_stamp = time_stamp;
+  message->topic_name = std::move(topic);
+  return message;
+}
+
+class MessageMergerTest : public Test
+{
+public:
+  MessageMerger make_merger()
+  {
+    return MessageMerger(
+      inputs_.size(), [this](size_t input) -> MessageMerger::Message {
+        reads_.push_back(input);
+        if (inputs_[input].empty()) {
+          return nullptr;
+        }
+        auto message = inputs_[input].front();
+        inputs_[input].pop_front();
+        return message;
+      });
+  }
+
+  std::vector<std::string> read_all_topics(MessageMerger & merger)
+  {
+    std::vector<std::string> topics;
+    while (merger.has_next()) {
+      topics.push_back(merger.read_next()->topic_name);
+    }
+    return topics;
+  }
+
+  std::vector<std::deque<MessageMerger::Message>> inputs_;
+  std::vector<size_t> reads_;
+};
+}  // namespace
+
+TEST_F(MessageMergerTest, merges_inputs_in_timestamp_order)
+{
+  inputs_ = {
+    {make_message(1, "a1"), make_message(4, "a4"), make_message(9, "a9")},
+    {},
+    {make_message(2, "c2"), make_message(3, "c3"), make_message(10, "c10")},
+    {make_message(5, "d5")}};
+  auto merger = make_merger();
+
+  EXPECT_THAT(read_all_topics(merger), ElementsAre("a1", "c2", "c3", "a4", "d5", "a9", "c10"));
+  EXPECT_THROW(merger.read_next(), std::runtime_error);
+}
+
+TEST_F(MessageMergerTest, equal_timestamps_follow_input_order)
+{
+  inputs_ = {
+    {make_message(1, "a1"), make_message(2, "a2")},
+    {make_message(1, "b1"), make_message(2, "b2")},
+    {make_message(1, "c1")}};
+  auto merger = make_merger();
+
+  EXPECT_THAT(read_all_topics(merger), ElementsAre("a1", "b1", "c1", "a2", "b2"));
+}
+
+TEST_F(MessageMergerTest, reads_only_the_input_of_the_returned_message)
+{
+  inputs_ = {
+    {make_message(1, "a1"), make_message(3, "a3")},
+    {make_message(2, "b2")},
+    {make_message(4, "c4")}};
+  auto merger = make_merger();
+
+  ASSERT_TRUE(merger.has_next());
+  EXPECT_THAT(reads_, ElementsAre(0u, 1u, 2u));
+  reads_.clear();
+  merger.read_next();
+  ASSERT_TRUE(merger.has_next());
+  EXPECT_THAT(reads_, ElementsAre(0u));
+}
+
+TEST_F(MessageMergerTest, remove_if_drops_pending_messages_and_reads_their_inputs_again)
+{
+  inputs_ = {
+    {make_message(1, "/drop"), make_message(3, "/keep")},
+    {make_message(2, "/keep")}};
+  auto merger = make_merger();
+  ASSERT_TRUE(merger.has_next());
+
+  merger.remove_if(
+    [](const rosbag2_storage::SerializedBagMessage & message) {
+      return message.topic_name == "/drop";
+    });
+
+  std::vector<rcutils_time_point_value_t> time_stamps;
+  while (merger.has_next()) {
+    time_stamps.push_back(merger.read_next()->time_stamp);
+  }
+  EXPECT_THAT(time_stamps, ElementsAre(2, 3));
+}
+
+TEST_F(MessageMergerTest, clear_reads_all_inputs_again)
+{
+  inputs_ = {{make_message(1, "a1")}, {make_message(2, "b2")}};
+  auto merger = make_merger();
+  ASSERT_TRUE(merger.has_next());
+
+  // Like after a seek, the inputs continue from elsewhere
+  inputs_ = {{make_message(5, "a5")}, {make_message(4, "b4")}};
+  merger.clear();
+
+  EXPECT_THAT(read_all_topics(merger), ElementsAre("b4", "a5"));
+}
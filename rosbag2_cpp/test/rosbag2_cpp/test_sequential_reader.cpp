@@ -234,3 +234,69 @@ TEST_F(TemporaryDirectoryFixture, reader_accepts_bare_file) {
   EXPECT_TRUE(reader.has_next());
   EXPECT_THAT(reader.get_metadata().topics_with_message_count, SizeIs(1));
 }
+
+TEST_F(TemporaryDirectoryFixture, reader_merges_messages_of_storage_shards_by_timestamp) {
+  rosbag2_storage::TopicMetadata topic_a{"topic_a", "test_msgs/BasicTypes", "rmw_format", ""};
+  rosbag2_storage::TopicMetadata topic_b{"topic_b", "test_msgs/BasicTypes", "rmw_format", ""};
+
+  rosbag2_storage::BagMetadata metadata;
+  metadata.version = 7;
+  metadata.storage_identifier = "mock_storage";
+  metadata.relative_file_paths = {"shard_0/shard_0_0.db3", "shard_1/shard_1_0.db3"};
+  metadata.files.resize(2);
+  metadata.files[0].path = metadata.relative_file_paths[0];
+  metadata.files[0].shard = 0;
+  metadata.files[1].path = metadata.relative_file_paths[1];
+  metadata.files[1].shard = 1;
+  metadata.topics_with_message_count = {{topic_a, 3}, {topic_b, 3}};
+
+  auto metadata_io = std::make_unique<NiceMock<MockMetadataIo>>();
+  ON_CALL(*metadata_io, metadata_file_exists(_)).WillByDefault(Return(true));
+  ON_CALL(*metadata_io, read_metadata(_)).WillByDefault(Return(metadata));
+
+  // Each shard stores one topic, with timestamps interleaved between shards
+  auto make_storage = [](const std::string & topic_name, std::vector<int64_t> time_stamps) {
+      auto storage = std::make_shared<NiceMock<MockStorage>>();
+      auto remaining = std::make_shared<std::vector<int64_t>>(std::move(time_stamps));
+      ON_CALL(*storage, has_next()).WillByDefault([remaining]() {return !remaining->empty();});
+      ON_CALL(*storage, read_next()).WillByDefault(
+        [remaining, topic_name]() {
+          auto message = std::make_shared<rosbag2_storage::SerializedBagMessage>();
+          message->topic_name = topic_name;
+          message->time_stamp = remaining->front();
+          remaining->erase(remaining->begin());
+          return message;
+        });
+      return storage;
+    };
+  auto shard_0_storage = make_storage("topic_a", {1, 4, 5});
+  auto shard_1_storage = make_storage("topic_b", {2, 3, 6});
+
+  auto storage_factory = std::make_unique<NiceMock<MockStorageFactory>>();
+  ON_CALL(*storage_factory, open_read_only(_)).WillByDefault(
+    [&](const rosbag2_storage::StorageOptions & storage_options)
+    -> std::shared_ptr<rosbag2_storage::storage_interfaces::ReadOnlyInterface> {
+      if (storage_options.uri.find("shard_1") != std::string::npos) {
+        return shard_1_storage;
+      }
+      return shard_0_storage;
+    });
+
+  rosbag2_cpp::readers::SequentialReader reader(
+    std::move(storage_factory),
+    std::make_shared<StrictMock<MockConverterFactory>>(),
+    std::move(metadata_io));
+  reader.open({temporary_dir_path_, "mock_storage"}, {"", ""});
+
+  std::vector<int64_t> time_stamps;
+  std::vector<std::string> topic_names;
+  while (reader.has_next()) {
+    auto message = reader.read_next();
+    time_stamps.push_back(message->time_stamp);
+    topic_names.push_back(message->topic_name);
+  }
+  EXPECT_THAT(time_stamps, ElementsAre(1, 2, 3, 4, 5, 6));
+  EXPECT_THAT(
+    topic_names, ElementsAre("topic_a", "topic_b", "topic_b", "topic_a", "topic_a", "topic_b"));
+  EXPECT_THAT(reader.get_all_topics_and_types(), SizeIs(2));
+}
@@ -14,10 +14,15 @@
 
 #include <gmock/gmock.h>
 
+#include <atomic>
+#include <chrono>
 #include <filesystem>
+#include <future>
 #include <memory>
+#include <mutex>
 #include <stdexcept>
 #include <string>
+#include <thread>
 #include <utility>
 #include <vector>
 
@@ -190,11 +195,12 @@ TEST_F(SequentialWriterTest, open_throws_error_on_invalid_splitting_size) {
   EXPECT_THROW(writer_->open(storage_options_, {rmw_format, rmw_format}), std::runtime_error);
 }
 
-TEST_F(SequentialWriterTest, bagfile_size_is_checked_on_every_write) {
+TEST_F(SequentialWriterTest, bagfile_size_estimate_is_checked_on_every_write) {
   const int counter = 10;
   const uint64_t max_bagfile_size = 100;
 
-  EXPECT_CALL(*storage_, get_bagfile_size()).Times(counter);
+  EXPECT_CALL(*storage_, get_bagfile_size_estimate()).Times(counter);
+  EXPECT_CALL(*storage_, get_bagfile_size()).Times(0);
 
   auto sequential_writer = std::make_unique<rosbag2_cpp::writers::SequentialWriter>(
     std::move(storage_factory_), converter_factory_, std::move(metadata_io_));
@@ -228,7 +234,7 @@ TEST_F(SequentialWriterTest, writer_splits_when_storage_bagfile_size_gt_max_bagf
       fake_storage_size_++;
     });
 
-  ON_CALL(*storage_, get_bagfile_size).WillByDefault(
+  ON_CALL(*storage_, get_bagfile_size_estimate).WillByDefault(
     [this]() {
       return fake_storage_size_.load();
     });
@@ -305,7 +311,7 @@ TEST_F(
       fake_storage_size_.fetch_add(static_cast<uint32_t>(msgs.size()));
     });
 
-  ON_CALL(*storage_, get_bagfile_size).WillByDefault(
+  ON_CALL(*storage_, get_bagfile_size_estimate).WillByDefault(
     [this]() {
       return fake_storage_size_.load();
     });
@@ -493,6 +499,372 @@ TEST_F(SequentialWriterTest, snapshot_mode_not_triggered_no_storage_write)
   }
 }
 
+TEST_F(SequentialWriterTest, snapshot_mode_file_per_trigger_splits_on_each_snapshot)
+{
+  storage_options_.max_bagfile_size = 0;
+  storage_options_.max_cache_size = 200;
+  storage_options_.snapshot_mode = true;
+  storage_options_.snapshot_file_per_trigger = true;
+
+  // One storage on open, and a new one for the second snapshot
+  EXPECT_CALL(*storage_factory_, open_read_write(_)).Times(2);
+
+  std::promise<void> first_snapshot_written;
+  size_t snapshots_written = 0;
+  ON_CALL(
+    *storage_, write(
+      An
+      <const std::vector<std::shared_ptr<const rosbag2_storage::SerializedBagMessage>> &>()))
+  .WillByDefault(
+    [&first_snapshot_written, &snapshots_written](
+      const std::vector<std::shared_ptr<const rosbag2_storage::SerializedBagMessage>> &) {
+      if (snapshots_written++ == 0u) {
+        first_snapshot_written.set_value();
+      }
+    });
+
+  auto sequential_writer = std::make_unique<rosbag2_cpp::writers::SequentialWriter>(
+    std::move(storage_factory_), converter_factory_, std::move(metadata_io_));
+  writer_ = std::make_unique<rosbag2_cpp::Writer>(std::move(sequential_writer));
+
+  std::string rmw_format = "rmw_format";
+  writer_->open(storage_options_, {rmw_format, rmw_format});
+  writer_->create_topic({"test_topic", "test_msgs/BasicTypes", "", ""});
+
+  for (auto i = 0u; i < 10; ++i) {
+    writer_->write(make_test_msg());
+  }
+  writer_->take_snapshot();
+  ASSERT_EQ(
+    first_snapshot_written.get_future().wait_for(std::chrono::seconds(5)),
+    std::future_status::ready);
+
+  for (auto i = 0u; i < 10; ++i) {
+    writer_->write(make_test_msg());
+  }
+  writer_->take_snapshot();
+  writer_.reset();
+  EXPECT_EQ(snapshots_written, 2u);
+}
+
+TEST_F(SequentialWriterTest, statistics_count_written_messages_per_topic)
+{
+  auto sequential_writer = std::make_unique<rosbag2_cpp::writers::SequentialWriter>(
+    std::move(storage_factory_), converter_factory_, std::move(metadata_io_));
+  writer_ = std::make_unique<rosbag2_cpp::Writer>(std::move(sequential_writer));
+
+  std::string rmw_format = "rmw_format";
+  storage_options_.max_cache_size = 4000u;
+  writer_->open(storage_options_, {rmw_format, rmw_format});
+  writer_->create_topic({"test_topic", "test_msgs/BasicTypes", "", ""});
+  writer_->create_topic({"other_topic", "test_msgs/BasicTypes", "", ""});
+
+  const size_t message_count = 10;
+  size_t expected_bytes = 0;
+  const auto now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+    std::chrono::system_clock::now().time_since_epoch()).count();
+  for (size_t i = 0; i < message_count; ++i) {
+    auto message = make_test_msg();
+    message->time_stamp = now;
+    expected_bytes += message->serialized_data->buffer_length;
+    writer_->write(message);
+  }
+  // Flush the cache, so all messages are accounted as written
+  writer_->get_implementation_handle().close();
+
+  const auto statistics = writer_->get_statistics();
+  EXPECT_EQ(statistics.messages, message_count);
+  EXPECT_EQ(statistics.bytes, expected_bytes);
+  ASSERT_EQ(statistics.topics.size(), 2u);
+
+  const auto & topic_statistics = statistics.topics.at("test_topic");
+  EXPECT_EQ(topic_statistics.messages, message_count);
+  EXPECT_EQ(topic_statistics.receive_to_push.count, message_count);
+  EXPECT_EQ(topic_statistics.cache_residency.count, message_count);
+  EXPECT_EQ(topic_statistics.storage_write.count, message_count);
+  EXPECT_EQ(topic_statistics.receive_to_commit.count, message_count);
+  EXPECT_LE(topic_statistics.receive_to_push.p50, topic_statistics.receive_to_commit.max);
+  EXPECT_EQ(statistics.topics.at("other_topic").messages, 0u);
+}
+
+TEST_F(SequentialWriterTest, statistics_measure_cache_residency_from_push)
+{
+  auto sequential_writer = std::make_unique<rosbag2_cpp::writers::SequentialWriter>(
+    std::move(storage_factory_), converter_factory_, std::move(metadata_io_));
+  writer_ = std::make_unique<rosbag2_cpp::Writer>(std::move(sequential_writer));
+
+  std::string rmw_format = "rmw_format";
+  storage_options_.max_cache_size = 4000u;
+  writer_->open(storage_options_, {rmw_format, rmw_format});
+  writer_->create_topic({"test_topic", "test_msgs/BasicTypes", "", ""});
+
+  // Received long ago, e.g. replayed from a bag
+  const size_t message_count = 10;
+  for (size_t i = 0; i < message_count; ++i) {
+    auto message = make_test_msg();
+    message->time_stamp = 1;
+    writer_->write(message);
+  }
+  writer_->get_implementation_handle().close();
+
+  const auto statistics = writer_->get_statistics();
+  const auto & topic_statistics = statistics.topics.at("test_topic");
+  EXPECT_EQ(topic_statistics.cache_residency.count, message_count);
+  EXPECT_LT(
+    topic_statistics.cache_residency.max,
+    static_cast<uint64_t>(std::chrono::nanoseconds(std::chrono::seconds(10)).count()));
+  EXPECT_GT(topic_statistics.receive_to_commit.max, topic_statistics.cache_residency.max);
+}
+
+TEST_F(SequentialWriterTest, interval_statistics_reset_latencies_but_keep_totals)
+{
+  auto sequential_writer = std::make_unique<rosbag2_cpp::writers::SequentialWriter>(
+    std::move(storage_factory_), converter_factory_, std::move(metadata_io_));
+  writer_ = std::make_unique<rosbag2_cpp::Writer>(std::move(sequential_writer));
+
+  std::string rmw_format = "rmw_format";
+  writer_->open(storage_options_, {rmw_format, rmw_format});
+  writer_->create_topic({"test_topic", "test_msgs/BasicTypes", "", ""});
+
+  const size_t message_count = 5;
+  for (size_t i = 0; i < message_count; ++i) {
+    writer_->write(make_test_msg());
+  }
+
+  const auto first_interval = writer_->get_interval_statistics();
+  const auto & first_topic = first_interval.topics.at("test_topic");
+  EXPECT_EQ(first_topic.messages, message_count);
+  EXPECT_EQ(first_topic.storage_write.count, message_count);
+
+  const auto second_interval = writer_->get_interval_statistics();
+  const auto & second_topic = second_interval.topics.at("test_topic");
+  EXPECT_EQ(second_topic.messages, message_count);
+  EXPECT_EQ(second_topic.storage_write.count, 0u);
+  EXPECT_EQ(second_topic.storage_write.max, 0u);
+
+  // Latencies of a taken interval are not reported again
+  const auto statistics = writer_->get_statistics();
+  EXPECT_EQ(statistics.topics.at("test_topic").messages, message_count);
+  EXPECT_EQ(statistics.topics.at("test_topic").storage_write.count, 0u);
+}
+
+TEST_F(SequentialWriterTest, statistics_report_cache_spill_file)
+{
+  // Hold the cache consumer in the storage, so that the cache overflows into the spill file
+  std::promise<void> storage_released;
+  auto storage_release = storage_released.get_future().share();
+  ON_CALL(
+    *storage_,
+    write(An<const std::vector<std::shared_ptr<const rosbag2_storage::SerializedBagMessage>> &>())).
+  WillByDefault(
+    [storage_release](
+      const std::vector<std::shared_ptr<const rosbag2_storage::SerializedBagMessage>> &) {
+      storage_release.wait();
+    });
+
+  auto sequential_writer = std::make_unique<rosbag2_cpp::writers::SequentialWriter>(
+    std::move(storage_factory_), converter_factory_, std::move(metadata_io_));
+  writer_ = std::make_unique<rosbag2_cpp::Writer>(std::move(sequential_writer));
+
+  std::string rmw_format = "rmw_format";
+  storage_options_.max_cache_size = 20u;
+  storage_options_.max_cache_spill_size = 1024u * 1024u;
+  writer_->open(storage_options_, {rmw_format, rmw_format});
+  writer_->create_topic({"test_topic", "test_msgs/BasicTypes", "", ""});
+
+  for (size_t i = 0; i < 20; ++i) {
+    writer_->write(make_test_msg());
+  }
+  const auto statistics = writer_->get_statistics();
+  storage_released.set_value();
+  writer_.reset();
+
+  EXPECT_GT(statistics.spill_bytes, 0u);
+  EXPECT_GT(statistics.spill_bytes_pending, 0u);
+  EXPECT_LE(statistics.spill_bytes_pending, statistics.spill_bytes);
+}
+
+TEST_F(SequentialWriterTest, concurrent_writes_through_cache_are_all_written)
+{
+  std::atomic<size_t> written_messages {0};
+  ON_CALL(
+    *storage_,
+    write(An<const std::vector<std::shared_ptr<const rosbag2_storage::SerializedBagMessage>> &>())).
+  WillByDefault(
+    [&written_messages]
+      (const std::vector<std::shared_ptr<const rosbag2_storage::SerializedBagMessage>> & msgs)
+    {
+      written_messages += msgs.size();
+    });
+  ON_CALL(*metadata_io_, write_metadata).WillByDefault(
+    [this](const std::string &, const rosbag2_storage::BagMetadata & metadata) {
+      fake_metadata_ = metadata;
+    });
+
+  auto sequential_writer = std::make_unique<rosbag2_cpp::writers::SequentialWriter>(
+    std::move(storage_factory_), converter_factory_, std::move(metadata_io_));
+  writer_ = std::make_unique<rosbag2_cpp::Writer>(std::move(sequential_writer));
+
+  std::string rmw_format = "rmw_format";
+  // Large enough to never drop messages
+  storage_options_.max_cache_size = 1024u * 1024u;
+  writer_->open(storage_options_, {rmw_format, rmw_format});
+
+  const size_t threads_count = 4;
+  const size_t messages_per_thread = 250;
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < threads_count; ++i) {
+    threads.emplace_back(
+      [this, i, &rmw_format]() {
+        const std::string topic_name = "topic_" + std::to_string(i);
+        for (size_t j = 0; j < messages_per_thread; ++j) {
+          auto message = make_test_msg();
+          message->topic_name = topic_name;
+          message->time_stamp = static_cast<rcutils_time_point_value_t>(i * 1000 + j);
+          writer_->write(message, topic_name, "test_msgs/BasicTypes", rmw_format);
+        }
+      });
+  }
+  for (auto & thread : threads) {
+    thread.join();
+  }
+  writer_.reset();
+
+  EXPECT_EQ(written_messages, threads_count * messages_per_thread);
+  EXPECT_EQ(fake_metadata_.message_count, threads_count * messages_per_thread);
+  EXPECT_EQ(
+    fake_metadata_.starting_time,
+    std::chrono::high_resolution_clock::time_point(std::chrono::nanoseconds(0)));
+  EXPECT_EQ(
+    fake_metadata_.duration,
+    std::chrono::nanoseconds((threads_count - 1) * 1000 + messages_per_thread - 1));
+  ASSERT_FALSE(fake_metadata_.files.empty());
+  EXPECT_EQ(fake_metadata_.files.back().message_count, threads_count * messages_per_thread);
+}
+
+TEST_F(SequentialWriterTest, metadata_is_checkpointed_on_split)
+{
+  std::vector<rosbag2_storage::BagMetadata> written_metadata;
+  ON_CALL(*metadata_io_, write_metadata).WillByDefault(
+    [&written_metadata](const std::string &, const rosbag2_storage::BagMetadata & metadata) {
+      written_metadata.push_back(metadata);
+    });
+  ON_CALL(*storage_, get_bagfile_size_estimate).WillByDefault(
+    [this]() {
+      return fake_storage_size_.load();
+    });
+  ON_CALL(
+    *storage_,
+    write(An<std::shared_ptr<const rosbag2_storage::SerializedBagMessage>>())).WillByDefault(
+    [this](std::shared_ptr<const rosbag2_storage::SerializedBagMessage>) {
+      fake_storage_size_++;
+    });
+  ON_CALL(*storage_, get_relative_file_path).WillByDefault(
+    [this]() {
+      return fake_storage_uri_;
+    });
+
+  auto sequential_writer = std::make_unique<rosbag2_cpp::writers::SequentialWriter>(
+    std::move(storage_factory_), converter_factory_, std::move(metadata_io_));
+  writer_ = std::make_unique<rosbag2_cpp::Writer>(std::move(sequential_writer));
+
+  // Long enough not to checkpoint periodically during the test
+  storage_options_.metadata_checkpoint_interval = 3600;
+  storage_options_.max_bagfile_size = 5;
+  writer_->open(storage_options_, {"rmw_format", "rmw_format"});
+  writer_->create_topic({"test_topic", "test_msgs/BasicTypes", "", ""});
+
+  for (int i = 0; i < 7; ++i) {
+    auto message = make_test_msg();
+    message->time_stamp = i;
+    writer_->write(message);
+  }
+
+  // Written on the split, before the bag was closed
+  ASSERT_THAT(written_metadata, SizeIs(1));
+  EXPECT_THAT(written_metadata[0].relative_file_paths, SizeIs(2));
+  EXPECT_EQ(written_metadata[0].message_count, 5u);
+  ASSERT_THAT(written_metadata[0].files, SizeIs(2));
+  EXPECT_EQ(written_metadata[0].files[0].message_count, 5u);
+
+  writer_.reset();
+  ASSERT_THAT(written_metadata, SizeIs(2));
+  EXPECT_EQ(written_metadata[1].message_count, 7u);
+}
+
+TEST_F(SequentialWriterTest, metadata_is_checkpointed_periodically)
+{
+  std::mutex written_metadata_mutex;
+  std::vector<rosbag2_storage::BagMetadata> written_metadata;
+  ON_CALL(*metadata_io_, write_metadata).WillByDefault(
+    [&](const std::string &, const rosbag2_storage::BagMetadata & metadata) {
+      std::lock_guard<std::mutex> lock(written_metadata_mutex);
+      written_metadata.push_back(metadata);
+    });
+
+  auto sequential_writer = std::make_unique<rosbag2_cpp::writers::SequentialWriter>(
+    std::move(storage_factory_), converter_factory_, std::move(metadata_io_));
+  writer_ = std::make_unique<rosbag2_cpp::Writer>(std::move(sequential_writer));
+
+  storage_options_.metadata_checkpoint_interval = 1;
+  writer_->open(storage_options_, {"rmw_format", "rmw_format"});
+  writer_->create_topic({"test_topic", "test_msgs/BasicTypes", "", ""});
+  writer_->write(make_test_msg());
+
+  const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+  bool checkpointed = false;
+  while (!checkpointed && std::chrono::steady_clock::now() < deadline) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    std::lock_guard<std::mutex> lock(written_metadata_mutex);
+    checkpointed = !written_metadata.empty();
+  }
+  ASSERT_TRUE(checkpointed);
+  {
+    std::lock_guard<std::mutex> lock(written_metadata_mutex);
+    EXPECT_EQ(written_metadata.front().message_count, 1u);
+    EXPECT_THAT(written_metadata.front().topics_with_message_count, SizeIs(1));
+  }
+
+  writer_.reset();
+}
+
+TEST_F(SequentialWriterTest, writes_go_on_while_periodic_checkpoint_is_written)
+{
+  std::promise<void> checkpoint_started;
+  std::promise<void> release_checkpoint;
+  auto checkpoint_released = release_checkpoint.get_future().share();
+  std::atomic<bool> first_checkpoint {true};
+  ON_CALL(*metadata_io_, write_metadata).WillByDefault(
+    [&](const std::string &, const rosbag2_storage::BagMetadata &) {
+      if (first_checkpoint.exchange(false)) {
+        checkpoint_started.set_value();
+        checkpoint_released.wait();
+      }
+    });
+
+  auto sequential_writer = std::make_unique<rosbag2_cpp::writers::SequentialWriter>(
+    std::move(storage_factory_), converter_factory_, std::move(metadata_io_));
+  writer_ = std::make_unique<rosbag2_cpp::Writer>(std::move(sequential_writer));
+
+  storage_options_.metadata_checkpoint_interval = 1;
+  writer_->open(storage_options_, {"rmw_format", "rmw_format"});
+  writer_->create_topic({"test_topic", "test_msgs/BasicTypes", "", ""});
+
+  ASSERT_EQ(
+    checkpoint_started.get_future().wait_for(std::chrono::seconds(10)),
+    std::future_status::ready);
+  // The checkpoint file is being written, writing messages must not wait for it
+  auto write = std::async(
+    std::launch::async, [this]() {
+      writer_->write(make_test_msg());
+    });
+  EXPECT_EQ(write.wait_for(std::chrono::seconds(5)), std::future_status::ready);
+
+  release_checkpoint.set_value();
+  write.get();
+  writer_.reset();
+}
+
 TEST_F(SequentialWriterTest, snapshot_mode_zero_cache_size_throws_exception)
 {
   storage_options_.max_bagfile_size = 0;
@@ -519,7 +891,7 @@ TEST_F(SequentialWriterTest, split_event_calls_callback)
       fake_storage_size_ += 1;
     });
 
-  ON_CALL(*storage_, get_bagfile_size).WillByDefault(
+  ON_CALL(*storage_, get_bagfile_size_estimate).WillByDefault(
     [this]() {
       return fake_storage_size_.load();
     });
@@ -0,0 +1,211 @@
+// Copyright 2022, Open Source Robotics Corporation.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gmock/gmock.h>
+
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "rcpputils/filesystem_helper.hpp"
+
+#include "rosbag2_cpp/writers/sharded_writer.hpp"
+
+#include "rosbag2_storage/bag_metadata.hpp"
+#include "rosbag2_storage/ros_helper.hpp"
+#include "rosbag2_storage/topic_metadata.hpp"
+
+#include "rosbag2_test_common/temporary_directory_fixture.hpp"
+
+#include "mock_converter_factory.hpp"
+#include "mock_metadata_io.hpp"
+#include "mock_storage.hpp"
+#include "mock_storage_factory.hpp"
+
+using namespace testing;  // NOLINT
+using rosbag2_test_common::TemporaryDirectoryFixture;
+
+class ShardedWriterTest : public TemporaryDirectoryFixture
+{
+public:
+  ShardedWriterTest()
+  {
+    storage_options_.uri = (rcpputils::fs::path(temporary_dir_path_) / "bag").string();
+    auto metadata_io = std::make_unique<NiceMock<MockMetadataIo>>();
+    ON_CALL(*metadata_io, write_metadata(_, _)).WillByDefault(
+      [this](const std::string & uri, const rosbag2_storage::BagMetadata & metadata) {
+        written_metadata_uri_ = uri;
+        written_metadata_ = metadata;
+      });
+
+    writer_ = std::make_unique<rosbag2_cpp::writers::ShardedWriter>(
+      2u,
+      [this]() {return make_storage_factory();},
+      std::make_shared<StrictMock<MockConverterFactory>>(),
+      std::move(metadata_io));
+  }
+
+  ~ShardedWriterTest() override
+  {
+    // Closing writes the metadata into members of the fixture
+    writer_.reset();
+  }
+
+  std::unique_ptr<rosbag2_storage::StorageFactoryInterface> make_storage_factory()
+  {
+    auto storage = std::make_shared<NiceMock<MockStorage>>();
+    storages_.push_back(storage);
+    created_topics_.emplace_back();
+    written_messages_.emplace_back();
+    const size_t shard = storages_.size() - 1;
+
+    ON_CALL(*storage, create_topic(_)).WillByDefault(
+      [this, shard](const rosbag2_storage::TopicMetadata & topic) {
+        created_topics_[shard].push_back(topic.name);
+      });
+    ON_CALL(*storage, write(An<std::shared_ptr<const rosbag2_storage::SerializedBagMessage>>()))
+    .WillByDefault(
+      [this, shard](std::shared_ptr<const rosbag2_storage::SerializedBagMessage> message) {
+        written_messages_[shard].push_back(message->topic_name);
+      });
+
+    auto storage_factory = std::make_unique<NiceMock<MockStorageFactory>>();
+    ON_CALL(*storage_factory, open_read_write(_)).WillByDefault(
+      [storage](const rosbag2_storage::StorageOptions & storage_options) {
+        const auto file_name =
+          rcpputils::fs::path(storage_options.uri).filename().string() + ".db3";
+        ON_CALL(*storage, get_relative_file_path()).WillByDefault(Return(file_name));
+        return storage;
+      });
+    return storage_factory;
+  }
+
+  void create_topic(const std::string & name)
+  {
+    writer_->create_topic({name, "test_msgs/BasicTypes", "rmw_format", ""});
+  }
+
+  void write(const std::string & topic_name, rcutils_time_point_value_t time_stamp)
+  {
+    auto message = std::make_shared<rosbag2_storage::SerializedBagMessage>();
+    message->topic_name = topic_name;
+    message->time_stamp = time_stamp;
+    message->serialized_data = rosbag2_storage::make_serialized_message("Hello", 5);
+    writer_->write(message);
+  }
+
+  rosbag2_storage::StorageOptions storage_options_;
+  std::unique_ptr<rosbag2_cpp::writers::ShardedWriter> writer_;
+  std::vector<std::shared_ptr<NiceMock<MockStorage>>> storages_;
+  std::vector<std::vector<std::string>> created_topics_;
+  std::vector<std::vector<std::string>> written_messages_;
+  std::string written_metadata_uri_;
+  rosbag2_storage::BagMetadata written_metadata_;
+};
+
+TEST_F(ShardedWriterTest, topics_are_spread_evenly_over_shards) {
+  writer_->open(storage_options_, {"rmw_format", "rmw_format"});
+  ASSERT_THAT(storages_, SizeIs(2));
+
+  create_topic("topic_a");
+  create_topic("topic_b");
+  create_topic("topic_c");
+  create_topic("topic_d");
+  create_topic("topic_a");
+
+  EXPECT_THAT(created_topics_[0], ElementsAre("topic_a", "topic_c"));
+  EXPECT_THAT(created_topics_[1], ElementsAre("topic_b", "topic_d"));
+}
+
+TEST_F(ShardedWriterTest, messages_are_written_to_the_shard_of_their_topic) {
+  writer_->open(storage_options_, {"rmw_format", "rmw_format"});
+  create_topic("topic_a");
+  create_topic("topic_b");
+
+  write("topic_a", 1);
+  write("topic_b", 2);
+  write("topic_a", 3);
+
+  EXPECT_THAT(written_messages_[0], ElementsAre("topic_a", "topic_a"));
+  EXPECT_THAT(written_messages_[1], ElementsAre("topic_b"));
+}
+
+TEST_F(ShardedWriterTest, write_to_unknown_topic_throws) {
+  writer_->open(storage_options_, {"rmw_format", "rmw_format"});
+
+  EXPECT_THROW(write("topic_a", 1), std::runtime_error);
+}
+
+TEST_F(ShardedWriterTest, shards_are_opened_in_subfolders_of_the_bag) {
+  writer_->open(storage_options_, {"rmw_format", "rmw_format"});
+
+  const rcpputils::fs::path bag_path(storage_options_.uri);
+  EXPECT_TRUE((bag_path / rosbag2_cpp::writers::ShardedWriter::shard_folder_name(0)).exists());
+  EXPECT_TRUE((bag_path / rosbag2_cpp::writers::ShardedWriter::shard_folder_name(1)).exists());
+}
+
+TEST_F(ShardedWriterTest, close_writes_metadata_merged_from_all_shards) {
+  storage_options_.custom_data["name"] = "value";
+  writer_->open(storage_options_, {"rmw_format", "rmw_format"});
+  create_topic("topic_a");
+  create_topic("topic_b");
+
+  write("topic_a", 100);
+  write("topic_b", 50);
+  write("topic_a", 300);
+  writer_->close();
+
+  EXPECT_EQ(written_metadata_uri_, storage_options_.uri);
+  EXPECT_EQ(written_metadata_.message_count, 3u);
+  EXPECT_EQ(
+    written_metadata_.starting_time.time_since_epoch(), std::chrono::nanoseconds(50));
+  EXPECT_EQ(written_metadata_.duration, std::chrono::nanoseconds(250));
+  EXPECT_THAT(written_metadata_.topics_with_message_count, SizeIs(2));
+  EXPECT_EQ(written_metadata_.custom_data["name"], "value");
+
+  const auto shard_0_file =
+    (rcpputils::fs::path("shard_0") / "shard_0_0.db3").string();
+  const auto shard_1_file =
+    (rcpputils::fs::path("shard_1") / "shard_1_0.db3").string();
+  EXPECT_THAT(written_metadata_.relative_file_paths, ElementsAre(shard_0_file, shard_1_file));
+  ASSERT_THAT(written_metadata_.files, SizeIs(2));
+  EXPECT_EQ(written_metadata_.files[0].path, shard_0_file);
+  EXPECT_EQ(written_metadata_.files[0].shard, 0u);
+  EXPECT_EQ(written_metadata_.files[0].message_count, 2u);
+  EXPECT_EQ(written_metadata_.files[1].path, shard_1_file);
+  EXPECT_EQ(written_metadata_.files[1].shard, 1u);
+  EXPECT_EQ(written_metadata_.files[1].message_count, 1u);
+}
+
+TEST_F(ShardedWriterTest, shard_checkpoints_write_merged_metadata) {
+  storage_options_.metadata_checkpoint_interval = 3600;
+  storage_options_.max_bagfile_size = 2;
+  writer_->open(storage_options_, {"rmw_format", "rmw_format"});
+  create_topic("topic_a");
+  create_topic("topic_b");
+  for (auto & storage : storages_) {
+    ON_CALL(*storage, get_bagfile_size_estimate()).WillByDefault(Return(2u));
+  }
+
+  write("topic_a", 100);
+  write("topic_a", 200);
+
+  // Splitting shard 0 checkpoints its metadata, merged with the one of shard 1
+  EXPECT_EQ(written_metadata_uri_, storage_options_.uri);
+  EXPECT_THAT(written_metadata_.relative_file_paths, SizeIs(3));
+  EXPECT_EQ(written_metadata_.message_count, 1u);
+}
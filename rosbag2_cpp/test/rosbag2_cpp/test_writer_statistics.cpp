@@ -0,0 +1,128 @@
+// Copyright 2022, Open Source Robotics Corporation.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gmock/gmock.h>
+
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "rosbag2_cpp/writer_statistics.hpp"
+
+using namespace testing;  // NOLINT
+
+TEST(LatencyHistogramTest, empty_histogram_has_zero_summary)
+{
+  rosbag2_cpp::LatencyHistogram histogram;
+  const auto summary = histogram.summarize();
+  EXPECT_EQ(summary.count, 0u);
+  EXPECT_EQ(summary.p50, 0u);
+  EXPECT_EQ(summary.p99, 0u);
+  EXPECT_EQ(summary.max, 0u);
+}
+
+TEST(LatencyHistogramTest, small_values_are_exact)
+{
+  rosbag2_cpp::LatencyHistogram histogram;
+  for (int64_t value = 0; value < 8; ++value) {
+    histogram.record(std::chrono::nanoseconds(value));
+  }
+  const auto summary = histogram.summarize();
+  EXPECT_EQ(summary.count, 8u);
+  EXPECT_EQ(summary.p50, 3u);
+  EXPECT_EQ(summary.p90, 7u);
+  EXPECT_EQ(summary.max, 7u);
+}
+
+TEST(LatencyHistogramTest, percentiles_are_within_bucket_precision)
+{
+  rosbag2_cpp::LatencyHistogram histogram;
+  for (int64_t value = 1; value <= 1000; ++value) {
+    histogram.record(std::chrono::microseconds(value));
+  }
+  const auto summary = histogram.summarize();
+  EXPECT_EQ(summary.count, 1000u);
+  EXPECT_EQ(summary.max, 1000000u);
+
+  // Buckets split every power of two in 8, reported values overestimate by less than 1/8
+  auto expect_close = [](uint64_t actual, uint64_t expected) {
+      EXPECT_GE(actual, expected);
+      EXPECT_LE(actual, expected + expected / 8);
+    };
+  expect_close(summary.p50, 500000u);
+  expect_close(summary.p90, 900000u);
+  expect_close(summary.p99, 990000u);
+}
+
+TEST(LatencyHistogramTest, negative_latencies_are_clamped_to_zero)
+{
+  rosbag2_cpp::LatencyHistogram histogram;
+  histogram.record(std::chrono::nanoseconds(-10));
+  const auto summary = histogram.summarize();
+  EXPECT_EQ(summary.count, 1u);
+  EXPECT_EQ(summary.max, 0u);
+}
+
+TEST(LatencyHistogramTest, records_from_multiple_threads)
+{
+  rosbag2_cpp::LatencyHistogram histogram;
+  const size_t threads_count = 4;
+  const size_t records_per_thread = 10000;
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < threads_count; ++i) {
+    threads.emplace_back(
+      [&histogram, i]() {
+        for (size_t j = 0; j < records_per_thread; ++j) {
+          histogram.record(std::chrono::nanoseconds(i * records_per_thread + j));
+        }
+      });
+  }
+  for (auto & thread : threads) {
+    thread.join();
+  }
+  const auto summary = histogram.summarize();
+  EXPECT_EQ(summary.count, threads_count * records_per_thread);
+  EXPECT_EQ(summary.max, threads_count * records_per_thread - 1);
+}
+
+TEST(TopicWriteStatisticsCollectorTest, ignores_messages_received_in_the_future)
+{
+  rosbag2_cpp::TopicWriteStatisticsCollector collector;
+  const auto now = rosbag2_cpp::TopicWriteStatisticsCollector::system_now();
+  rosbag2_cpp::TopicWriteStatisticsCollector::record_since_receive(
+    collector.receive_to_push, now + 1000, now);
+  rosbag2_cpp::TopicWriteStatisticsCollector::record_since_receive(
+    collector.receive_to_push, now - 1000, now);
+  const auto statistics = collector.summarize();
+  EXPECT_EQ(statistics.receive_to_push.count, 1u);
+  EXPECT_EQ(statistics.receive_to_push.max, 1000u);
+}
+
+TEST(LatencyHistogramTest, reset_starts_a_new_interval)
+{
+  rosbag2_cpp::LatencyHistogram histogram;
+  for (int64_t value = 1; value <= 100; ++value) {
+    histogram.record(std::chrono::microseconds(value));
+  }
+  const auto first_interval = histogram.summarize_and_reset();
+  EXPECT_EQ(first_interval.count, 100u);
+  EXPECT_EQ(first_interval.max, 100000u);
+  EXPECT_EQ(histogram.summarize().count, 0u);
+
+  histogram.record(std::chrono::nanoseconds(5));
+  const auto second_interval = histogram.summarize_and_reset();
+  EXPECT_EQ(second_interval.count, 1u);
+  EXPECT_EQ(second_interval.p99, 5u);
+  EXPECT_EQ(second_interval.max, 5u);
+}
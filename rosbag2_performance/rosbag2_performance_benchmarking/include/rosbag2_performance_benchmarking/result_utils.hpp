@@ -15,6 +15,7 @@
 #ifndef ROSBAG2_PERFORMANCE_BENCHMARKING__RESULT_UTILS_HPP_
 #define ROSBAG2_PERFORMANCE_BENCHMARKING__RESULT_UTILS_HPP_
 
+#include <cstdint>
 #include <string>
 #include <vector>
 
@@ -28,6 +29,9 @@ namespace result_utils
 /// Read total count of recorded messages from metadata.yaml file
 int get_message_count_from_metadata(const std::string & uri);
 
+/// Sum the sizes of the files of the bag listed in its metadata.yaml file
+uint64_t get_bag_size_from_metadata(const std::string & uri);
+
 /// Based on configuration and metadata from completed benchmark, write results
 void write_benchmark_results(
   const std::vector<PublisherGroupConfig> & publisher_groups_config,
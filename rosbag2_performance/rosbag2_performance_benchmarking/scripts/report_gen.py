@@ -78,6 +78,7 @@ class PostprocessStorageConfig(Postprocess):
                            max_bagfile_size_selected):
             for storage_cfg_name, data in splitted_data.items():
                 cache_samples = {}
+                cache_ratio_samples = {}
                 for sample in data:
                     # Single sample contains multiple rows
                     if len(sample) != len(producers_config_publishers['publisher_groups']):
@@ -96,15 +97,27 @@ class PostprocessStorageConfig(Postprocess):
 
                     if sample[0]['cache_size'] not in cache_samples.keys():
                         cache_samples.update({sample[0]['cache_size']: []})
+                        cache_ratio_samples.update({sample[0]['cache_size']: []})
 
                     # TODO(piotr.jaroszek) WARNING, currently results in 'total_produced' column
                     # are correct (per publisher group), but 'total_recorded' is already summed
                     # for all the publisher groups!
                     sample_total_produced = 0
+                    sample_total_produced_bytes = 0
                     for row in sample:
                         sample_total_produced += int(row['total_produced'])
-                    cache_samples[sample[0]['cache_size']].append(
-                        int(sample[0]['total_recorded_count'])/sample_total_produced)
+                        sample_total_produced_bytes += \
+                            int(row['total_produced']) * int(row['message_size'])
+                    recorded_fraction = \
+                        int(sample[0]['total_recorded_count'])/sample_total_produced
+                    cache_samples[sample[0]['cache_size']].append(recorded_fraction)
+
+                    # Ratio of the recorded data to the size of the bag, which includes the
+                    # overhead of the storage. Results of older versions have no bag size.
+                    bag_size = int(sample[0].get('bag_size') or 0)
+                    if bag_size > 0:
+                        cache_ratio_samples[sample[0]['cache_size']].append(
+                            sample_total_produced_bytes * recorded_fraction / bag_size)
 
                 cache_recorded_percentage_stats = {
                     cache: {
@@ -114,6 +127,10 @@ class PostprocessStorageConfig(Postprocess):
                     }
                     for cache, samples in cache_samples.items()
                 }
+                for cache, samples in cache_ratio_samples.items():
+                    if samples:
+                        cache_recorded_percentage_stats[cache]['ratio'] = \
+                            statistics.mean(samples)
                 cache_data_per_storage_conf.update(
                     {storage_cfg_name: cache_recorded_percentage_stats}
                 )
@@ -144,6 +161,9 @@ class PostprocessStorageConfig(Postprocess):
                         percent_recorded['min'],
                         percent_recorded['avg'],
                         percent_recorded['max']))
+                    if 'ratio' in percent_recorded:
+                        print('\t\t\t\tcompression ratio, average: {:.2f}'.format(
+                            percent_recorded['ratio']))
 
         [
             __process_test(
@@ -0,0 +1,170 @@
+// Copyright 2022, Open Source Robotics Corporation.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Measures the time and the heap allocations per message of compressing and decompressing
+// messages of typical sizes with a compression plugin, without any storage involved.
+//
+// Usage: compression_benchmark [compression_formats] [iterations]
+// where compression_formats is a comma separated list, e.g. "zstd,lz4" to compare both.
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "rosbag2_compression/compression_factory.hpp"
+#include "rosbag2_storage/ros_helper.hpp"
+#include "rosbag2_storage/serialized_bag_message.hpp"
+
+namespace
+{
+std::atomic<uint64_t> allocation_count{0};
+}  // namespace
+
+void * operator new(std::size_t size)
+{
+  allocation_count.fetch_add(1, std::memory_order_relaxed);
+  if (void * pointer = std::malloc(size == 0 ? 1 : size)) {
+    return pointer;
+  }
+  throw std::bad_alloc();
+}
+
+void operator delete(void * pointer) noexcept
+{
+  std::free(pointer);
+}
+
+void operator delete(void * pointer, std::size_t) noexcept
+{
+  std::free(pointer);
+}
+
+namespace
+{
+struct Result
+{
+  double ns_per_message;
+  double allocations_per_message;
+
+  double megabytes_per_second(size_t message_size) const
+  {
+    return static_cast<double>(message_size) * 1e3 / ns_per_message;
+  }
+};
+
+// Sensor-like data: slowly changing values with some noise, which compresses moderately well.
+std::vector<uint8_t> make_payload(size_t size)
+{
+  std::mt19937 generator(42);
+  std::uniform_int_distribution<int> noise(0, 255);
+  std::vector<uint8_t> payload(size);
+  for (size_t i = 0; i < size; i++) {
+    // Every fourth byte is noise, like the low bytes of measurements.
+    payload[i] = static_cast<uint8_t>(i % 4 == 0 ? noise(generator) : (i / 256) % 256);
+  }
+  return payload;
+}
+
+template<typename Function>
+Result measure(size_t iterations, Function && function)
+{
+  // Warm up, so that contexts and reused buffers are in place before measuring.
+  for (size_t i = 0; i < 10; i++) {
+    function();
+  }
+  const auto allocations_before = allocation_count.load();
+  const auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < iterations; i++) {
+    function();
+  }
+  const auto end = std::chrono::steady_clock::now();
+  const auto allocations = allocation_count.load() - allocations_before;
+  const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+  return {
+    static_cast<double>(ns) / static_cast<double>(iterations),
+    static_cast<double>(allocations) / static_cast<double>(iterations)};
+}
+
+void run_benchmark(
+  rosbag2_compression::CompressionFactory & factory,
+  const std::string & compression_format,
+  size_t iterations)
+{
+  auto compressor = factory.create_compressor(compression_format);
+  auto decompressor = factory.create_decompressor(compression_format);
+
+  for (const size_t size : {size_t{1024}, size_t{64 * 1024}, size_t{1024 * 1024}}) {
+    const auto payload = make_payload(size);
+    rosbag2_storage::SerializedBagMessage message;
+    message.topic_name = "/benchmark";
+    message.serialized_data = rosbag2_storage::make_serialized_message(payload.data(), size);
+
+    // Like the writer, every compressed message is released before the next one is compressed.
+    rosbag2_storage::SerializedBagMessage compressed_message;
+    compressed_message.topic_name = message.topic_name;
+    const auto compress = measure(
+      iterations, [&] {
+        compressed_message.serialized_data.reset();
+        compressor->compress_serialized_bag_message(&message, &compressed_message);
+      });
+    const auto compressed_size = compressed_message.serialized_data->buffer_length;
+
+    // Like the reader, every decompressed message is released before the next one is read.
+    rosbag2_storage::SerializedBagMessage decompressed_message;
+    const auto decompress = measure(
+      iterations, [&] {
+        decompressed_message.serialized_data.reset();
+        decompressed_message.serialized_data = rosbag2_storage::make_serialized_message(
+          compressed_message.serialized_data->buffer, compressed_size);
+        decompressor->decompress_serialized_bag_message(&decompressed_message);
+      });
+
+    std::printf(
+      "%-8s %8zu %12.0f %10.1f %16.2f %14.0f %12.1f %18.2f %7.2f\n",
+      compression_format.c_str(), size,
+      compress.ns_per_message, compress.megabytes_per_second(size),
+      compress.allocations_per_message,
+      decompress.ns_per_message, decompress.megabytes_per_second(size),
+      decompress.allocations_per_message,
+      static_cast<double>(size) / static_cast<double>(compressed_size));
+  }
+}
+}  // namespace
+
+int main(int argc, char ** argv)
+{
+  const std::string compression_formats = argc > 1 ? argv[1] : "zstd";
+  const size_t iterations = argc > 2 ? std::stoul(argv[2]) : 1000u;
+
+  rosbag2_compression::CompressionFactory factory;
+  std::printf(
+    "%-8s %8s %12s %10s %16s %14s %12s %18s %7s\n", "format", "size", "compress ns",
+    "MB/s", "compress allocs", "decompress ns", "MB/s", "decompress allocs", "ratio");
+  std::stringstream formats(compression_formats);
+  std::string compression_format;
+  while (std::getline(formats, compression_format, ',')) {
+    run_benchmark(factory, compression_format, iterations);
+  }
+  std::printf(
+    "Decompression allocations include the two of copying the compressed message, "
+    "which a storage plugin makes when reading it.\n");
+  return 0;
+}
@@ -0,0 +1,118 @@
+// Copyright 2022, Open Source Robotics Corporation.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Measures the throughput of compressing and decompressing whole files with a compression plugin,
+// as done in FILE compression mode for every split of a bag.
+//
+// Usage: file_compression_benchmark [compression_formats] [file_size_mib] [iterations] [directory]
+// where compression_formats is a comma separated list, e.g. "zstd,lz4" to compare both.
+// The file is written to directory, the temporary directory by default; pick one on the disk the
+// bags are recorded to, since the throughput depends on it for files larger than the page cache.
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "rcpputils/filesystem_helper.hpp"
+
+#include "rosbag2_compression/compression_factory.hpp"
+
+namespace
+{
+// Sensor-like data: slowly changing values with some noise, which compresses moderately well.
+void write_file(const std::string & uri, uint64_t size_mib)
+{
+  std::mt19937 generator(42);
+  std::uniform_int_distribution<int> noise(0, 255);
+  std::vector<char> block(1024 * 1024);
+  std::ofstream output(uri, std::ios::out | std::ios::binary);
+  for (uint64_t mib = 0; mib < size_mib; mib++) {
+    for (size_t i = 0; i < block.size(); i++) {
+      block[i] = static_cast<char>(i % 4 == 0 ? noise(generator) : (mib + i / 256) % 256);
+    }
+    output.write(block.data(), static_cast<std::streamsize>(block.size()));
+  }
+  if (!output) {
+    throw std::runtime_error("Failed to write " + uri);
+  }
+}
+
+double seconds_since(std::chrono::steady_clock::time_point start)
+{
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+void run_benchmark(
+  rosbag2_compression::CompressionFactory & factory,
+  const std::string & compression_format,
+  uint64_t size_mib,
+  size_t iterations,
+  const rcpputils::fs::path & directory)
+{
+  auto compressor = factory.create_compressor(compression_format);
+  auto decompressor = factory.create_decompressor(compression_format);
+  const auto uri = (directory / "file_compression_benchmark.db3").string();
+  const auto megabytes = static_cast<double>(size_mib) * 1024 * 1024 / 1e6;
+
+  for (size_t i = 0; i < iterations; i++) {
+    write_file(uri, size_mib);
+
+    // Like the writer, the uncompressed file is removed once it has been compressed.
+    auto start = std::chrono::steady_clock::now();
+    const auto compressed_uri = compressor->compress_uri(uri);
+    const auto compress_seconds = seconds_since(start);
+    rcpputils::fs::remove(rcpputils::fs::path{uri});
+    const auto compressed_size = rcpputils::fs::file_size(rcpputils::fs::path{compressed_uri});
+
+    start = std::chrono::steady_clock::now();
+    const auto decompressed_uri = decompressor->decompress_uri(compressed_uri);
+    const auto decompress_seconds = seconds_since(start);
+    rcpputils::fs::remove(rcpputils::fs::path{decompressed_uri});
+    rcpputils::fs::remove(rcpputils::fs::path{compressed_uri});
+
+    std::printf(
+      "%-8s %10llu %12.2f %10.1f %14.2f %10.1f %7.2f\n",
+      compression_format.c_str(), static_cast<unsigned long long>(size_mib),  // NOLINT
+      compress_seconds, megabytes / compress_seconds,
+      decompress_seconds, megabytes / decompress_seconds,
+      static_cast<double>(size_mib) * 1024 * 1024 / static_cast<double>(compressed_size));
+  }
+}
+}  // namespace
+
+int main(int argc, char ** argv)
+{
+  const std::string compression_formats = argc > 1 ? argv[1] : "zstd";
+  const uint64_t size_mib = argc > 2 ? std::stoull(argv[2]) : 2048u;
+  const size_t iterations = argc > 3 ? std::stoul(argv[3]) : 3u;
+  const auto directory = argc > 4 ?
+    rcpputils::fs::path(argv[4]) : rcpputils::fs::temp_directory_path();
+
+  rosbag2_compression::CompressionFactory factory;
+  std::printf(
+    "%-8s %10s %12s %10s %14s %10s %7s\n", "format", "size MiB", "compress s", "MB/s",
+    "decompress s", "MB/s", "ratio");
+  std::stringstream formats(compression_formats);
+  std::string compression_format;
+  while (std::getline(formats, compression_format, ',')) {
+    run_benchmark(factory, compression_format, size_mib, iterations, directory);
+  }
+  return 0;
+}
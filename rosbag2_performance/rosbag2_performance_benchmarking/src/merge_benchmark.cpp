@@ -0,0 +1,137 @@
+// Copyright 2022, Open Source Robotics Corporation.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Measures merging the messages of many inputs in timestamp order, as done by bag_rewrite for
+// several input bags and by the reader for bags recorded with several storage shards.
+// Inputs are held in memory, so only the cost of merging is measured.
+//
+// Usage: merge_benchmark [inputs] [messages_per_input] [iterations]
+
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "rosbag2_cpp/message_merger.hpp"
+
+namespace
+{
+using Message = rosbag2_cpp::MessageMerger::Message;
+
+struct Input
+{
+  std::vector<Message> messages;
+  size_t position = 0;
+
+  Message read_next()
+  {
+    return position < messages.size() ? messages[position++] : nullptr;
+  }
+};
+
+// Inputs recorded at the same time: every input has messages throughout the whole duration.
+std::vector<Input> make_inputs(size_t num_inputs, size_t messages_per_input)
+{
+  std::mt19937 generator(42);
+  std::uniform_int_distribution<rcutils_time_point_value_t> period(1000, 100000);
+  std::vector<Input> inputs(num_inputs);
+  for (size_t i = 0; i < num_inputs; i++) {
+    rcutils_time_point_value_t time_stamp = 0;
+    for (size_t j = 0; j < messages_per_input; j++) {
+      auto message = std::make_shared<rosbag2_storage::SerializedBagMessage>();
+      time_stamp += period(generator);
+      message->time_stamp = time_stamp;
+      message->topic_name = "/topic_" + std::to_string(i);
+      inputs[i].messages.push_back(message);
+    }
+  }
+  return inputs;
+}
+
+void rewind(std::vector<Input> & inputs)
+{
+  for (auto & input : inputs) {
+    input.position = 0;
+  }
+}
+
+// The merge bag_rewrite did before: scan the next message of every input for the oldest one.
+size_t merge_with_linear_scan(std::vector<Input> & inputs)
+{
+  std::vector<Message> next_messages(inputs.size());
+  size_t count = 0;
+  while (true) {
+    size_t earliest = inputs.size();
+    for (size_t i = 0; i < inputs.size(); i++) {
+      if (!next_messages[i]) {
+        next_messages[i] = inputs[i].read_next();
+      }
+      if (next_messages[i] &&
+        (earliest == inputs.size() ||
+        next_messages[i]->time_stamp < next_messages[earliest]->time_stamp))
+      {
+        earliest = i;
+      }
+    }
+    if (earliest == inputs.size()) {
+      return count;
+    }
+    next_messages[earliest].reset();
+    count++;
+  }
+}
+
+size_t merge_with_message_merger(std::vector<Input> & inputs)
+{
+  rosbag2_cpp::MessageMerger merger(
+    inputs.size(), [&inputs](size_t input) {return inputs[input].read_next();});
+  size_t count = 0;
+  while (merger.has_next()) {
+    merger.read_next();
+    count++;
+  }
+  return count;
+}
+
+template<typename Merge>
+void run_benchmark(
+  const char * name, Merge merge, std::vector<Input> & inputs, size_t iterations)
+{
+  for (size_t i = 0; i < iterations; i++) {
+    rewind(inputs);
+    const auto start = std::chrono::steady_clock::now();
+    const auto count = merge(inputs);
+    const auto seconds =
+      std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::printf(
+      "%-8s %8zu %12zu %10.3f %14.1f\n", name, inputs.size(), count, seconds,
+      static_cast<double>(count) / seconds / 1e6);
+  }
+}
+}  // namespace
+
+int main(int argc, char ** argv)
+{
+  const size_t num_inputs = argc > 1 ? std::stoul(argv[1]) : 100u;
+  const size_t messages_per_input = argc > 2 ? std::stoul(argv[2]) : 20000u;
+  const size_t iterations = argc > 3 ? std::stoul(argv[3]) : 3u;
+
+  auto inputs = make_inputs(num_inputs, messages_per_input);
+  std::printf("%-8s %8s %12s %10s %14s\n", "merge", "inputs", "messages", "seconds", "M msgs/s");
+  run_benchmark("linear", merge_with_linear_scan, inputs, iterations);
+  run_benchmark("heap", merge_with_message_merger, inputs, iterations);
+  return 0;
+}
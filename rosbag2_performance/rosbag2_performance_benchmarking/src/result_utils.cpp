@@ -20,6 +20,8 @@
 #include <string>
 #include <vector>
 
+#include "rcpputils/filesystem_helper.hpp"
+
 #include "rosbag2_storage/storage_options.hpp"
 #include "rosbag2_storage/metadata_io.hpp"
 #include "rosbag2_storage/yaml.hpp"
@@ -49,6 +51,30 @@ int get_message_count_from_metadata(const std::string & uri)
   return total_recorded_count;
 }
 
+/// Sum the sizes of the files of the bag listed in its metadata.yaml file
+uint64_t get_bag_size_from_metadata(const std::string & uri)
+{
+  uint64_t bag_size = 0;
+  std::string metadata_path = uri + "/" + rosbag2_storage::MetadataIo::metadata_filename;
+  try {
+    YAML::Node yaml_file = YAML::LoadFile(metadata_path);
+    for (const auto & file : yaml_file["rosbag2_bagfile_information"]["relative_file_paths"]) {
+      // Older bags list the paths relative to the parent directory of the bag.
+      const auto path =
+        rcpputils::fs::path(uri) / rcpputils::fs::path(file.as<std::string>()).filename();
+      if (path.exists()) {
+        bag_size += path.file_size();
+      }
+    }
+  } catch (const YAML::Exception & ex) {
+    throw std::runtime_error(
+            std::string("Exception on parsing metadata file to get bag size: ") +
+            metadata_path + " " +
+            ex.what());
+  }
+  return bag_size;
+}
+
 /// Based on configuration and metadata from completed benchmark, write results
 void write_benchmark_results(
   const std::vector<PublisherGroupConfig> & publisher_groups_config,
@@ -74,10 +100,11 @@ void write_benchmark_results(
     output_file << "instances frequency message_size total_messages_sent cache_size ";
     output_file << "max_bagfile_size storage_config ";
     output_file << "compression compression_queue compression_threads ";
-    output_file << "total_produced total_recorded_count\n";
+    output_file << "total_produced total_recorded_count bag_size\n";
   }
 
   int total_recorded_count = get_message_count_from_metadata(bag_config.storage_options.uri);
+  uint64_t bag_size = get_bag_size_from_metadata(bag_config.storage_options.uri);
 
   for (const auto & c : publisher_groups_config) {
     output_file << c.count << " ";
@@ -96,7 +123,8 @@ void write_benchmark_results(
     // For now, these need to be summed for each group
     auto total_messages_produced = c.producer_config.max_count * c.count;
     output_file << total_messages_produced << " ";
-    output_file << total_recorded_count << std::endl;
+    output_file << total_recorded_count << " ";
+    output_file << bag_size << std::endl;
   }
 }
 
@@ -24,6 +24,7 @@ with add_dll_directories_from_env('PATH'):
         get_registered_readers,
     )
     from rosbag2_py._storage import (
+        CompressionStatistics,
         ConverterOptions,
         FileInformation,
         StorageFilter,
@@ -55,6 +56,7 @@ with add_dll_directories_from_env('PATH'):
 
 __all__ = [
     'bag_rewrite',
+    'CompressionStatistics',
     'ConverterOptions',
     'FileInformation',
     'get_registered_readers',
@@ -81,6 +81,7 @@ PYBIND11_MODULE(_storage, m) {
   .def(
     pybind11::init<
       std::string, std::string, uint64_t, uint64_t, uint64_t, std::string, std::string, bool,
+      uint64_t, bool, uint64_t, uint64_t, uint64_t, uint64_t, uint64_t, uint64_t,
       KEY_VALUE_MAP>(),
     pybind11::arg("uri"),
     pybind11::arg("storage_id") = "",
@@ -90,6 +91,14 @@ PYBIND11_MODULE(_storage, m) {
     pybind11::arg("storage_preset_profile") = "",
     pybind11::arg("storage_config_uri") = "",
     pybind11::arg("snapshot_mode") = false,
+    pybind11::arg("snapshot_duration") = 0,
+    pybind11::arg("snapshot_file_per_trigger") = false,
+    pybind11::arg("max_cache_spill_size") = 0,
+    pybind11::arg("metadata_checkpoint_interval") = 0,
+    pybind11::arg("max_decompression_buffer_size") = 1024 * 1024 * 1024,
+    pybind11::arg("decompression_threads") = 0,
+    pybind11::arg("decompression_read_ahead_size") = 16 * 1024 * 1024,
+    pybind11::arg("decompression_read_ahead_files") = 0,
     pybind11::arg("custom_data") = KEY_VALUE_MAP{})
   .def_readwrite("uri", &rosbag2_storage::StorageOptions::uri)
   .def_readwrite("storage_id", &rosbag2_storage::StorageOptions::storage_id)
@@ -111,6 +120,30 @@ PYBIND11_MODULE(_storage, m) {
   .def_readwrite(
     "snapshot_mode",
     &rosbag2_storage::StorageOptions::snapshot_mode)
+  .def_readwrite(
+    "snapshot_duration",
+    &rosbag2_storage::StorageOptions::snapshot_duration)
+  .def_readwrite(
+    "snapshot_file_per_trigger",
+    &rosbag2_storage::StorageOptions::snapshot_file_per_trigger)
+  .def_readwrite(
+    "max_cache_spill_size",
+    &rosbag2_storage::StorageOptions::max_cache_spill_size)
+  .def_readwrite(
+    "metadata_checkpoint_interval",
+    &rosbag2_storage::StorageOptions::metadata_checkpoint_interval)
+  .def_readwrite(
+    "max_decompression_buffer_size",
+    &rosbag2_storage::StorageOptions::max_decompression_buffer_size)
+  .def_readwrite(
+    "decompression_threads",
+    &rosbag2_storage::StorageOptions::decompression_threads)
+  .def_readwrite(
+    "decompression_read_ahead_size",
+    &rosbag2_storage::StorageOptions::decompression_read_ahead_size)
+  .def_readwrite(
+    "decompression_read_ahead_files",
+    &rosbag2_storage::StorageOptions::decompression_read_ahead_files)
   .def_readwrite(
     "custom_data",
     &rosbag2_storage::StorageOptions::custom_data);
@@ -191,7 +224,21 @@ PYBIND11_MODULE(_storage, m) {
       self.duration = from_rclpy_duration(value);
     })
   .def_readwrite("duration", &rosbag2_storage::FileInformation::duration)
-  .def_readwrite("message_count", &rosbag2_storage::FileInformation::message_count);
+  .def_readwrite("message_count", &rosbag2_storage::FileInformation::message_count)
+  .def_readwrite("shard", &rosbag2_storage::FileInformation::shard);
+
+  pybind11::class_<rosbag2_storage::CompressionStatistics>(m, "CompressionStatistics")
+  .def(pybind11::init<>())
+  .def_readwrite("input_bytes", &rosbag2_storage::CompressionStatistics::input_bytes)
+  .def_readwrite("output_bytes", &rosbag2_storage::CompressionStatistics::output_bytes)
+  .def_property(
+    "compression_time",
+    [](const rosbag2_storage::CompressionStatistics & self) {
+      return to_rclpy_duration(self.compression_time);
+    },
+    [](rosbag2_storage::CompressionStatistics & self, const pybind11::object & value) {
+      self.compression_time = from_rclpy_duration(value);
+    });
 
   pybind11::class_<rosbag2_storage::BagMetadata>(m, "BagMetadata")
   .def(
@@ -225,7 +272,7 @@ PYBIND11_MODULE(_storage, m) {
           custom_data
         };
       }),
-    pybind11::arg("version") = 6,
+    pybind11::arg("version") = 11,
     pybind11::arg("bag_size") = 0,
     pybind11::arg("storage_identifier") = "",
     pybind11::arg("relative_file_paths") = std::vector<std::string>(),
@@ -266,6 +313,11 @@ PYBIND11_MODULE(_storage, m) {
   .def_readwrite("compression_format", &rosbag2_storage::BagMetadata::compression_format)
   .def_readwrite("compression_mode", &rosbag2_storage::BagMetadata::compression_mode)
   .def_readwrite("custom_data", &rosbag2_storage::BagMetadata::custom_data)
+  .def_readwrite("compression_levels", &rosbag2_storage::BagMetadata::compression_levels)
+  .def_readwrite(
+    "compression_statistics",
+    &rosbag2_storage::BagMetadata::compression_statistics)
+  .def_readwrite("uncompressed_topics", &rosbag2_storage::BagMetadata::uncompressed_topics)
   .def(
     "__repr__", [](const rosbag2_storage::BagMetadata & metadata) {
       return format_bag_meta_data(metadata);
@@ -325,6 +325,19 @@ PYBIND11_MODULE(_transport, m) {
   .def_readwrite("compression_format", &RecordOptions::compression_format)
   .def_readwrite("compression_queue_size", &RecordOptions::compression_queue_size)
   .def_readwrite("compression_threads", &RecordOptions::compression_threads)
+  .def_readwrite("compression_chunk_size", &RecordOptions::compression_chunk_size)
+  .def_readwrite(
+    "compression_dictionary_samples", &RecordOptions::compression_dictionary_samples)
+  .def_readwrite("compression_level", &RecordOptions::compression_level)
+  .def_readwrite("adaptive_compression_level", &RecordOptions::adaptive_compression_level)
+  .def_readwrite("min_compression_level", &RecordOptions::min_compression_level)
+  .def_readwrite("compression_file_workers", &RecordOptions::compression_file_workers)
+  .def_readwrite(
+    "compression_seekable_frame_size", &RecordOptions::compression_seekable_frame_size)
+  .def_readwrite("compression_policy", &RecordOptions::compression_policy)
+  .def_readwrite("compression_topic_policies", &RecordOptions::compression_topic_policies)
+  .def_readwrite("compression_policy_samples", &RecordOptions::compression_policy_samples)
+  .def_readwrite("compression_policy_min_ratio", &RecordOptions::compression_policy_min_ratio)
   .def_property(
     "topic_qos_profile_overrides",
     &RecordOptions::getTopicQoSProfileOverrides,
@@ -334,6 +347,10 @@ PYBIND11_MODULE(_transport, m) {
   .def_readwrite("start_paused", &RecordOptions::start_paused)
   .def_readwrite("ignore_leaf_topics", &RecordOptions::ignore_leaf_topics)
   .def_readwrite("use_sim_time", &RecordOptions::use_sim_time)
+  .def_readwrite("statistics_publish_period", &RecordOptions::statistics_publish_period)
+  .def_readwrite("storage_shards", &RecordOptions::storage_shards)
+  .def_readwrite("topic_max_rates", &RecordOptions::topic_max_rates)
+  .def_readwrite("topic_keep_every_n", &RecordOptions::topic_keep_every_n)
   ;
 
   py::class_<rosbag2_py::Player>(m, "Player")
@@ -17,6 +17,7 @@
 #include <chrono>
 #include <iostream>
 #include <iomanip>
+#include <map>
 #include <sstream>
 #include <string>
 #include <unordered_map>
@@ -132,6 +133,42 @@ void format_topics_with_type(
   }
 }
 
+void format_compression_statistics(
+  const std::map<std::string, rosbag2_storage::CompressionStatistics> & statistics,
+  std::stringstream & info_stream,
+  int indentation_spaces)
+{
+  bool first = true;
+  for (const auto & topic_statistics : statistics) {
+    const auto & topic = topic_statistics.first;
+    const auto & sums = topic_statistics.second;
+    if (!first) {
+      indent(info_stream, indentation_spaces);
+    }
+    first = false;
+    // Files and chunks of several topics are counted under the empty topic name.
+    info_stream << "Topic: " << (topic.empty() ? "(all topics)" : topic) << " | ";
+    info_stream << "Input: " << format_file_size(sums.input_bytes) << " | ";
+    info_stream << "Output: " << format_file_size(sums.output_bytes) << " | ";
+    std::stringstream ratio;
+    ratio << std::setprecision(2) << std::fixed;
+    if (sums.output_bytes > 0) {
+      ratio << static_cast<double>(sums.input_bytes) / static_cast<double>(sums.output_bytes);
+    } else {
+      ratio << "-";
+    }
+    info_stream << "Ratio: " << ratio.str() << " | ";
+    const auto seconds = std::chrono::duration<double>(sums.compression_time).count();
+    info_stream << "Speed: ";
+    if (seconds > 0) {
+      info_stream << format_file_size(static_cast<uint64_t>(sums.input_bytes / seconds)) << "/s";
+    } else {
+      info_stream << "-";
+    }
+    info_stream << std::endl;
+  }
+}
+
 }  // namespace
 
 std::string format_bag_meta_data(const rosbag2_storage::BagMetadata & metadata)
@@ -156,6 +193,11 @@ std::string format_bag_meta_data(const rosbag2_storage::BagMetadata & metadata)
   info_stream << "Topic information: ";
   format_topics_with_type(
     metadata.topics_with_message_count, info_stream, indentation_spaces);
+  if (!metadata.compression_statistics.empty()) {
+    info_stream << "Compression:       ";
+    format_compression_statistics(
+      metadata.compression_statistics, info_stream, indentation_spaces);
+  }
 
   return info_stream.str();
 }
@@ -16,6 +16,8 @@
 #define ROSBAG2_STORAGE__BAG_METADATA_HPP_
 
 #include <chrono>
+#include <cstdint>
+#include <map>
 #include <string>
 #include <vector>
 #include <utility>
@@ -38,11 +40,21 @@ struct FileInformation
   std::chrono::time_point<std::chrono::high_resolution_clock> starting_time;
   std::chrono::nanoseconds duration;
   size_t message_count;
+  // Index of the shard the file belongs to, for bags striped across several storages.
+  // Files of a shard are read one after the other, shards are merged in timestamp order.
+  size_t shard = 0;
+};
+
+struct CompressionStatistics
+{
+  uint64_t input_bytes = 0;
+  uint64_t output_bytes = 0;
+  std::chrono::nanoseconds compression_time{0};
 };
 
 struct BagMetadata
 {
-  int version = 6;  // upgrade this number when changing the content of the struct
+  int version = 11;  // upgrade this number when changing the content of the struct
   uint64_t bag_size = 0;  // Will not be serialized
   std::string storage_identifier;
   std::vector<std::string> relative_file_paths;
@@ -54,6 +66,16 @@ struct BagMetadata
   std::string compression_format;
   std::string compression_mode;
   std::unordered_map<std::string, std::string> custom_data;  // {key: value, ...}
+  // Dictionaries used by MESSAGE compression, stored with the bag so it can be decompressed.
+  std::unordered_map<std::string, std::vector<uint8_t>> compression_dictionaries;  // {topic: dict}
+  // Number of messages compressed with each level, when MESSAGE compression used a set level.
+  std::map<int32_t, uint64_t> compression_levels;  // {level: message count}
+  // Bytes in and out of the compressor and the time it took, per topic in MESSAGE mode. FILE and
+  // CHUNK mode compress several topics at once, they are counted under the empty topic name.
+  std::map<std::string, CompressionStatistics> compression_statistics;  // {topic: statistics}
+  // Topics of which MESSAGE compression stored some messages uncompressed, following their
+  // compression policy. Readers only decompress the messages of these topics that are compressed.
+  std::vector<std::string> uncompressed_topics;
 };
 
 }  // namespace rosbag2_storage
@@ -0,0 +1,52 @@
+// Copyright 2022, Open Source Robotics Corporation.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ROSBAG2_STORAGE__RANGE_READER_INTERFACE_HPP_
+#define ROSBAG2_STORAGE__RANGE_READER_INTERFACE_HPP_
+
+#include <cstdint>
+
+#include "rosbag2_storage/visibility_control.hpp"
+
+namespace rosbag2_storage
+{
+
+/**
+ * Random access to the content of a storage file which is neither on disk nor in memory as a
+ * whole, e.g. a compressed file of which only the parts being read are decompressed.
+ * Storage plugins may read from several threads, implementations must be thread safe.
+ */
+class ROSBAG2_STORAGE_PUBLIC RangeReaderInterface
+{
+public:
+  virtual ~RangeReaderInterface() = default;
+
+  /// Size of the content in bytes.
+  virtual uint64_t size() const = 0;
+
+  /**
+   * Read a range of the content.
+   *
+   * \param offset First byte to read.
+   * \param length Number of bytes to read.
+   * \param[out] buffer Receives length bytes.
+   * \throws std::out_of_range if the range is not within the content.
+   * \throws std::runtime_error if the content can not be read.
+   */
+  virtual void read(uint64_t offset, uint64_t length, uint8_t * buffer) = 0;
+};
+
+}  // namespace rosbag2_storage
+
+#endif  // ROSBAG2_STORAGE__RANGE_READER_INTERFACE_HPP_
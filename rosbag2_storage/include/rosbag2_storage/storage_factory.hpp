@@ -16,8 +16,10 @@
 #ifndef ROSBAG2_STORAGE__STORAGE_FACTORY_HPP_
 #define ROSBAG2_STORAGE__STORAGE_FACTORY_HPP_
 
+#include <cstdint>
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "rosbag2_storage/storage_factory_interface.hpp"
 #include "rosbag2_storage/visibility_control.hpp"
@@ -54,6 +56,15 @@ public:
   std::shared_ptr<storage_interfaces::ReadWriteInterface>
   open_read_write(const StorageOptions & storage_options) override;
 
+  std::shared_ptr<storage_interfaces::ReadOnlyInterface>
+  open_read_only_from_buffer(
+    const StorageOptions & storage_options, std::shared_ptr<std::vector<uint8_t>> buffer) override;
+
+  std::shared_ptr<storage_interfaces::ReadOnlyInterface>
+  open_read_only_from_range_reader(
+    const StorageOptions & storage_options,
+    std::shared_ptr<RangeReaderInterface> range_reader) override;
+
 private:
   std::unique_ptr<StorageFactoryImpl> impl_;
 };
@@ -15,9 +15,12 @@
 #ifndef ROSBAG2_STORAGE__STORAGE_FACTORY_INTERFACE_HPP_
 #define ROSBAG2_STORAGE__STORAGE_FACTORY_INTERFACE_HPP_
 
+#include <cstdint>
 #include <memory>
 #include <string>
+#include <vector>
 
+#include "rosbag2_storage/range_reader_interface.hpp"
 #include "rosbag2_storage/storage_interfaces/read_only_interface.hpp"
 #include "rosbag2_storage/storage_interfaces/read_write_interface.hpp"
 #include "rosbag2_storage/visibility_control.hpp"
@@ -35,6 +38,34 @@ public:
 
   virtual std::shared_ptr<storage_interfaces::ReadWriteInterface>
   open_read_write(const StorageOptions & storage_options) = 0;
+
+  /**
+   * Opens a storage file held in memory, see ReadOnlyInterface::open_from_buffer.
+   *
+   * \return nullptr if no storage plugin can read the buffer.
+   */
+  virtual std::shared_ptr<storage_interfaces::ReadOnlyInterface>
+  open_read_only_from_buffer(
+    const StorageOptions & storage_options, std::shared_ptr<std::vector<uint8_t>> buffer)
+  {
+    (void)storage_options;
+    (void)buffer;
+    return nullptr;
+  }
+
+  /**
+   * Opens a storage file through a range reader, see ReadOnlyInterface::open_from_range_reader.
+   *
+   * \return nullptr if no storage plugin can read through the range reader.
+   */
+  virtual std::shared_ptr<storage_interfaces::ReadOnlyInterface>
+  open_read_only_from_range_reader(
+    const StorageOptions & storage_options, std::shared_ptr<RangeReaderInterface> range_reader)
+  {
+    (void)storage_options;
+    (void)range_reader;
+    return nullptr;
+  }
 };
 
 }  // namespace rosbag2_storage
@@ -18,6 +18,8 @@
 #include <string>
 #include <vector>
 
+#include "rosbag2_storage/visibility_control.hpp"
+
 namespace rosbag2_storage
 {
 
@@ -39,6 +41,11 @@ struct StorageFilter
   std::string topics_regex_to_exclude = "";
 };
 
+/// Whether messages on topic_name are read with filter set, for messages filtered after they
+/// were taken out of the storage.
+ROSBAG2_STORAGE_PUBLIC
+bool topic_passes_filter(const std::string & topic_name, const StorageFilter & filter);
+
 }  // namespace rosbag2_storage
 
 #endif  // ROSBAG2_STORAGE__STORAGE_FILTER_HPP_
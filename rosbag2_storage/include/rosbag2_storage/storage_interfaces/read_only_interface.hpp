@@ -15,10 +15,15 @@
 #ifndef ROSBAG2_STORAGE__STORAGE_INTERFACES__READ_ONLY_INTERFACE_HPP_
 #define ROSBAG2_STORAGE__STORAGE_INTERFACES__READ_ONLY_INTERFACE_HPP_
 
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
 #include <string>
+#include <vector>
 
 #include "rcutils/types.h"
 
+#include "rosbag2_storage/range_reader_interface.hpp"
 #include "rosbag2_storage/storage_filter.hpp"
 #include "rosbag2_storage/storage_interfaces/base_info_interface.hpp"
 #include "rosbag2_storage/storage_interfaces/base_io_interface.hpp"
@@ -41,6 +46,39 @@ public:
     const StorageOptions & storage_options,
     IOFlag io_flag = IOFlag::READ_ONLY) override = 0;
 
+  /**
+  Opens a storage file held in memory for reading, instead of a file on disk.
+  Storage plugins which only read from disk keep this default implementation, which throws.
+  \param storage_options The uri names the file, it does not need to exist on disk.
+  \param buffer Content of the file. The storage keeps it while open and may modify it.
+  \throws std::runtime_error if the storage can not read the buffer.
+  */
+  virtual void open_from_buffer(
+    const StorageOptions & storage_options, std::shared_ptr<std::vector<uint8_t>> buffer)
+  {
+    (void)storage_options;
+    (void)buffer;
+    throw std::runtime_error(
+            "Storage '" + get_storage_identifier() + "' can not read files from memory.");
+  }
+
+  /**
+  Opens a storage file for reading through a range reader, which provides the parts of the file
+  the storage reads on demand. Storage plugins which only read from disk keep this default
+  implementation, which throws.
+  \param storage_options The uri names the file, it does not need to exist on disk.
+  \param range_reader Content of the file. The storage keeps it while open.
+  \throws std::runtime_error if the storage can not read through the range reader.
+  */
+  virtual void open_from_range_reader(
+    const StorageOptions & storage_options, std::shared_ptr<RangeReaderInterface> range_reader)
+  {
+    (void)storage_options;
+    (void)range_reader;
+    throw std::runtime_error(
+            "Storage '" + get_storage_identifier() + "' can not read files through range reads.");
+  }
+
   uint64_t get_bagfile_size() const override = 0;
 
   std::string get_storage_identifier() const override = 0;
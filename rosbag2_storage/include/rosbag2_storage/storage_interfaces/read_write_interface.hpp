@@ -40,6 +40,17 @@ public:
 
   uint64_t get_bagfile_size() const override = 0;
 
+  /**
+   * Returns a running estimate of the bagfile size, cheap enough to be called for every
+   * written message. Storage plugins which can track written bytes without touching the
+   * filesystem should override this; the default falls back to get_bagfile_size().
+   * \returns the estimated size of the bagfile in bytes.
+   */
+  virtual uint64_t get_bagfile_size_estimate() const
+  {
+    return get_bagfile_size();
+  }
+
   std::string get_storage_identifier() const override = 0;
 
   virtual uint64_t get_minimum_split_file_size() const = 0;
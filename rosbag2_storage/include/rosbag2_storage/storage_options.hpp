@@ -55,6 +55,45 @@ public:
   // Defaults to disabled.
   bool snapshot_mode = false;
 
+  // Time window in seconds retained per topic in snapshot mode.
+  // If greater than zero, each topic keeps its own history of this duration instead of
+  // sharing a single circular buffer, still bounded in total by max_cache_size.
+  // Defaults to 0, meaning a single circular buffer of max_cache_size is used.
+  uint64_t snapshot_duration = 0;
+
+  // Write every snapshot to a new storage file in snapshot mode.
+  // Defaults to disabled, i.e. snapshots are appended to the current file.
+  bool snapshot_file_per_trigger = false;
+
+  // The maximum size in bytes of the file absorbing messages which do not fit into the cache.
+  // The file is drained back to storage in order. Not used in snapshot mode.
+  // Defaults to 0, which disables the spill file and drops messages when the cache is full.
+  uint64_t max_cache_spill_size = 0;
+
+  // The interval in seconds at which the metadata file is rewritten while recording, and on
+  // every split, so that the bag can be read without reindexing after an unclean shutdown.
+  // Defaults to 0, which writes the metadata only when closing the bag.
+  uint64_t metadata_checkpoint_interval = 0;
+
+  // The maximum size in bytes of a FILE-compressed bag file decompressed in memory for reading.
+  // Larger files, and files of storages that can not read from memory, are decompressed to disk.
+  // Defaults to 1 GiB. A value of 0 always decompresses to disk.
+  uint64_t max_decompression_buffer_size = 1024 * 1024 * 1024;
+
+  // The number of threads decompressing the messages of a MESSAGE-compressed bag ahead of the
+  // reader. Defaults to 0, which decompresses every message when it is read.
+  uint64_t decompression_threads = 0;
+
+  // The size in bytes of the messages read and decompressed ahead of the reader when
+  // decompression_threads is set. At least one message is always read ahead.
+  // Defaults to 16 MiB.
+  uint64_t decompression_read_ahead_size = 16 * 1024 * 1024;
+
+  // The number of files of a FILE-compressed bag decompressed on a background thread ahead of
+  // the file being read. Files decompressed to disk are removed once they have been read.
+  // Defaults to 0, which decompresses every file when the reader reaches it.
+  uint64_t decompression_read_ahead_files = 0;
+
   // Stores the custom data
   std::unordered_map<std::string, std::string> custom_data{};
 };
@@ -14,6 +14,7 @@
 #ifndef ROSBAG2_STORAGE__YAML_HPP_
 #define ROSBAG2_STORAGE__YAML_HPP_
 
+#include <map>
 #include <string>
 #include <unordered_map>
 #include <vector>
@@ -172,6 +173,7 @@ struct convert<rosbag2_storage::FileInformation>
     node["starting_time"] = metadata.starting_time;
     node["duration"] = metadata.duration;
     node["message_count"] = metadata.message_count;
+    node["shard"] = metadata.shard;
     return node;
   }
 
@@ -182,6 +184,9 @@ struct convert<rosbag2_storage::FileInformation>
       node["starting_time"].as<std::chrono::time_point<std::chrono::high_resolution_clock>>();
     metadata.duration = node["duration"].as<std::chrono::nanoseconds>();
     metadata.message_count = node["message_count"].as<uint64_t>();
+    if (node["shard"]) {  // introduced in version 7
+      metadata.shard = node["shard"].as<size_t>();
+    }
     return true;
   }
 };
@@ -222,6 +227,27 @@ struct convert<std::chrono::time_point<std::chrono::high_resolution_clock>>
   }
 };
 
+template<>
+struct convert<rosbag2_storage::CompressionStatistics>
+{
+  static Node encode(const rosbag2_storage::CompressionStatistics & statistics)
+  {
+    Node node;
+    node["input_bytes"] = statistics.input_bytes;
+    node["output_bytes"] = statistics.output_bytes;
+    node["compression_time"] = statistics.compression_time;
+    return node;
+  }
+
+  static bool decode(const Node & node, rosbag2_storage::CompressionStatistics & statistics)
+  {
+    statistics.input_bytes = node["input_bytes"].as<uint64_t>();
+    statistics.output_bytes = node["output_bytes"].as<uint64_t>();
+    statistics.compression_time = node["compression_time"].as<std::chrono::nanoseconds>();
+    return true;
+  }
+};
+
 template<>
 struct convert<rosbag2_storage::BagMetadata>
 {
@@ -239,6 +265,19 @@ struct convert<rosbag2_storage::BagMetadata>
     node["relative_file_paths"] = metadata.relative_file_paths;
     node["files"] = metadata.files;
     node["custom_data"] = metadata.custom_data;
+    for (const auto & dictionary : metadata.compression_dictionaries) {
+      node["compression_dictionaries"][dictionary.first] =
+        Binary(dictionary.second.data(), dictionary.second.size());
+    }
+    if (!metadata.compression_levels.empty()) {
+      node["compression_levels"] = metadata.compression_levels;
+    }
+    if (!metadata.compression_statistics.empty()) {
+      node["compression_statistics"] = metadata.compression_statistics;
+    }
+    if (!metadata.uncompressed_topics.empty()) {
+      node["uncompressed_topics"] = metadata.uncompressed_topics;
+    }
 
     return node;
   }
@@ -270,6 +309,28 @@ struct convert<rosbag2_storage::BagMetadata>
       metadata.custom_data = node["custom_data"].as<std::unordered_map<std::string, std::string>>();
     }
 
+    if (metadata.version >= 8 && node["compression_dictionaries"]) {
+      for (const auto & dictionary : node["compression_dictionaries"]) {
+        const auto data = dictionary.second.as<Binary>();
+        metadata.compression_dictionaries.emplace(
+          dictionary.first.as<std::string>(),
+          std::vector<uint8_t>(data.data(), data.data() + data.size()));
+      }
+    }
+
+    if (metadata.version >= 9 && node["compression_levels"]) {
+      metadata.compression_levels = node["compression_levels"].as<std::map<int32_t, uint64_t>>();
+    }
+
+    if (metadata.version >= 10 && node["compression_statistics"]) {
+      metadata.compression_statistics = node["compression_statistics"]
+        .as<std::map<std::string, rosbag2_storage::CompressionStatistics>>();
+    }
+
+    if (metadata.version >= 11 && node["uncompressed_topics"]) {
+      metadata.uncompressed_topics = node["uncompressed_topics"].as<std::vector<std::string>>();
+    }
+
     return true;
   }
 };
@@ -17,11 +17,14 @@
 #define ROSBAG2_STORAGE__IMPL__STORAGE_FACTORY_IMPL_HPP_
 
 #include <algorithm>
+#include <cstdint>
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "pluginlib/class_loader.hpp"
 
+#include "rosbag2_storage/range_reader_interface.hpp"
 #include "rosbag2_storage/storage_interfaces/read_only_interface.hpp"
 #include "rosbag2_storage/storage_interfaces/read_write_interface.hpp"
 
@@ -60,6 +63,29 @@ try_load_plugin(
   return instance;
 }
 
+/// Content of a storage file to read instead of the file on disk, if either is set.
+struct StorageContent
+{
+  std::shared_ptr<std::vector<uint8_t>> buffer;
+  std::shared_ptr<RangeReaderInterface> range_reader;
+};
+
+/// Opens the storage file named in storage_options, from content if it is set.
+template<typename InterfaceT>
+void open_instance(
+  InterfaceT & instance,
+  const StorageOptions & storage_options,
+  storage_interfaces::IOFlag flag,
+  const StorageContent & content)
+{
+  if (content.buffer) {
+    instance.open_from_buffer(storage_options, content.buffer);
+  } else if (content.range_reader) {
+    instance.open_from_range_reader(storage_options, content.range_reader);
+  } else {
+    instance.open(storage_options, flag);
+  }
+}
 
 template<
   typename InterfaceT,
@@ -68,7 +94,8 @@ template<
 std::shared_ptr<InterfaceT>
 try_detect_and_open_storage(
   std::shared_ptr<pluginlib::ClassLoader<InterfaceT>> class_loader,
-  const StorageOptions & storage_options)
+  const StorageOptions & storage_options,
+  const StorageContent & content = {})
 {
   bool creating_file = flag != storage_interfaces::IOFlag::READ_ONLY;
   if (creating_file) {
@@ -85,7 +112,7 @@ try_detect_and_open_storage(
     ROSBAG2_STORAGE_LOG_DEBUG_STREAM(
       "Trying storage implementation '" << registered_class << "'.");
     try {
-      instance->open(storage_options, flag);
+      open_instance(*instance, storage_options, flag, content);
       ROSBAG2_STORAGE_LOG_DEBUG_STREAM(
         "Success, using implementation '" << registered_class << "'.");
       return instance;
@@ -105,10 +132,11 @@ template<
 std::shared_ptr<InterfaceT>
 get_interface_instance(
   std::shared_ptr<pluginlib::ClassLoader<InterfaceT>> class_loader,
-  const StorageOptions & storage_options)
+  const StorageOptions & storage_options,
+  const StorageContent & content = {})
 {
   if (storage_options.storage_id.empty()) {
-    return try_detect_and_open_storage<InterfaceT, flag>(class_loader, storage_options);
+    return try_detect_and_open_storage<InterfaceT, flag>(class_loader, storage_options, content);
   }
 
   const auto & registered_classes = class_loader->getDeclaredClasses();
@@ -127,7 +155,7 @@ get_interface_instance(
   }
 
   try {
-    instance->open(storage_options, flag);
+    open_instance(*instance, storage_options, flag, content);
     return instance;
   } catch (const std::runtime_error & ex) {
     ROSBAG2_STORAGE_LOG_ERROR_STREAM(
@@ -177,16 +205,19 @@ public:
     return instance;
   }
 
-  std::shared_ptr<ReadOnlyInterface> open_read_only(const StorageOptions & storage_options)
+  /// Opens the file named in storage_options, or its content if it is set.
+  std::shared_ptr<ReadOnlyInterface> open_read_only(
+    const StorageOptions & storage_options,
+    const StorageContent & content = {})
   {
     // try all registered ReadOnly plugins first
     auto instance = get_interface_instance(
-      read_only_class_loader_, storage_options);
+      read_only_class_loader_, storage_options, content);
 
     // try ReadWrite plugins if no ReadOnly plugin was found
     if (instance == nullptr) {
       instance = get_interface_instance<ReadWriteInterface, storage_interfaces::IOFlag::READ_ONLY>(
-        read_write_class_loader_, storage_options);
+        read_write_class_loader_, storage_options, content);
     }
 
     if (instance == nullptr) {
@@ -14,10 +14,18 @@
 
 #include "rosbag2_storage/metadata_io.hpp"
 
-#include <fstream>
+#include <cstdio>
+#include <sstream>
+#include <stdexcept>
 #include <string>
 #include <vector>
 
+#ifdef _WIN32
+# include <io.h>
+#else
+# include <unistd.h>
+#endif
+
 #include "rcpputils/filesystem_helper.hpp"
 
 #include "rcutils/filesystem.h"
@@ -28,12 +36,48 @@
 namespace rosbag2_storage
 {
 
+namespace
+{
+// Write the file and flush it to disk, so it survives a power loss once renamed
+void write_file_synced(const std::string & file_name, const std::string & content)
+{
+  FILE * file = std::fopen(file_name.c_str(), "w");
+  if (file == nullptr) {
+    throw std::runtime_error("Failed to open metadata file for writing: " + file_name);
+  }
+  bool written = std::fwrite(content.data(), 1, content.size(), file) == content.size() &&
+    std::fflush(file) == 0;
+#ifdef _WIN32
+  written = written && _commit(_fileno(file)) == 0;
+#else
+  written = written && fsync(fileno(file)) == 0;
+#endif
+  written = std::fclose(file) == 0 && written;
+  if (!written) {
+    throw std::runtime_error("Failed to write metadata file: " + file_name);
+  }
+}
+}  // namespace
+
 void MetadataIo::write_metadata(const std::string & uri, const BagMetadata & metadata)
 {
   YAML::Node metadata_node;
   metadata_node["rosbag2_bagfile_information"] = metadata;
-  std::ofstream fout(get_metadata_file_name(uri));
-  fout << metadata_node;
+  std::stringstream serialized_metadata;
+  serialized_metadata << metadata_node;
+
+  // Metadata is rewritten while recording, so write it aside and replace the previous file in
+  // one step. Readers never see a partially written file, even after a crash.
+  const auto metadata_file_name = get_metadata_file_name(uri);
+  const auto temporary_file_name = metadata_file_name + ".tmp";
+  write_file_synced(temporary_file_name, serialized_metadata.str());
+#ifdef _WIN32
+  // rename() does not replace existing files on Windows
+  std::remove(metadata_file_name.c_str());
+#endif
+  if (std::rename(temporary_file_name.c_str(), metadata_file_name.c_str()) != 0) {
+    throw std::runtime_error("Failed to replace metadata file: " + metadata_file_name);
+  }
 }
 
 BagMetadata MetadataIo::read_metadata(const std::string & uri)
@@ -15,8 +15,11 @@
 
 #include "rosbag2_storage/storage_factory.hpp"
 
+#include <cstdint>
 #include <memory>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "rosbag2_storage/storage_interfaces/read_only_interface.hpp"
 #include "rosbag2_storage/storage_interfaces/read_write_interface.hpp"
@@ -48,4 +51,16 @@ std::shared_ptr<ReadWriteInterface> StorageFactory::open_read_write(
   return impl_->open_read_write(storage_options);
 }
 
+std::shared_ptr<ReadOnlyInterface> StorageFactory::open_read_only_from_buffer(
+  const StorageOptions & storage_options, std::shared_ptr<std::vector<uint8_t>> buffer)
+{
+  return impl_->open_read_only(storage_options, {std::move(buffer), nullptr});
+}
+
+std::shared_ptr<ReadOnlyInterface> StorageFactory::open_read_only_from_range_reader(
+  const StorageOptions & storage_options, std::shared_ptr<RangeReaderInterface> range_reader)
+{
+  return impl_->open_read_only(storage_options, {nullptr, std::move(range_reader)});
+}
+
 }  // namespace rosbag2_storage
@@ -0,0 +1,40 @@
+// Copyright 2020 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "rosbag2_storage/storage_filter.hpp"
+
+#include <algorithm>
+#include <regex>
+#include <string>
+
+namespace rosbag2_storage
+{
+
+bool topic_passes_filter(const std::string & topic_name, const StorageFilter & filter)
+{
+  if (!filter.topics_regex_to_exclude.empty() &&
+    std::regex_match(topic_name, std::regex(filter.topics_regex_to_exclude)))
+  {
+    return false;
+  }
+  if (filter.topics.empty() && filter.topics_regex.empty()) {
+    return true;
+  }
+  return std::find(filter.topics.begin(), filter.topics.end(), topic_name) !=
+         filter.topics.end() ||
+         (!filter.topics_regex.empty() &&
+         std::regex_match(topic_name, std::regex(filter.topics_regex)));
+}
+
+}  // namespace rosbag2_storage
@@ -32,6 +32,14 @@ Node convert<rosbag2_storage::StorageOptions>::encode(
   node["storage_preset_profile"] = storage_options.storage_preset_profile;
   node["storage_config_uri"] = storage_options.storage_config_uri;
   node["snapshot_mode"] = storage_options.snapshot_mode;
+  node["snapshot_duration"] = storage_options.snapshot_duration;
+  node["snapshot_file_per_trigger"] = storage_options.snapshot_file_per_trigger;
+  node["max_cache_spill_size"] = storage_options.max_cache_spill_size;
+  node["metadata_checkpoint_interval"] = storage_options.metadata_checkpoint_interval;
+  node["max_decompression_buffer_size"] = storage_options.max_decompression_buffer_size;
+  node["decompression_threads"] = storage_options.decompression_threads;
+  node["decompression_read_ahead_size"] = storage_options.decompression_read_ahead_size;
+  node["decompression_read_ahead_files"] = storage_options.decompression_read_ahead_files;
   node["custom_data"] = storage_options.custom_data;
   return node;
 }
@@ -48,6 +56,19 @@ bool convert<rosbag2_storage::StorageOptions>::decode(
     node, "storage_preset_profile", storage_options.storage_preset_profile);
   optional_assign<std::string>(node, "storage_config_uri", storage_options.storage_config_uri);
   optional_assign<bool>(node, "snapshot_mode", storage_options.snapshot_mode);
+  optional_assign<uint64_t>(node, "snapshot_duration", storage_options.snapshot_duration);
+  optional_assign<bool>(
+    node, "snapshot_file_per_trigger", storage_options.snapshot_file_per_trigger);
+  optional_assign<uint64_t>(node, "max_cache_spill_size", storage_options.max_cache_spill_size);
+  optional_assign<uint64_t>(
+    node, "metadata_checkpoint_interval", storage_options.metadata_checkpoint_interval);
+  optional_assign<uint64_t>(
+    node, "max_decompression_buffer_size", storage_options.max_decompression_buffer_size);
+  optional_assign<uint64_t>(node, "decompression_threads", storage_options.decompression_threads);
+  optional_assign<uint64_t>(
+    node, "decompression_read_ahead_size", storage_options.decompression_read_ahead_size);
+  optional_assign<uint64_t>(
+    node, "decompression_read_ahead_files", storage_options.decompression_read_ahead_files);
   using KEY_VALUE_MAP = std::unordered_map<std::string, std::string>;
   optional_assign<KEY_VALUE_MAP>(node, "custom_data", storage_options.custom_data);
   return true;
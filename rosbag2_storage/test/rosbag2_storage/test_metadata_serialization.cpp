@@ -25,6 +25,8 @@
 # include <Windows.h>
 #endif
 
+#include "rcpputils/filesystem_helper.hpp"
+
 #include "rosbag2_storage/bag_metadata.hpp"
 #include "rosbag2_storage/metadata_io.hpp"
 #include "rosbag2_test_common/temporary_directory_fixture.hpp"
@@ -145,3 +147,96 @@ TEST_F(MetadataFixture, metadata_reads_v6_custom_data)
 
   EXPECT_THAT(read_metadata.custom_data, Eq(metadata.custom_data));
 }
+
+TEST_F(MetadataFixture, metadata_reads_v7_file_shards)
+{
+  BagMetadata metadata{};
+  metadata.version = 7;
+  metadata.relative_file_paths = {"shard_0/shard_0_0.db3", "shard_1/shard_1_0.db3"};
+  metadata.files = {
+    {"shard_0/shard_0_0.db3", {}, std::chrono::nanoseconds(10), 1, 0},
+    {"shard_1/shard_1_0.db3", {}, std::chrono::nanoseconds(20), 2, 1}
+  };
+
+  metadata_io_->write_metadata(temporary_dir_path_, metadata);
+  auto read_metadata = metadata_io_->read_metadata(temporary_dir_path_);
+
+  ASSERT_THAT(read_metadata.files, SizeIs(2u));
+  EXPECT_EQ(read_metadata.files[0].shard, 0u);
+  EXPECT_EQ(read_metadata.files[1].shard, 1u);
+  EXPECT_EQ(read_metadata.files[1].path, "shard_1/shard_1_0.db3");
+}
+
+TEST_F(MetadataFixture, metadata_reads_v8_compression_dictionaries)
+{
+  BagMetadata metadata{};
+  metadata.version = 8;
+  // Not valid UTF-8 on purpose, dictionaries are arbitrary binary data
+  metadata.compression_dictionaries["/odom"] = {0x37, 0xa4, 0x30, 0xec, 0x00, 0xff, 0x0a};
+  metadata.compression_dictionaries["/tf"] = {0x01};
+
+  metadata_io_->write_metadata(temporary_dir_path_, metadata);
+  auto read_metadata = metadata_io_->read_metadata(temporary_dir_path_);
+
+  EXPECT_THAT(read_metadata.compression_dictionaries, Eq(metadata.compression_dictionaries));
+}
+
+TEST_F(MetadataFixture, metadata_reads_v9_compression_levels)
+{
+  BagMetadata metadata{};
+  metadata.version = 9;
+  metadata.compression_levels = {{-5, 10u}, {1, 200u}, {19, 3u}};
+
+  metadata_io_->write_metadata(temporary_dir_path_, metadata);
+  auto read_metadata = metadata_io_->read_metadata(temporary_dir_path_);
+
+  EXPECT_THAT(read_metadata.compression_levels, Eq(metadata.compression_levels));
+}
+
+TEST_F(MetadataFixture, metadata_reads_v10_compression_statistics)
+{
+  BagMetadata metadata{};
+  metadata.version = 10;
+  metadata.compression_statistics["/odom"] = {1000u, 250u, std::chrono::nanoseconds{12345}};
+  metadata.compression_statistics[""] = {1u << 30, 1u << 20, std::chrono::seconds{2}};
+
+  metadata_io_->write_metadata(temporary_dir_path_, metadata);
+  auto read_metadata = metadata_io_->read_metadata(temporary_dir_path_);
+
+  ASSERT_THAT(read_metadata.compression_statistics, SizeIs(2u));
+  for (const auto & expected : metadata.compression_statistics) {
+    const auto & statistics = read_metadata.compression_statistics.at(expected.first);
+    EXPECT_EQ(statistics.input_bytes, expected.second.input_bytes);
+    EXPECT_EQ(statistics.output_bytes, expected.second.output_bytes);
+    EXPECT_EQ(statistics.compression_time, expected.second.compression_time);
+  }
+}
+
+TEST_F(MetadataFixture, metadata_reads_v11_uncompressed_topics)
+{
+  BagMetadata metadata{};
+  metadata.version = 11;
+  metadata.uncompressed_topics = {"/camera/image/compressed", "/video"};
+
+  metadata_io_->write_metadata(temporary_dir_path_, metadata);
+  auto read_metadata = metadata_io_->read_metadata(temporary_dir_path_);
+
+  EXPECT_THAT(read_metadata.uncompressed_topics, Eq(metadata.uncompressed_topics));
+}
+
+TEST_F(MetadataFixture, metadata_write_replaces_previous_file)
+{
+  BagMetadata metadata{};
+  metadata.message_count = 1;
+  metadata_io_->write_metadata(temporary_dir_path_, metadata);
+  metadata.message_count = 2;
+  metadata_io_->write_metadata(temporary_dir_path_, metadata);
+
+  auto read_metadata = metadata_io_->read_metadata(temporary_dir_path_);
+  EXPECT_EQ(read_metadata.message_count, 2u);
+
+  // The file written aside is renamed to the metadata file
+  const auto temporary_file = rcpputils::fs::path(temporary_dir_path_) /
+    (std::string(MetadataIo::metadata_filename) + ".tmp");
+  EXPECT_FALSE(temporary_file.exists());
+}
@@ -29,6 +29,14 @@ TEST(storage_options, test_yaml_serialization)
   original.storage_preset_profile = "profile";
   original.storage_config_uri = "config_uri";
   original.snapshot_mode = true;
+  original.snapshot_duration = 30;
+  original.snapshot_file_per_trigger = true;
+  original.max_cache_spill_size = 4096;
+  original.metadata_checkpoint_interval = 10;
+  original.max_decompression_buffer_size = 4096;
+  original.decompression_threads = 4;
+  original.decompression_read_ahead_size = 8192;
+  original.decompression_read_ahead_files = 2;
   original.custom_data["key1"] = "value1";
   original.custom_data["key2"] = "value2";
 
@@ -48,5 +56,17 @@ TEST(storage_options, test_yaml_serialization)
   ASSERT_EQ(original.storage_preset_profile, reconstructed.storage_preset_profile);
   ASSERT_EQ(original.storage_config_uri, reconstructed.storage_config_uri);
   ASSERT_EQ(original.snapshot_mode, reconstructed.snapshot_mode);
+  ASSERT_EQ(original.snapshot_duration, reconstructed.snapshot_duration);
+  ASSERT_EQ(original.snapshot_file_per_trigger, reconstructed.snapshot_file_per_trigger);
+  ASSERT_EQ(original.max_cache_spill_size, reconstructed.max_cache_spill_size);
+  ASSERT_EQ(
+    original.metadata_checkpoint_interval, reconstructed.metadata_checkpoint_interval);
+  ASSERT_EQ(
+    original.max_decompression_buffer_size, reconstructed.max_decompression_buffer_size);
+  ASSERT_EQ(original.decompression_threads, reconstructed.decompression_threads);
+  ASSERT_EQ(
+    original.decompression_read_ahead_size, reconstructed.decompression_read_ahead_size);
+  ASSERT_EQ(
+    original.decompression_read_ahead_files, reconstructed.decompression_read_ahead_files);
   ASSERT_EQ(original.custom_data, reconstructed.custom_data);
 }
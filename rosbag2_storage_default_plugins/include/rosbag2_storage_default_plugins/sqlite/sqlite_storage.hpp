@@ -54,6 +54,16 @@ public:
     rosbag2_storage::storage_interfaces::IOFlag io_flag =
     rosbag2_storage::storage_interfaces::IOFlag::READ_WRITE) override;
 
+  /// Opens a database file held in memory through SQLite's deserialization API, read-only.
+  void open_from_buffer(
+    const rosbag2_storage::StorageOptions & storage_options,
+    std::shared_ptr<std::vector<uint8_t>> buffer) override;
+
+  /// Opens a database file through a read-only SQLite VFS reading from range_reader.
+  void open_from_range_reader(
+    const rosbag2_storage::StorageOptions & storage_options,
+    std::shared_ptr<rosbag2_storage::RangeReaderInterface> range_reader) override;
+
   void remove_topic(const rosbag2_storage::TopicMetadata & topic) override;
 
   void create_topic(const rosbag2_storage::TopicMetadata & topic) override;
@@ -76,6 +86,10 @@ public:
 
   uint64_t get_bagfile_size() const override;
 
+  /// Size of the database file as of the last filesystem check plus the bytes written since.
+  /// The file size is only re-read once enough data has been written to make the estimate drift.
+  uint64_t get_bagfile_size_estimate() const override;
+
   std::string get_storage_identifier() const override;
 
   uint64_t get_minimum_split_file_size() const override;
@@ -103,6 +117,7 @@ private:
   void commit_transaction();
   void write_locked(std::shared_ptr<const rosbag2_storage::SerializedBagMessage> message)
   RCPPUTILS_TSA_REQUIRES(database_write_mutex_);
+  void sync_bagfile_size_estimate() RCPPUTILS_TSA_REQUIRES(database_write_mutex_);
 
   using ReadQueryResult = SqliteStatementWrapper::QueryResult<
     std::shared_ptr<rcutils_uint8_array_t>, rcutils_time_point_value_t, std::string, int>;
@@ -116,8 +131,16 @@ private:
   std::unordered_map<std::string, int> topics_ RCPPUTILS_TSA_GUARDED_BY(database_write_mutex_);
   std::vector<rosbag2_storage::TopicMetadata> all_topics_and_types_;
   std::string relative_path_;
+  // Size of the database opened with open_from_buffer() or open_from_range_reader(),
+  // 0 for a database on disk.
+  uint64_t in_memory_file_size_ = 0;
   std::atomic_bool active_transaction_ {false};
 
+  // Running byte accounting for get_bagfile_size_estimate(). Only updated from the writing
+  // thread, read from the thread deciding about bagfile splits.
+  std::atomic<uint64_t> bagfile_size_at_last_check_ {0};
+  std::atomic<uint64_t> bytes_written_since_size_check_ {0};
+
   rcutils_time_point_value_t seek_time_ = 0;
   int seek_row_id_ = 0;
   rosbag2_storage::StorageFilter storage_filter_ {};
@@ -17,11 +17,14 @@
 
 #include <sqlite3.h>
 
+#include <cstdint>
 #include <memory>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 #include "rcutils/types.h"
+#include "rosbag2_storage/range_reader_interface.hpp"
 #include "rosbag2_storage/serialized_bag_message.hpp"
 #include "rosbag2_storage/storage_interfaces/base_io_interface.hpp"
 #include "rosbag2_storage_default_plugins/sqlite/sqlite_statement_wrapper.hpp"
@@ -42,9 +45,21 @@ public:
     const std::string & uri,
     rosbag2_storage::storage_interfaces::IOFlag io_flag,
     std::unordered_map<std::string, std::string> && pragmas = {});
+  /// Opens the database file held in buffer, read-only.
+  /// \throws SqliteException if the SQLite library can not open buffers, see can_open_buffers()
+  SqliteWrapper(
+    std::shared_ptr<std::vector<uint8_t>> buffer,
+    std::unordered_map<std::string, std::string> && pragmas = {});
+  /// Opens the database file read through range_reader, read-only.
+  SqliteWrapper(
+    std::shared_ptr<rosbag2_storage::RangeReaderInterface> range_reader,
+    std::unordered_map<std::string, std::string> && pragmas = {});
   SqliteWrapper();
   ~SqliteWrapper();
 
+  /// Whether the SQLite library supports opening a database file held in a buffer.
+  static bool can_open_buffers();
+
   bool field_exists(const std::string & table_name, const std::string & field_name);
   SqliteStatement prepare_statement(const std::string & query);
   std::string query_pragma_value(const std::string & key);
@@ -63,6 +78,8 @@ private:
   void initialize_application_functions();
 
   sqlite3 * db_ptr;
+  // Content of an in-memory database, must outlive db_ptr.
+  std::shared_ptr<std::vector<uint8_t>> buffer_;
 };
 
 
@@ -146,6 +146,14 @@ constexpr const auto FILE_EXTENSION = ".db3";
 
 // Minimum size of a sqlite3 database file in bytes (84 kiB).
 constexpr const uint64_t MIN_SPLIT_FILE_SIZE = 86016;
+
+// Amount of data written after which the estimated bagfile size is re-synchronized
+// with the actual size of the database file.
+constexpr const uint64_t BAGFILE_SIZE_CHECK_INTERVAL = 1024 * 1024;
+
+// Approximate per-row cost of the messages table on top of the serialized payload
+// (row id, topic id, timestamp and record header).
+constexpr const uint64_t MESSAGE_ROW_OVERHEAD = 32;
 }  // namespace
 
 namespace rosbag2_storage_plugins
@@ -166,6 +174,7 @@ void SqliteStorage::open(
   if (resilient_preset && is_read_write(io_flag)) {
     apply_resilient_storage_settings(pragmas);
   }
+  in_memory_file_size_ = 0;
 
   if (is_read_write(io_flag)) {
     relative_path_ = storage_options.uri + FILE_EXTENSION;
@@ -196,6 +205,9 @@ void SqliteStorage::open(
     initialize();
   }
 
+  bagfile_size_at_last_check_ = get_bagfile_size();
+  bytes_written_since_size_check_ = 0;
+
   // Reset the read and write statements in case the database changed.
   // These will be reinitialized lazily on the first read or write.
   read_statement_ = nullptr;
@@ -205,6 +217,55 @@ void SqliteStorage::open(
     "Opened database '" << relative_path_ << "' for " << to_string(io_flag) << ".");
 }
 
+void SqliteStorage::open_from_buffer(
+  const rosbag2_storage::StorageOptions & storage_options,
+  std::shared_ptr<std::vector<uint8_t>> buffer)
+{
+  const auto io_flag = rosbag2_storage::storage_interfaces::IOFlag::READ_ONLY;
+  relative_path_ = storage_options.uri;
+  in_memory_file_size_ = buffer->size();
+
+  try {
+    database_ = std::make_unique<SqliteWrapper>(
+      std::move(buffer), parse_pragmas(storage_options.storage_config_uri, io_flag));
+  } catch (const SqliteException & e) {
+    throw std::runtime_error("Failed to setup storage. Error: " + std::string(e.what()));
+  }
+
+  bagfile_size_at_last_check_ = get_bagfile_size();
+  bytes_written_since_size_check_ = 0;
+  read_statement_ = nullptr;
+  write_statement_ = nullptr;
+
+  ROSBAG2_STORAGE_DEFAULT_PLUGINS_LOG_INFO_STREAM(
+    "Opened database '" << relative_path_ << "' from memory for " << to_string(io_flag) << ".");
+}
+
+void SqliteStorage::open_from_range_reader(
+  const rosbag2_storage::StorageOptions & storage_options,
+  std::shared_ptr<rosbag2_storage::RangeReaderInterface> range_reader)
+{
+  const auto io_flag = rosbag2_storage::storage_interfaces::IOFlag::READ_ONLY;
+  relative_path_ = storage_options.uri;
+  in_memory_file_size_ = range_reader->size();
+
+  try {
+    database_ = std::make_unique<SqliteWrapper>(
+      std::move(range_reader), parse_pragmas(storage_options.storage_config_uri, io_flag));
+  } catch (const SqliteException & e) {
+    throw std::runtime_error("Failed to setup storage. Error: " + std::string(e.what()));
+  }
+
+  bagfile_size_at_last_check_ = get_bagfile_size();
+  bytes_written_since_size_check_ = 0;
+  read_statement_ = nullptr;
+  write_statement_ = nullptr;
+
+  ROSBAG2_STORAGE_DEFAULT_PLUGINS_LOG_INFO_STREAM(
+    "Opened database '" << relative_path_ << "' through range reads for " <<
+      to_string(io_flag) << ".");
+}
+
 void SqliteStorage::activate_transaction()
 {
   if (active_transaction_) {
@@ -233,6 +294,7 @@ void SqliteStorage::write(std::shared_ptr<const rosbag2_storage::SerializedBagMe
 {
   std::lock_guard<std::mutex> db_lock(database_write_mutex_);
   write_locked(message);
+  sync_bagfile_size_estimate();
 }
 
 void SqliteStorage::write_locked(
@@ -270,6 +332,8 @@ void SqliteStorage::write_locked(
     }
   }
   write_statement_->execute_and_reset();
+  bytes_written_since_size_check_ +=
+    message->serialized_data->buffer_length + MESSAGE_ROW_OVERHEAD;
 }
 
 void SqliteStorage::write(
@@ -287,6 +351,7 @@ void SqliteStorage::write(
   }
 
   commit_transaction();
+  sync_bagfile_size_estimate();
 }
 
 bool SqliteStorage::has_next()
@@ -329,11 +394,33 @@ std::vector<rosbag2_storage::TopicMetadata> SqliteStorage::get_all_topics_and_ty
 
 uint64_t SqliteStorage::get_bagfile_size() const
 {
+  if (in_memory_file_size_ > 0) {
+    return in_memory_file_size_;
+  }
   const auto bag_path = rcpputils::fs::path{get_relative_file_path()};
 
   return bag_path.exists() ? bag_path.file_size() : 0u;
 }
 
+uint64_t SqliteStorage::get_bagfile_size_estimate() const
+{
+  return bagfile_size_at_last_check_.load() + bytes_written_since_size_check_.load();
+}
+
+void SqliteStorage::sync_bagfile_size_estimate()
+{
+  // Avoid a stat() call per message: only go to the filesystem once enough data was written
+  // for the running estimate to drift noticeably from the actual file size. Called after a
+  // commit, so the file holds all bytes counted so far.
+  const auto bytes_written = bytes_written_since_size_check_.load();
+  if (bytes_written >= BAGFILE_SIZE_CHECK_INTERVAL) {
+    // Subtract first, so that concurrent readers underestimate for a moment rather than split
+    // early on bytes counted twice
+    bytes_written_since_size_check_.fetch_sub(bytes_written);
+    bagfile_size_at_last_check_ = get_bagfile_size();
+  }
+}
+
 void SqliteStorage::initialize()
 {
   std::string create_stmt = "CREATE TABLE topics(" \
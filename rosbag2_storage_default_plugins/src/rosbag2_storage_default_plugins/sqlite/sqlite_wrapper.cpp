@@ -15,8 +15,12 @@
 #include "rosbag2_storage_default_plugins/sqlite/sqlite_wrapper.hpp"
 
 #include <algorithm>
+#include <atomic>
+#include <cstring>
 #include <iostream>
 #include <memory>
+#include <mutex>
+#include <new>
 #include <regex>
 #include <sstream>
 #include <string>
@@ -31,6 +35,12 @@
 
 #include "../logging.hpp"
 
+// Since SQLite 3.36 sqlite3_deserialize() is available unless omitted, before only if enabled
+#if (SQLITE_VERSION_NUMBER >= 3036000 && !defined(SQLITE_OMIT_DESERIALIZE)) || \
+  defined(SQLITE_ENABLE_DESERIALIZE)
+#define ROSBAG2_STORAGE_DEFAULT_PLUGINS_SQLITE_DESERIALIZE
+#endif
+
 namespace rosbag2_storage_plugins
 {
 
@@ -58,6 +68,208 @@ void sqlite_regexp(sqlite3_context * context, int argc, sqlite3_value ** values)
 
 }   // namespace sqlite3_application_functions
 
+namespace sqlite3_range_reader_vfs
+{
+// A read-only SQLite VFS serving the main database file from a range reader, registered by
+// name for the duration of sqlite3_open_v2(). Temporary files, e.g. of large sorts, are left to
+// the default VFS. Journals never exist, since the database is never written.
+constexpr const char kVfsName[] = "rosbag2_range_reader";
+
+struct RangeReaderFile
+{
+  sqlite3_file base;
+  std::shared_ptr<rosbag2_storage::RangeReaderInterface> range_reader;
+};
+
+std::mutex registry_mutex;
+std::unordered_map<std::string, std::shared_ptr<rosbag2_storage::RangeReaderInterface>> registry;
+std::atomic<uint64_t> next_file_id{0};
+sqlite3_vfs * default_vfs = nullptr;
+
+RangeReaderFile * to_range_reader_file(sqlite3_file * file)
+{
+  return reinterpret_cast<RangeReaderFile *>(file);
+}
+
+int x_close(sqlite3_file * file)
+{
+  to_range_reader_file(file)->~RangeReaderFile();
+  return SQLITE_OK;
+}
+
+int x_read(sqlite3_file * file, void * buffer, int amount, sqlite3_int64 offset)
+{
+  auto & range_reader = *to_range_reader_file(file)->range_reader;
+  auto * const output = static_cast<uint8_t *>(buffer);
+  try {
+    const auto size = range_reader.size();
+    const auto begin = std::min(static_cast<uint64_t>(offset), size);
+    const auto length = std::min(static_cast<uint64_t>(amount), size - begin);
+    range_reader.read(begin, length, output);
+    // As for databases held in memory, databases written in WAL mode are read as rollback
+    // journal databases, which is what they are once the WAL was checkpointed on close.
+    for (uint64_t i = std::max<uint64_t>(begin, 18); i < std::min<uint64_t>(begin + length, 20);
+      i++)
+    {
+      if (output[i - begin] == 2) {
+        output[i - begin] = 1;
+      }
+    }
+    if (length < static_cast<uint64_t>(amount)) {
+      std::memset(output + length, 0, static_cast<size_t>(amount - length));
+      return SQLITE_IOERR_SHORT_READ;
+    }
+    return SQLITE_OK;
+  } catch (const std::exception & e) {
+    ROSBAG2_STORAGE_DEFAULT_PLUGINS_LOG_ERROR_STREAM(
+      "Could not read database through range reader: " << e.what());
+    return SQLITE_IOERR_READ;
+  }
+}
+
+int x_write(sqlite3_file *, const void *, int, sqlite3_int64)
+{
+  return SQLITE_READONLY;
+}
+
+int x_truncate(sqlite3_file *, sqlite3_int64)
+{
+  return SQLITE_READONLY;
+}
+
+int x_sync(sqlite3_file *, int)
+{
+  return SQLITE_OK;
+}
+
+int x_file_size(sqlite3_file * file, sqlite3_int64 * size)
+{
+  *size = static_cast<sqlite3_int64>(to_range_reader_file(file)->range_reader->size());
+  return SQLITE_OK;
+}
+
+int x_lock(sqlite3_file *, int)
+{
+  return SQLITE_OK;
+}
+
+int x_check_reserved_lock(sqlite3_file *, int * result)
+{
+  *result = 0;
+  return SQLITE_OK;
+}
+
+int x_file_control(sqlite3_file *, int, void *)
+{
+  return SQLITE_NOTFOUND;
+}
+
+int x_sector_size(sqlite3_file *)
+{
+  return 0;
+}
+
+int x_device_characteristics(sqlite3_file *)
+{
+  return SQLITE_IOCAP_IMMUTABLE;
+}
+
+// Version 1 of the methods, without shared memory or memory mapping.
+const sqlite3_io_methods io_methods = {
+  1, &x_close, &x_read, &x_write, &x_truncate, &x_sync, &x_file_size, &x_lock, &x_lock,
+  &x_check_reserved_lock, &x_file_control, &x_sector_size, &x_device_characteristics,
+  nullptr, nullptr, nullptr, nullptr, nullptr, nullptr};
+
+int x_open(sqlite3_vfs *, const char * name, sqlite3_file * file, int flags, int * out_flags)
+{
+  if ((flags & SQLITE_OPEN_MAIN_DB) == 0) {
+    return default_vfs->xOpen(default_vfs, name, file, flags, out_flags);
+  }
+  file->pMethods = nullptr;
+  std::shared_ptr<rosbag2_storage::RangeReaderInterface> range_reader;
+  {
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    const auto entry = registry.find(name == nullptr ? "" : name);
+    if (entry == registry.end()) {
+      return SQLITE_CANTOPEN;
+    }
+    range_reader = entry->second;
+  }
+  new (to_range_reader_file(file)) RangeReaderFile{{&io_methods}, std::move(range_reader)};
+  if (out_flags != nullptr) {
+    *out_flags = SQLITE_OPEN_READONLY;
+  }
+  return SQLITE_OK;
+}
+
+int x_delete(sqlite3_vfs *, const char *, int)
+{
+  return SQLITE_IOERR_DELETE;
+}
+
+int x_access(sqlite3_vfs *, const char *, int, int * result)
+{
+  *result = 0;
+  return SQLITE_OK;
+}
+
+int x_full_pathname(sqlite3_vfs *, const char * name, int size, char * full_name)
+{
+  sqlite3_snprintf(size, full_name, "%s", name);
+  return SQLITE_OK;
+}
+
+// Registers the VFS with SQLite once, returns its name.
+const char * register_vfs()
+{
+  static std::once_flag registered;
+  static sqlite3_vfs vfs;
+  std::call_once(
+    registered, [] {
+      default_vfs = sqlite3_vfs_find(nullptr);
+      // Randomness, sleeping, time and dynamic loading are those of the default VFS.
+      vfs = *default_vfs;
+      vfs.iVersion = std::min(default_vfs->iVersion, 2);
+      vfs.szOsFile = std::max(default_vfs->szOsFile, static_cast<int>(sizeof(RangeReaderFile)));
+      vfs.pNext = nullptr;
+      vfs.zName = kVfsName;
+      vfs.pAppData = nullptr;
+      vfs.xOpen = &x_open;
+      vfs.xDelete = &x_delete;
+      vfs.xAccess = &x_access;
+      vfs.xFullPathname = &x_full_pathname;
+      sqlite3_vfs_register(&vfs, 0);
+    });
+  return kVfsName;
+}
+
+// Makes a range reader available under a unique file name while opening a database.
+class RegisteredRangeReader
+{
+public:
+  explicit RegisteredRangeReader(std::shared_ptr<rosbag2_storage::RangeReaderInterface> reader)
+  : name_(std::string(kVfsName) + "_" + std::to_string(next_file_id++))
+  {
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    registry.emplace(name_, std::move(reader));
+  }
+
+  ~RegisteredRangeReader()
+  {
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    registry.erase(name_);
+  }
+
+  const std::string & name() const
+  {
+    return name_;
+  }
+
+private:
+  const std::string name_;
+};
+}   // namespace sqlite3_range_reader_vfs
+
 SqliteWrapper::SqliteWrapper(
   const std::string & uri,
   rosbag2_storage::storage_interfaces::IOFlag io_flag,
@@ -91,6 +303,79 @@ SqliteWrapper::SqliteWrapper(
   initialize_application_functions();
 }
 
+SqliteWrapper::SqliteWrapper(
+  std::shared_ptr<std::vector<uint8_t>> buffer,
+  std::unordered_map<std::string, std::string> && pragmas)
+: db_ptr(nullptr),
+  buffer_(std::move(buffer))
+{
+#ifndef ROSBAG2_STORAGE_DEFAULT_PLUGINS_SQLITE_DESERIALIZE
+  (void)pragmas;
+  throw SqliteException{
+          "Could not load in-memory database. SQLite " SQLITE_VERSION " is built without "
+          "SQLITE_ENABLE_DESERIALIZE."};
+#else
+  int rc = sqlite3_open_v2(
+    ":memory:", &db_ptr, SQLITE_OPEN_READWRITE | SQLITE_OPEN_NOMUTEX, nullptr);
+  if (rc != SQLITE_OK) {
+    std::stringstream errmsg;
+    errmsg << "Could not open in-memory database. SQLite error (" <<
+      rc << "): " << sqlite3_errstr(rc);
+    throw SqliteException{errmsg.str()};
+  }
+
+  // Databases written in WAL mode are marked as such in bytes 18 and 19 of their header. The
+  // in-memory VFS has no WAL support, so mark the buffer as a rollback journal database instead;
+  // the content is the same once the WAL was checkpointed on close.
+  if (buffer_->size() >= 20 && (*buffer_)[18] == 2 && (*buffer_)[19] == 2) {
+    (*buffer_)[18] = 1;
+    (*buffer_)[19] = 1;
+  }
+  rc = sqlite3_deserialize(
+    db_ptr, "main", buffer_->data(), static_cast<sqlite3_int64>(buffer_->size()),
+    static_cast<sqlite3_int64>(buffer_->size()), SQLITE_DESERIALIZE_READONLY);
+  if (rc != SQLITE_OK) {
+    std::stringstream errmsg;
+    errmsg << "Could not load in-memory database. SQLite error (" <<
+      rc << "): " << sqlite3_errstr(rc);
+    sqlite3_close(db_ptr);
+    db_ptr = nullptr;
+    throw SqliteException{errmsg.str()};
+  }
+
+  apply_pragma_settings(pragmas, rosbag2_storage::storage_interfaces::IOFlag::READ_ONLY);
+  sqlite3_extended_result_codes(db_ptr, 1);
+  initialize_application_functions();
+#endif
+}
+
+SqliteWrapper::SqliteWrapper(
+  std::shared_ptr<rosbag2_storage::RangeReaderInterface> range_reader,
+  std::unordered_map<std::string, std::string> && pragmas)
+: db_ptr(nullptr)
+{
+  const auto * vfs_name = sqlite3_range_reader_vfs::register_vfs();
+  int rc = SQLITE_OK;
+  {
+    // The opened file holds on to the range reader, it is only needed by name for opening.
+    const sqlite3_range_reader_vfs::RegisteredRangeReader registered(std::move(range_reader));
+    rc = sqlite3_open_v2(
+      registered.name().c_str(), &db_ptr, SQLITE_OPEN_READONLY | SQLITE_OPEN_NOMUTEX, vfs_name);
+  }
+  if (rc != SQLITE_OK) {
+    std::stringstream errmsg;
+    errmsg << "Could not open database through range reader. SQLite error (" <<
+      rc << "): " << sqlite3_errstr(rc);
+    sqlite3_close(db_ptr);
+    db_ptr = nullptr;
+    throw SqliteException{errmsg.str()};
+  }
+
+  apply_pragma_settings(pragmas, rosbag2_storage::storage_interfaces::IOFlag::READ_ONLY);
+  sqlite3_extended_result_codes(db_ptr, 1);
+  initialize_application_functions();
+}
+
 SqliteWrapper::SqliteWrapper()
 : db_ptr(nullptr) {}
 
@@ -104,6 +389,15 @@ SqliteWrapper::~SqliteWrapper()
   }
 }
 
+bool SqliteWrapper::can_open_buffers()
+{
+#ifdef ROSBAG2_STORAGE_DEFAULT_PLUGINS_SQLITE_DESERIALIZE
+  return true;
+#else
+  return false;
+#endif
+}
+
 void SqliteWrapper::apply_pragma_settings(
   std::unordered_map<std::string, std::string> & pragmas,
   rosbag2_storage::storage_interfaces::IOFlag io_flag)
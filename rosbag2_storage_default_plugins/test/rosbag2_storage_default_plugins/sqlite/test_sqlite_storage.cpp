@@ -15,9 +15,15 @@
 #include <gmock/gmock.h>
 
 #include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <iterator>
 #include <limits>
 #include <memory>
+#include <mutex>
+#include <stdexcept>
 #include <string>
+#include <thread>
 #include <tuple>
 #include <utility>
 #include <vector>
@@ -375,6 +381,51 @@ TEST_F(StorageTestFixture, get_relative_file_path_returns_db_name_with_ext) {
   EXPECT_EQ(append_storage->get_relative_file_path(), storage_filename);
 }
 
+TEST_F(StorageTestFixture, get_bagfile_size_estimate_tracks_written_bytes) {
+  auto writable_storage = this->write_messages_to_sqlite({});
+  const auto initial_size = writable_storage->get_bagfile_size();
+  EXPECT_EQ(writable_storage->get_bagfile_size_estimate(), initial_size);
+
+  const std::string payload(1000, 'x');
+  const size_t message_count = 10;
+  std::vector<std::tuple<std::string, int64_t, std::string, std::string, std::string>> messages;
+  for (size_t i = 0; i < message_count; ++i) {
+    messages.emplace_back(payload, i, "topic", "type", "rmw_format");
+  }
+  this->write_messages_to_sqlite(messages, writable_storage);
+
+  // The estimate accounts for every written payload without going back to the filesystem
+  EXPECT_GE(
+    writable_storage->get_bagfile_size_estimate(),
+    initial_size + message_count * payload.size());
+}
+
+TEST_F(StorageTestFixture, get_bagfile_size_estimate_keeps_bytes_written_while_read) {
+  auto writable_storage = this->write_messages_to_sqlite({});
+  const auto initial_size = writable_storage->get_bagfile_size();
+
+  // Enough to re-synchronize with the file size a few times
+  const std::string payload(1000, 'x');
+  const size_t message_count = 3000;
+  std::vector<std::tuple<std::string, int64_t, std::string, std::string, std::string>> messages;
+  for (size_t i = 0; i < message_count; ++i) {
+    messages.emplace_back(payload, i, "topic", "type", "rmw_format");
+  }
+  std::atomic_bool writing {true};
+  std::thread split_checker([&writable_storage, &writing]() {
+      while (writing) {
+        writable_storage->get_bagfile_size_estimate();
+      }
+    });
+  this->write_messages_to_sqlite(messages, writable_storage);
+  writing = false;
+  split_checker.join();
+
+  EXPECT_GE(
+    writable_storage->get_bagfile_size_estimate(),
+    initial_size + message_count * payload.size());
+}
+
 TEST_F(StorageTestFixture, loads_config_file) {
   // Check that storage opens with correct sqlite config file
   const auto valid_yaml = "write:\n  pragmas: [\"journal_mode = MEMORY\"]\n";
@@ -385,6 +436,113 @@ TEST_F(StorageTestFixture, loads_config_file) {
       rosbag2_storage::storage_interfaces::IOFlag::READ_WRITE));
 }
 
+TEST_F(StorageTestFixture, messages_are_read_from_a_database_held_in_memory) {
+  std::vector<std::string> string_messages = {"first message", "second message", "third message"};
+  std::vector<std::tuple<std::string, int64_t, std::string, std::string, std::string>> messages =
+  {std::make_tuple(string_messages[0], 1, "topic1", "type1", "rmw1"),
+    std::make_tuple(string_messages[1], 2, "topic2", "type2", "rmw2"),
+    std::make_tuple(string_messages[2], 3, "topic1", "type1", "rmw1")};
+  write_messages_to_sqlite(messages);
+
+  const auto db_file = (rcpputils::fs::path(temporary_dir_path_) / "rosbag.db3").string();
+  std::ifstream input(db_file, std::ios::binary);
+  auto buffer = std::make_shared<std::vector<uint8_t>>(
+    std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>());
+  const auto buffer_size = buffer->size();
+  ASSERT_GT(buffer_size, 0u);
+
+  auto readable_storage = std::make_unique<rosbag2_storage_plugins::SqliteStorage>();
+  if (!rosbag2_storage_plugins::SqliteWrapper::can_open_buffers()) {
+    // Readers fall back to decompressing the file to disk
+    EXPECT_THROW(
+      readable_storage->open_from_buffer({db_file, kPluginID}, buffer), std::runtime_error);
+    return;
+  }
+  readable_storage->open_from_buffer({db_file, kPluginID}, buffer);
+
+  std::vector<std::shared_ptr<rosbag2_storage::SerializedBagMessage>> read_messages;
+  while (readable_storage->has_next()) {
+    read_messages.push_back(readable_storage->read_next());
+  }
+  ASSERT_THAT(read_messages, SizeIs(3));
+  for (size_t i = 0; i < 3; i++) {
+    EXPECT_THAT(deserialize_message(read_messages[i]->serialized_data), Eq(string_messages[i]));
+    EXPECT_THAT(read_messages[i]->time_stamp, Eq(std::get<1>(messages[i])));
+  }
+  EXPECT_THAT(readable_storage->get_all_topics_and_types(), SizeIs(2));
+  EXPECT_THAT(readable_storage->get_bagfile_size(), Eq(buffer_size));
+  EXPECT_THAT(readable_storage->get_relative_file_path(), Eq(db_file));
+}
+
+class BufferRangeReader : public rosbag2_storage::RangeReaderInterface
+{
+public:
+  explicit BufferRangeReader(std::vector<uint8_t> buffer)
+  : buffer_(std::move(buffer)) {}
+
+  uint64_t size() const override
+  {
+    return buffer_.size();
+  }
+
+  void read(uint64_t offset, uint64_t length, uint8_t * buffer) override
+  {
+    if (offset + length > buffer_.size()) {
+      throw std::out_of_range("read past the end");
+    }
+    std::copy(buffer_.begin() + offset, buffer_.begin() + offset + length, buffer);
+    std::lock_guard<std::mutex> lock(mutex_);
+    bytes_read_ += length;
+  }
+
+  uint64_t bytes_read()
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return bytes_read_;
+  }
+
+private:
+  const std::vector<uint8_t> buffer_;
+  std::mutex mutex_;
+  uint64_t bytes_read_ = 0;
+};
+
+TEST_F(StorageTestFixture, messages_are_read_from_a_database_through_range_reads) {
+  std::vector<std::string> string_messages = {"first message", "second message", "third message"};
+  std::vector<std::tuple<std::string, int64_t, std::string, std::string, std::string>> messages =
+  {std::make_tuple(string_messages[0], 1, "topic1", "type1", "rmw1"),
+    std::make_tuple(string_messages[1], 2, "topic2", "type2", "rmw2"),
+    std::make_tuple(string_messages[2], 3, "topic1", "type1", "rmw1")};
+  write_messages_to_sqlite(messages);
+
+  const auto db_file = (rcpputils::fs::path(temporary_dir_path_) / "rosbag.db3").string();
+  std::ifstream input(db_file, std::ios::binary);
+  auto range_reader = std::make_shared<BufferRangeReader>(
+    std::vector<uint8_t>(std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>()));
+  const auto file_size = range_reader->size();
+  ASSERT_GT(file_size, 0u);
+
+  auto readable_storage = std::make_unique<rosbag2_storage_plugins::SqliteStorage>();
+  readable_storage->open_from_range_reader({db_file, kPluginID}, range_reader);
+
+  std::vector<std::shared_ptr<rosbag2_storage::SerializedBagMessage>> read_messages;
+  while (readable_storage->has_next()) {
+    read_messages.push_back(readable_storage->read_next());
+  }
+  ASSERT_THAT(read_messages, SizeIs(3));
+  for (size_t i = 0; i < 3; i++) {
+    EXPECT_THAT(deserialize_message(read_messages[i]->serialized_data), Eq(string_messages[i]));
+    EXPECT_THAT(read_messages[i]->time_stamp, Eq(std::get<1>(messages[i])));
+  }
+  EXPECT_THAT(readable_storage->get_all_topics_and_types(), SizeIs(2));
+  EXPECT_THAT(readable_storage->get_bagfile_size(), Eq(file_size));
+  EXPECT_THAT(range_reader->bytes_read(), Gt(0u));
+
+  // The storage holds on to the range reader until it is released.
+  readable_storage.reset();
+  EXPECT_THAT(range_reader.use_count(), Eq(1));
+}
+
 TEST_F(StorageTestFixture, storage_configuration_file_applies_over_storage_preset_profile) {
   // Check that "resilient" values are overriden
   const auto journal_setting = "\"journal_mode = OFF\"";
@@ -42,12 +42,41 @@ public:
   std::string compression_format = "";
   uint64_t compression_queue_size = 1;
   uint64_t compression_threads = 0;
+  // Uncompressed bytes per chunk in CHUNK compression mode, 0 for one chunk per cache flush
+  uint64_t compression_chunk_size = 1024 * 1024;
+  // Messages per topic to train a compression dictionary on in MESSAGE mode, 0 for none
+  uint64_t compression_dictionary_samples = 0;
+  // Compression level, 0 for the default level of the compression format
+  int32_t compression_level = 0;
+  // In MESSAGE mode, lower the level down to min_compression_level while compression falls behind
+  bool adaptive_compression_level = false;
+  int32_t min_compression_level = 1;
+  // In FILE mode, worker threads shared by the files being compressed, 0 for none
+  uint64_t compression_file_workers = 0;
+  // In FILE mode, uncompressed bytes per seekable compression frame, 0 to compress files whole
+  uint64_t compression_seekable_frame_size = 0;
+  // In MESSAGE mode, whether topics are compressed: "always", "never" or "auto", "" for always
+  std::string compression_policy = "";
+  // Topic name -> compression policy overriding compression_policy for the topic
+  std::unordered_map<std::string, std::string> compression_topic_policies{};
+  // Messages per topic the "auto" policy compresses before deciding on the topic
+  uint64_t compression_policy_samples = 16;
+  // Compression ratio below which the "auto" policy stores a topic uncompressed
+  double compression_policy_min_ratio = 1.1;
   std::unordered_map<std::string, rclcpp::QoS> topic_qos_profile_overrides{};
   bool include_hidden_topics = false;
   bool include_unpublished_topics = false;
   bool ignore_leaf_topics = false;
   bool start_paused = false;
   bool use_sim_time = false;
+  // Period to publish write statistics on the "write_statistics" topic. Disabled if 0
+  std::chrono::milliseconds statistics_publish_period{0};
+  // Number of storage instances topics are spread over, each written by its own thread
+  uint64_t storage_shards = 1;
+  // Topic name -> maximum rate in Hz of recorded messages. Faster messages are dropped
+  std::unordered_map<std::string, double> topic_max_rates{};
+  // Topic name -> n, only every n-th received message of the topic is recorded
+  std::unordered_map<std::string, uint64_t> topic_keep_every_n{};
 };
 
 }  // namespace rosbag2_transport
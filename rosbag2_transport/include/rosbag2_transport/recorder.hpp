@@ -33,12 +33,14 @@
 #include "rosbag2_interfaces/srv/snapshot.hpp"
 
 #include "rosbag2_interfaces/msg/write_split_event.hpp"
+#include "rosbag2_interfaces/msg/write_statistics.hpp"
 
 #include "rosbag2_storage/topic_metadata.hpp"
 
 #include "rosbag2_transport/record_options.hpp"
 #include "rosbag2_transport/visibility_control.hpp"
 #include "rosbag2_transport/topic_filter.hpp"
+#include "rosbag2_transport/topic_throttle.hpp"
 
 namespace rosbag2_cpp
 {
@@ -150,7 +152,11 @@ private:
 
   void warn_if_new_qos_for_subscribed_topic(const std::string & topic_name);
 
+  // Create throttles for the topics with a max rate or keep every n policy
+  void create_topic_throttles();
+
   std::unique_ptr<TopicFilter> topic_filter_;
+  std::unordered_map<std::string, std::shared_ptr<TopicThrottle>> topic_throttles_;
   std::future<void> discovery_future_;
   std::unordered_map<std::string, std::shared_ptr<rclcpp::GenericSubscription>> subscriptions_;
   std::unordered_set<std::string> topics_warned_about_incompatibility_;
@@ -176,6 +182,14 @@ private:
 
   void event_publisher_thread_main();
   bool event_publisher_thread_should_wake();
+
+  // Variables for statistics publishing
+  rclcpp::Publisher<rosbag2_interfaces::msg::WriteStatistics>::SharedPtr statistics_pub_;
+  rclcpp::TimerBase::SharedPtr statistics_timer_;
+  // Statistics of the previous publication, to compute rates since then
+  rosbag2_cpp::WriterStatistics last_statistics_;
+
+  void publish_statistics();
 };
 
 }  // namespace rosbag2_transport
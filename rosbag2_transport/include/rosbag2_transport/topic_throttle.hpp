@@ -0,0 +1,70 @@
+// Copyright 2022, Open Source Robotics Corporation.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ROSBAG2_TRANSPORT__TOPIC_THROTTLE_HPP_
+#define ROSBAG2_TRANSPORT__TOPIC_THROTTLE_HPP_
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+#include "rcutils/time.h"
+
+#include "rosbag2_transport/visibility_control.hpp"
+
+namespace rosbag2_transport
+{
+
+/// Decides which of the messages received on a topic are recorded.
+/// Dropped messages are never handed to the writer, so they cost no copy, caching nor storage.
+class ROSBAG2_TRANSPORT_PUBLIC TopicThrottle
+{
+public:
+  /**
+   * \param max_rate Maximum rate of recorded messages in Hz. 0 disables the rate limit.
+   * \param keep_every_n Only record every n-th received message. 0 and 1 record all messages.
+   * When both are set, the rate limit applies to the messages kept by keep_every_n.
+   */
+  TopicThrottle(double max_rate, uint64_t keep_every_n);
+
+  /**
+   * Decide whether to record a message. Thread-safe.
+   *
+   * \param receive_time Time the message was received, in nanoseconds
+   * \return true if the message is to be recorded
+   */
+  bool take_message(rcutils_time_point_value_t receive_time);
+
+  uint64_t get_received_count() const;
+
+  uint64_t get_dropped_count() const;
+
+  /// Policy in the form "max_rate=10;keep_every_n=2", as recorded in the bag metadata
+  std::string to_string() const;
+
+private:
+  bool take_by_rate(rcutils_time_point_value_t receive_time);
+
+  double max_rate_;
+  int64_t min_period_;
+  uint64_t keep_every_n_;
+  std::atomic<uint64_t> received_count_ {0u};
+  std::atomic<uint64_t> dropped_count_ {0u};
+  // Receive time from which the next message may be recorded under the rate limit
+  std::atomic<int64_t> next_time_;
+};
+
+}  // namespace rosbag2_transport
+
+#endif  // ROSBAG2_TRANSPORT__TOPIC_THROTTLE_HPP_
@@ -14,14 +14,21 @@
 
 #include "rosbag2_transport/bag_rewrite.hpp"
 
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
 #include <unordered_map>
 #include <unordered_set>
 #include <utility>
 #include <vector>
 
+#include "rosbag2_cpp/message_merger.hpp"
 #include "rosbag2_cpp/reader.hpp"
 #include "rosbag2_cpp/writer.hpp"
 #include "rosbag2_transport/reader_writer_factory.hpp"
@@ -32,39 +39,129 @@
 namespace
 {
 
-/// Find the next chronological message from all opened input bags.
-/// Updates the next_messages queue as necessary.
-/// next_messages is needed because Reader has no "peek" interface, we cannot put a message back.
-/// Returns nullptr when all input bags have been fully read.
-std::shared_ptr<rosbag2_storage::SerializedBagMessage> get_next(
-  const std::vector<std::unique_ptr<rosbag2_cpp::Reader>> & input_bags,
-  std::vector<std::shared_ptr<rosbag2_storage::SerializedBagMessage>> & next_messages)
+using MessageSharedPtr = std::shared_ptr<rosbag2_storage::SerializedBagMessage>;
+
+// Bytes of messages read ahead of the merge from each input bag
+constexpr uint64_t kInputQueueSize = 8 * 1024 * 1024;
+// Bytes of messages waiting for the writer of each output bag
+constexpr uint64_t kOutputQueueSize = 32 * 1024 * 1024;
+
+/// Queue passing messages from one stage of the rewrite to the next one, on another thread.
+/// It is bounded in bytes: push() waits while the queue is full, so that a slow stage holds back
+/// the stages before it instead of letting memory grow.
+class MessageQueue
 {
-  // find message with lowest timestamp
-  std::shared_ptr<rosbag2_storage::SerializedBagMessage> earliest_msg = nullptr;
-  size_t earliest_msg_index = -1;
-  for (size_t i = 0; i < next_messages.size(); i++) {
-    // refill queue if bag not empty
-    if (next_messages[i] == nullptr && input_bags[i]->has_next()) {
-      next_messages[i] = input_bags[i]->read_next();
+public:
+  explicit MessageQueue(uint64_t max_size)
+  : max_size_(max_size) {}
+
+  /// Waits for room and adds a message. Returns false if the queue was aborted.
+  bool push(MessageSharedPtr message)
+  {
+    const auto size = message_size(*message);
+    std::unique_lock<std::mutex> lock(mutex_);
+    // Never full while empty, so that messages larger than the queue still pass
+    not_full_.wait(
+      lock, [this] {return is_aborted_ || messages_.empty() || size_ < max_size_;});
+    if (is_aborted_) {
+      return false;
     }
+    size_ += size;
+    messages_.push_back(std::move(message));
+    lock.unlock();
+    not_empty_.notify_one();
+    return true;
+  }
 
-    auto & msg = next_messages[i];
-    if (msg == nullptr) {
-      continue;
+  /// Waits for a message and takes it out. Returns nullptr once the queue is closed and empty,
+  /// or aborted.
+  MessageSharedPtr pop()
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    not_empty_.wait(lock, [this] {return is_aborted_ || is_closed_ || !messages_.empty();});
+    if (is_aborted_ || messages_.empty()) {
+      return nullptr;
     }
-    if (earliest_msg == nullptr || msg->time_stamp < earliest_msg->time_stamp) {
-      earliest_msg = msg;
-      earliest_msg_index = i;
+    auto message = std::move(messages_.front());
+    messages_.pop_front();
+    size_ -= message_size(*message);
+    lock.unlock();
+    not_full_.notify_one();
+    return message;
+  }
+
+  /// No more messages will be pushed, pop() returns nullptr once the queue is empty.
+  void close()
+  {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      is_closed_ = true;
     }
+    not_empty_.notify_all();
   }
 
-  // clear returned message from queue before returning it, so it can be refilled next time
-  if (earliest_msg != nullptr) {
-    next_messages[earliest_msg_index].reset();
+  /// Drops the messages and wakes up both sides, which stop.
+  void abort()
+  {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      is_aborted_ = true;
+      messages_.clear();
+      size_ = 0;
+    }
+    not_empty_.notify_all();
+    not_full_.notify_all();
   }
-  return earliest_msg;
-}
+
+private:
+  static uint64_t message_size(const rosbag2_storage::SerializedBagMessage & message)
+  {
+    return message.serialized_data ? message.serialized_data->buffer_length : 0u;
+  }
+
+  const uint64_t max_size_;
+  std::mutex mutex_;
+  std::condition_variable not_empty_;
+  std::condition_variable not_full_;
+  std::deque<MessageSharedPtr> messages_;
+  uint64_t size_{0};
+  bool is_closed_{false};
+  bool is_aborted_{false};
+};
+
+/// Keeps the first error thrown by a stage of the rewrite and stops all stages on it.
+class RewriteErrors
+{
+public:
+  explicit RewriteErrors(std::vector<MessageQueue *> queues)
+  : queues_(std::move(queues)) {}
+
+  void set(std::exception_ptr error)
+  {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (!error_) {
+        error_ = error;
+      }
+    }
+    for (auto queue : queues_) {
+      queue->abort();
+    }
+  }
+
+  void rethrow_if_any()
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (error_) {
+      std::rethrow_exception(error_);
+    }
+  }
+
+private:
+  const std::vector<MessageQueue *> queues_;
+  std::mutex mutex_;
+  std::exception_ptr error_;
+};
 
 /// Discover what topics are in the inputs, filter out topics that can't be processed,
 /// create_topic on Writers that will receive topics.
@@ -132,6 +229,10 @@ setup_topic_filtering(
   return filtered_outputs;
 }
 
+/// Rewrites the messages in a pipeline, so that reading, converting, compressing and writing
+/// them overlap: every input bag is read on a thread of its own, the messages of all inputs are
+/// merged in timestamp order on the calling thread, and every output bag is written on a thread of
+/// its own. Stages are connected by bounded queues.
 void perform_rewrite(
   const std::vector<std::unique_ptr<rosbag2_cpp::Reader>> & input_bags,
   const std::vector<
@@ -143,20 +244,81 @@ void perform_rewrite(
     throw std::runtime_error("Must provide at least one input and one output bag to rewrite.");
   }
 
-  auto topic_outputs = setup_topic_filtering(input_bags, output_bags);
+  const auto topic_outputs = setup_topic_filtering(input_bags, output_bags);
+
+  std::vector<std::unique_ptr<MessageQueue>> input_queues;
+  std::vector<std::unique_ptr<MessageQueue>> output_queues;
+  std::vector<MessageQueue *> all_queues;
+  for (size_t i = 0; i < input_bags.size(); i++) {
+    input_queues.push_back(std::make_unique<MessageQueue>(kInputQueueSize));
+    all_queues.push_back(input_queues.back().get());
+  }
+  std::unordered_map<const rosbag2_cpp::Writer *, MessageQueue *> writer_queues;
+  for (const auto & output_bag : output_bags) {
+    output_queues.push_back(std::make_unique<MessageQueue>(kOutputQueueSize));
+    all_queues.push_back(output_queues.back().get());
+    writer_queues[output_bag.first.get()] = output_queues.back().get();
+  }
+  std::unordered_map<std::string, std::vector<MessageQueue *>> topic_queues;
+  for (const auto & [topic_name, writers] : topic_outputs) {
+    for (auto writer : writers) {
+      topic_queues[topic_name].push_back(writer_queues.at(writer));
+    }
+  }
+  RewriteErrors errors(all_queues);
 
-  std::vector<std::shared_ptr<rosbag2_storage::SerializedBagMessage>> next_messages;
-  next_messages.resize(input_bags.size(), nullptr);
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < input_bags.size(); i++) {
+    threads.emplace_back(
+      [&reader = *input_bags[i], &queue = *input_queues[i], &topic_queues, &errors]() {
+        try {
+          while (reader.has_next()) {
+            auto message = reader.read_next();
+            // Messages on topics without outputs are dropped right away
+            if (topic_queues.count(message->topic_name) > 0 && !queue.push(std::move(message))) {
+              return;
+            }
+          }
+          queue.close();
+        } catch (...) {
+          errors.set(std::current_exception());
+        }
+      });
+  }
+  for (size_t i = 0; i < output_bags.size(); i++) {
+    threads.emplace_back(
+      [&writer = *output_bags[i].first, &queue = *output_queues[i], &errors]() {
+        try {
+          while (auto message = queue.pop()) {
+            writer.write(message);
+          }
+        } catch (...) {
+          errors.set(std::current_exception());
+        }
+      });
+  }
 
-  std::shared_ptr<rosbag2_storage::SerializedBagMessage> next_msg;
-  while ((next_msg = get_next(input_bags, next_messages))) {
-    auto topic_writers = topic_outputs.find(next_msg->topic_name);
-    if (topic_writers != topic_outputs.end()) {
-      for (auto writer : topic_writers->second) {
-        writer->write(next_msg);
+  try {
+    rosbag2_cpp::MessageMerger merger(
+      input_queues.size(),
+      [&input_queues](size_t input) {return input_queues[input]->pop();});
+    while (merger.has_next()) {
+      auto next_msg = merger.read_next();
+      for (auto queue : topic_queues.at(next_msg->topic_name)) {
+        queue->push(next_msg);
       }
     }
+    for (auto & queue : output_queues) {
+      queue->close();
+    }
+  } catch (...) {
+    errors.set(std::current_exception());
+  }
+
+  for (auto & thread : threads) {
+    thread.join();
   }
+  errors.rethrow_if_any();
 }
 
 }  // namespace
@@ -182,14 +344,14 @@ void bag_rewrite(
   }
 
   for (auto & [storage_options, record_options] : output_options) {
-    // TODO(emersonknapp) - utilize cache to get better performance.
-    // For now, zero cache allows for synchronous writes which are guaranteed to go through.
-    // With cache enabled, the buffer could overflow and drop messages in this fast-write loop.
-    // To enable the cache we will need to implement a mechanism for the writer to take messages
-    // only when it is able to, which will likely require some new APIs.
+    // Every output bag is written on a thread of its own, which waits for its writes to go
+    // through. A cache or a compression queue could instead overflow and drop messages when the
+    // inputs are read faster than the output is written, so both are disabled.
     auto zero_cache_storage_options = storage_options;
     zero_cache_storage_options.max_cache_size = 0u;
-    auto writer = ReaderWriterFactory::make_writer(record_options);
+    auto blocking_record_options = record_options;
+    blocking_record_options.compression_queue_size = 0u;
+    auto writer = ReaderWriterFactory::make_writer(blocking_record_options);
     writer->open(zero_cache_storage_options);
     output_bags.push_back(std::make_pair(std::move(writer), record_options));
   }
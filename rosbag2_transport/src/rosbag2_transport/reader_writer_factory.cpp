@@ -15,11 +15,13 @@
 #include "rosbag2_transport/reader_writer_factory.hpp"
 
 #include <memory>
+#include <stdexcept>
 #include <utility>
 
 #include "rosbag2_compression/compression_options.hpp"
 #include "rosbag2_compression/sequential_compression_reader.hpp"
 #include "rosbag2_compression/sequential_compression_writer.hpp"
+#include "rosbag2_cpp/writers/sharded_writer.hpp"
 #include "rosbag2_storage/metadata_io.hpp"
 
 namespace rosbag2_transport
@@ -48,6 +50,9 @@ std::unique_ptr<rosbag2_cpp::Writer> ReaderWriterFactory::make_writer(
   const rosbag2_transport::RecordOptions & record_options)
 {
   std::unique_ptr<rosbag2_cpp::writer_interfaces::BaseWriterInterface> writer_impl;
+  if (record_options.storage_shards > 1 && !record_options.compression_format.empty()) {
+    throw std::runtime_error("Compression is not supported when recording to storage shards.");
+  }
   if (!record_options.compression_format.empty()) {
     rosbag2_compression::CompressionOptions compression_options {
       record_options.compression_format,
@@ -55,11 +60,32 @@ std::unique_ptr<rosbag2_cpp::Writer> ReaderWriterFactory::make_writer(
       record_options.compression_queue_size,
       record_options.compression_threads
     };
+    compression_options.compression_chunk_size = record_options.compression_chunk_size;
+    compression_options.compression_dictionary_samples =
+      record_options.compression_dictionary_samples;
+    compression_options.compression_level = record_options.compression_level;
+    compression_options.adaptive_compression_level = record_options.adaptive_compression_level;
+    compression_options.min_compression_level = record_options.min_compression_level;
+    compression_options.compression_file_workers = record_options.compression_file_workers;
+    compression_options.compression_seekable_frame_size =
+      record_options.compression_seekable_frame_size;
+    compression_options.compression_policy =
+      rosbag2_compression::topic_compression_policy_from_string(record_options.compression_policy);
+    for (const auto & topic_policy : record_options.compression_topic_policies) {
+      compression_options.compression_topic_policies[topic_policy.first] =
+        rosbag2_compression::topic_compression_policy_from_string(topic_policy.second);
+    }
+    compression_options.compression_policy_samples = record_options.compression_policy_samples;
+    compression_options.compression_policy_min_ratio =
+      record_options.compression_policy_min_ratio;
     if (compression_options.compression_threads < 1) {
       compression_options.compression_threads = std::thread::hardware_concurrency();
     }
     writer_impl = std::make_unique<rosbag2_compression::SequentialCompressionWriter>(
       compression_options);
+  } else if (record_options.storage_shards > 1) {
+    writer_impl = std::make_unique<rosbag2_cpp::writers::ShardedWriter>(
+      record_options.storage_shards);
   } else {
     writer_impl = std::make_unique<rosbag2_cpp::writers::SequentialWriter>();
   }
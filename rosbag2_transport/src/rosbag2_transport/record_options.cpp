@@ -54,12 +54,31 @@ Node convert<rosbag2_transport::RecordOptions>::encode(
   node["compression_format"] = record_options.compression_format;
   node["compression_queue_size"] = record_options.compression_queue_size;
   node["compression_threads"] = record_options.compression_threads;
+  node["compression_chunk_size"] = record_options.compression_chunk_size;
+  node["compression_dictionary_samples"] = record_options.compression_dictionary_samples;
+  node["compression_level"] = record_options.compression_level;
+  node["adaptive_compression_level"] = record_options.adaptive_compression_level;
+  node["min_compression_level"] = record_options.min_compression_level;
+  node["compression_file_workers"] = record_options.compression_file_workers;
+  node["compression_seekable_frame_size"] = record_options.compression_seekable_frame_size;
+  node["compression_policy"] = record_options.compression_policy;
+  node["compression_topic_policies"] = std::map<std::string, std::string>(
+    record_options.compression_topic_policies.begin(),
+    record_options.compression_topic_policies.end());
+  node["compression_policy_samples"] = record_options.compression_policy_samples;
+  node["compression_policy_min_ratio"] = record_options.compression_policy_min_ratio;
   std::map<std::string, rosbag2_transport::Rosbag2QoS> qos_overrides(
     record_options.topic_qos_profile_overrides.begin(),
     record_options.topic_qos_profile_overrides.end());
   node["topic_qos_profile_overrides"] = qos_overrides;
   node["include_hidden_topics"] = record_options.include_hidden_topics;
   node["include_unpublished_topics"] = record_options.include_unpublished_topics;
+  node["statistics_publish_period"] = record_options.statistics_publish_period;
+  node["storage_shards"] = record_options.storage_shards;
+  node["topic_max_rates"] = std::map<std::string, double>(
+    record_options.topic_max_rates.begin(), record_options.topic_max_rates.end());
+  node["topic_keep_every_n"] = std::map<std::string, uint64_t>(
+    record_options.topic_keep_every_n.begin(), record_options.topic_keep_every_n.end());
   return node;
 }
 
@@ -80,6 +99,27 @@ bool convert<rosbag2_transport::RecordOptions>::decode(
   optional_assign<std::string>(node, "compression_format", record_options.compression_format);
   optional_assign<uint64_t>(node, "compression_queue_size", record_options.compression_queue_size);
   optional_assign<uint64_t>(node, "compression_threads", record_options.compression_threads);
+  optional_assign<uint64_t>(node, "compression_chunk_size", record_options.compression_chunk_size);
+  optional_assign<uint64_t>(
+    node, "compression_dictionary_samples", record_options.compression_dictionary_samples);
+  optional_assign<int32_t>(node, "compression_level", record_options.compression_level);
+  optional_assign<bool>(
+    node, "adaptive_compression_level", record_options.adaptive_compression_level);
+  optional_assign<int32_t>(node, "min_compression_level", record_options.min_compression_level);
+  optional_assign<uint64_t>(
+    node, "compression_file_workers", record_options.compression_file_workers);
+  optional_assign<uint64_t>(
+    node, "compression_seekable_frame_size", record_options.compression_seekable_frame_size);
+  optional_assign<std::string>(node, "compression_policy", record_options.compression_policy);
+  std::map<std::string, std::string> compression_topic_policies;
+  optional_assign<std::map<std::string, std::string>>(
+    node, "compression_topic_policies", compression_topic_policies);
+  record_options.compression_topic_policies.insert(
+    compression_topic_policies.begin(), compression_topic_policies.end());
+  optional_assign<uint64_t>(
+    node, "compression_policy_samples", record_options.compression_policy_samples);
+  optional_assign<double>(
+    node, "compression_policy_min_ratio", record_options.compression_policy_min_ratio);
 
   // yaml-cpp doesn't implement unordered_map
   std::map<std::string, rosbag2_transport::Rosbag2QoS> qos_overrides;
@@ -91,6 +131,17 @@ bool convert<rosbag2_transport::RecordOptions>::decode(
   optional_assign<bool>(
     node, "include_unpublished_topics",
     record_options.include_unpublished_topics);
+  optional_assign<std::chrono::milliseconds>(
+    node, "statistics_publish_period", record_options.statistics_publish_period);
+  optional_assign<uint64_t>(node, "storage_shards", record_options.storage_shards);
+
+  std::map<std::string, double> topic_max_rates;
+  optional_assign<std::map<std::string, double>>(node, "topic_max_rates", topic_max_rates);
+  record_options.topic_max_rates.insert(topic_max_rates.begin(), topic_max_rates.end());
+  std::map<std::string, uint64_t> topic_keep_every_n;
+  optional_assign<std::map<std::string, uint64_t>>(
+    node, "topic_keep_every_n", topic_keep_every_n);
+  record_options.topic_keep_every_n.insert(topic_keep_every_n.begin(), topic_keep_every_n.end());
   return true;
 }
 
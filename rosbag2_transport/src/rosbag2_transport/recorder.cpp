@@ -26,6 +26,7 @@
 
 #include "rclcpp/logging.hpp"
 #include "rclcpp/clock.hpp"
+#include "rclcpp/duration.hpp"
 
 #include "rosbag2_cpp/bag_events.hpp"
 #include "rosbag2_cpp/writer.hpp"
@@ -103,6 +104,7 @@ Recorder::Recorder(
   for (auto & topic : record_options_.topics) {
     topic = rclcpp::expand_topic_or_service_name(topic, get_name(), get_namespace(), false);
   }
+  create_topic_throttles();
 }
 
 Recorder::~Recorder()
@@ -115,6 +117,14 @@ Recorder::~Recorder()
 
   subscriptions_.clear();
 
+  for (const auto & topic_throttle : topic_throttles_) {
+    RCLCPP_INFO_STREAM(
+      get_logger(),
+      "Throttled topic '" << topic_throttle.first << "': dropped " <<
+        topic_throttle.second->get_dropped_count() << " of " <<
+        topic_throttle.second->get_received_count() << " messages");
+  }
+
   {
     std::lock_guard<std::mutex> lock(event_publisher_thread_mutex_);
     event_publisher_thread_should_exit_ = true;
@@ -132,6 +142,12 @@ void Recorder::record()
     throw std::runtime_error("No serialization format specified!");
   }
 
+  // Record throttling policies in the metadata, since the bag misses messages of those topics
+  for (const auto & topic_throttle : topic_throttles_) {
+    storage_options_.custom_data["throttle:" + topic_throttle.first] =
+      topic_throttle.second->to_string();
+  }
+
   writer_->open(
     storage_options_,
     {rmw_get_serialization_format(), record_options_.rmw_serialization_format});
@@ -167,6 +183,15 @@ void Recorder::record()
     };
   writer_->add_event_callbacks(callbacks);
 
+  if (record_options_.statistics_publish_period.count() > 0) {
+    statistics_pub_ = create_publisher<rosbag2_interfaces::msg::WriteStatistics>(
+      "~/write_statistics",
+      10);
+    statistics_timer_ = create_wall_timer(
+      record_options_.statistics_publish_period,
+      [this]() {publish_statistics();});
+  }
+
   serialization_format_ = record_options_.rmw_serialization_format;
   RCLCPP_INFO(this->get_logger(), "Listening for topics...");
   subscribe_topics(get_requested_or_available_topics());
@@ -209,6 +234,73 @@ bool Recorder::event_publisher_thread_should_wake()
   return write_split_has_occurred_ || event_publisher_thread_should_exit_;
 }
 
+namespace
+{
+double rate_since(uint64_t count, uint64_t last_count, double elapsed_seconds)
+{
+  if (elapsed_seconds <= 0.0 || count < last_count) {
+    return 0.0;
+  }
+  return static_cast<double>(count - last_count) / elapsed_seconds;
+}
+
+rosbag2_interfaces::msg::LatencySummary to_latency_summary_msg(
+  const rosbag2_cpp::LatencySummary & summary)
+{
+  rosbag2_interfaces::msg::LatencySummary message;
+  message.count = summary.count;
+  message.p50 = summary.p50;
+  message.p90 = summary.p90;
+  message.p99 = summary.p99;
+  message.max = summary.max;
+  return message;
+}
+}  // namespace
+
+void Recorder::publish_statistics()
+{
+  // Latencies are summarized per publishing interval, counts since the bag was opened
+  auto statistics = writer_->get_interval_statistics();
+  const double elapsed_seconds =
+    std::chrono::duration<double>(statistics.duration - last_statistics_.duration).count();
+
+  auto message = rosbag2_interfaces::msg::WriteStatistics();
+  message.duration = rclcpp::Duration(statistics.duration);
+  message.messages = statistics.messages;
+  message.bytes = statistics.bytes;
+  message.messages_per_second =
+    rate_since(statistics.messages, last_statistics_.messages, elapsed_seconds);
+  message.bytes_per_second = rate_since(statistics.bytes, last_statistics_.bytes, elapsed_seconds);
+  message.spill_bytes = statistics.spill_bytes;
+  message.spill_bytes_pending = statistics.spill_bytes_pending;
+  message.spill_drain_rate = statistics.spill_drain_rate;
+
+  message.topics.reserve(statistics.topics.size());
+  for (const auto & topic : statistics.topics) {
+    rosbag2_cpp::TopicWriteStatistics last_topic_statistics;
+    const auto last_it = last_statistics_.topics.find(topic.first);
+    if (last_it != last_statistics_.topics.end()) {
+      last_topic_statistics = last_it->second;
+    }
+    rosbag2_interfaces::msg::TopicWriteStatistics topic_message;
+    topic_message.topic_name = topic.first;
+    topic_message.messages = topic.second.messages;
+    topic_message.bytes = topic.second.bytes;
+    topic_message.messages_per_second =
+      rate_since(topic.second.messages, last_topic_statistics.messages, elapsed_seconds);
+    topic_message.bytes_per_second =
+      rate_since(topic.second.bytes, last_topic_statistics.bytes, elapsed_seconds);
+    topic_message.receive_to_push = to_latency_summary_msg(topic.second.receive_to_push);
+    topic_message.cache_residency = to_latency_summary_msg(topic.second.cache_residency);
+    topic_message.storage_write = to_latency_summary_msg(topic.second.storage_write);
+    topic_message.receive_to_commit = to_latency_summary_msg(topic.second.receive_to_commit);
+    message.topics.push_back(std::move(topic_message));
+  }
+  statistics_pub_->publish(message);
+
+  last_statistics_ = std::move(statistics);
+}
+
 const rosbag2_cpp::Writer & Recorder::get_writer_handle()
 {
   return *writer_;
@@ -319,18 +411,55 @@ std::shared_ptr<rclcpp::GenericSubscription>
 Recorder::create_subscription(
   const std::string & topic_name, const std::string & topic_type, const rclcpp::QoS & qos)
 {
+  const auto throttle_it = topic_throttles_.find(topic_name);
+  std::shared_ptr<TopicThrottle> throttle =
+    throttle_it != topic_throttles_.end() ? throttle_it->second : nullptr;
+
   auto subscription = this->create_generic_subscription(
     topic_name,
     topic_type,
     qos,
-    [this, topic_name, topic_type](std::shared_ptr<const rclcpp::SerializedMessage> message) {
-      if (!paused_.load()) {
-        writer_->write(message, topic_name, topic_type, this->get_clock()->now());
+    [this, topic_name, topic_type, throttle](
+      std::shared_ptr<const rclcpp::SerializedMessage> message) {
+      if (paused_.load()) {
+        return;
+      }
+      const auto receive_time = this->get_clock()->now();
+      // Drop throttled messages before the writer copies them
+      if (throttle && !throttle->take_message(receive_time.nanoseconds())) {
+        return;
       }
+      writer_->write(message, topic_name, topic_type, receive_time);
     });
   return subscription;
 }
 
+void Recorder::create_topic_throttles()
+{
+  const auto expand = [this](const std::string & topic_name) {
+      return rclcpp::expand_topic_or_service_name(topic_name, get_name(), get_namespace(), false);
+    };
+  std::unordered_map<std::string, double> max_rates;
+  for (const auto & max_rate : record_options_.topic_max_rates) {
+    max_rates[expand(max_rate.first)] = max_rate.second;
+  }
+  std::unordered_map<std::string, uint64_t> keep_every_n;
+  for (const auto & every_n : record_options_.topic_keep_every_n) {
+    keep_every_n[expand(every_n.first)] = every_n.second;
+  }
+
+  for (const auto & max_rate : max_rates) {
+    const auto every_n_it = keep_every_n.find(max_rate.first);
+    const uint64_t n = every_n_it != keep_every_n.end() ? every_n_it->second : 0u;
+    topic_throttles_.emplace(max_rate.first, std::make_shared<TopicThrottle>(max_rate.second, n));
+  }
+  for (const auto & every_n : keep_every_n) {
+    if (topic_throttles_.find(every_n.first) == topic_throttles_.end()) {
+      topic_throttles_.emplace(every_n.first, std::make_shared<TopicThrottle>(0.0, every_n.second));
+    }
+  }
+}
+
 std::string Recorder::serialized_offered_qos_profiles_for_topic(const std::string & topic_name)
 {
   YAML::Node offered_qos_profiles;
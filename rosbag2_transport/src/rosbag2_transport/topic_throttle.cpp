@@ -0,0 +1,87 @@
+// Copyright 2022, Open Source Robotics Corporation.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "rosbag2_transport/topic_throttle.hpp"
+
+#include <limits>
+#include <sstream>
+#include <string>
+
+namespace rosbag2_transport
+{
+
+TopicThrottle::TopicThrottle(double max_rate, uint64_t keep_every_n)
+: max_rate_(max_rate > 0.0 ? max_rate : 0.0),
+  min_period_(max_rate > 0.0 ? static_cast<int64_t>(1e9 / max_rate) : 0),
+  keep_every_n_(keep_every_n),
+  next_time_(std::numeric_limits<int64_t>::min())
+{}
+
+bool TopicThrottle::take_message(rcutils_time_point_value_t receive_time)
+{
+  const uint64_t index = received_count_.fetch_add(1u, std::memory_order_relaxed);
+  bool take = keep_every_n_ <= 1u || index % keep_every_n_ == 0u;
+  if (take && min_period_ > 0) {
+    take = take_by_rate(receive_time);
+  }
+  if (!take) {
+    dropped_count_.fetch_add(1u, std::memory_order_relaxed);
+  }
+  return take;
+}
+
+bool TopicThrottle::take_by_rate(rcutils_time_point_value_t receive_time)
+{
+  int64_t next_time = next_time_.load(std::memory_order_relaxed);
+  int64_t new_next_time = 0;
+  do {
+    const bool first_message = next_time == std::numeric_limits<int64_t>::min();
+    // The clock may jump back, e.g. when replaying a looped bag with simulated time
+    const bool time_jumped_back = !first_message && receive_time < next_time - 2 * min_period_;
+    if (!first_message && !time_jumped_back && receive_time < next_time) {
+      return false;
+    }
+    // Keep to the schedule of recorded messages as long as messages arrive in time for it,
+    // so that jitter in receive times does not lower the recorded rate
+    const bool on_schedule = !first_message && !time_jumped_back &&
+      receive_time - next_time < min_period_;
+    new_next_time = on_schedule ? next_time + min_period_ : receive_time + min_period_;
+  } while (!next_time_.compare_exchange_weak(
+    next_time, new_next_time, std::memory_order_relaxed));
+  return true;
+}
+
+uint64_t TopicThrottle::get_received_count() const
+{
+  return received_count_.load(std::memory_order_relaxed);
+}
+
+uint64_t TopicThrottle::get_dropped_count() const
+{
+  return dropped_count_.load(std::memory_order_relaxed);
+}
+
+std::string TopicThrottle::to_string() const
+{
+  std::stringstream policy;
+  if (max_rate_ > 0.0) {
+    policy << "max_rate=" << max_rate_;
+  }
+  if (keep_every_n_ > 1u) {
+    policy << (max_rate_ > 0.0 ? ";" : "") << "keep_every_n=" << keep_every_n_;
+  }
+  return policy.str();
+}
+
+}  // namespace rosbag2_transport
@@ -14,14 +14,18 @@
 
 #include <gmock/gmock.h>
 
+#include <atomic>
 #include <memory>
 #include <string>
+#include <thread>
 #include <unordered_map>
 #include <utility>
 #include <vector>
 
 #include "rclcpp/rclcpp.hpp"
 
+#include "rosbag2_interfaces/msg/write_statistics.hpp"
+
 #include "rosbag2_test_common/publication_manager.hpp"
 #include "rosbag2_test_common/wait_for.hpp"
 
@@ -357,3 +361,67 @@ TEST_F(RecordIntegrationTestFixture, write_split_callback_is_called)
   EXPECT_EQ(closed_file, "BagFile0");
   EXPECT_EQ(opened_file, "BagFile1");
 }
+
+TEST_F(RecordIntegrationTestFixture, write_statistics_are_published_periodically)
+{
+  std::string string_topic = "/string_topic";
+  rosbag2_transport::RecordOptions record_options =
+  {false, false, {string_topic}, "rmw_format", 100ms};
+  record_options.statistics_publish_period = 50ms;
+  auto recorder = std::make_shared<rosbag2_transport::Recorder>(
+    std::move(writer_), storage_options_, record_options);
+  recorder->record();
+
+  std::atomic<size_t> statistics_received {0};
+  auto listener_node = std::make_shared<rclcpp::Node>("write_statistics_listener");
+  auto subscription = listener_node->create_subscription<rosbag2_interfaces::msg::WriteStatistics>(
+    "/rosbag2_recorder/write_statistics", 10,
+    [&statistics_received](rosbag2_interfaces::msg::WriteStatistics::ConstSharedPtr) {
+      ++statistics_received;
+    });
+
+  start_async_spin(recorder);
+
+  auto ret = rosbag2_test_common::wait_until_shutdown(
+    std::chrono::seconds(5),
+    [&listener_node, &statistics_received]() {
+      rclcpp::spin_some(listener_node);
+      return statistics_received >= 2u;
+    });
+  EXPECT_TRUE(ret) << "failed to receive write statistics in time";
+}
+
+TEST_F(RecordIntegrationTestFixture, throttled_topic_records_every_nth_message)
+{
+  auto string_message = get_messages_strings()[1];
+  std::string string_topic = "/string_topic";
+  const size_t published_messages = 10;
+
+  rosbag2_transport::RecordOptions record_options =
+  {false, false, {string_topic}, "rmw_format", 100ms};
+  record_options.topic_keep_every_n.emplace(string_topic, 2u);
+  auto recorder = std::make_shared<rosbag2_transport::Recorder>(
+    std::move(writer_), storage_options_, record_options);
+  recorder->record();
+
+  start_async_spin(recorder);
+
+  auto & writer = recorder->get_writer_handle();
+  MockSequentialWriter & mock_writer =
+    static_cast<MockSequentialWriter &>(writer.get_implementation_handle());
+
+  rosbag2_test_common::PublicationManager pub_manager;
+  pub_manager.setup_publisher(string_topic, string_message, published_messages);
+  ASSERT_TRUE(pub_manager.wait_for_matched(string_topic.c_str()));
+  pub_manager.run_publishers();
+
+  auto ret = rosbag2_test_common::wait_until_shutdown(
+    std::chrono::seconds(5),
+    [&mock_writer, published_messages]() {
+      return mock_writer.get_messages().size() >= published_messages / 2;
+    });
+  EXPECT_TRUE(ret) << "failed to capture expected messages in time";
+  // Give dropped messages the time to show up, had they not been dropped
+  std::this_thread::sleep_for(200ms);
+  EXPECT_THAT(mock_writer.get_messages(), SizeIs(published_messages / 2));
+}
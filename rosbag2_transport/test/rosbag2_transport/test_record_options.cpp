@@ -33,9 +33,24 @@ TEST(record_options, test_yaml_serialization)
   original.compression_format = "h264";
   original.compression_queue_size = 2;
   original.compression_threads = 123;
+  original.compression_chunk_size = 4096;
+  original.compression_dictionary_samples = 500;
+  original.compression_level = 19;
+  original.adaptive_compression_level = true;
+  original.min_compression_level = -5;
+  original.compression_file_workers = 8;
+  original.compression_seekable_frame_size = 4 * 1024 * 1024;
+  original.compression_policy = "auto";
+  original.compression_topic_policies.emplace("/camera/image/compressed", "never");
+  original.compression_policy_samples = 32;
+  original.compression_policy_min_ratio = 1.5;
   original.topic_qos_profile_overrides.emplace("topic", rclcpp::QoS(10).transient_local());
   original.include_hidden_topics = true;
   original.include_unpublished_topics = true;
+  original.statistics_publish_period = std::chrono::milliseconds{500};
+  original.storage_shards = 4;
+  original.topic_max_rates.emplace("/joint_states", 100.0);
+  original.topic_keep_every_n.emplace("/tf", 10);
 
   auto node = YAML::convert<rosbag2_transport::RecordOptions>().encode(original);
 
@@ -49,5 +64,20 @@ TEST(record_options, test_yaml_serialization)
   CHECK(is_discovery_disabled);
   CHECK(topics);
   CHECK(rmw_serialization_format);
+  CHECK(statistics_publish_period);
+  CHECK(compression_chunk_size);
+  CHECK(compression_dictionary_samples);
+  CHECK(compression_level);
+  CHECK(adaptive_compression_level);
+  CHECK(min_compression_level);
+  CHECK(compression_file_workers);
+  CHECK(compression_seekable_frame_size);
+  CHECK(compression_policy);
+  CHECK(compression_topic_policies);
+  CHECK(compression_policy_samples);
+  CHECK(compression_policy_min_ratio);
+  CHECK(storage_shards);
+  CHECK(topic_max_rates);
+  CHECK(topic_keep_every_n);
   #undef CMP
 }
@@ -14,6 +14,7 @@
 
 #include <gmock/gmock.h>
 
+#include <algorithm>
 #include <string>
 #include <vector>
 #include <utility>
@@ -193,3 +194,52 @@ TEST_F(TestRewrite, test_compress) {
   EXPECT_TRUE(compressed_bagfile.exists());
   EXPECT_TRUE(compressed_bagfile.is_regular_file());
 }
+
+TEST_F(TestRewrite, test_merge_keeps_timestamp_order) {
+  use_input_a();
+  use_input_b();
+
+  rosbag2_storage::StorageOptions output_storage;
+  output_storage.uri = (output_dir_ / "merged_in_order").string();
+  output_storage.storage_id = "sqlite3";
+  rosbag2_transport::RecordOptions output_record;
+  output_record.all = true;
+  output_bags_.push_back({output_storage, output_record});
+
+  rosbag2_transport::bag_rewrite(input_bags_, output_bags_);
+
+  auto reader = rosbag2_transport::ReaderWriterFactory::make_reader(output_storage);
+  reader->open(output_storage);
+  std::vector<rcutils_time_point_value_t> time_stamps;
+  while (reader->has_next()) {
+    time_stamps.push_back(reader->read_next()->time_stamp);
+  }
+  EXPECT_THAT(time_stamps, SizeIs(100u + 50u + 50u + 25u));
+  EXPECT_TRUE(std::is_sorted(time_stamps.begin(), time_stamps.end()));
+}
+
+TEST_F(TestRewrite, test_message_compression_keeps_all_messages) {
+  use_input_a();
+
+  rosbag2_storage::StorageOptions output_storage;
+  output_storage.uri = (output_dir_ / "message_compressed").string();
+  output_storage.storage_id = "sqlite3";
+  rosbag2_transport::RecordOptions output_record;
+  output_record.all = true;
+  output_record.compression_mode = "message";
+  output_record.compression_format = "zstd";
+  // Would drop messages while recording, rewriting waits for the compression instead
+  output_record.compression_queue_size = 1;
+  output_bags_.push_back({output_storage, output_record});
+
+  rosbag2_transport::bag_rewrite(input_bags_, output_bags_);
+
+  auto reader = rosbag2_transport::ReaderWriterFactory::make_reader(output_storage);
+  reader->open(output_storage);
+  size_t message_count = 0;
+  while (reader->has_next()) {
+    reader->read_next();
+    message_count++;
+  }
+  EXPECT_EQ(message_count, 100u + 50u);
+}
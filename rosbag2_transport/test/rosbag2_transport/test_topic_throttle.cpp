@@ -0,0 +1,122 @@
+// Copyright 2022, Open Source Robotics Corporation.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gmock/gmock.h>
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include "rosbag2_transport/topic_throttle.hpp"
+
+using namespace ::testing;  // NOLINT
+using rosbag2_transport::TopicThrottle;
+
+namespace
+{
+constexpr int64_t kMillisecond = 1000000;
+
+// Receive times in ns of the messages taken out of count messages received every period
+std::vector<int64_t> taken_messages(TopicThrottle & throttle, int64_t period, int count)
+{
+  std::vector<int64_t> taken;
+  for (int i = 0; i < count; ++i) {
+    if (throttle.take_message(i * period)) {
+      taken.push_back(i * period);
+    }
+  }
+  return taken;
+}
+}  // namespace
+
+TEST(TestTopicThrottle, no_policy_takes_all_messages) {
+  TopicThrottle throttle(0.0, 0u);
+  EXPECT_THAT(taken_messages(throttle, kMillisecond, 10), SizeIs(10));
+  EXPECT_EQ(throttle.get_received_count(), 10u);
+  EXPECT_EQ(throttle.get_dropped_count(), 0u);
+}
+
+TEST(TestTopicThrottle, keep_every_n_takes_first_and_every_nth_message) {
+  TopicThrottle throttle(0.0, 3u);
+  EXPECT_THAT(
+    taken_messages(throttle, kMillisecond, 10),
+    ElementsAre(0, 3 * kMillisecond, 6 * kMillisecond, 9 * kMillisecond));
+  EXPECT_EQ(throttle.get_dropped_count(), 6u);
+}
+
+TEST(TestTopicThrottle, max_rate_limits_recorded_rate) {
+  // 1 kHz down to 100 Hz
+  TopicThrottle throttle(100.0, 0u);
+  auto taken = taken_messages(throttle, kMillisecond, 1000);
+  EXPECT_THAT(taken, SizeIs(100));
+  for (size_t i = 1; i < taken.size(); ++i) {
+    EXPECT_GE(taken[i] - taken[i - 1], 10 * kMillisecond);
+  }
+}
+
+TEST(TestTopicThrottle, max_rate_is_kept_with_jittering_receive_times) {
+  TopicThrottle throttle(100.0, 0u);
+  size_t taken = 0;
+  for (int64_t i = 0; i < 1000; ++i) {
+    // Messages arrive every ms, up to half a ms late
+    const int64_t jitter = (i % 2) * kMillisecond / 2;
+    taken += throttle.take_message(i * kMillisecond + jitter) ? 1u : 0u;
+  }
+  EXPECT_EQ(taken, 100u);
+}
+
+TEST(TestTopicThrottle, max_rate_recovers_when_time_jumps_back) {
+  TopicThrottle throttle(10.0, 0u);
+  EXPECT_TRUE(throttle.take_message(10000 * kMillisecond));
+  EXPECT_FALSE(throttle.take_message(10050 * kMillisecond));
+  EXPECT_TRUE(throttle.take_message(0));
+  EXPECT_FALSE(throttle.take_message(50 * kMillisecond));
+  EXPECT_TRUE(throttle.take_message(100 * kMillisecond));
+}
+
+TEST(TestTopicThrottle, max_rate_applies_on_top_of_keep_every_n) {
+  // Every second of 1 kHz messages, then at most 100 Hz
+  TopicThrottle throttle(100.0, 2u);
+  auto taken = taken_messages(throttle, kMillisecond, 1000);
+  EXPECT_THAT(taken, SizeIs(100));
+  for (const auto time : taken) {
+    EXPECT_EQ((time / kMillisecond) % 2, 0);
+  }
+}
+
+TEST(TestTopicThrottle, concurrent_messages_respect_keep_every_n) {
+  TopicThrottle throttle(0.0, 4u);
+  std::vector<std::thread> threads;
+  std::atomic<size_t> taken {0u};
+  for (int t = 0; t < 4; ++t) {
+    threads.emplace_back(
+      [&throttle, &taken]() {
+        for (int i = 0; i < 1000; ++i) {
+          taken += throttle.take_message(i) ? 1u : 0u;
+        }
+      });
+  }
+  for (auto & thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(taken, 1000u);
+  EXPECT_EQ(throttle.get_dropped_count(), 3000u);
+}
+
+TEST(TestTopicThrottle, policy_description) {
+  EXPECT_EQ(TopicThrottle(100.0, 0u).to_string(), "max_rate=100");
+  EXPECT_EQ(TopicThrottle(0.0, 5u).to_string(), "keep_every_n=5");
+  EXPECT_EQ(TopicThrottle(2.5, 3u).to_string(), "max_rate=2.5;keep_every_n=3");
+}